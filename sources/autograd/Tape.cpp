@@ -0,0 +1,596 @@
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "autograd/Tape.hpp"
+#include "gemm/Gemm.hpp"
+#include "transpose/Transpose.hpp"
+
+static constexpr std::size_t none = static_cast<std::size_t>(-1);
+
+// target += g (or -= g) summed over the axes along which target, of the
+// given shape, was broadcast to the shape of g. g must be contiguous.
+template<typename T>
+static void reduceInto(const NDArrayView<const T>& g, const std::vector<std::size_t>& shape, T* target, bool negate) {
+    const std::vector<std::size_t>& gShape = g.shape();
+    const std::size_t rank = gShape.size();
+    const std::vector<std::ptrdiff_t> strides = broadcast_strides(shape, contiguous_strides(shape), gShape);
+    const std::size_t inner = gShape[rank - 1];
+    if (inner == 0) {
+        return;
+    }
+    const std::size_t outer = shape_size(gShape) / inner;
+    const simd::BasicKernels<T>& kernels = simd::kernels<T>();
+    std::vector<std::size_t> index(rank - 1, 0);
+    std::ptrdiff_t offset = 0;
+    for (std::size_t row = 0; row < outer; row++) {
+        const T* run = g.data() + row * inner;
+        T* out = target + offset;
+        if (strides[rank - 1] == 0) {
+            const T s = kernels.sum(run, inner);
+            *out += negate ? -s : s;
+        } else if (negate) {
+            kernels.sub(out, run, out, inner);
+        } else {
+            kernels.add(out, run, out, inner);
+        }
+        for (std::size_t k = rank - 1; k-- > 0;) {
+            offset += strides[k];
+            if (++index[k] < gShape[k]) {
+                break;
+            }
+            offset -= strides[k] * static_cast<std::ptrdiff_t>(gShape[k]);
+            index[k] = 0;
+        }
+    }
+}
+
+namespace autograd {
+
+// Constructors
+
+template<typename T>
+BasicTape<T>::BasicTape() :
+    m_nodes(), m_pool(), m_liveBytes(0), m_peakBytes(0), m_pooledBytes(0), m_backwardDone(false)
+{}
+
+// Private methods
+
+template<typename T>
+NDArray<T> BasicTape<T>::acquire(const std::vector<std::size_t>& shape) {
+    const std::size_t n = shape_size(shape);
+    NDArray<T> buffer;
+    auto it = m_pool.find(n);
+    if (it != m_pool.end() && !it->second.empty()) {
+        buffer = std::move(it->second.back());
+        it->second.pop_back();
+        m_pooledBytes -= n * sizeof(T);
+        buffer.reshape(shape);
+    } else {
+        buffer = NDArray<T>(shape);
+    }
+    m_liveBytes += n * sizeof(T);
+    m_peakBytes = std::max(m_peakBytes, m_liveBytes);
+    return buffer;
+}
+
+template<typename T>
+void BasicTape<T>::release(NDArray<T>& buffer) {
+    const std::size_t n = buffer.size();
+    m_liveBytes -= n * sizeof(T);
+    m_pooledBytes += n * sizeof(T);
+    m_pool[n].push_back(std::move(buffer));
+    buffer.clear();
+}
+
+template<typename T>
+std::size_t BasicTape<T>::push(Op op, std::size_t a, std::size_t b, std::vector<std::size_t> shape) {
+    if (m_backwardDone) {
+        throw std::invalid_argument("Cannot record on a tape after backward(), clear() it first.");
+    }
+    Node node;
+    node.op = op;
+    node.inputs[0] = a;
+    node.inputs[1] = b;
+    node.shape = std::move(shape);
+    node.leafValue = nullptr;
+    node.leafGrad = nullptr;
+    node.hasGrad = false;
+    node.requiresGrad = (a != none && m_nodes[a].requiresGrad) || (b != none && m_nodes[b].requiresGrad);
+    node.retained = false;
+    node.released = false;
+    node.uses = 0;
+    node.activation = Activation::Identity;
+    m_nodes.push_back(std::move(node));
+    return m_nodes.size() - 1;
+}
+
+template<typename T>
+void BasicTape<T>::save(std::size_t node, std::size_t input) {
+    m_nodes[node].saved.push_back(input);
+    m_nodes[input].uses++;
+}
+
+template<typename T>
+const NDArray<T>& BasicTape<T>::valueOf(std::size_t i) const {
+    const Node& node = m_nodes[i];
+    return (node.op == Op::Leaf) ? *node.leafValue : node.value;
+}
+
+template<typename T>
+std::size_t BasicTape<T>::checked(Variable v) const {
+    if (v.index >= m_nodes.size()) {
+        throw std::invalid_argument("Variable does not belong to this tape.");
+    }
+    return v.index;
+}
+
+// Checks that v can be the input of a new operation, before any buffer is
+// taken for its result.
+template<typename T>
+std::size_t BasicTape<T>::operand(Variable v) const {
+    if (m_backwardDone) {
+        throw std::invalid_argument("Cannot record on a tape after backward(), clear() it first.");
+    }
+    return checked(v);
+}
+
+// Gradient buffer of node i, or null when it needs none. fresh is set when the
+// buffer holds no contribution yet and must be overwritten, not added to.
+template<typename T>
+NDArray<T>* BasicTape<T>::gradientTarget(std::size_t i, bool& fresh) {
+    Node& node = m_nodes[i];
+    if (!node.requiresGrad) {
+        return nullptr;
+    }
+    if (node.op == Op::Leaf) {
+        fresh = false;
+        return node.leafGrad;
+    }
+    fresh = !node.hasGrad;
+    if (fresh) {
+        node.grad = acquire(node.shape);
+        node.hasGrad = true;
+    }
+    return &node.grad;
+}
+
+// Adds g, of the shape of the consumer, into the gradient of node i.
+template<typename T>
+void BasicTape<T>::contribute(std::size_t i, const NDArrayView<const T>& g, bool negate) {
+    bool fresh;
+    NDArray<T>* target = gradientTarget(i, fresh);
+    if (target == nullptr) {
+        return;
+    }
+    if (g.shape() == m_nodes[i].shape) {
+        const T zero = T(0);
+        if (fresh && negate) {
+            broadcast_apply<ElementwiseSub, T>(NDArrayView<const T>(&zero, {}, {}), g, target->view());
+        } else if (fresh) {
+            target->view().assign(g);
+        } else if (negate) {
+            target->view() -= g;
+        } else {
+            target->view() += g;
+        }
+        return;
+    }
+    if (fresh) {
+        std::fill(target->data(), target->data() + target->size(), T(0));
+    }
+    reduceInto(g, m_nodes[i].shape, target->data(), negate);
+}
+
+// Adds x op y, of the given shape, into the gradient of node i, directly into
+// its buffer when it is the first contribution and needs no reduction.
+template<typename T>
+template<typename Kernel>
+void BasicTape<T>::contributeProduct(std::size_t i, const NDArrayView<const T>& x, const NDArrayView<const T>& y, const std::vector<std::size_t>& shape) {
+    const Node& node = m_nodes[i];
+    if (node.op != Op::Leaf && !node.hasGrad && node.shape == shape) {
+        bool fresh;
+        NDArray<T>* target = gradientTarget(i, fresh);
+        broadcast_apply<Kernel, T>(x, y, target->view());
+        return;
+    }
+    NDArray<T> scratch = acquire(shape);
+    broadcast_apply<Kernel, T>(x, y, scratch.view());
+    contribute(i, scratch.view());
+    release(scratch);
+}
+
+template<typename T>
+void BasicTape<T>::backwardOf(std::size_t j) {
+    const Node& node = m_nodes[j];
+    const NDArrayView<const T> g = node.grad.view();
+    const std::size_t a = node.inputs[0];
+    const std::size_t b = node.inputs[1];
+    switch (node.op) {
+        case Op::Leaf:
+            break;
+        case Op::Add:
+            contribute(a, g);
+            contribute(b, g);
+            break;
+        case Op::Sub:
+            contribute(a, g);
+            contribute(b, g, true);
+            break;
+        case Op::Mul:
+            if (m_nodes[a].requiresGrad) {
+                contributeProduct<ElementwiseMul>(a, g, valueOf(b).view(), node.shape);
+            }
+            if (m_nodes[b].requiresGrad) {
+                contributeProduct<ElementwiseMul>(b, g, valueOf(a).view(), node.shape);
+            }
+            break;
+        case Op::Div:
+            if (m_nodes[a].requiresGrad) {
+                contributeProduct<ElementwiseDiv>(a, g, valueOf(b).view(), node.shape);
+            }
+            if (m_nodes[b].requiresGrad) {
+                // d(a / b) / db = -a / b^2
+                NDArray<T> scratch = acquire(node.shape);
+                broadcast_apply<ElementwiseMul, T>(g, valueOf(a).view(), scratch.view());
+                scratch /= valueOf(b);
+                scratch /= valueOf(b);
+                contribute(b, scratch.view(), true);
+                release(scratch);
+            }
+            break;
+        case Op::MatMul: {
+            const std::size_t m = m_nodes[a].shape[0];
+            const std::size_t k = m_nodes[a].shape[1];
+            const std::size_t n = m_nodes[b].shape[1];
+            bool fresh;
+            // dA = G B^T and dB = A^T G, the transposes being read in place.
+            if (NDArray<T>* target = gradientTarget(a, fresh)) {
+                ::gemm(m, k, n, T(1), g.data(), n, 1, valueOf(b).data(), 1, n, fresh ? T(0) : T(1), target->data(), k, 1);
+            }
+            if (NDArray<T>* target = gradientTarget(b, fresh)) {
+                ::gemm(k, n, m, T(1), valueOf(a).data(), 1, k, g.data(), n, 1, fresh ? T(0) : T(1), target->data(), n, 1);
+            }
+            break;
+        }
+        case Op::Transpose: {
+            std::vector<std::size_t> inverse(node.axes.size());
+            for (std::size_t i = 0; i < node.axes.size(); i++) {
+                inverse[node.axes[i]] = i;
+            }
+            const Node& input = m_nodes[a];
+            if (input.requiresGrad && input.op != Op::Leaf && !input.hasGrad && node.shape.size() == 2 && node.axes[0] == 1) {
+                bool fresh;
+                NDArray<T>* target = gradientTarget(a, fresh);
+                ::transpose(node.shape[0], node.shape[1], g.data(), node.shape[1], target->data(), node.shape[0]);
+            } else {
+                contribute(a, g.transpose(inverse));
+            }
+            break;
+        }
+        case Op::Reshape:
+            contribute(a, g.reshape(m_nodes[a].shape));
+            break;
+        case Op::Activate: {
+            bool fresh;
+            NDArray<T>* target = gradientTarget(a, fresh);
+            if (target == nullptr) {
+                break;
+            }
+            // Only the value the derivative reads has been kept.
+            const T* saved = derivativeNeedsInput(node.activation) ? valueOf(a).data() : valueOf(j).data();
+            const T* d = g.data();
+            T* out = target->data();
+            dispatchActivation(node.activation, [&](auto activation) {
+                parallelFor(0, g.size(), parallelGrain, [&](std::size_t first, std::size_t last) {
+                    for (std::size_t i = first; i < last; i++) {
+                        const T v = d[i] * activateDerivative<decltype(activation)::value>(saved[i], saved[i]);
+                        out[i] = fresh ? v : out[i] + v;
+                    }
+                });
+            });
+            break;
+        }
+        case Op::Sum:
+        case Op::Mean: {
+            const std::vector<std::size_t>& shape = m_nodes[a].shape;
+            const T value = (node.op == Op::Sum) ? g.data()[0] : g.data()[0] / static_cast<T>(shape_size(shape));
+            contribute(a, NDArrayView<const T>(&value, shape, std::vector<std::ptrdiff_t>(shape.size(), 0)));
+            break;
+        }
+    }
+}
+
+template<typename T>
+template<typename Kernel>
+Variable BasicTape<T>::elementwise(Variable a, Variable b, Op op) {
+    const std::size_t i = operand(a);
+    const std::size_t j = operand(b);
+    std::vector<std::size_t> shape = broadcast_shapes(m_nodes[i].shape, m_nodes[j].shape);
+    NDArray<T> out = acquire(shape);
+    broadcast_apply<Kernel, T>(valueOf(i).view(), valueOf(j).view(), out.view());
+    const std::size_t k = push(op, i, j, std::move(shape));
+    m_nodes[k].value = std::move(out);
+    if (op == Op::Mul || op == Op::Div) {
+        // Each operand's gradient reads the other; that of a divisor also
+        // reads the dividend.
+        if (m_nodes[i].requiresGrad || (op == Op::Div && m_nodes[j].requiresGrad)) {
+            save(k, j);
+        }
+        if (m_nodes[j].requiresGrad) {
+            save(k, i);
+        }
+    }
+    return Variable{k};
+}
+
+// Other members
+
+template<typename T>
+Variable BasicTape<T>::constant(const NDArray<T>& value) {
+    if (value.format() != MemoryFormat::RowMajor) {
+        throw std::invalid_argument("Tape leaves must be row-major.");
+    }
+    const std::size_t k = push(Op::Leaf, none, none, value.shape());
+    m_nodes[k].leafValue = &value;
+    return Variable{k};
+}
+
+template<typename T>
+Variable BasicTape<T>::parameter(const NDArray<T>& value, NDArray<T>& grad) {
+    if (grad.shape() != value.shape()) {
+        throw std::invalid_argument("Gradient buffer must have the shape of its parameter.");
+    }
+    if (value.format() != MemoryFormat::RowMajor || grad.format() != MemoryFormat::RowMajor) {
+        throw std::invalid_argument("Tape leaves must be row-major.");
+    }
+    const std::size_t k = push(Op::Leaf, none, none, value.shape());
+    m_nodes[k].leafValue = &value;
+    m_nodes[k].leafGrad = &grad;
+    m_nodes[k].requiresGrad = true;
+    return Variable{k};
+}
+
+template<typename T>
+Variable BasicTape<T>::add(Variable a, Variable b) {
+    return elementwise<ElementwiseAdd>(a, b, Op::Add);
+}
+
+template<typename T>
+Variable BasicTape<T>::sub(Variable a, Variable b) {
+    return elementwise<ElementwiseSub>(a, b, Op::Sub);
+}
+
+template<typename T>
+Variable BasicTape<T>::mul(Variable a, Variable b) {
+    return elementwise<ElementwiseMul>(a, b, Op::Mul);
+}
+
+template<typename T>
+Variable BasicTape<T>::div(Variable a, Variable b) {
+    return elementwise<ElementwiseDiv>(a, b, Op::Div);
+}
+
+template<typename T>
+Variable BasicTape<T>::matmul(Variable a, Variable b) {
+    const std::size_t i = operand(a);
+    const std::size_t j = operand(b);
+    const std::vector<std::size_t>& sa = m_nodes[i].shape;
+    const std::vector<std::size_t>& sb = m_nodes[j].shape;
+    if (sa.size() != 2 || sb.size() != 2 || sa[1] != sb[0]) {
+        throw std::invalid_argument("Variables do not have the right dimensions for matmul.");
+    }
+    const std::size_t m = sa[0];
+    const std::size_t k = sa[1];
+    const std::size_t n = sb[1];
+    NDArray<T> out = acquire({m, n});
+    ::gemm(m, n, k, T(1), valueOf(i).data(), k, 1, valueOf(j).data(), n, 1, T(0), out.data(), n, 1);
+    const std::size_t r = push(Op::MatMul, i, j, {m, n});
+    m_nodes[r].value = std::move(out);
+    if (m_nodes[i].requiresGrad) {
+        save(r, j);
+    }
+    if (m_nodes[j].requiresGrad) {
+        save(r, i);
+    }
+    return Variable{r};
+}
+
+template<typename T>
+Variable BasicTape<T>::transpose(Variable a) {
+    std::vector<std::size_t> axes(m_nodes[operand(a)].shape.size());
+    for (std::size_t i = 0; i < axes.size(); i++) {
+        axes[i] = axes.size() - 1 - i;
+    }
+    return transpose(a, axes);
+}
+
+template<typename T>
+Variable BasicTape<T>::transpose(Variable a, const std::vector<std::size_t>& axes) {
+    const std::size_t i = operand(a);
+    const NDArrayView<const T> source = valueOf(i).view().transpose(axes);
+    NDArray<T> out = acquire(source.shape());
+    if (source.dim() == 2 && axes[0] == 1) {
+        ::transpose(source.shape()[1], source.shape()[0], source.data(), source.shape()[0], out.data(), source.shape()[1]);
+    } else {
+        out.view().assign(source);
+    }
+    const std::size_t r = push(Op::Transpose, i, none, source.shape());
+    m_nodes[r].value = std::move(out);
+    m_nodes[r].axes = axes;
+    return Variable{r};
+}
+
+template<typename T>
+Variable BasicTape<T>::reshape(Variable a, const std::vector<std::size_t>& shape) {
+    const std::size_t i = operand(a);
+    if (shape_size(shape) != shape_size(m_nodes[i].shape)) {
+        throw std::invalid_argument("Cannot reshape Variable to given shape.");
+    }
+    NDArray<T> out = acquire(shape);
+    std::copy(valueOf(i).data(), valueOf(i).data() + out.size(), out.data());
+    const std::size_t r = push(Op::Reshape, i, none, shape);
+    m_nodes[r].value = std::move(out);
+    return Variable{r};
+}
+
+template<typename T>
+Variable BasicTape<T>::activate(Variable a, Activation activation) {
+    const std::size_t i = operand(a);
+    NDArray<T> out = acquire(m_nodes[i].shape);
+    const T* source = valueOf(i).data();
+    T* target = out.data();
+    parallelFor(0, out.size(), parallelGrain, [&](std::size_t first, std::size_t last) {
+        std::copy(source + first, source + last, target + first);
+        ::activate(activation, target + first, last - first);
+    });
+    const std::size_t r = push(Op::Activate, i, none, m_nodes[i].shape);
+    m_nodes[r].value = std::move(out);
+    m_nodes[r].activation = activation;
+    if (m_nodes[r].requiresGrad) {
+        save(r, derivativeNeedsInput(activation) ? i : r);
+    }
+    return Variable{r};
+}
+
+template<typename T>
+Variable BasicTape<T>::sum(Variable a) {
+    const std::size_t i = operand(a);
+    NDArray<T> out = acquire({});
+    out.data()[0] = valueOf(i).sum();
+    const std::size_t r = push(Op::Sum, i, none, {});
+    m_nodes[r].value = std::move(out);
+    return Variable{r};
+}
+
+template<typename T>
+Variable BasicTape<T>::mean(Variable a) {
+    const std::size_t i = operand(a);
+    NDArray<T> out = acquire({});
+    out.data()[0] = valueOf(i).sum() / static_cast<T>(shape_size(m_nodes[i].shape));
+    const std::size_t r = push(Op::Mean, i, none, {});
+    m_nodes[r].value = std::move(out);
+    return Variable{r};
+}
+
+template<typename T>
+const NDArray<T>& BasicTape<T>::value(Variable v) const {
+    const std::size_t i = checked(v);
+    if (m_nodes[i].released) {
+        throw std::invalid_argument("The value of this Variable was released by backward(), retain() it first.");
+    }
+    return valueOf(i);
+}
+
+template<typename T>
+const std::vector<std::size_t>& BasicTape<T>::shape(Variable v) const {
+    return m_nodes[checked(v)].shape;
+}
+
+template<typename T>
+void BasicTape<T>::retain(Variable v) {
+    m_nodes[checked(v)].retained = true;
+}
+
+template<typename T>
+void BasicTape<T>::backward(Variable root) {
+    const std::size_t r = checked(root);
+    if (m_backwardDone) {
+        throw std::invalid_argument("backward() was already called on this recording.");
+    }
+    if (shape_size(m_nodes[r].shape) != 1) {
+        throw std::invalid_argument("backward() needs a root with a single element.");
+    }
+    if (!m_nodes[r].requiresGrad) {
+        throw std::invalid_argument("The root of backward() does not depend on any parameter.");
+    }
+    m_backwardDone = true;
+    auto releaseValue = [&](std::size_t i) {
+        Node& node = m_nodes[i];
+        if (node.op != Op::Leaf && !node.retained && !node.released && i != r) {
+            release(node.value);
+            node.released = true;
+        }
+    };
+    // Operations recorded after the root take no part.
+    for (std::size_t j = r + 1; j < m_nodes.size(); j++) {
+        for (std::size_t s : m_nodes[j].saved) {
+            m_nodes[s].uses--;
+        }
+    }
+    for (std::size_t i = 0; i <= r; i++) {
+        if (m_nodes[i].uses == 0) {
+            releaseValue(i);
+        }
+    }
+
+    m_nodes[r].grad = acquire(m_nodes[r].shape);
+    m_nodes[r].grad.data()[0] = T(1);
+    m_nodes[r].hasGrad = true;
+    for (std::size_t j = r + 1; j-- > 0;) {
+        Node& node = m_nodes[j];
+        if (node.op == Op::Leaf || !node.requiresGrad) {
+            continue;
+        }
+        if (node.hasGrad) {
+            backwardOf(j);
+        }
+        for (std::size_t s : node.saved) {
+            if (--m_nodes[s].uses == 0) {
+                releaseValue(s);
+            }
+        }
+        if (node.hasGrad) {
+            release(node.grad);
+            node.hasGrad = false;
+        }
+    }
+}
+
+template<typename T>
+void BasicTape<T>::clear() {
+    for (Node& node : m_nodes) {
+        if (node.op != Op::Leaf && !node.released) {
+            release(node.value);
+        }
+        if (node.hasGrad) {
+            release(node.grad);
+        }
+    }
+    m_nodes.clear();
+    m_peakBytes = m_liveBytes;
+    m_backwardDone = false;
+}
+
+template<typename T>
+void BasicTape<T>::trim() {
+    m_pool.clear();
+    m_pooledBytes = 0;
+}
+
+template<typename T>
+std::size_t BasicTape<T>::size() const {
+    return m_nodes.size();
+}
+
+template<typename T>
+std::size_t BasicTape<T>::liveBytes() const {
+    return m_liveBytes;
+}
+
+template<typename T>
+std::size_t BasicTape<T>::peakBytes() const {
+    return m_peakBytes;
+}
+
+template<typename T>
+std::size_t BasicTape<T>::pooledBytes() const {
+    return m_pooledBytes;
+}
+
+// Instantiations
+
+template class BasicTape<double>;
+template class BasicTape<float>;
+
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include "gemm/Epilogue.hpp"
+#include "ndarray/NDArray.hpp"
+
+namespace autograd {
+
+// Handle to a value recorded on a tape.
+struct Variable {
+    std::size_t index;
+};
+
+// Reverse-mode automatic differentiation over NDArray. Operations are
+// computed as they are recorded; backward() then walks the tape from a scalar
+// root to its leaves and accumulates gradients into the buffers given to
+// parameter().
+//
+// Memory follows liveness: each operation records which values its backward
+// kernel reads, and an intermediate value goes back to the tape's buffer pool
+// as soon as the last kernel reading it has run (values no kernel reads go
+// back when backward() starts). Gradients of intermediates are released right
+// after they have been propagated. clear() keeps the pool, so a training loop
+// that records the same graph every step stops allocating after the first.
+template<typename T>
+class BasicTape {
+
+    enum class Op {
+        Leaf,
+        Add,
+        Sub,
+        Mul,
+        Div,
+        MatMul,
+        Transpose,
+        Reshape,
+        Activate,
+        Sum,
+        Mean
+    };
+
+    struct Node {
+        Op op;
+        std::size_t inputs[2];
+        std::vector<std::size_t> shape;
+        // Intermediate values are owned, leaves point to the caller's arrays.
+        NDArray<T> value;
+        const NDArray<T>* leafValue;
+        NDArray<T>* leafGrad;
+        NDArray<T> grad;
+        bool hasGrad;
+        bool requiresGrad;
+        bool retained;
+        bool released;
+        // Values read by the backward kernel of this node.
+        std::vector<std::size_t> saved;
+        // Backward kernels still to run that read this value.
+        std::size_t uses;
+        std::vector<std::size_t> axes;
+        Activation activation;
+    };
+
+    std::vector<Node> m_nodes;
+    // Released buffers by number of elements.
+    std::unordered_map<std::size_t, std::vector<NDArray<T>>> m_pool;
+    std::size_t m_liveBytes;
+    std::size_t m_peakBytes;
+    std::size_t m_pooledBytes;
+    bool m_backwardDone;
+
+    NDArray<T> acquire(const std::vector<std::size_t>& shape);
+    void release(NDArray<T>& buffer);
+
+    std::size_t push(Op op, std::size_t a, std::size_t b, std::vector<std::size_t> shape);
+    void save(std::size_t node, std::size_t input);
+    const NDArray<T>& valueOf(std::size_t i) const;
+    std::size_t checked(Variable v) const;
+    std::size_t operand(Variable v) const;
+
+    NDArray<T>* gradientTarget(std::size_t i, bool& fresh);
+    void contribute(std::size_t i, const NDArrayView<const T>& g, bool negate = false);
+    template<typename Kernel>
+    void contributeProduct(std::size_t i, const NDArrayView<const T>& x, const NDArrayView<const T>& y, const std::vector<std::size_t>& shape);
+    void backwardOf(std::size_t j);
+
+    template<typename Kernel>
+    Variable elementwise(Variable a, Variable b, Op op);
+
+public:
+
+    // Constructors
+    BasicTape();
+    BasicTape(const BasicTape&) = delete;
+    BasicTape& operator=(const BasicTape&) = delete;
+
+    // Other members
+    // Leaves, which must be row-major. The arrays are not copied and must
+    // outlive the tape's use of them. backward() adds into grad, which has
+    // the shape of value: zero it between steps.
+    Variable constant(const NDArray<T>& value);
+    Variable parameter(const NDArray<T>& value, NDArray<T>& grad);
+
+    // Elementwise operations broadcast as the NDArray operators do.
+    Variable add(Variable a, Variable b);
+    Variable sub(Variable a, Variable b);
+    Variable mul(Variable a, Variable b);
+    Variable div(Variable a, Variable b);
+    // Matrix product of two arrays of rank 2.
+    Variable matmul(Variable a, Variable b);
+    Variable transpose(Variable a);
+    Variable transpose(Variable a, const std::vector<std::size_t>& axes);
+    Variable reshape(Variable a, const std::vector<std::size_t>& shape);
+    Variable activate(Variable a, Activation activation);
+    // Reductions of every element to an array of rank 0.
+    Variable sum(Variable a);
+    Variable mean(Variable a);
+
+    // Throws if backward() has released the value, unless it was retained.
+    const NDArray<T>& value(Variable v) const;
+    const std::vector<std::size_t>& shape(Variable v) const;
+    // Keeps the value of v through backward().
+    void retain(Variable v);
+
+    // root must hold a single element. Can be called once per recording.
+    void backward(Variable root);
+
+    // Forgets every operation, keeping the buffers for the next recording.
+    void clear();
+    // Frees the pooled buffers.
+    void trim();
+
+    std::size_t size() const;
+    // Bytes of values and gradients held by operations, its highest value
+    // since the last clear(), and bytes waiting in the pool.
+    std::size_t liveBytes() const;
+    std::size_t peakBytes() const;
+    std::size_t pooledBytes() const;
+
+};
+
+using Tape = BasicTape<double>;
+using FloatTape = BasicTape<float>;
+
+}
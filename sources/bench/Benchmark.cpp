@@ -0,0 +1,434 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <regex>
+#include <stdexcept>
+#include <string>
+
+#include "bench/Benchmark.hpp"
+#include "memory/AlignedAllocator.hpp"
+#include "parallel/ThreadPool.hpp"
+#include "profile/Profiler.hpp"
+#include "simd/Simd.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string filter = ".*";
+    double minTime = 0.2;
+    std::size_t repetitions = 1;
+    std::string json;
+    double peakGflops = 0;
+    double peakGbs = 0;
+    bool list = false;
+    bool profile = false;
+    std::string trace;
+    bool help = false;
+};
+
+struct Result {
+    std::string name;
+    std::string label;
+    std::size_t iterations;
+    double seconds;
+    double gflops;
+    double gflopsPeak;
+    double gbs;
+};
+
+static std::vector<std::unique_ptr<bench::Benchmark>>& registry() {
+    static std::vector<std::unique_ptr<bench::Benchmark>> benchmarks;
+    return benchmarks;
+}
+
+static void printUsage(std::ostream& out, const char* program) {
+    out << "Usage: " << program << " [options]\n"
+        << "  --filter=REGEX       only the benchmarks whose full name matches (.*)\n"
+        << "  --min-time=SECONDS   minimum duration of a measured run (0.2)\n"
+        << "  --repetitions=N      measured runs per benchmark, the median is kept (1)\n"
+        << "  --json=FILE          also write the results as JSON\n"
+        << "  --peak-gflops=X      double precision peak, instead of the estimate\n"
+        << "  --peak-gbs=X         memory bandwidth peak, instead of the measured one\n"
+        << "  --list               print the benchmark names and exit\n"
+        << "  --profile            print the per-operation counters at the end\n"
+        << "  --trace=FILE         write a Chrome trace of the instrumented operations\n"
+        << "  --help               print this message and exit\n"
+        << "--profile and --trace need a build with NN_ENABLE_PROFILING.\n";
+}
+
+static Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const std::string option(argv[i]);
+        const std::size_t equal = option.find('=');
+        const std::string key = option.substr(0, equal);
+        const std::string value = (equal == std::string::npos) ? "" : option.substr(equal + 1);
+        if (key == "--filter") {
+            options.filter = value;
+        } else if (key == "--min-time") {
+            options.minTime = std::stod(value);
+        } else if (key == "--repetitions") {
+            options.repetitions = std::max<std::size_t>(1, std::stoul(value));
+        } else if (key == "--json") {
+            options.json = value;
+        } else if (key == "--peak-gflops") {
+            options.peakGflops = std::stod(value);
+        } else if (key == "--peak-gbs") {
+            options.peakGbs = std::stod(value);
+        } else if (key == "--list") {
+            options.list = true;
+        } else if (key == "--profile") {
+            options.profile = true;
+        } else if (key == "--trace") {
+            options.trace = value;
+        } else if (key == "--help" || key == "-h") {
+            options.help = true;
+        } else {
+            throw std::invalid_argument("Unknown option " + option + ", see --help.");
+        }
+    }
+    return options;
+}
+
+// Nominal frequency of the first core in GHz, or 0 when the system does not
+// tell.
+static double cpuGhz() {
+    std::ifstream maxFrequency("/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq");
+    double khz = 0;
+    if (maxFrequency >> khz && khz > 0) {
+        return khz / 1e6;
+    }
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.rfind("cpu MHz", 0) == 0) {
+            return std::stod(line.substr(line.find(':') + 1)) / 1e3;
+        }
+    }
+    return 0;
+}
+
+static std::size_t vectorBytes(simd::Isa isa) {
+    switch (isa) {
+        case simd::Isa::Scalar: return 8;
+        case simd::Isa::Sse2: return 16;
+        case simd::Isa::Avx2: return 32;
+        case simd::Isa::Avx512: return 64;
+    }
+    return 8;
+}
+
+// Double precision peak: two FMA pipes per core from AVX2 on, one add and
+// one multiply before.
+static double estimatePeakGflops(double ghz) {
+    const simd::Isa isa = simd::activeIsa();
+    const double lanes = static_cast<double>(vectorBytes(isa) / sizeof(double));
+    const double flopsPerCycle = (isa >= simd::Isa::Avx2) ? 2 * 2 * lanes : 2 * lanes;
+    return static_cast<double>(nbThreads()) * ghz * flopsPerCycle;
+}
+
+// STREAM triad over buffers well beyond the last level cache, best of five.
+static double measurePeakGbs() {
+    using Buffer = std::vector<double, AlignedAllocator<double>>;
+    const std::size_t n = std::size_t(1) << 23;
+    Buffer a(n, 1.0);
+    Buffer b(n, 2.0);
+    Buffer c(n, 3.0);
+    double best = 0;
+    for (int run = 0; run < 5; run++) {
+        const Clock::time_point start = Clock::now();
+        parallelFor(0, n, parallelGrain, [&](std::size_t first, std::size_t last) {
+            for (std::size_t i = first; i < last; i++) {
+                a[i] = b[i] + 3.0 * c[i];
+            }
+        });
+        bench::clobberMemory();
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        best = std::max(best, 3.0 * n * sizeof(double) / seconds / 1e9);
+    }
+    return best;
+}
+
+static std::string fullName(const bench::Benchmark& benchmark, const std::vector<std::int64_t>& args) {
+    std::string name = benchmark.name();
+    for (std::int64_t arg : args) {
+        name += '/';
+        name += std::to_string(arg);
+    }
+    return name;
+}
+
+static double timeRun(const bench::Function& function, const std::vector<std::int64_t>& args, std::size_t iterations, bench::State& state) {
+    state = bench::State(args, iterations);
+    function(state);
+    if (state.seconds() < 0) {
+        throw std::logic_error("Benchmark did not run its State loop.");
+    }
+    return state.seconds();
+}
+
+// Grows the iteration count until a run lasts minTime, then measures.
+static Result measure(const bench::Benchmark& benchmark, const std::vector<std::int64_t>& args, const Options& options, double peakGflops) {
+    bench::State state(args, 1);
+    std::size_t iterations = 1;
+    double seconds = timeRun(benchmark.function(), args, iterations, state);
+    while (seconds < options.minTime && iterations < (std::size_t(1) << 40)) {
+        const double scale = (seconds <= 0) ? 10 : std::min(10.0, 1.4 * options.minTime / seconds);
+        iterations = std::max(iterations + 1, static_cast<std::size_t>(static_cast<double>(iterations) * scale));
+        seconds = timeRun(benchmark.function(), args, iterations, state);
+    }
+    std::vector<double> perIteration{seconds / static_cast<double>(iterations)};
+    for (std::size_t r = 1; r < options.repetitions; r++) {
+        perIteration.push_back(timeRun(benchmark.function(), args, iterations, state) / static_cast<double>(iterations));
+    }
+    std::nth_element(perIteration.begin(), perIteration.begin() + perIteration.size() / 2, perIteration.end());
+    const double time = perIteration[perIteration.size() / 2];
+    const double typePeak = peakGflops * sizeof(double) / static_cast<double>(state.flopBytes());
+    return Result{
+        fullName(benchmark, args), state.label(), iterations, time,
+        state.flops() / time / 1e9, typePeak, state.bytes() / time / 1e9
+    };
+}
+
+static std::string rate(double value) {
+    if (value <= 0) {
+        return "";
+    }
+    char text[16];
+    std::snprintf(text, sizeof(text), "%.2f", value);
+    return text;
+}
+
+static std::string percent(double value, double peak) {
+    if (value <= 0 || peak <= 0) {
+        return "";
+    }
+    char text[16];
+    std::snprintf(text, sizeof(text), "%.1f%%", 100 * value / peak);
+    return text;
+}
+
+static std::string jsonString(const std::string& text) {
+    std::string result = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+        }
+        result += c;
+    }
+    return result + "\"";
+}
+
+static void writeJson(const std::string& path, const std::vector<Result>& results, double ghz, double peakGflops, double peakGbs) {
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error("Cannot open '" + path + "' for writing.");
+    }
+    char date[32];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    file << "{\n  \"context\": {\n"
+         << "    \"date\": " << jsonString(date) << ",\n"
+         << "    \"isa\": " << jsonString(simd::isaName(simd::activeIsa())) << ",\n"
+         << "    \"threads\": " << nbThreads() << ",\n"
+         << "    \"cpu_ghz\": " << ghz << ",\n"
+         << "    \"peak_gflops_f64\": " << peakGflops << ",\n"
+         << "    \"peak_gbs\": " << peakGbs << ",\n"
+#ifdef __VERSION__
+         << "    \"compiler\": " << jsonString(__VERSION__) << ",\n"
+#endif
+#ifdef NDEBUG
+         << "    \"assertions\": false\n"
+#else
+         << "    \"assertions\": true\n"
+#endif
+         << "  },\n  \"benchmarks\": [";
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        file << (i == 0 ? "\n" : ",\n")
+             << "    {\"name\": " << jsonString(r.name)
+             << ", \"label\": " << jsonString(r.label)
+             << ", \"iterations\": " << r.iterations
+             << ", \"time_ns\": " << r.seconds * 1e9
+             << ", \"gflops\": " << r.gflops
+             << ", \"gflops_peak\": " << r.gflopsPeak
+             << ", \"gbs\": " << r.gbs
+             << ", \"gbs_peak\": " << peakGbs << "}";
+    }
+    file << "\n  ]\n}\n";
+}
+
+namespace bench {
+
+// State
+
+State::State(std::vector<std::int64_t> args, std::size_t iterations) :
+    m_args(std::move(args)), m_iterations(iterations), m_start(), m_seconds(-1), m_flops(0), m_flopBytes(sizeof(double)), m_bytes(0), m_label()
+{}
+
+std::int64_t State::arg(std::size_t i) const {
+    if (i >= m_args.size()) {
+        throw std::invalid_argument("Benchmark argument out of range.");
+    }
+    return m_args[i];
+}
+
+std::size_t State::iterations() const {
+    return m_iterations;
+}
+
+double State::seconds() const {
+    return m_seconds;
+}
+
+void State::setFlops(double flops, std::size_t elementBytes) {
+    m_flops = flops;
+    m_flopBytes = elementBytes;
+}
+
+void State::setBytes(double bytes) {
+    m_bytes = bytes;
+}
+
+void State::setLabel(std::string label) {
+    m_label = std::move(label);
+}
+
+double State::flops() const {
+    return m_flops;
+}
+
+std::size_t State::flopBytes() const {
+    return m_flopBytes;
+}
+
+double State::bytes() const {
+    return m_bytes;
+}
+
+const std::string& State::label() const {
+    return m_label;
+}
+
+// Benchmark
+
+Benchmark::Benchmark(std::string name, Function function) :
+    m_name(std::move(name)), m_function(std::move(function)), m_args()
+{}
+
+Benchmark* Benchmark::arg(std::int64_t value) {
+    m_args.push_back({value});
+    return this;
+}
+
+Benchmark* Benchmark::args(std::vector<std::int64_t> values) {
+    m_args.push_back(std::move(values));
+    return this;
+}
+
+Benchmark* Benchmark::range(std::int64_t low, std::int64_t high, std::int64_t multiplier) {
+    if (low <= 0 || high < low || multiplier < 2) {
+        throw std::invalid_argument("Invalid benchmark range.");
+    }
+    std::int64_t value = low;
+    for (; value < high; value *= multiplier) {
+        m_args.push_back({value});
+    }
+    m_args.push_back({high});
+    return this;
+}
+
+const std::string& Benchmark::name() const {
+    return m_name;
+}
+
+const Function& Benchmark::function() const {
+    return m_function;
+}
+
+const std::vector<std::vector<std::int64_t>>& Benchmark::argumentSets() const {
+    return m_args;
+}
+
+// Functions
+
+Benchmark* registerBenchmark(std::string name, Function function) {
+    registry().push_back(std::make_unique<Benchmark>(std::move(name), std::move(function)));
+    return registry().back().get();
+}
+
+int run(int argc, char** argv) {
+    Options options;
+    try {
+        options = parseOptions(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    if (options.help) {
+        printUsage(std::cout, argv[0]);
+        return 0;
+    }
+
+    const std::regex filter(options.filter);
+    std::vector<std::pair<const Benchmark*, std::vector<std::int64_t>>> selected;
+    for (const std::unique_ptr<Benchmark>& benchmark : registry()) {
+        std::vector<std::vector<std::int64_t>> sets = benchmark->argumentSets();
+        if (sets.empty()) {
+            sets.emplace_back();
+        }
+        for (const std::vector<std::int64_t>& args : sets) {
+            if (std::regex_search(fullName(*benchmark, args), filter)) {
+                selected.emplace_back(benchmark.get(), args);
+            }
+        }
+    }
+    if (options.list) {
+        for (const auto& [benchmark, args] : selected) {
+            std::cout << fullName(*benchmark, args) << "\n";
+        }
+        return 0;
+    }
+
+    const double ghz = cpuGhz();
+    const double peakGflops = (options.peakGflops > 0) ? options.peakGflops : estimatePeakGflops(ghz);
+    const double peakGbs = (options.peakGbs > 0) ? options.peakGbs : measurePeakGbs();
+    std::printf(
+        "isa %s, %zu threads, %.2f GHz, peak %.1f GFLOP/s (double), %.1f GB/s%s\n",
+        simd::isaName(simd::activeIsa()), nbThreads(), ghz, peakGflops, peakGbs,
+        (options.peakGbs > 0) ? "" : " (measured triad)"
+    );
+    std::printf("%-40s %14s %12s %10s %7s %10s %7s\n", "Benchmark", "Time (ns)", "Iterations", "GFLOP/s", "%flops", "GB/s", "%mem");
+
+    profile::reset();
+    profile::setTracing(!options.trace.empty());
+    std::vector<Result> results;
+    for (const auto& [benchmark, args] : selected) {
+        const Result r = measure(*benchmark, args, options, peakGflops);
+        std::printf(
+            "%-40s %14.1f %12zu %10s %7s %10s %7s %s\n",
+            r.name.c_str(), r.seconds * 1e9, r.iterations, rate(r.gflops).c_str(), percent(r.gflops, r.gflopsPeak).c_str(),
+            rate(r.gbs).c_str(), percent(r.gbs, peakGbs).c_str(), r.label.c_str()
+        );
+        std::fflush(stdout);
+        results.push_back(r);
+    }
+
+    if (!options.json.empty()) {
+        writeJson(options.json, results, ghz, peakGflops, peakGbs);
+    }
+    if (options.profile) {
+        std::cout << "\n";
+        profile::printSummary(std::cout);
+    }
+    if (!options.trace.empty()) {
+        profile::writeChromeTrace(options.trace);
+    }
+    return 0;
+}
+
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Micro-benchmark harness in the style of Google Benchmark, without the
+// dependency.
+//
+//     static void vectorAdd(bench::State& state) {
+//         Vector a(state.arg(0)), b(state.arg(0)), out(state.arg(0));
+//         for ([[maybe_unused]] auto _ : state) {
+//             add(a, b, out);
+//             bench::doNotOptimize(out.data());
+//         }
+//         state.setFlops(a.size());
+//         state.setBytes(3 * a.size() * sizeof(double));
+//     }
+//     BENCHMARK(vectorAdd)->range(1 << 10, 1 << 24);
+//
+// Each benchmark runs with an iteration count grown until one run lasts at
+// least the minimum time. The reported time is the wall time per iteration
+// of the loop over the State only, without the setup before it. The flop
+// and byte counts per iteration give GFLOP/s and GB/s, which are also
+// reported as a fraction of the machine's peak: the arithmetic peak
+// estimated from the clock and the active instruction set, and the memory
+// bandwidth of a STREAM triad. Operands that stay in cache can exceed the
+// latter.
+namespace bench {
+
+class State {
+
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<std::int64_t> m_args;
+    std::size_t m_iterations;
+    Clock::time_point m_start;
+    double m_seconds;
+    double m_flops;
+    std::size_t m_flopBytes;
+    double m_bytes;
+    std::string m_label;
+
+public:
+
+    // Range-for over the State runs the timed loop: begin() starts the clock
+    // and the comparison that ends the loop stops it.
+    struct Iterator {
+        State* state;
+        std::size_t remaining;
+        bool operator!=(const Iterator& other) const {
+            if (remaining != other.remaining) {
+                return true;
+            }
+            state->m_seconds = std::chrono::duration<double>(Clock::now() - state->m_start).count();
+            return false;
+        }
+        void operator++() { remaining--; }
+        int operator*() const { return 0; }
+    };
+
+    // Constructors
+    State(std::vector<std::int64_t> args, std::size_t iterations);
+
+    // Other members
+    Iterator begin() {
+        m_start = Clock::now();
+        return Iterator{this, m_iterations};
+    }
+    Iterator end() { return Iterator{this, 0}; }
+    std::int64_t arg(std::size_t i = 0) const;
+    std::size_t iterations() const;
+    // Duration of the timed loop in seconds, negative until it has run.
+    double seconds() const;
+    // Floating point operations per iteration, on elements of elementBytes
+    // bytes (the peak depends on how many fit in a register).
+    void setFlops(double flops, std::size_t elementBytes = sizeof(double));
+    // Bytes moved to or from memory per iteration.
+    void setBytes(double bytes);
+    void setLabel(std::string label);
+    double flops() const;
+    std::size_t flopBytes() const;
+    double bytes() const;
+    const std::string& label() const;
+
+};
+
+using Function = std::function<void(State&)>;
+
+class Benchmark {
+
+    std::string m_name;
+    Function m_function;
+    std::vector<std::vector<std::int64_t>> m_args;
+
+public:
+
+    // Constructors
+    Benchmark(std::string name, Function function);
+
+    // Other members
+    // One run per call, with the given arguments.
+    Benchmark* arg(std::int64_t value);
+    Benchmark* args(std::vector<std::int64_t> values);
+    // One run per power of multiplier from low to high, high included.
+    Benchmark* range(std::int64_t low, std::int64_t high, std::int64_t multiplier = 8);
+    const std::string& name() const;
+    const Function& function() const;
+    const std::vector<std::vector<std::int64_t>>& argumentSets() const;
+
+};
+
+Benchmark* registerBenchmark(std::string name, Function function);
+
+// Runs the registered benchmarks. Options:
+//   --filter=REGEX       only the benchmarks whose full name matches
+//   --min-time=SECONDS   minimum duration of a measured run (0.2)
+//   --repetitions=N      measured runs per benchmark, the median is kept (1)
+//   --json=FILE          also write the results as JSON
+//   --peak-gflops=X      double precision peak, instead of the estimate
+//   --peak-gbs=X         memory bandwidth peak, instead of the measured one
+//   --list               print the benchmark names and exit
+//   --profile            print the per-operation counters at the end
+//   --trace=FILE         write a Chrome trace of the instrumented operations
+//   --help               print the options and exit
+// --profile and --trace need a build with NN_ENABLE_PROFILING.
+int run(int argc, char** argv);
+
+// Keeps the compiler from discarding a computation whose result is unused.
+template<typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Forces pending stores to memory to be considered observable.
+inline void clobberMemory() {
+    asm volatile("" : : : "memory");
+}
+
+}
+
+#define BENCHMARK_CONCAT_IMPL(a, b) a##b
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT_IMPL(a, b)
+#define BENCHMARK(function) \
+    [[maybe_unused]] static bench::Benchmark* BENCHMARK_CONCAT(benchmark_, __LINE__) = \
+        bench::registerBenchmark(#function, function)
+#define BENCHMARK_TEMPLATE(function, T) \
+    [[maybe_unused]] static bench::Benchmark* BENCHMARK_CONCAT(benchmark_, __LINE__) = \
+        bench::registerBenchmark(#function "<" #T ">", function<T>)
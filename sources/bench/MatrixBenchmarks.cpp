@@ -0,0 +1,134 @@
+#include <cstdint>
+#include <vector>
+
+#include "bench/Benchmark.hpp"
+#include "gemm/Gemm.hpp"
+#include "matrix/Matrix.hpp"
+
+// Square matrices of side 16 to 8192.
+static constexpr std::int64_t smallest = 16;
+static constexpr std::int64_t largest = 8192;
+
+template<typename T>
+static BasicMatrix<T> filledMatrix(std::size_t n) {
+    BasicMatrix<T> m(n, n);
+    for (std::size_t i = 0; i < n; i++) {
+        for (std::size_t j = 0; j < n; j++) {
+            m(i, j) = static_cast<T>((i * 7 + j * 3) % 11) / T(11);
+        }
+    }
+    return m;
+}
+
+template<typename T>
+static void matrixDot(bench::State& state) {
+    const std::size_t n = state.arg();
+    const BasicMatrix<T> a = filledMatrix<T>(n);
+    const BasicMatrix<T> b = filledMatrix<T>(n);
+    BasicMatrix<T> out(n, n);
+    for ([[maybe_unused]] auto _ : state) {
+        dot(a, b, out);
+        bench::doNotOptimize(out.data());
+    }
+    state.setFlops(2.0 * n * n * n, sizeof(T));
+    state.setBytes(3.0 * n * n * sizeof(T));
+}
+BENCHMARK_TEMPLATE(matrixDot, double)->range(smallest, largest, 4);
+BENCHMARK_TEMPLATE(matrixDot, float)->range(smallest, largest, 4);
+
+// Integer operations, counted as flops on 16-bit lanes since the kernel
+// multiplies int16 pairs.
+static void matrixDotInt8(bench::State& state) {
+    const std::size_t n = state.arg();
+    std::vector<std::int8_t> a(n * n);
+    std::vector<std::int8_t> b(n * n);
+    std::vector<std::int32_t> c(n * n);
+    for (std::size_t i = 0; i < n * n; i++) {
+        a[i] = static_cast<std::int8_t>(i % 251 - 125);
+        b[i] = static_cast<std::int8_t>(i % 241 - 120);
+    }
+    for ([[maybe_unused]] auto _ : state) {
+        gemm(n, n, n, a.data(), n, 1, b.data(), n, 1, c.data(), n, 1);
+        bench::doNotOptimize(c.data());
+    }
+    state.setFlops(2.0 * n * n * n, sizeof(std::int16_t));
+    state.setBytes(2.0 * n * n + 4.0 * n * n);
+}
+BENCHMARK(matrixDotInt8)->range(smallest, largest, 4);
+
+template<typename T>
+static void matrixVectorDot(bench::State& state) {
+    const std::size_t n = state.arg();
+    const BasicMatrix<T> a = filledMatrix<T>(n);
+    const BasicVector<T> x(n, T(1));
+    BasicVector<T> y(n);
+    for ([[maybe_unused]] auto _ : state) {
+        dot(a, x, y);
+        bench::doNotOptimize(y.data());
+    }
+    state.setFlops(2.0 * n * n, sizeof(T));
+    state.setBytes((1.0 * n * n + 2.0 * n) * sizeof(T));
+}
+BENCHMARK_TEMPLATE(matrixVectorDot, double)->range(smallest, largest, 4);
+BENCHMARK_TEMPLATE(matrixVectorDot, float)->range(smallest, largest, 4);
+
+template<typename T>
+static void matrixTranspose(bench::State& state) {
+    const std::size_t n = state.arg();
+    const BasicMatrix<T> a = filledMatrix<T>(n);
+    BasicMatrix<T> out(n, n);
+    for ([[maybe_unused]] auto _ : state) {
+        transpose(a, out);
+        bench::doNotOptimize(out.data());
+    }
+    state.setBytes(2.0 * n * n * sizeof(T));
+}
+BENCHMARK_TEMPLATE(matrixTranspose, double)->range(smallest, largest, 4);
+BENCHMARK_TEMPLATE(matrixTranspose, float)->range(smallest, largest, 4);
+
+template<typename T>
+static void matrixTransposeInPlace(bench::State& state) {
+    const std::size_t n = state.arg();
+    BasicMatrix<T> a = filledMatrix<T>(n);
+    for ([[maybe_unused]] auto _ : state) {
+        a.transposeInPlace();
+        bench::doNotOptimize(a.data());
+    }
+    state.setBytes(2.0 * n * n * sizeof(T));
+}
+BENCHMARK_TEMPLATE(matrixTransposeInPlace, double)->range(smallest, largest, 4);
+BENCHMARK_TEMPLATE(matrixTransposeInPlace, float)->range(smallest, largest, 4);
+
+template<typename T>
+static void matrixAdd(bench::State& state) {
+    const std::size_t n = state.arg();
+    const BasicMatrix<T> a = filledMatrix<T>(n);
+    const BasicMatrix<T> b = filledMatrix<T>(n);
+    BasicMatrix<T> out(n, n);
+    for ([[maybe_unused]] auto _ : state) {
+        add(a, b, out);
+        bench::doNotOptimize(out.data());
+    }
+    state.setFlops(1.0 * n * n, sizeof(T));
+    state.setBytes(3.0 * n * n * sizeof(T));
+}
+BENCHMARK_TEMPLATE(matrixAdd, double)->range(smallest, largest, 4);
+BENCHMARK_TEMPLATE(matrixAdd, float)->range(smallest, largest, 4);
+
+// a * b + c through the expression templates.
+template<typename T>
+static void matrixExpression(bench::State& state) {
+    const std::size_t n = state.arg();
+    const BasicMatrix<T> a = filledMatrix<T>(n);
+    const BasicMatrix<T> b = filledMatrix<T>(n);
+    const BasicMatrix<T> c = filledMatrix<T>(n);
+    BasicMatrix<T> out(n, n);
+    for ([[maybe_unused]] auto _ : state) {
+        out = a * b + c;
+        bench::doNotOptimize(out.data());
+    }
+    state.setFlops(2.0 * n * n, sizeof(T));
+    state.setBytes(4.0 * n * n * sizeof(T));
+}
+BENCHMARK_TEMPLATE(matrixExpression, double)->range(smallest, largest, 4);
+BENCHMARK_TEMPLATE(matrixExpression, float)->range(smallest, largest, 4);
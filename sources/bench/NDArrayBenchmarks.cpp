@@ -0,0 +1,131 @@
+#include "bench/Benchmark.hpp"
+#include "ndarray/NDArray.hpp"
+
+// Unchecked indexing of every element of an n x n x n array.
+static void ndarrayIndexing(bench::State& state) {
+    const std::size_t n = state.arg();
+    NDArray<float> a({n, n, n}, 1.0f);
+    for ([[maybe_unused]] auto _ : state) {
+        float total = 0;
+        for (std::size_t i = 0; i < n; i++) {
+            for (std::size_t j = 0; j < n; j++) {
+                for (std::size_t k = 0; k < n; k++) {
+                    total += a(i, j, k);
+                }
+            }
+        }
+        bench::doNotOptimize(total);
+    }
+    state.setBytes(1.0 * n * n * n * sizeof(float));
+}
+BENCHMARK(ndarrayIndexing)->range(16, 256, 4);
+
+// Same with bounds checks.
+static void ndarrayCheckedIndexing(bench::State& state) {
+    const std::size_t n = state.arg();
+    NDArray<float> a({n, n, n}, 1.0f);
+    for ([[maybe_unused]] auto _ : state) {
+        float total = 0;
+        for (std::size_t i = 0; i < n; i++) {
+            for (std::size_t j = 0; j < n; j++) {
+                for (std::size_t k = 0; k < n; k++) {
+                    total += a.at(i, j, k);
+                }
+            }
+        }
+        bench::doNotOptimize(total);
+    }
+    state.setBytes(1.0 * n * n * n * sizeof(float));
+}
+BENCHMARK(ndarrayCheckedIndexing)->range(16, 256, 4);
+
+// Metadata only: a reshaped view and back.
+static void ndarrayReshapeView(bench::State& state) {
+    const std::size_t n = state.arg();
+    NDArray<float> a({n, n}, 1.0f);
+    for ([[maybe_unused]] auto _ : state) {
+        NDArrayView<float> view = a.reshape_view({n / 4, 4, n});
+        bench::doNotOptimize(view.data());
+    }
+}
+BENCHMARK(ndarrayReshapeView)->arg(64)->arg(4096);
+
+// Reshaping a transposed view, which copies.
+static void ndarrayTransposeCopy(bench::State& state) {
+    const std::size_t n = state.arg();
+    NDArray<float> a({n, n}, 1.0f);
+    for ([[maybe_unused]] auto _ : state) {
+        NDArray<float> copy = a.transpose().copy();
+        bench::doNotOptimize(copy.data());
+    }
+    state.setBytes(2.0 * n * n * sizeof(float));
+}
+BENCHMARK(ndarrayTransposeCopy)->range(16, 4096, 4);
+
+// (n, n) + (n): the row is broadcast along the leading axis.
+static void ndarrayBroadcastRow(bench::State& state) {
+    const std::size_t n = state.arg();
+    NDArray<float> a({n, n}, 1.0f);
+    NDArray<float> b({n}, 2.0f);
+    for ([[maybe_unused]] auto _ : state) {
+        NDArray<float> out = a + b;
+        bench::doNotOptimize(out.data());
+    }
+    state.setFlops(1.0 * n * n, sizeof(float));
+    state.setBytes(2.0 * n * n * sizeof(float));
+}
+BENCHMARK(ndarrayBroadcastRow)->range(16, 4096, 4);
+
+// (n, n) + (n, 1): a scalar per row.
+static void ndarrayBroadcastColumn(bench::State& state) {
+    const std::size_t n = state.arg();
+    NDArray<float> a({n, n}, 1.0f);
+    NDArray<float> b({n, 1}, 2.0f);
+    for ([[maybe_unused]] auto _ : state) {
+        NDArray<float> out = a + b;
+        bench::doNotOptimize(out.data());
+    }
+    state.setFlops(1.0 * n * n, sizeof(float));
+    state.setBytes(2.0 * n * n * sizeof(float));
+}
+BENCHMARK(ndarrayBroadcastColumn)->range(16, 4096, 4);
+
+static void ndarraySum(bench::State& state) {
+    const std::size_t n = state.arg();
+    NDArray<float> a({n, n}, 1.0f);
+    for ([[maybe_unused]] auto _ : state) {
+        bench::doNotOptimize(a.sum());
+    }
+    state.setFlops(1.0 * n * n, sizeof(float));
+    state.setBytes(1.0 * n * n * sizeof(float));
+}
+BENCHMARK(ndarraySum)->range(16, 4096, 4);
+
+// Reorders of a batch of 8 images of 56 x 56 pixels with arg(0) channels,
+// from row-major NCHW into the format arg(1): 2 channels-last, 3 blocked.
+static void ndarrayReorder(bench::State& state) {
+    const std::size_t c = state.arg(0);
+    const MemoryFormat format = static_cast<MemoryFormat>(state.arg(1));
+    const NDArray<float> a(std::vector<std::size_t>{8, c, 56, 56}, 1.0f);
+    NDArray<float> b(a.shape(), format);
+    for ([[maybe_unused]] auto _ : state) {
+        reorder(a, b);
+        bench::doNotOptimize(b.data());
+    }
+    state.setBytes(2.0 * a.size() * sizeof(float));
+}
+BENCHMARK(ndarrayReorder)->args({3, 2})->args({64, 2})->args({3, 3})->args({64, 3});
+
+// Sums of an n x n array along axis arg(1): 0 combines whole rows across the
+// contiguous runs, 1 reduces each run.
+static void ndarrayAxisSum(bench::State& state) {
+    const std::size_t n = state.arg(0);
+    const std::size_t axis = state.arg(1);
+    const NDArray<float> a(std::vector<std::size_t>{n, n}, 1.0f);
+    for ([[maybe_unused]] auto _ : state) {
+        NDArray<float> result = a.sum(axis);
+        bench::doNotOptimize(result.data());
+    }
+    state.setBytes(static_cast<double>(a.size() * sizeof(float)));
+}
+BENCHMARK(ndarrayAxisSum)->args({256, 0})->args({256, 1})->args({4096, 0})->args({4096, 1});
@@ -0,0 +1,162 @@
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "bench/Benchmark.hpp"
+#include "gemm/Epilogue.hpp"
+#include "matrix/Matrix.hpp"
+#include "nn/Dense.hpp"
+#include "nn/Optimizer.hpp"
+#include "nn/Softmax.hpp"
+
+// Mini-batch of 256 samples through a square layer of width 64 to 4096.
+static constexpr std::size_t batch = 256;
+
+template<typename T>
+static BasicMatrix<T> filledBatch(std::size_t width) {
+    BasicMatrix<T> x(batch, width);
+    for (std::size_t i = 0; i < batch; i++) {
+        for (std::size_t j = 0; j < width; j++) {
+            x(i, j) = static_cast<T>((i * 5 + j * 3) % 13) / T(13) - T(0.5);
+        }
+    }
+    return x;
+}
+
+template<typename T>
+static void denseForward(bench::State& state) {
+    const std::size_t width = state.arg();
+    nn::BasicDense<T> layer(width, width, Activation::Gelu);
+    layer.initialize(1);
+    const BasicMatrix<T> x = filledBatch<T>(width);
+    BasicMatrix<T> out(batch, width);
+    for ([[maybe_unused]] auto _ : state) {
+        layer.forward(x, out);
+        bench::doNotOptimize(out.data());
+    }
+    state.setFlops(2.0 * batch * width * width, sizeof(T));
+    state.setBytes((2.0 * batch * width + 1.0 * width * width) * sizeof(T));
+}
+BENCHMARK_TEMPLATE(denseForward, double)->range(64, 4096, 4);
+BENCHMARK_TEMPLATE(denseForward, float)->range(64, 4096, 4);
+
+// The same layer as a plain GEMM followed by separate bias and activation
+// passes, as a baseline for the fused epilogue.
+template<typename T>
+static void denseForwardUnfused(bench::State& state) {
+    const std::size_t width = state.arg();
+    nn::BasicDense<T> layer(width, width, Activation::Gelu);
+    layer.initialize(1);
+    const BasicMatrix<T> x = filledBatch<T>(width);
+    BasicMatrix<T> out(batch, width);
+    for ([[maybe_unused]] auto _ : state) {
+        gemm(T(1), x, layer.weights(), T(0), out);
+        for (std::size_t i = 0; i < batch; i++) {
+            T* row = out.data() + i * out.rowStride();
+            for (std::size_t j = 0; j < width; j++) {
+                row[j] += layer.bias()[j];
+            }
+            activate(Activation::Gelu, row, width);
+        }
+        bench::doNotOptimize(out.data());
+    }
+    state.setFlops(2.0 * batch * width * width, sizeof(T));
+    state.setBytes((2.0 * batch * width + 1.0 * width * width) * sizeof(T));
+}
+BENCHMARK_TEMPLATE(denseForwardUnfused, double)->range(64, 4096, 4);
+BENCHMARK_TEMPLATE(denseForwardUnfused, float)->range(64, 4096, 4);
+
+// Softmax cross-entropy loss and gradient of a classification head over 64
+// samples with 1k to 64k classes.
+static constexpr std::size_t headBatch = 64;
+
+template<typename T>
+static void softmaxCrossEntropy(bench::State& state) {
+    const std::size_t classes = state.arg();
+    BasicMatrix<T> logits(headBatch, classes);
+    for (std::size_t i = 0; i < headBatch; i++) {
+        for (std::size_t j = 0; j < classes; j++) {
+            logits(i, j) = static_cast<T>((i * 7 + j * 3) % 29) - T(14);
+        }
+    }
+    std::vector<std::size_t> labels(headBatch);
+    for (std::size_t i = 0; i < headBatch; i++) {
+        labels[i] = (i * 131) % classes;
+    }
+    BasicMatrix<T> gradient(headBatch, classes);
+    for ([[maybe_unused]] auto _ : state) {
+        bench::doNotOptimize(nn::softmaxCrossEntropy(logits, labels, gradient));
+        bench::doNotOptimize(gradient.data());
+    }
+    state.setBytes(3.0 * headBatch * classes * sizeof(T));
+}
+BENCHMARK_TEMPLATE(softmaxCrossEntropy, double)->range(1024, 65536, 4);
+BENCHMARK_TEMPLATE(softmaxCrossEntropy, float)->range(1024, 65536, 4);
+
+// The same loss and gradient in separate max, exp, sum and normalization
+// passes with std::exp, as a baseline for the fused kernels.
+template<typename T>
+static void softmaxCrossEntropyUnfused(bench::State& state) {
+    const std::size_t classes = state.arg();
+    BasicMatrix<T> logits(headBatch, classes);
+    for (std::size_t i = 0; i < headBatch; i++) {
+        for (std::size_t j = 0; j < classes; j++) {
+            logits(i, j) = static_cast<T>((i * 7 + j * 3) % 29) - T(14);
+        }
+    }
+    BasicMatrix<T> gradient(headBatch, classes);
+    for ([[maybe_unused]] auto _ : state) {
+        T loss = T(0);
+        for (std::size_t i = 0; i < headBatch; i++) {
+            const T* x = logits.data() + i * logits.rowStride();
+            T* g = gradient.data() + i * gradient.rowStride();
+            T max = x[0];
+            for (std::size_t j = 1; j < classes; j++) {
+                max = std::max(max, x[j]);
+            }
+            for (std::size_t j = 0; j < classes; j++) {
+                g[j] = std::exp(x[j] - max);
+            }
+            T sum = T(0);
+            for (std::size_t j = 0; j < classes; j++) {
+                sum += g[j];
+            }
+            for (std::size_t j = 0; j < classes; j++) {
+                g[j] /= sum * T(headBatch);
+            }
+            const std::size_t label = (i * 131) % classes;
+            loss += std::log(sum) - (x[label] - max);
+            g[label] -= T(1) / T(headBatch);
+        }
+        bench::doNotOptimize(loss);
+        bench::doNotOptimize(gradient.data());
+    }
+    state.setBytes(3.0 * headBatch * classes * sizeof(T));
+}
+BENCHMARK_TEMPLATE(softmaxCrossEntropyUnfused, double)->range(1024, 65536, 4);
+BENCHMARK_TEMPLATE(softmaxCrossEntropyUnfused, float)->range(1024, 65536, 4);
+
+// One Adam step over 4M parameters split into tensors of arg() elements, so
+// that small tensors show the per-tensor overhead of a step.
+template<typename T>
+static void adamStep(bench::State& state) {
+    const std::size_t total = std::size_t(1) << 22;
+    const std::size_t size = state.arg();
+    std::vector<T> weights(total, T(1));
+    std::vector<T> gradients(total, T(0.01));
+    nn::OptimizerOptions options;
+    options.algorithm = nn::OptimizerAlgorithm::AdamW;
+    options.learningRate = 1e-3;
+    options.weightDecay = 1e-2;
+    nn::BasicOptimizer<T> optimizer(options);
+    for (std::size_t i = 0; i < total; i += size) {
+        optimizer.add(weights.data() + i, gradients.data() + i, size);
+    }
+    for ([[maybe_unused]] auto _ : state) {
+        optimizer.step();
+        bench::doNotOptimize(weights.data());
+    }
+    state.setBytes(7.0 * total * sizeof(T));
+}
+BENCHMARK_TEMPLATE(adamStep, double)->range(64, 1 << 22, 64);
+BENCHMARK_TEMPLATE(adamStep, float)->range(64, 1 << 22, 64);
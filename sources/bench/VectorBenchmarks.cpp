@@ -0,0 +1,67 @@
+#include "bench/Benchmark.hpp"
+#include "vector/Vector.hpp"
+
+// Vector sizes from the L1 cache to main memory.
+static constexpr std::int64_t smallest = 1 << 10;
+static constexpr std::int64_t largest = 1 << 24;
+
+template<typename T>
+static void vectorAdd(bench::State& state) {
+    const std::size_t n = state.arg();
+    BasicVector<T> a(n, T(1));
+    BasicVector<T> b(n, T(2));
+    BasicVector<T> out(n);
+    for ([[maybe_unused]] auto _ : state) {
+        add(a, b, out);
+        bench::doNotOptimize(out.data());
+    }
+    state.setFlops(n, sizeof(T));
+    state.setBytes(3.0 * n * sizeof(T));
+}
+BENCHMARK_TEMPLATE(vectorAdd, double)->range(smallest, largest);
+BENCHMARK_TEMPLATE(vectorAdd, float)->range(smallest, largest);
+
+// a + b * c through the expression templates, one pass without temporaries.
+template<typename T>
+static void vectorExpression(bench::State& state) {
+    const std::size_t n = state.arg();
+    BasicVector<T> a(n, T(1));
+    BasicVector<T> b(n, T(2));
+    BasicVector<T> c(n, T(3));
+    BasicVector<T> out(n);
+    for ([[maybe_unused]] auto _ : state) {
+        out = a + b * c;
+        bench::doNotOptimize(out.data());
+    }
+    state.setFlops(2.0 * n, sizeof(T));
+    state.setBytes(4.0 * n * sizeof(T));
+}
+BENCHMARK_TEMPLATE(vectorExpression, double)->range(smallest, largest);
+BENCHMARK_TEMPLATE(vectorExpression, float)->range(smallest, largest);
+
+template<typename T>
+static void vectorDot(bench::State& state) {
+    const std::size_t n = state.arg();
+    BasicVector<T> a(n, T(1));
+    BasicVector<T> b(n, T(2));
+    for ([[maybe_unused]] auto _ : state) {
+        bench::doNotOptimize(a.dot(b));
+    }
+    state.setFlops(2.0 * n, sizeof(T));
+    state.setBytes(2.0 * n * sizeof(T));
+}
+BENCHMARK_TEMPLATE(vectorDot, double)->range(smallest, largest);
+BENCHMARK_TEMPLATE(vectorDot, float)->range(smallest, largest);
+
+template<typename T>
+static void vectorSum(bench::State& state) {
+    const std::size_t n = state.arg();
+    BasicVector<T> a(n, T(1));
+    for ([[maybe_unused]] auto _ : state) {
+        bench::doNotOptimize(a.sum());
+    }
+    state.setFlops(n, sizeof(T));
+    state.setBytes(1.0 * n * sizeof(T));
+}
+BENCHMARK_TEMPLATE(vectorSum, double)->range(smallest, largest);
+BENCHMARK_TEMPLATE(vectorSum, float)->range(smallest, largest);
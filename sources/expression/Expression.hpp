@@ -0,0 +1,665 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+// Lazy elementwise arithmetic for Vector and Matrix, of any element type.
+//
+// The free arithmetic operators return lightweight expression nodes rather
+// than a new Vector or Matrix. Nothing is computed until the expression is
+// assigned to (or used to construct) a Vector or Matrix, which then walks its
+// storage once and evaluates the whole tree per element:
+//
+//     Vector z = a * x + b * y - c;   // one loop, no temporaries
+//
+// Nodes refer to the storage of their Vector/Matrix operands, so an
+// expression must be evaluated before those operands are destroyed; avoid
+// keeping one in an auto variable past the end of the statement.
+//
+// Scalar operands are converted to the element type of the other operand,
+// so FloatVector expressions are computed in float throughout.
+
+template<typename T>
+class BasicVector;
+template<typename T>
+class BasicMatrix;
+template<typename T>
+class BasicMatrixRow;
+template<typename T>
+class BasicConstMatrixRow;
+
+using Vector = BasicVector<double>;
+using Matrix = BasicMatrix<double>;
+using MatrixRow = BasicMatrixRow<double>;
+using ConstMatrixRow = BasicConstMatrixRow<double>;
+using FloatVector = BasicVector<float>;
+using FloatMatrix = BasicMatrix<float>;
+using FloatMatrixRow = BasicMatrixRow<float>;
+using FloatConstMatrixRow = BasicConstMatrixRow<float>;
+
+template<typename E>
+struct VectorExpression {};
+
+template<typename E>
+struct MatrixExpression {};
+
+// Operations
+
+struct ExprAssign {
+    template<typename A, typename B>
+    static B apply(A, B b) { return b; }
+};
+
+struct ExprAdd {
+    template<typename A, typename B>
+    static auto apply(A a, B b) { return a + b; }
+};
+
+struct ExprSub {
+    template<typename A, typename B>
+    static auto apply(A a, B b) { return a - b; }
+};
+
+struct ExprMul {
+    template<typename A, typename B>
+    static auto apply(A a, B b) { return a * b; }
+};
+
+struct ExprDiv {
+    template<typename A, typename B>
+    static auto apply(A a, B b) { return a / b; }
+};
+
+// Leaves
+
+template<typename T>
+class VectorLeaf : public VectorExpression<VectorLeaf<T>> {
+
+private:
+
+    const T* m_data;
+    std::size_t m_size;
+
+public:
+
+    using value_type = T;
+
+    VectorLeaf(const T* data, std::size_t size) : m_data(data), m_size(size) {}
+
+    T operator[](std::size_t i) const { return m_data[i]; }
+    std::size_t size() const { return m_size; }
+
+};
+
+template<typename T>
+class StridedVectorLeaf : public VectorExpression<StridedVectorLeaf<T>> {
+
+private:
+
+    const T* m_data;
+    std::size_t m_size;
+    std::size_t m_stride;
+
+public:
+
+    using value_type = T;
+
+    StridedVectorLeaf(const T* data, std::size_t size, std::size_t stride) :
+        m_data(data), m_size(size), m_stride(stride) {}
+
+    T operator[](std::size_t i) const { return m_data[i * m_stride]; }
+    std::size_t size() const { return m_size; }
+
+};
+
+// Matrix storage always has a unit column stride, only the row stride is
+// kept so the inner loop over columns stays contiguous.
+template<typename T>
+class MatrixLeaf : public MatrixExpression<MatrixLeaf<T>> {
+
+private:
+
+    const T* m_data;
+    std::size_t m_rows;
+    std::size_t m_cols;
+    std::size_t m_rowStride;
+
+public:
+
+    using value_type = T;
+
+    MatrixLeaf(const T* data, std::size_t rows, std::size_t cols, std::size_t rowStride) :
+        m_data(data), m_rows(rows), m_cols(cols), m_rowStride(rowStride) {}
+
+    T operator()(std::size_t i, std::size_t j) const { return m_data[i * m_rowStride + j]; }
+    std::size_t nbRows() const { return m_rows; }
+    std::size_t nbCols() const { return m_cols; }
+
+};
+
+// Operand classification
+
+template<typename T>
+constexpr bool isVector = false;
+
+template<typename T>
+constexpr bool isVector<BasicVector<T>> = true;
+
+template<typename T>
+constexpr bool isMatrixRow = false;
+
+template<typename T>
+constexpr bool isMatrixRow<BasicMatrixRow<T>> = true;
+
+template<typename T>
+constexpr bool isMatrixRow<BasicConstMatrixRow<T>> = true;
+
+template<typename T>
+constexpr bool isMatrix = false;
+
+template<typename T>
+constexpr bool isMatrix<BasicMatrix<T>> = true;
+
+// Scalar operands of a node are stored as plain arithmetic values.
+template<typename T>
+constexpr bool isScalar = std::is_arithmetic_v<T>;
+
+template<typename T>
+constexpr bool isVectorOperand = isVector<T> || isMatrixRow<T> || std::is_base_of_v<VectorExpression<T>, T>;
+
+template<typename T>
+constexpr bool isMatrixOperand = isMatrix<T> || std::is_base_of_v<MatrixExpression<T>, T>;
+
+template<typename T>
+concept VectorOperand = isVectorOperand<std::remove_cvref_t<T>>;
+
+template<typename T>
+concept MatrixOperand = isMatrixOperand<std::remove_cvref_t<T>>;
+
+template<typename T>
+auto asVectorExpression(const T& t) {
+    if constexpr (isVector<T>) {
+        return VectorLeaf(t.data(), t.size());
+    } else if constexpr (isMatrixRow<T>) {
+        return StridedVectorLeaf(t.data(), t.size(), t.stride());
+    } else {
+        return t;
+    }
+}
+
+template<typename T>
+auto asMatrixExpression(const T& t) {
+    if constexpr (isMatrix<T>) {
+        return MatrixLeaf(t.data(), t.nbRows(), t.nbCols(), t.rowStride());
+    } else {
+        return t;
+    }
+}
+
+// Element type of an expression node or scalar operand.
+template<typename T>
+struct ValueOf {
+    using type = typename T::value_type;
+};
+
+template<typename T>
+    requires isScalar<T>
+struct ValueOf<T> {
+    using type = T;
+};
+
+template<typename T>
+using ValueOfT = typename ValueOf<T>::type;
+
+template<typename T>
+using VectorExpressionOf = decltype(asVectorExpression(std::declval<const T&>()));
+
+template<typename T>
+using MatrixExpressionOf = decltype(asMatrixExpression(std::declval<const T&>()));
+
+// Nodes
+
+// Either operand may be a scalar, which is broadcast to every element.
+template<typename L, typename R, typename Op>
+class VectorBinary : public VectorExpression<VectorBinary<L, R, Op>> {
+
+private:
+
+    L m_l;
+    R m_r;
+
+public:
+
+    using value_type = std::common_type_t<ValueOfT<L>, ValueOfT<R>>;
+
+private:
+
+    template<typename X>
+    static value_type at(const X& x, std::size_t i) {
+        if constexpr (isScalar<X>) {
+            return x;
+        } else {
+            return x[i];
+        }
+    }
+
+public:
+
+    VectorBinary(const L& l, const R& r) : m_l(l), m_r(r) {
+        if constexpr (!isScalar<L> && !isScalar<R>) {
+            if (m_l.size() != m_r.size()) {
+                throw("Vectors do not have the same dimension.");
+            }
+        }
+    }
+
+    value_type operator[](std::size_t i) const { return Op::apply(at(m_l, i), at(m_r, i)); }
+
+    std::size_t size() const {
+        if constexpr (isScalar<L>) {
+            return m_r.size();
+        } else {
+            return m_l.size();
+        }
+    }
+
+};
+
+template<typename E>
+class VectorNegate : public VectorExpression<VectorNegate<E>> {
+
+private:
+
+    E m_e;
+
+public:
+
+    using value_type = typename E::value_type;
+
+    explicit VectorNegate(const E& e) : m_e(e) {}
+
+    value_type operator[](std::size_t i) const { return -m_e[i]; }
+    std::size_t size() const { return m_e.size(); }
+
+};
+
+// Presents a vector expression as a matrix whose rows all equal it.
+template<typename E>
+class RowBroadcast : public MatrixExpression<RowBroadcast<E>> {
+
+private:
+
+    E m_e;
+    std::size_t m_rows;
+
+public:
+
+    using value_type = typename E::value_type;
+
+    RowBroadcast(const E& e, std::size_t rows) : m_e(e), m_rows(rows) {}
+
+    value_type operator()(std::size_t, std::size_t j) const { return m_e[j]; }
+    std::size_t nbRows() const { return m_rows; }
+    std::size_t nbCols() const { return m_e.size(); }
+
+};
+
+template<typename L, typename R, typename Op>
+class MatrixBinary : public MatrixExpression<MatrixBinary<L, R, Op>> {
+
+private:
+
+    L m_l;
+    R m_r;
+
+public:
+
+    using value_type = std::common_type_t<ValueOfT<L>, ValueOfT<R>>;
+
+private:
+
+    template<typename X>
+    static value_type at(const X& x, std::size_t i, std::size_t j) {
+        if constexpr (isScalar<X>) {
+            return x;
+        } else {
+            return x(i, j);
+        }
+    }
+
+public:
+
+    MatrixBinary(const L& l, const R& r) : m_l(l), m_r(r) {
+        if constexpr (!isScalar<L> && !isScalar<R>) {
+            if (m_l.nbRows() != m_r.nbRows() || m_l.nbCols() != m_r.nbCols()) {
+                throw("Matrix do not have the same dimensions.");
+            }
+        }
+    }
+
+    value_type operator()(std::size_t i, std::size_t j) const { return Op::apply(at(m_l, i, j), at(m_r, i, j)); }
+
+    std::size_t nbRows() const {
+        if constexpr (isScalar<L>) {
+            return m_r.nbRows();
+        } else {
+            return m_l.nbRows();
+        }
+    }
+
+    std::size_t nbCols() const {
+        if constexpr (isScalar<L>) {
+            return m_r.nbCols();
+        } else {
+            return m_l.nbCols();
+        }
+    }
+
+};
+
+template<typename E>
+class MatrixNegate : public MatrixExpression<MatrixNegate<E>> {
+
+private:
+
+    E m_e;
+
+public:
+
+    using value_type = typename E::value_type;
+
+    explicit MatrixNegate(const E& e) : m_e(e) {}
+
+    value_type operator()(std::size_t i, std::size_t j) const { return -m_e(i, j); }
+    std::size_t nbRows() const { return m_e.nbRows(); }
+    std::size_t nbCols() const { return m_e.nbCols(); }
+
+};
+
+// Functions
+
+template<typename Op, typename L, typename R>
+auto makeVectorBinary(const L& l, const R& r) {
+    return VectorBinary<VectorExpressionOf<L>, VectorExpressionOf<R>, Op>(asVectorExpression(l), asVectorExpression(r));
+}
+
+template<typename Op, typename L>
+auto makeVectorScalar(const L& l, double value) {
+    using V = typename VectorExpressionOf<L>::value_type;
+    return VectorBinary<VectorExpressionOf<L>, V, Op>(asVectorExpression(l), static_cast<V>(value));
+}
+
+template<typename Op, typename R>
+auto makeScalarVector(double value, const R& r) {
+    using V = typename VectorExpressionOf<R>::value_type;
+    return VectorBinary<V, VectorExpressionOf<R>, Op>(static_cast<V>(value), asVectorExpression(r));
+}
+
+template<typename Op, typename L, typename R>
+auto makeMatrixBinary(const L& l, const R& r) {
+    return MatrixBinary<MatrixExpressionOf<L>, MatrixExpressionOf<R>, Op>(asMatrixExpression(l), asMatrixExpression(r));
+}
+
+template<typename Op, typename L, typename R>
+auto makeMatrixVector(const L& m, const R& v) {
+    const MatrixExpressionOf<L> l = asMatrixExpression(m);
+    const VectorExpressionOf<R> r = asVectorExpression(v);
+    if (r.size() != l.nbCols()) {
+        throw("Vector and Matrix do not have the right dimensions.");
+    }
+    return MatrixBinary<MatrixExpressionOf<L>, RowBroadcast<VectorExpressionOf<R>>, Op>(l, RowBroadcast<VectorExpressionOf<R>>(r, l.nbRows()));
+}
+
+template<typename Op, typename L, typename R>
+auto makeVectorMatrix(const L& v, const R& m) {
+    const VectorExpressionOf<L> l = asVectorExpression(v);
+    const MatrixExpressionOf<R> r = asMatrixExpression(m);
+    if (l.size() != r.nbCols()) {
+        throw("Vector and Matrix do not have the right dimensions.");
+    }
+    return MatrixBinary<RowBroadcast<VectorExpressionOf<L>>, MatrixExpressionOf<R>, Op>(RowBroadcast<VectorExpressionOf<L>>(l, r.nbRows()), r);
+}
+
+template<typename Op, typename L>
+auto makeMatrixScalar(const L& l, double value) {
+    using V = typename MatrixExpressionOf<L>::value_type;
+    return MatrixBinary<MatrixExpressionOf<L>, V, Op>(asMatrixExpression(l), static_cast<V>(value));
+}
+
+template<typename Op, typename R>
+auto makeScalarMatrix(double value, const R& r) {
+    using V = typename MatrixExpressionOf<R>::value_type;
+    return MatrixBinary<V, MatrixExpressionOf<R>, Op>(static_cast<V>(value), asMatrixExpression(r));
+}
+
+// Vector operators
+
+template<VectorOperand L, VectorOperand R>
+auto operator+(const L& l, const R& r) { return makeVectorBinary<ExprAdd>(l, r); }
+
+template<VectorOperand L, VectorOperand R>
+auto operator-(const L& l, const R& r) { return makeVectorBinary<ExprSub>(l, r); }
+
+template<VectorOperand L, VectorOperand R>
+auto operator*(const L& l, const R& r) { return makeVectorBinary<ExprMul>(l, r); } // not the dot product
+
+template<VectorOperand L, VectorOperand R>
+auto operator/(const L& l, const R& r) { return makeVectorBinary<ExprDiv>(l, r); }
+
+template<VectorOperand L>
+auto operator+(const L& l, double value) { return makeVectorScalar<ExprAdd>(l, value); }
+
+template<VectorOperand L>
+auto operator-(const L& l, double value) { return makeVectorScalar<ExprSub>(l, value); }
+
+template<VectorOperand L>
+auto operator*(const L& l, double value) { return makeVectorScalar<ExprMul>(l, value); }
+
+template<VectorOperand L>
+auto operator/(const L& l, double value) { return makeVectorScalar<ExprDiv>(l, value); }
+
+template<VectorOperand R>
+auto operator+(double value, const R& r) { return makeScalarVector<ExprAdd>(value, r); }
+
+template<VectorOperand R>
+auto operator-(double value, const R& r) { return makeScalarVector<ExprSub>(value, r); }
+
+template<VectorOperand R>
+auto operator*(double value, const R& r) { return makeScalarVector<ExprMul>(value, r); }
+
+template<VectorOperand R>
+auto operator/(double value, const R& r) { return makeScalarVector<ExprDiv>(value, r); }
+
+template<VectorOperand E>
+auto operator+(const E& e) { return asVectorExpression(e); }
+
+template<VectorOperand E>
+auto operator-(const E& e) { return VectorNegate<VectorExpressionOf<E>>(asVectorExpression(e)); }
+
+// Matrix operators (elementwise, the matrix product is Matrix::dot)
+
+template<MatrixOperand L, MatrixOperand R>
+auto operator+(const L& l, const R& r) { return makeMatrixBinary<ExprAdd>(l, r); }
+
+template<MatrixOperand L, MatrixOperand R>
+auto operator-(const L& l, const R& r) { return makeMatrixBinary<ExprSub>(l, r); }
+
+template<MatrixOperand L, MatrixOperand R>
+auto operator*(const L& l, const R& r) { return makeMatrixBinary<ExprMul>(l, r); }
+
+template<MatrixOperand L, MatrixOperand R>
+auto operator/(const L& l, const R& r) { return makeMatrixBinary<ExprDiv>(l, r); }
+
+// A vector operand is applied to every row of the matrix operand.
+
+template<MatrixOperand L, VectorOperand R>
+auto operator+(const L& l, const R& r) { return makeMatrixVector<ExprAdd>(l, r); }
+
+template<MatrixOperand L, VectorOperand R>
+auto operator-(const L& l, const R& r) { return makeMatrixVector<ExprSub>(l, r); }
+
+template<MatrixOperand L, VectorOperand R>
+auto operator*(const L& l, const R& r) { return makeMatrixVector<ExprMul>(l, r); }
+
+template<MatrixOperand L, VectorOperand R>
+auto operator/(const L& l, const R& r) { return makeMatrixVector<ExprDiv>(l, r); }
+
+template<VectorOperand L, MatrixOperand R>
+auto operator+(const L& l, const R& r) { return makeVectorMatrix<ExprAdd>(l, r); }
+
+template<VectorOperand L, MatrixOperand R>
+auto operator-(const L& l, const R& r) { return makeVectorMatrix<ExprSub>(l, r); }
+
+template<VectorOperand L, MatrixOperand R>
+auto operator*(const L& l, const R& r) { return makeVectorMatrix<ExprMul>(l, r); }
+
+template<VectorOperand L, MatrixOperand R>
+auto operator/(const L& l, const R& r) { return makeVectorMatrix<ExprDiv>(l, r); }
+
+template<MatrixOperand L>
+auto operator+(const L& l, double value) { return makeMatrixScalar<ExprAdd>(l, value); }
+
+template<MatrixOperand L>
+auto operator-(const L& l, double value) { return makeMatrixScalar<ExprSub>(l, value); }
+
+template<MatrixOperand L>
+auto operator*(const L& l, double value) { return makeMatrixScalar<ExprMul>(l, value); }
+
+template<MatrixOperand L>
+auto operator/(const L& l, double value) { return makeMatrixScalar<ExprDiv>(l, value); }
+
+template<MatrixOperand R>
+auto operator+(double value, const R& r) { return makeScalarMatrix<ExprAdd>(value, r); }
+
+template<MatrixOperand R>
+auto operator-(double value, const R& r) { return makeScalarMatrix<ExprSub>(value, r); }
+
+template<MatrixOperand R>
+auto operator*(double value, const R& r) { return makeScalarMatrix<ExprMul>(value, r); }
+
+template<MatrixOperand R>
+auto operator/(double value, const R& r) { return makeScalarMatrix<ExprDiv>(value, r); }
+
+template<MatrixOperand E>
+auto operator+(const E& e) { return asMatrixExpression(e); }
+
+template<MatrixOperand E>
+auto operator-(const E& e) { return MatrixNegate<MatrixExpressionOf<E>>(asMatrixExpression(e)); }
+
+// Operators on a temporary Vector or Matrix (left operand, or right operand
+// of a scalar) evaluate into its storage and return it instead of building a
+// node that refers to it, so the temporary's buffer becomes the result:
+//
+//     Matrix h = x.dot(w) + bias;   // no second allocation
+//
+// Elements are read and written in place, with the aliasing rules of the
+// compound assignments.
+
+template<typename T>
+concept VectorTemporary = isVector<T>;
+
+template<typename T>
+concept MatrixTemporary = isMatrix<T>;
+
+template<typename Op, typename V, typename R>
+V evaluateInto(V&& l, const R& r) {
+    if constexpr (isMatrixOperand<V> && isVectorOperand<R>) {
+        l = makeMatrixVector<Op>(l, r);
+    } else if constexpr (isMatrixOperand<V> && isScalar<R>) {
+        l = makeMatrixScalar<Op>(l, r);
+    } else if constexpr (isMatrixOperand<V>) {
+        l = makeMatrixBinary<Op>(l, r);
+    } else if constexpr (isScalar<R>) {
+        l = makeVectorScalar<Op>(l, r);
+    } else {
+        l = makeVectorBinary<Op>(l, r);
+    }
+    return std::move(l);
+}
+
+template<typename Op, typename V>
+V evaluateScalarInto(double value, V&& r) {
+    if constexpr (isMatrixOperand<V>) {
+        r = makeScalarMatrix<Op>(value, r);
+    } else {
+        r = makeScalarVector<Op>(value, r);
+    }
+    return std::move(r);
+}
+
+template<VectorTemporary V, VectorOperand R>
+V operator+(V&& l, const R& r) { return evaluateInto<ExprAdd>(std::move(l), r); }
+
+template<VectorTemporary V, VectorOperand R>
+V operator-(V&& l, const R& r) { return evaluateInto<ExprSub>(std::move(l), r); }
+
+template<VectorTemporary V, VectorOperand R>
+V operator*(V&& l, const R& r) { return evaluateInto<ExprMul>(std::move(l), r); }
+
+template<VectorTemporary V, VectorOperand R>
+V operator/(V&& l, const R& r) { return evaluateInto<ExprDiv>(std::move(l), r); }
+
+template<VectorTemporary V>
+V operator+(V&& l, double value) { return evaluateInto<ExprAdd>(std::move(l), value); }
+
+template<VectorTemporary V>
+V operator-(V&& l, double value) { return evaluateInto<ExprSub>(std::move(l), value); }
+
+template<VectorTemporary V>
+V operator*(V&& l, double value) { return evaluateInto<ExprMul>(std::move(l), value); }
+
+template<VectorTemporary V>
+V operator/(V&& l, double value) { return evaluateInto<ExprDiv>(std::move(l), value); }
+
+template<VectorTemporary V>
+V operator+(double value, V&& r) { return evaluateScalarInto<ExprAdd>(value, std::move(r)); }
+
+template<VectorTemporary V>
+V operator-(double value, V&& r) { return evaluateScalarInto<ExprSub>(value, std::move(r)); }
+
+template<VectorTemporary V>
+V operator*(double value, V&& r) { return evaluateScalarInto<ExprMul>(value, std::move(r)); }
+
+template<VectorTemporary V>
+V operator/(double value, V&& r) { return evaluateScalarInto<ExprDiv>(value, std::move(r)); }
+
+template<MatrixTemporary M, typename R>
+    requires MatrixOperand<R> || VectorOperand<R>
+M operator+(M&& l, const R& r) { return evaluateInto<ExprAdd>(std::move(l), r); }
+
+template<MatrixTemporary M, typename R>
+    requires MatrixOperand<R> || VectorOperand<R>
+M operator-(M&& l, const R& r) { return evaluateInto<ExprSub>(std::move(l), r); }
+
+template<MatrixTemporary M, typename R>
+    requires MatrixOperand<R> || VectorOperand<R>
+M operator*(M&& l, const R& r) { return evaluateInto<ExprMul>(std::move(l), r); }
+
+template<MatrixTemporary M, typename R>
+    requires MatrixOperand<R> || VectorOperand<R>
+M operator/(M&& l, const R& r) { return evaluateInto<ExprDiv>(std::move(l), r); }
+
+template<MatrixTemporary M>
+M operator+(M&& l, double value) { return evaluateInto<ExprAdd>(std::move(l), value); }
+
+template<MatrixTemporary M>
+M operator-(M&& l, double value) { return evaluateInto<ExprSub>(std::move(l), value); }
+
+template<MatrixTemporary M>
+M operator*(M&& l, double value) { return evaluateInto<ExprMul>(std::move(l), value); }
+
+template<MatrixTemporary M>
+M operator/(M&& l, double value) { return evaluateInto<ExprDiv>(std::move(l), value); }
+
+template<MatrixTemporary M>
+M operator+(double value, M&& r) { return evaluateScalarInto<ExprAdd>(value, std::move(r)); }
+
+template<MatrixTemporary M>
+M operator-(double value, M&& r) { return evaluateScalarInto<ExprSub>(value, std::move(r)); }
+
+template<MatrixTemporary M>
+M operator*(double value, M&& r) { return evaluateScalarInto<ExprMul>(value, std::move(r)); }
+
+template<MatrixTemporary M>
+M operator/(double value, M&& r) { return evaluateScalarInto<ExprDiv>(value, std::move(r)); }
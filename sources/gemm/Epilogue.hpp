@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+// Pointwise activations, and the epilogue that fuses a bias and an
+// activation into GEMM: each element of C gets c = act(c + bias) as soon as
+// its sum over k is complete, while its register tile is being written
+// back, instead of in separate passes over C.
+enum class Activation {
+    Identity,
+    Relu,
+    Gelu,
+    Sigmoid,
+    Tanh
+};
+
+inline const char* activationName(Activation activation) {
+    switch (activation) {
+        case Activation::Identity: return "identity";
+        case Activation::Relu: return "relu";
+        case Activation::Gelu: return "gelu";
+        case Activation::Sigmoid: return "sigmoid";
+        case Activation::Tanh: return "tanh";
+    }
+    return "unknown";
+}
+
+template<Activation A, typename T>
+inline T activate(T x) {
+    if constexpr (A == Activation::Identity) {
+        return x;
+    } else if constexpr (A == Activation::Relu) {
+        return std::max(x, T(0));
+    } else if constexpr (A == Activation::Gelu) {
+        // tanh approximation, as in GPT-2 and BERT.
+        constexpr T c = T(0.7978845608028654);
+        return T(0.5) * x * (T(1) + std::tanh(c * (x + T(0.044715) * x * x * x)));
+    } else if constexpr (A == Activation::Sigmoid) {
+        return T(1) / (T(1) + std::exp(-x));
+    } else {
+        return std::tanh(x);
+    }
+}
+
+// GELU's derivative is computed from its input, the others from their output.
+constexpr bool derivativeNeedsInput(Activation activation) {
+    return activation == Activation::Gelu;
+}
+
+// d activate<A>(x) / dx, where y = activate<A>(x). Only x is read for GELU
+// and only y for the other activations.
+template<Activation A, typename T>
+inline T activateDerivative(T x, T y) {
+    if constexpr (A == Activation::Identity) {
+        return T(1);
+    } else if constexpr (A == Activation::Relu) {
+        return (y > T(0)) ? T(1) : T(0);
+    } else if constexpr (A == Activation::Gelu) {
+        constexpr T c = T(0.7978845608028654);
+        const T t = std::tanh(c * (x + T(0.044715) * x * x * x));
+        return T(0.5) * (T(1) + t) + T(0.5) * x * (T(1) - t * t) * c * (T(1) + T(3 * 0.044715) * x * x);
+    } else if constexpr (A == Activation::Sigmoid) {
+        return y * (T(1) - y);
+    } else {
+        return T(1) - y * y;
+    }
+}
+
+// Calls fn(std::integral_constant<Activation, A>()) for the runtime value
+// activation, so that loops inside fn are specialized on it.
+template<typename F>
+inline void dispatchActivation(Activation activation, const F& fn) {
+    switch (activation) {
+        case Activation::Identity: fn(std::integral_constant<Activation, Activation::Identity>()); return;
+        case Activation::Relu: fn(std::integral_constant<Activation, Activation::Relu>()); return;
+        case Activation::Gelu: fn(std::integral_constant<Activation, Activation::Gelu>()); return;
+        case Activation::Sigmoid: fn(std::integral_constant<Activation, Activation::Sigmoid>()); return;
+        case Activation::Tanh: fn(std::integral_constant<Activation, Activation::Tanh>()); return;
+    }
+}
+
+// x[i] = act(x[i]) over contiguous storage.
+template<typename T>
+void activate(Activation activation, T* x, std::size_t n) {
+    dispatchActivation(activation, [&](auto a) {
+        for (std::size_t i = 0; i < n; i++) {
+            x[i] = activate<decltype(a)::value>(x[i]);
+        }
+    });
+}
+
+// c = act(c + bias) applied by gemm() to every element of C. bias, when not
+// null, holds one value per column of C, or per row with biasPerRow.
+template<typename T>
+struct GemmEpilogue {
+    const T* bias = nullptr;
+    bool biasPerRow = false;
+    Activation activation = Activation::Identity;
+};
@@ -0,0 +1,472 @@
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "gemm/Gemm.hpp"
+#include "memory/AlignedAllocator.hpp"
+#include "parallel/ThreadPool.hpp"
+#include "profile/Profiler.hpp"
+#include "simd/Simd.hpp"
+
+// Rows of the register tile computed by the micro-kernel. Its columns,
+// simd::gemmNRFor<T>, depend on the element type.
+static constexpr std::size_t MR = simd::gemmMR;
+
+// Cache blocks: a KC x NR sliver of B stays in L1, the packed MC x KC block
+// of A in L2 and the packed KC x NC panel of B in L3.
+static constexpr std::size_t MC = 128;
+static constexpr std::size_t KC = 256;
+static constexpr std::size_t NC = 4096;
+
+template<typename T>
+using PackBuffer = std::vector<T, AlignedAllocator<T>>;
+
+// Packs the mc x kc block of A into row panels of MR rows, stored k-major and
+// zero padded, so the micro-kernel reads it with unit stride. Operands
+// stored in a narrower type are widened to T here, so the micro-kernel only
+// ever sees T.
+template<typename T, typename TA>
+static void packA(
+    std::size_t mc, std::size_t kc,
+    const TA* a, std::size_t rsa, std::size_t csa,
+    T* packed
+) {
+    for (std::size_t i = 0; i < mc; i += MR) {
+        const std::size_t mr = std::min(MR, mc - i);
+        for (std::size_t p = 0; p < kc; p++) {
+            for (std::size_t r = 0; r < mr; r++) {
+                packed[r] = static_cast<T>(a[(i + r) * rsa + p * csa]);
+            }
+            for (std::size_t r = mr; r < MR; r++) {
+                packed[r] = T(0);
+            }
+            packed += MR;
+        }
+    }
+}
+
+// Packs the kc x nc panel of B into column panels of NR columns.
+template<typename T, typename TB>
+static void packB(
+    std::size_t kc, std::size_t nc,
+    const TB* b, std::size_t rsb, std::size_t csb,
+    T* packed
+) {
+    constexpr std::size_t NR = simd::gemmNRFor<T>;
+    for (std::size_t j = 0; j < nc; j += NR) {
+        const std::size_t nr = std::min(NR, nc - j);
+        for (std::size_t p = 0; p < kc; p++) {
+            for (std::size_t c = 0; c < nr; c++) {
+                packed[c] = static_cast<T>(b[p * rsb + (j + c) * csb]);
+            }
+            for (std::size_t c = nr; c < NR; c++) {
+                packed[c] = T(0);
+            }
+            packed += NR;
+        }
+    }
+}
+
+// Writes the mr x nr valid part of an MR x NR tile of A * B into C as
+// finish(alpha * acc + beta * c, r, j).
+template<typename T, typename Finish>
+static void mergeTile(
+    const T* acc, T alpha, T beta, T* c, std::size_t rsc, std::size_t csc,
+    std::size_t mr, std::size_t nr, const Finish& finish
+) {
+    constexpr std::size_t NR = simd::gemmNRFor<T>;
+    for (std::size_t r = 0; r < mr; r++) {
+        for (std::size_t j = 0; j < nr; j++) {
+            T& out = c[r * rsc + j * csc];
+            out = finish((beta == T(0)) ? alpha * acc[r * NR + j] : alpha * acc[r * NR + j] + beta * out, r, j);
+        }
+    }
+}
+
+// Computes an MR x NR tile of alpha * A * B from packed panels with the
+// dispatched SIMD micro-kernel and merges the mr x nr valid part into C. The
+// epilogue, if any, is applied in the same pass; (i0, j0) is the position of
+// the tile in C, for the bias.
+template<typename T>
+static void microKernel(
+    const simd::BasicKernels<T>& k, std::size_t kc,
+    T alpha, const T* a, const T* b,
+    T beta, T* c, std::size_t rsc, std::size_t csc,
+    std::size_t mr, std::size_t nr,
+    const GemmEpilogue<T>* epilogue, std::size_t i0, std::size_t j0
+) {
+    constexpr std::size_t NR = simd::gemmNRFor<T>;
+    alignas(64) T acc[MR * NR];
+    k.gemmTile(kc, a, b, acc);
+    if (epilogue == nullptr) {
+        mergeTile(acc, alpha, beta, c, rsc, csc, mr, nr, [](T v, std::size_t, std::size_t) { return v; });
+        return;
+    }
+    const T* bias = epilogue->bias;
+    const bool perRow = epilogue->biasPerRow;
+    dispatchActivation(epilogue->activation, [&](auto activation) {
+        mergeTile(acc, alpha, beta, c, rsc, csc, mr, nr, [&](T v, std::size_t r, std::size_t j) {
+            if (bias != nullptr) {
+                v += bias[perRow ? i0 + r : j0 + j];
+            }
+            return activate<decltype(activation)::value>(v);
+        });
+    });
+}
+
+template<typename T>
+static void scale(std::size_t m, std::size_t n, T beta, T* c, std::size_t rsc, std::size_t csc) {
+    for (std::size_t i = 0; i < m; i++) {
+        for (std::size_t j = 0; j < n; j++) {
+            T& out = c[i * rsc + j * csc];
+            out = (beta == T(0)) ? T(0) : beta * out;
+        }
+    }
+}
+
+// The epilogue on its own, for products that need no micro-kernel.
+template<typename T>
+static void applyEpilogue(const GemmEpilogue<T>& epilogue, std::size_t m, std::size_t n, T* c, std::size_t rsc, std::size_t csc) {
+    dispatchActivation(epilogue.activation, [&](auto activation) {
+        for (std::size_t i = 0; i < m; i++) {
+            for (std::size_t j = 0; j < n; j++) {
+                T& out = c[i * rsc + j * csc];
+                const T v = (epilogue.bias != nullptr) ? out + epilogue.bias[epilogue.biasPerRow ? i : j] : out;
+                out = activate<decltype(activation)::value>(v);
+            }
+        }
+    });
+}
+
+// Pack buffers of one thread, shared by every operand type computed in T.
+// They live as long as their thread, so they must not come from a scoped
+// arena the caller may have selected.
+template<typename T>
+static T* packBufferB(std::size_t size) {
+    thread_local PackBuffer<T> buffer;
+    if (buffer.size() < size) {
+        memory::ScopedResource longLived(memory::defaultResource());
+        buffer.resize(size);
+    }
+    return buffer.data();
+}
+
+template<typename T>
+static T* packBufferA() {
+    thread_local PackBuffer<T> buffer;
+    if (buffer.empty()) {
+        memory::ScopedResource longLived(memory::defaultResource());
+        buffer.resize(MC * KC);
+    }
+    return buffer.data();
+}
+
+// Row blocks of A are shared out between threads; they are shrunk below MC
+// when there would not be one per thread.
+static std::size_t rowBlockStep(std::size_t m) {
+    std::size_t threads = nbThreads();
+    if (maxThreadsLimit() > 0) {
+        threads = std::min(threads, maxThreadsLimit());
+    }
+    return std::min(MC, std::max(MR, ((m + threads - 1) / threads + MR - 1) / MR * MR));
+}
+
+// C = alpha * A * B + beta * C computed in T, with A and B stored as TA and TB,
+// and the epilogue, if any, applied to the result.
+template<typename T, typename TA, typename TB>
+static void blockedGemm(
+    std::size_t m, std::size_t n, std::size_t k,
+    T alpha,
+    const TA* a, std::size_t rsa, std::size_t csa,
+    const TB* b, std::size_t rsb, std::size_t csb,
+    T beta,
+    T* c, std::size_t rsc, std::size_t csc,
+    const GemmEpilogue<T>* epilogue = nullptr
+) {
+    constexpr std::size_t NR = simd::gemmNRFor<T>;
+    NN_PROFILE_SCOPE(
+        Dot, "gemm",
+        static_cast<double>(m * k * sizeof(TA) + k * n * sizeof(TB) + 2 * m * n * sizeof(T)),
+        2.0 * static_cast<double>(m) * n * k
+    );
+    if (m == 0 || n == 0) {
+        return;
+    }
+    if (k == 0 || alpha == T(0)) {
+        scale(m, n, beta, c, rsc, csc);
+        if (epilogue != nullptr) {
+            applyEpilogue(*epilogue, m, n, c, rsc, csc);
+        }
+        return;
+    }
+
+    const simd::BasicKernels<T>& kernels = simd::kernels<T>();
+    T* panelB = packBufferB<T>(KC * ((std::min(NC, n) + NR - 1) / NR) * NR);
+
+    const std::size_t mcStep = rowBlockStep(m);
+    const std::size_t nbBlocks = (m + mcStep - 1) / mcStep;
+
+    for (std::size_t jc = 0; jc < n; jc += NC) {
+        const std::size_t nc = std::min(NC, n - jc);
+        for (std::size_t pc = 0; pc < k; pc += KC) {
+            const std::size_t kc = std::min(KC, k - pc);
+            // Only the first slice of k sees the caller's beta, later ones
+            // accumulate into what has already been written.
+            const T betaPc = (pc == 0) ? beta : T(1);
+            // The epilogue goes with the last one.
+            const GemmEpilogue<T>* epiloguePc = (pc + kc == k) ? epilogue : nullptr;
+            const std::size_t panelsB = (nc + NR - 1) / NR;
+            parallelFor(0, panelsB, std::max<std::size_t>(1, parallelGrain / (kc * NR)), [&](std::size_t first, std::size_t last) {
+                const std::size_t j0 = first * NR;
+                const std::size_t j1 = std::min(nc, last * NR);
+                packB(kc, j1 - j0, b + pc * rsb + (jc + j0) * csb, rsb, csb, panelB + j0 * kc);
+            });
+            const std::size_t grain = (m * nc * kc >= parallelGrain) ? 1 : nbBlocks;
+            parallelFor(0, nbBlocks, grain, [&](std::size_t first, std::size_t last) {
+                T* packedA = packBufferA<T>();
+                for (std::size_t block = first; block < last; block++) {
+                    const std::size_t ic = block * mcStep;
+                    const std::size_t mc = std::min(mcStep, m - ic);
+                    packA(mc, kc, a + ic * rsa + pc * csa, rsa, csa, packedA);
+                    for (std::size_t jr = 0; jr < nc; jr += NR) {
+                        const std::size_t nr = std::min(NR, nc - jr);
+                        for (std::size_t ir = 0; ir < mc; ir += MR) {
+                            const std::size_t mr = std::min(MR, mc - ir);
+                            microKernel(
+                                kernels, kc, alpha,
+                                packedA + ir * kc,
+                                panelB + jr * kc,
+                                betaPc,
+                                c + (ic + ir) * rsc + (jc + jr) * csc, rsc, csc,
+                                mr, nr,
+                                epiloguePc, ic + ir, jc + jr
+                            );
+                        }
+                    }
+                }
+            });
+        }
+    }
+}
+
+void gemm(
+    std::size_t m, std::size_t n, std::size_t k,
+    double alpha,
+    const double* a, std::size_t rsa, std::size_t csa,
+    const double* b, std::size_t rsb, std::size_t csb,
+    double beta,
+    double* c, std::size_t rsc, std::size_t csc
+) {
+    blockedGemm(m, n, k, alpha, a, rsa, csa, b, rsb, csb, beta, c, rsc, csc);
+}
+
+void gemm(
+    std::size_t m, std::size_t n, std::size_t k,
+    float alpha,
+    const float* a, std::size_t rsa, std::size_t csa,
+    const float* b, std::size_t rsb, std::size_t csb,
+    float beta,
+    float* c, std::size_t rsc, std::size_t csc
+) {
+    blockedGemm(m, n, k, alpha, a, rsa, csa, b, rsb, csb, beta, c, rsc, csc);
+}
+
+void gemm(
+    std::size_t m, std::size_t n, std::size_t k,
+    double alpha,
+    const double* a, std::size_t rsa, std::size_t csa,
+    const double* b, std::size_t rsb, std::size_t csb,
+    double beta,
+    double* c, std::size_t rsc, std::size_t csc,
+    const GemmEpilogue<double>& epilogue
+) {
+    blockedGemm(m, n, k, alpha, a, rsa, csa, b, rsb, csb, beta, c, rsc, csc, &epilogue);
+}
+
+void gemm(
+    std::size_t m, std::size_t n, std::size_t k,
+    float alpha,
+    const float* a, std::size_t rsa, std::size_t csa,
+    const float* b, std::size_t rsb, std::size_t csb,
+    float beta,
+    float* c, std::size_t rsc, std::size_t csc,
+    const GemmEpilogue<float>& epilogue
+) {
+    blockedGemm(m, n, k, alpha, a, rsa, csa, b, rsb, csb, beta, c, rsc, csc, &epilogue);
+}
+
+void gemm(
+    std::size_t m, std::size_t n, std::size_t k,
+    float alpha,
+    const float* a, std::size_t rsa, std::size_t csa,
+    const BFloat16* b, std::size_t rsb, std::size_t csb,
+    float beta,
+    float* c, std::size_t rsc, std::size_t csc
+) {
+    blockedGemm(m, n, k, alpha, a, rsa, csa, b, rsb, csb, beta, c, rsc, csc);
+}
+
+void gemm(
+    std::size_t m, std::size_t n, std::size_t k,
+    float alpha,
+    const BFloat16* a, std::size_t rsa, std::size_t csa,
+    const BFloat16* b, std::size_t rsb, std::size_t csb,
+    float beta,
+    float* c, std::size_t rsc, std::size_t csc
+) {
+    blockedGemm(m, n, k, alpha, a, rsa, csa, b, rsb, csb, beta, c, rsc, csc);
+}
+
+void gemm(
+    std::size_t m, std::size_t n, std::size_t k,
+    float alpha,
+    const float* a, std::size_t rsa, std::size_t csa,
+    const Float16* b, std::size_t rsb, std::size_t csb,
+    float beta,
+    float* c, std::size_t rsc, std::size_t csc
+) {
+    blockedGemm(m, n, k, alpha, a, rsa, csa, b, rsb, csb, beta, c, rsc, csc);
+}
+
+void gemm(
+    std::size_t m, std::size_t n, std::size_t k,
+    float alpha,
+    const Float16* a, std::size_t rsa, std::size_t csa,
+    const Float16* b, std::size_t rsb, std::size_t csb,
+    float beta,
+    float* c, std::size_t rsc, std::size_t csc
+) {
+    blockedGemm(m, n, k, alpha, a, rsa, csa, b, rsb, csb, beta, c, rsc, csc);
+}
+
+// Int8 GEMM. Both operands are packed as int16 pairs of consecutive k (see
+// simd::Int8Kernels), with kc rounded up to even by a zero row.
+
+static std::size_t roundUpEven(std::size_t kc) {
+    return (kc + 1) & ~std::size_t(1);
+}
+
+static void packAInt8(
+    std::size_t mc, std::size_t kc,
+    const std::int8_t* a, std::size_t rsa, std::size_t csa,
+    std::int16_t* packed
+) {
+    for (std::size_t i = 0; i < mc; i += MR) {
+        const std::size_t mr = std::min(MR, mc - i);
+        for (std::size_t p = 0; p < kc; p += 2) {
+            for (std::size_t r = 0; r < mr; r++) {
+                const std::int8_t* row = a + (i + r) * rsa;
+                packed[2 * r] = row[p * csa];
+                packed[2 * r + 1] = (p + 1 < kc) ? row[(p + 1) * csa] : 0;
+            }
+            for (std::size_t r = mr; r < MR; r++) {
+                packed[2 * r] = 0;
+                packed[2 * r + 1] = 0;
+            }
+            packed += 2 * MR;
+        }
+    }
+}
+
+static void packBInt8(
+    std::size_t kc, std::size_t nc,
+    const std::int8_t* b, std::size_t rsb, std::size_t csb,
+    std::int16_t* packed
+) {
+    constexpr std::size_t NR = simd::gemmNRFor<std::int32_t>;
+    for (std::size_t j = 0; j < nc; j += NR) {
+        const std::size_t nr = std::min(NR, nc - j);
+        for (std::size_t p = 0; p < kc; p += 2) {
+            for (std::size_t c = 0; c < nr; c++) {
+                const std::int8_t* col = b + (j + c) * csb;
+                packed[2 * c] = col[p * rsb];
+                packed[2 * c + 1] = (p + 1 < kc) ? col[(p + 1) * rsb] : 0;
+            }
+            for (std::size_t c = nr; c < NR; c++) {
+                packed[2 * c] = 0;
+                packed[2 * c + 1] = 0;
+            }
+            packed += 2 * NR;
+        }
+    }
+}
+
+static void microKernelInt8(
+    const simd::Int8Kernels& k, std::size_t kc,
+    const std::int16_t* a, const std::int16_t* b,
+    bool accumulate, std::int32_t* c, std::size_t rsc, std::size_t csc,
+    std::size_t mr, std::size_t nr
+) {
+    constexpr std::size_t NR = simd::gemmNRFor<std::int32_t>;
+    alignas(64) std::int32_t acc[MR * NR];
+    k.gemmTile(kc, a, b, acc);
+    for (std::size_t r = 0; r < mr; r++) {
+        for (std::size_t j = 0; j < nr; j++) {
+            std::int32_t& out = c[r * rsc + j * csc];
+            out = accumulate ? out + acc[r * NR + j] : acc[r * NR + j];
+        }
+    }
+}
+
+void gemm(
+    std::size_t m, std::size_t n, std::size_t k,
+    const std::int8_t* a, std::size_t rsa, std::size_t csa,
+    const std::int8_t* b, std::size_t rsb, std::size_t csb,
+    std::int32_t* c, std::size_t rsc, std::size_t csc
+) {
+    constexpr std::size_t NR = simd::gemmNRFor<std::int32_t>;
+    NN_PROFILE_SCOPE(
+        Dot, "gemm int8",
+        static_cast<double>(m * k + k * n + m * n * sizeof(std::int32_t)),
+        2.0 * static_cast<double>(m) * n * k
+    );
+    if (m == 0 || n == 0) {
+        return;
+    }
+    if (k == 0) {
+        scale(m, n, std::int32_t(0), c, rsc, csc);
+        return;
+    }
+
+    const simd::Int8Kernels& kernels = simd::int8Kernels();
+    std::int16_t* panelB = packBufferB<std::int16_t>(KC * ((std::min(NC, n) + NR - 1) / NR) * NR);
+    const std::size_t mcStep = rowBlockStep(m);
+    const std::size_t nbBlocks = (m + mcStep - 1) / mcStep;
+
+    for (std::size_t jc = 0; jc < n; jc += NC) {
+        const std::size_t nc = std::min(NC, n - jc);
+        for (std::size_t pc = 0; pc < k; pc += KC) {
+            const std::size_t kc = std::min(KC, k - pc);
+            const std::size_t kcPacked = roundUpEven(kc);
+            const std::size_t panelsB = (nc + NR - 1) / NR;
+            parallelFor(0, panelsB, std::max<std::size_t>(1, parallelGrain / (kc * NR)), [&](std::size_t first, std::size_t last) {
+                const std::size_t j0 = first * NR;
+                const std::size_t j1 = std::min(nc, last * NR);
+                packBInt8(kc, j1 - j0, b + pc * rsb + (jc + j0) * csb, rsb, csb, panelB + j0 * kcPacked);
+            });
+            const std::size_t grain = (m * nc * kc >= parallelGrain) ? 1 : nbBlocks;
+            parallelFor(0, nbBlocks, grain, [&](std::size_t first, std::size_t last) {
+                std::int16_t* packedA = packBufferA<std::int16_t>();
+                for (std::size_t block = first; block < last; block++) {
+                    const std::size_t ic = block * mcStep;
+                    const std::size_t mc = std::min(mcStep, m - ic);
+                    packAInt8(mc, kc, a + ic * rsa + pc * csa, rsa, csa, packedA);
+                    for (std::size_t jr = 0; jr < nc; jr += NR) {
+                        const std::size_t nr = std::min(NR, nc - jr);
+                        for (std::size_t ir = 0; ir < mc; ir += MR) {
+                            const std::size_t mr = std::min(MR, mc - ir);
+                            microKernelInt8(
+                                kernels, kcPacked,
+                                packedA + ir * kcPacked,
+                                panelB + jr * kcPacked,
+                                pc > 0,
+                                c + (ic + ir) * rsc + (jc + jr) * csc, rsc, csc,
+                                mr, nr
+                            );
+                        }
+                    }
+                }
+            });
+        }
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "gemm/Epilogue.hpp"
+#include "half/Half.hpp"
+
+// Blocked general matrix multiply on strided row/column storage:
+//
+//     C = alpha * A * B + beta * C
+//
+// A is m x k, B is k x n and C is m x n. Element (i, j) of an operand X lives
+// at x[i * rsx + j * csx], so transposed operands are passed by swapping
+// their strides. When beta is 0, C is not read.
+void gemm(
+    std::size_t m, std::size_t n, std::size_t k,
+    double alpha,
+    const double* a, std::size_t rsa, std::size_t csa,
+    const double* b, std::size_t rsb, std::size_t csb,
+    double beta,
+    double* c, std::size_t rsc, std::size_t csc
+);
+
+void gemm(
+    std::size_t m, std::size_t n, std::size_t k,
+    float alpha,
+    const float* a, std::size_t rsa, std::size_t csa,
+    const float* b, std::size_t rsb, std::size_t csb,
+    float beta,
+    float* c, std::size_t rsc, std::size_t csc
+);
+
+// Same, followed by c = act(c + bias) on every element of C, fused into
+// the write-back of the last k block of each tile (see gemm/Epilogue.hpp).
+void gemm(
+    std::size_t m, std::size_t n, std::size_t k,
+    double alpha,
+    const double* a, std::size_t rsa, std::size_t csa,
+    const double* b, std::size_t rsb, std::size_t csb,
+    double beta,
+    double* c, std::size_t rsc, std::size_t csc,
+    const GemmEpilogue<double>& epilogue
+);
+
+void gemm(
+    std::size_t m, std::size_t n, std::size_t k,
+    float alpha,
+    const float* a, std::size_t rsa, std::size_t csa,
+    const float* b, std::size_t rsb, std::size_t csb,
+    float beta,
+    float* c, std::size_t rsc, std::size_t csc,
+    const GemmEpilogue<float>& epilogue
+);
+
+// Mixed precision: A and/or B stored in 16 bits (e.g. weights kept in
+// bfloat16), widened to float while they are packed. The micro-kernel and
+// the accumulation into C run in float.
+void gemm(
+    std::size_t m, std::size_t n, std::size_t k,
+    float alpha,
+    const float* a, std::size_t rsa, std::size_t csa,
+    const BFloat16* b, std::size_t rsb, std::size_t csb,
+    float beta,
+    float* c, std::size_t rsc, std::size_t csc
+);
+
+void gemm(
+    std::size_t m, std::size_t n, std::size_t k,
+    float alpha,
+    const BFloat16* a, std::size_t rsa, std::size_t csa,
+    const BFloat16* b, std::size_t rsb, std::size_t csb,
+    float beta,
+    float* c, std::size_t rsc, std::size_t csc
+);
+
+void gemm(
+    std::size_t m, std::size_t n, std::size_t k,
+    float alpha,
+    const float* a, std::size_t rsa, std::size_t csa,
+    const Float16* b, std::size_t rsb, std::size_t csb,
+    float beta,
+    float* c, std::size_t rsc, std::size_t csc
+);
+
+void gemm(
+    std::size_t m, std::size_t n, std::size_t k,
+    float alpha,
+    const Float16* a, std::size_t rsa, std::size_t csa,
+    const Float16* b, std::size_t rsb, std::size_t csb,
+    float beta,
+    float* c, std::size_t rsc, std::size_t csc
+);
+
+// Exact int8 product for the quantized path: C = A * B accumulated in int32,
+// with C overwritten. Scales and zero points are applied by the caller, see
+// quant/Quantize.hpp.
+void gemm(
+    std::size_t m, std::size_t n, std::size_t k,
+    const std::int8_t* a, std::size_t rsa, std::size_t csa,
+    const std::int8_t* b, std::size_t rsb, std::size_t csb,
+    std::int32_t* c, std::size_t rsc, std::size_t csc
+);
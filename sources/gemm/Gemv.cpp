@@ -0,0 +1,114 @@
+#include <algorithm>
+
+#include "gemm/Gemv.hpp"
+#include "parallel/ThreadPool.hpp"
+#include "profile/Profiler.hpp"
+#include "simd/Simd.hpp"
+
+// Rows of A handled per dot4 / columns per axpy4.
+constexpr std::size_t rowGroup = 4;
+
+// y[first, last) for row-contiguous A.
+template<typename T>
+static void gemvRows(
+    const simd::BasicKernels<T>& k, std::size_t first, std::size_t last, std::size_t n,
+    T alpha, const T* a, std::size_t rsa, const T* x, T beta, T* y
+) {
+    T dots[rowGroup];
+    std::size_t i = first;
+    for (; i + rowGroup <= last; i += rowGroup) {
+        k.dot4(a + i * rsa, rsa, x, dots, n);
+        for (std::size_t r = 0; r < rowGroup; r++) {
+            y[i + r] = (beta == T(0)) ? alpha * dots[r] : alpha * dots[r] + beta * y[i + r];
+        }
+    }
+    for (; i < last; i++) {
+        const T dot = k.dot(a + i * rsa, x, n);
+        y[i] = (beta == T(0)) ? alpha * dot : alpha * dot + beta * y[i];
+    }
+}
+
+// y[first, last) for column-contiguous A.
+template<typename T>
+static void gemvColumns(
+    const simd::BasicKernels<T>& k, std::size_t first, std::size_t last, std::size_t n,
+    T alpha, const T* a, std::size_t csa, const T* x, T beta, T* y
+) {
+    const std::size_t len = last - first;
+    if (beta == T(0)) {
+        std::fill(y + first, y + last, T(0));
+    } else if (beta != T(1)) {
+        k.mulScalar(y + first, beta, y + first, len);
+    }
+    T scaled[rowGroup];
+    std::size_t j = 0;
+    for (; j + rowGroup <= n; j += rowGroup) {
+        for (std::size_t r = 0; r < rowGroup; r++) {
+            scaled[r] = alpha * x[j + r];
+        }
+        k.axpy4(scaled, a + j * csa + first, csa, y + first, len);
+    }
+    for (; j < n; j++) {
+        k.axpy(alpha * x[j], a + j * csa + first, y + first, len);
+    }
+}
+
+template<typename T>
+static void stridedGemv(
+    std::size_t m, std::size_t n,
+    T alpha,
+    const T* a, std::size_t rsa, std::size_t csa,
+    const T* x,
+    T beta,
+    T* y
+) {
+    NN_PROFILE_SCOPE(Dot, "gemv", static_cast<double>((m * n + n + 2 * m) * sizeof(T)), 2.0 * static_cast<double>(m) * n);
+    if (m == 0) {
+        return;
+    }
+    const simd::BasicKernels<T>& k = simd::kernels<T>();
+    // Each block of y costs about n multiply-adds per element.
+    const std::size_t grain = std::max<std::size_t>(rowGroup, parallelGrain / std::max<std::size_t>(1, n) / rowGroup * rowGroup);
+
+    if (csa == 1) {
+        parallelFor(0, m, grain, [&](std::size_t first, std::size_t last) {
+            gemvRows(k, first, last, n, alpha, a, rsa, x, beta, y);
+        });
+    } else if (rsa == 1) {
+        parallelFor(0, m, grain, [&](std::size_t first, std::size_t last) {
+            gemvColumns(k, first, last, n, alpha, a, csa, x, beta, y);
+        });
+    } else {
+        parallelFor(0, m, grain, [&](std::size_t first, std::size_t last) {
+            for (std::size_t i = first; i < last; i++) {
+                T dot = T(0);
+                for (std::size_t j = 0; j < n; j++) {
+                    dot += a[i * rsa + j * csa] * x[j];
+                }
+                y[i] = (beta == T(0)) ? alpha * dot : alpha * dot + beta * y[i];
+            }
+        });
+    }
+}
+
+void gemv(
+    std::size_t m, std::size_t n,
+    double alpha,
+    const double* a, std::size_t rsa, std::size_t csa,
+    const double* x,
+    double beta,
+    double* y
+) {
+    stridedGemv(m, n, alpha, a, rsa, csa, x, beta, y);
+}
+
+void gemv(
+    std::size_t m, std::size_t n,
+    float alpha,
+    const float* a, std::size_t rsa, std::size_t csa,
+    const float* x,
+    float beta,
+    float* y
+) {
+    stridedGemv(m, n, alpha, a, rsa, csa, x, beta, y);
+}
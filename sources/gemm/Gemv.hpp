@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+
+// Matrix-vector product on strided storage:
+//
+//     y = alpha * A * x + beta * y
+//
+// A is m x n and element (i, j) lives at a[i * rsa + j * csa], so A^T x is
+// computed by swapping the strides (and m and n). x and y are contiguous and
+// must not overlap A or each other. When beta is 0, y is not read.
+//
+// Row-contiguous A (csa == 1) takes dot products of four rows at a time with
+// x; column-contiguous A (rsa == 1) accumulates four scaled columns at a time
+// into y. Tall problems are split over the thread pool by blocks of y, so no
+// reduction between threads is needed and nothing is allocated.
+void gemv(
+    std::size_t m, std::size_t n,
+    double alpha,
+    const double* a, std::size_t rsa, std::size_t csa,
+    const double* x,
+    double beta,
+    double* y
+);
+
+void gemv(
+    std::size_t m, std::size_t n,
+    float alpha,
+    const float* a, std::size_t rsa, std::size_t csa,
+    const float* x,
+    float beta,
+    float* y
+);
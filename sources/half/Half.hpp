@@ -0,0 +1,149 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <type_traits>
+
+// 16-bit floating point storage types. Both convert implicitly to and from
+// float, so arithmetic on them is carried out in float and rounded back when
+// stored; the kernels that matter (dot products, GEMM, sums) widen whole
+// blocks with SIMD instead and accumulate in float.
+//
+// BFloat16 keeps the 8-bit exponent of float and truncates the mantissa to
+// 7 bits: same range as float, about 3 significant digits. Float16 is IEEE
+// binary16: 5-bit exponent (largest finite value 65504), 10-bit mantissa.
+// Conversions from float round to nearest even.
+
+class BFloat16 {
+
+private:
+
+    std::uint16_t m_bits;
+
+public:
+
+    static constexpr std::uint16_t fromFloat(float value) {
+        const std::uint32_t bits = std::bit_cast<std::uint32_t>(value);
+        if ((bits & 0x7FFFFFFFu) > 0x7F800000u) {
+            // NaN: keep the sign and the top of the payload, force it quiet.
+            return static_cast<std::uint16_t>((bits >> 16) | 0x0040u);
+        }
+        const std::uint32_t rounding = 0x7FFFu + ((bits >> 16) & 1u);
+        return static_cast<std::uint16_t>((bits + rounding) >> 16);
+    }
+
+    static constexpr float toFloat(std::uint16_t bits) {
+        return std::bit_cast<float>(static_cast<std::uint32_t>(bits) << 16);
+    }
+
+    // Constructors
+    BFloat16() = default;
+    constexpr BFloat16(float value) : m_bits(fromFloat(value)) {};
+
+    static constexpr BFloat16 fromBits(std::uint16_t bits) {
+        BFloat16 result;
+        result.m_bits = bits;
+        return result;
+    }
+
+    // Operators
+    constexpr operator float() const {
+        return toFloat(m_bits);
+    }
+
+    // Other members
+    constexpr std::uint16_t bits() const {
+        return m_bits;
+    }
+
+};
+
+class Float16 {
+
+private:
+
+    std::uint16_t m_bits;
+
+public:
+
+    static constexpr std::uint16_t fromFloat(float value) {
+        const std::uint32_t bits = std::bit_cast<std::uint32_t>(value);
+        const std::uint16_t sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000u);
+        const std::uint32_t magnitude = bits & 0x7FFFFFFFu;
+        if (magnitude >= 0x7F800000u) {
+            // Infinity, or a quiet NaN keeping the top of the payload.
+            return sign | ((magnitude > 0x7F800000u) ? static_cast<std::uint16_t>(0x7E00u | ((magnitude >> 13) & 0x3FFu)) : 0x7C00u);
+        }
+        if (magnitude >= 0x477FF000u) {
+            // Rounds above 65504.
+            return sign | 0x7C00u;
+        }
+        if (magnitude < 0x38800000u) {
+            // Subnormal (or zero) in binary16: align the implicit bit on
+            // 2^-24 and round to nearest even.
+            if (magnitude < 0x33000000u) {
+                return sign;
+            }
+            const std::uint32_t exponent = magnitude >> 23;
+            const std::uint32_t mantissa = (magnitude & 0x7FFFFFu) | 0x800000u;
+            const std::uint32_t shift = 126u - exponent;
+            const std::uint32_t halfway = 1u << (shift - 1);
+            const std::uint32_t rest = mantissa & ((1u << shift) - 1u);
+            std::uint32_t result = mantissa >> shift;
+            if (rest > halfway || (rest == halfway && (result & 1u))) {
+                result++;
+            }
+            return sign | static_cast<std::uint16_t>(result);
+        }
+        // Normal: rebias the exponent from 127 to 15, then round the 13
+        // dropped mantissa bits to nearest even (a carry bumps the exponent).
+        const std::uint32_t rebased = magnitude - (112u << 23);
+        const std::uint32_t rounding = 0xFFFu + ((rebased >> 13) & 1u);
+        return sign | static_cast<std::uint16_t>((rebased + rounding) >> 13);
+    }
+
+    static constexpr float toFloat(std::uint16_t bits) {
+        const std::uint32_t sign = static_cast<std::uint32_t>(bits & 0x8000u) << 16;
+        const std::uint32_t exponent = (bits >> 10) & 0x1Fu;
+        const std::uint32_t mantissa = bits & 0x3FFu;
+        if (exponent == 0x1Fu) {
+            // Infinity, or a NaN made quiet as the F16C conversions do.
+            return std::bit_cast<float>(sign | 0x7F800000u | (mantissa << 13) | ((mantissa != 0) ? 0x400000u : 0u));
+        }
+        if (exponent == 0) {
+            // Zero or subnormal: mantissa * 2^-24, exact in float.
+            const float value = static_cast<float>(mantissa) * 0x1p-24f;
+            return sign ? -value : value;
+        }
+        return std::bit_cast<float>(sign | ((exponent + 112u) << 23) | (mantissa << 13));
+    }
+
+    // Constructors
+    Float16() = default;
+    constexpr Float16(float value) : m_bits(fromFloat(value)) {};
+
+    static constexpr Float16 fromBits(std::uint16_t bits) {
+        Float16 result;
+        result.m_bits = bits;
+        return result;
+    }
+
+    // Operators
+    constexpr operator float() const {
+        return toFloat(m_bits);
+    }
+
+    // Other members
+    constexpr std::uint16_t bits() const {
+        return m_bits;
+    }
+
+};
+
+template<typename T>
+constexpr bool isHalf = std::is_same_v<T, BFloat16> || std::is_same_v<T, Float16>;
+
+// Type sums and products of T are accumulated in: float for the 16-bit
+// types, T itself otherwise.
+template<typename T>
+using Accumulator = std::conditional_t<isHalf<T>, float, T>;
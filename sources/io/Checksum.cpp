@@ -0,0 +1,84 @@
+#include <array>
+#include <cstring>
+
+#include "io/Checksum.hpp"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define NN_CRC32C_X86 1
+#endif
+
+// Reflected Castagnoli polynomial.
+static constexpr std::uint32_t polynomial = 0x82F63B78u;
+
+using CrcTables = std::array<std::array<std::uint32_t, 256>, 8>;
+
+// tables[0] is the usual byte table; tables[k][b] advances the CRC of byte b
+// by k more zero bytes, so eight bytes are folded per step.
+static CrcTables makeTables() {
+    CrcTables tables{};
+    for (std::uint32_t b = 0; b < 256; b++) {
+        std::uint32_t crc = b;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ polynomial : crc >> 1;
+        }
+        tables[0][b] = crc;
+    }
+    for (std::size_t k = 1; k < 8; k++) {
+        for (std::uint32_t b = 0; b < 256; b++) {
+            const std::uint32_t previous = tables[k - 1][b];
+            tables[k][b] = (previous >> 8) ^ tables[0][previous & 0xFF];
+        }
+    }
+    return tables;
+}
+
+static std::uint32_t crc32cTable(const unsigned char* p, std::size_t bytes, std::uint32_t crc) {
+    static const CrcTables tables = makeTables();
+    for (; bytes >= 8; bytes -= 8, p += 8) {
+        std::uint32_t lo;
+        std::uint32_t hi;
+        std::memcpy(&lo, p, 4);
+        std::memcpy(&hi, p + 4, 4);
+        lo ^= crc;
+        crc = tables[7][lo & 0xFF] ^ tables[6][(lo >> 8) & 0xFF] ^ tables[5][(lo >> 16) & 0xFF] ^ tables[4][lo >> 24]
+            ^ tables[3][hi & 0xFF] ^ tables[2][(hi >> 8) & 0xFF] ^ tables[1][(hi >> 16) & 0xFF] ^ tables[0][hi >> 24];
+    }
+    for (; bytes > 0; bytes--, p++) {
+        crc = (crc >> 8) ^ tables[0][(crc ^ *p) & 0xFF];
+    }
+    return crc;
+}
+
+#ifdef NN_CRC32C_X86
+__attribute__((target("sse4.2")))
+static std::uint32_t crc32cHardware(const unsigned char* p, std::size_t bytes, std::uint32_t crc) {
+    std::uint64_t c = crc;
+    for (; bytes >= 8; bytes -= 8, p += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, p, 8);
+        c = _mm_crc32_u64(c, word);
+    }
+    std::uint32_t c32 = static_cast<std::uint32_t>(c);
+    for (; bytes > 0; bytes--, p++) {
+        c32 = _mm_crc32_u8(c32, *p);
+    }
+    return c32;
+}
+#endif
+
+namespace io {
+
+std::uint32_t crc32c(const void* data, std::size_t bytes, std::uint32_t crc) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+#ifdef NN_CRC32C_X86
+    static const bool hardware = __builtin_cpu_supports("sse4.2");
+    if (hardware) {
+        return ~crc32cHardware(p, bytes, crc);
+    }
+#endif
+    return ~crc32cTable(p, bytes, crc);
+}
+
+}
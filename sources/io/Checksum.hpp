@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace io {
+
+// CRC-32C (Castagnoli) of bytes bytes at data, continuing from a previous
+// result crc so that a buffer can be checksummed in pieces. Uses the SSE4.2
+// crc32 instruction when the CPU has it, and a slicing-by-8 table otherwise;
+// both give the same value.
+std::uint32_t crc32c(const void* data, std::size_t bytes, std::uint32_t crc = 0);
+
+}
@@ -0,0 +1,465 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+#include "io/Checksum.hpp"
+#include "io/TensorFile.hpp"
+#include "profile/Profiler.hpp"
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define NN_TENSOR_FILE_MMAP 1
+#endif
+
+// On-disk layout, see TensorFile.hpp. Records are read and written with
+// memcpy, so nothing in the mapping needs to be aligned but the data blocks.
+
+static constexpr char magic[8] = {'N', 'N', 'T', 'E', 'N', 'S', 'O', 'R'};
+static constexpr std::uint32_t formatVersion = 1;
+// Reads back as 0x04030201 on a big-endian machine.
+static constexpr std::uint32_t byteOrderMark = 0x01020304;
+static constexpr std::uint64_t blockAlignment = 64;
+static constexpr std::uint32_t maxRank = 64;
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint64_t count;
+    std::uint64_t indexBytes;
+    std::uint32_t indexChecksum;
+    std::uint32_t alignment;
+    std::uint32_t reserved[5];
+    // CRC-32C of the fields above.
+    std::uint32_t headerChecksum;
+};
+
+static_assert(sizeof(FileHeader) == 64, "Tensor file header must be 64 bytes.");
+
+// Fixed part of an index record, followed by rank shapes, rank strides and
+// the name padded to 8 bytes.
+struct RecordHeader {
+    std::uint32_t dtype;
+    std::uint32_t rank;
+    std::uint32_t nameBytes;
+    std::uint32_t checksum;
+    std::uint64_t offset;
+    std::uint64_t bytes;
+};
+
+static_assert(sizeof(RecordHeader) == 32, "Tensor file records must be packed.");
+
+static std::uint64_t alignUp(std::uint64_t value, std::uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static std::uint64_t recordBytes(std::size_t rank, std::size_t nameBytes) {
+    return sizeof(RecordHeader) + 16 * rank + alignUp(nameBytes, 8);
+}
+
+static std::uint32_t headerChecksum(const FileHeader& header) {
+    return io::crc32c(&header, offsetof(FileHeader, headerChecksum));
+}
+
+static bool knownDType(std::uint32_t dtype) {
+    return dtype <= static_cast<std::uint32_t>(io::DType::Int64);
+}
+
+// a * b, or false on overflow.
+static bool checkedMul(std::uint64_t a, std::uint64_t b, std::uint64_t& out) {
+    return !__builtin_mul_overflow(a, b, &out);
+}
+
+[[noreturn]] static void corrupt(const std::string& path, const std::string& reason) {
+    throw std::runtime_error("Invalid tensor file '" + path + "': " + reason + ".");
+}
+
+namespace io {
+
+std::size_t dtypeSize(DType dtype) {
+    switch (dtype) {
+        case DType::Float64: return 8;
+        case DType::Float32: return 4;
+        case DType::BFloat16: return 2;
+        case DType::Float16: return 2;
+        case DType::Int8: return 1;
+        case DType::UInt8: return 1;
+        case DType::Int16: return 2;
+        case DType::Int32: return 4;
+        case DType::Int64: return 8;
+    }
+    throw std::invalid_argument("Unknown tensor dtype.");
+}
+
+const char* dtypeName(DType dtype) {
+    switch (dtype) {
+        case DType::Float64: return "float64";
+        case DType::Float32: return "float32";
+        case DType::BFloat16: return "bfloat16";
+        case DType::Float16: return "float16";
+        case DType::Int8: return "int8";
+        case DType::UInt8: return "uint8";
+        case DType::Int16: return "int16";
+        case DType::Int32: return "int32";
+        case DType::Int64: return "int64";
+    }
+    return "unknown";
+}
+
+std::size_t TensorInfo::size() const {
+    return std::accumulate(shape.begin(), shape.end(), std::size_t(1), std::multiplies<std::size_t>());
+}
+
+// TensorWriter
+
+void TensorWriter::addEntry(Entry entry) {
+    if (m_names.count(entry.name) != 0) {
+        throw std::invalid_argument("Tensor '" + entry.name + "' was already added.");
+    }
+    if (entry.shape.size() > maxRank) {
+        throw std::invalid_argument("Tensor '" + entry.name + "' has too many dimensions to be stored.");
+    }
+    m_names.emplace(entry.name, m_entries.size());
+    m_entries.push_back(std::move(entry));
+}
+
+std::size_t TensorWriter::size() const {
+    return m_entries.size();
+}
+
+void TensorWriter::clear() {
+    m_entries.clear();
+    m_names.clear();
+}
+
+void TensorWriter::write(const std::string& path) const {
+    NN_PROFILE_SCOPE(Io, "TensorWriter::write", 0, 0);
+    // Truncating path in place would pull the pages from under any process
+    // that has it mapped (SIGBUS); a rename leaves them the old file.
+    const std::string temporary = path + ".tmp";
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Cannot open '" + temporary + "' for writing.");
+    }
+
+    // Offsets of every block, known before any data is written.
+    std::uint64_t indexBytes = 0;
+    for (const Entry& entry : m_entries) {
+        indexBytes += recordBytes(entry.shape.size(), entry.name.size());
+    }
+    std::vector<std::uint64_t> offsets(m_entries.size());
+    std::uint64_t end = alignUp(sizeof(FileHeader) + indexBytes, blockAlignment);
+    for (std::size_t t = 0; t < m_entries.size(); t++) {
+        offsets[t] = end;
+        end = alignUp(end + m_entries[t].rows * m_entries[t].rowBytes, blockAlignment);
+    }
+
+    // The data goes first, after room for the header and the index, so that
+    // each block is read once: its checksum is only known once written.
+    const char zeros[blockAlignment] = {};
+    std::vector<std::uint32_t> checksums(m_entries.size());
+    std::uint64_t position = offsets.empty() ? end : offsets[0];
+    file.seekp(static_cast<std::streamoff>(position));
+    for (std::size_t t = 0; t < m_entries.size(); t++) {
+        const Entry& entry = m_entries[t];
+        file.write(zeros, static_cast<std::streamsize>(offsets[t] - position));
+        const std::byte* data = entry.owned.empty() ? entry.data : entry.owned.data();
+        std::uint32_t crc = 0;
+        for (std::size_t r = 0; r < entry.rows; r++) {
+            const std::byte* row = data + r * entry.rowPitch;
+            crc = crc32c(row, entry.rowBytes, crc);
+            file.write(reinterpret_cast<const char*>(row), static_cast<std::streamsize>(entry.rowBytes));
+        }
+        checksums[t] = crc;
+        position = offsets[t] + entry.rows * entry.rowBytes;
+    }
+    file.write(zeros, static_cast<std::streamsize>(end - position));
+
+    std::vector<char> index;
+    index.reserve(indexBytes);
+    for (std::size_t t = 0; t < m_entries.size(); t++) {
+        const Entry& entry = m_entries[t];
+        const RecordHeader record{
+            static_cast<std::uint32_t>(entry.dtype), static_cast<std::uint32_t>(entry.shape.size()),
+            static_cast<std::uint32_t>(entry.name.size()), checksums[t],
+            offsets[t], entry.rows * entry.rowBytes
+        };
+        const char* bytes = reinterpret_cast<const char*>(&record);
+        index.insert(index.end(), bytes, bytes + sizeof(record));
+        std::vector<std::uint64_t> shape(entry.shape.begin(), entry.shape.end());
+        const std::vector<std::ptrdiff_t> contiguous = contiguous_strides(entry.shape);
+        std::vector<std::int64_t> strides(contiguous.begin(), contiguous.end());
+        bytes = reinterpret_cast<const char*>(shape.data());
+        index.insert(index.end(), bytes, bytes + 8 * shape.size());
+        bytes = reinterpret_cast<const char*>(strides.data());
+        index.insert(index.end(), bytes, bytes + 8 * strides.size());
+        index.insert(index.end(), entry.name.begin(), entry.name.end());
+        index.resize(alignUp(index.size(), 8), '\0');
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = formatVersion;
+    header.byteOrder = byteOrderMark;
+    header.count = m_entries.size();
+    header.indexBytes = indexBytes;
+    header.indexChecksum = crc32c(index.data(), index.size());
+    header.alignment = blockAlignment;
+    header.headerChecksum = headerChecksum(header);
+
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(index.data(), static_cast<std::streamsize>(index.size()));
+    file.flush();
+    file.close();
+    if (!file) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("Cannot write tensor file '" + temporary + "'.");
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("Cannot replace tensor file '" + path + "'.");
+    }
+}
+
+// TensorFile
+
+// Constructors
+
+TensorFile::TensorFile(const std::string& path) :
+    m_data(nullptr), m_bytes(0), m_mapping(nullptr), m_buffer(), m_tensors(), m_index()
+{
+#ifdef NN_TENSOR_FILE_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open tensor file '" + path + "'.");
+    }
+    struct stat status;
+    if (::fstat(fd, &status) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot read tensor file '" + path + "'.");
+    }
+    m_bytes = static_cast<std::size_t>(status.st_size);
+    if (m_bytes >= sizeof(FileHeader)) {
+        void* mapping = ::mmap(nullptr, m_bytes, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Cannot map tensor file '" + path + "'.");
+        }
+        m_mapping = mapping;
+        m_data = static_cast<const std::byte*>(mapping);
+    }
+    // The mapping keeps the file alive.
+    ::close(fd);
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw std::runtime_error("Cannot open tensor file '" + path + "'.");
+    }
+    m_bytes = static_cast<std::size_t>(file.tellg());
+    m_buffer.resize(m_bytes);
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(m_buffer.data()), static_cast<std::streamsize>(m_bytes))) {
+        throw std::runtime_error("Cannot read tensor file '" + path + "'.");
+    }
+    m_data = m_buffer.data();
+#endif
+    try {
+        parse(path);
+    } catch (...) {
+        release();
+        throw;
+    }
+}
+
+TensorFile::TensorFile(TensorFile&& other) noexcept :
+    m_data(std::exchange(other.m_data, nullptr)),
+    m_bytes(std::exchange(other.m_bytes, 0)),
+    m_mapping(std::exchange(other.m_mapping, nullptr)),
+    m_buffer(std::move(other.m_buffer)),
+    m_tensors(std::move(other.m_tensors)),
+    m_index(std::move(other.m_index))
+{}
+
+// Destructor
+
+TensorFile::~TensorFile() {
+    release();
+}
+
+// Operators
+
+TensorFile& TensorFile::operator=(TensorFile&& other) noexcept {
+    if (this != &other) {
+        release();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_bytes = std::exchange(other.m_bytes, 0);
+        m_mapping = std::exchange(other.m_mapping, nullptr);
+        m_buffer = std::move(other.m_buffer);
+        m_tensors = std::move(other.m_tensors);
+        m_index = std::move(other.m_index);
+    }
+    return *this;
+}
+
+// Other members
+
+void TensorFile::release() {
+#ifdef NN_TENSOR_FILE_MMAP
+    if (m_mapping != nullptr) {
+        ::munmap(m_mapping, m_bytes);
+    }
+#endif
+    m_mapping = nullptr;
+    m_data = nullptr;
+    m_bytes = 0;
+}
+
+void TensorFile::parse(const std::string& path) {
+    NN_PROFILE_SCOPE(Io, "TensorFile::parse", 0, 0);
+    if (m_bytes < sizeof(FileHeader)) {
+        corrupt(path, "too small");
+    }
+    FileHeader header;
+    std::memcpy(&header, m_data, sizeof(header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0) {
+        corrupt(path, "not a tensor file");
+    }
+    if (header.byteOrder != byteOrderMark) {
+        corrupt(path, "byte order differs from this machine's");
+    }
+    if (header.headerChecksum != headerChecksum(header)) {
+        corrupt(path, "header checksum mismatch");
+    }
+    if (header.version != formatVersion) {
+        corrupt(path, "unsupported version " + std::to_string(header.version));
+    }
+    if (header.indexBytes > m_bytes - sizeof(FileHeader)) {
+        corrupt(path, "truncated index");
+    }
+    const std::byte* index = m_data + sizeof(FileHeader);
+    if (crc32c(index, header.indexBytes) != header.indexChecksum) {
+        corrupt(path, "index checksum mismatch");
+    }
+
+    std::uint64_t position = 0;
+    m_tensors.reserve(std::min<std::uint64_t>(header.count, header.indexBytes / sizeof(RecordHeader)));
+    for (std::uint64_t t = 0; t < header.count; t++) {
+        RecordHeader record;
+        if (header.indexBytes - position < sizeof(record)) {
+            corrupt(path, "truncated index");
+        }
+        std::memcpy(&record, index + position, sizeof(record));
+        if (!knownDType(record.dtype) || record.rank > maxRank) {
+            corrupt(path, "bad record " + std::to_string(t));
+        }
+        const std::uint64_t bytes = recordBytes(record.rank, record.nameBytes);
+        if (header.indexBytes - position < bytes) {
+            corrupt(path, "truncated index");
+        }
+
+        TensorInfo tensor;
+        tensor.dtype = static_cast<DType>(record.dtype);
+        tensor.shape.resize(record.rank);
+        tensor.strides.resize(record.rank);
+        tensor.offset = record.offset;
+        tensor.bytes = record.bytes;
+        tensor.checksum = record.checksum;
+        const std::byte* p = index + position + sizeof(record);
+        for (std::uint32_t i = 0; i < record.rank; i++) {
+            std::uint64_t extent;
+            std::int64_t stride;
+            std::memcpy(&extent, p + 8 * i, 8);
+            std::memcpy(&stride, p + 8 * (record.rank + i), 8);
+            if (extent > std::numeric_limits<std::size_t>::max() || stride < 0) {
+                corrupt(path, "bad shape in record " + std::to_string(t));
+            }
+            tensor.shape[i] = static_cast<std::size_t>(extent);
+            tensor.strides[i] = static_cast<std::ptrdiff_t>(stride);
+        }
+        tensor.name.assign(reinterpret_cast<const char*>(p + 16 * record.rank), record.nameBytes);
+        position += bytes;
+
+        // Every element the strides reach must lie within the block, and the
+        // block within the file.
+        const std::size_t elementSize = dtypeSize(tensor.dtype);
+        std::uint64_t last = 0;
+        bool empty = false;
+        for (std::uint32_t i = 0; i < record.rank; i++) {
+            std::uint64_t span;
+            empty = empty || tensor.shape[i] == 0;
+            if (tensor.shape[i] > 0 && (!checkedMul(tensor.shape[i] - 1, static_cast<std::uint64_t>(tensor.strides[i]), span) || __builtin_add_overflow(last, span, &last))) {
+                corrupt(path, "bad strides for '" + tensor.name + "'");
+            }
+        }
+        std::uint64_t needed = 0;
+        if (!empty && (!checkedMul(last + 1, elementSize, needed) || needed > tensor.bytes)) {
+            corrupt(path, "data block of '" + tensor.name + "' is too small for its shape");
+        }
+        if (tensor.offset % blockAlignment != 0 || tensor.offset > m_bytes || tensor.bytes > m_bytes - tensor.offset) {
+            corrupt(path, "data block of '" + tensor.name + "' is out of bounds");
+        }
+        if (!m_index.emplace(tensor.name, m_tensors.size()).second) {
+            corrupt(path, "duplicate tensor '" + tensor.name + "'");
+        }
+        m_tensors.push_back(std::move(tensor));
+    }
+}
+
+bool TensorFile::isMapped() const {
+    return m_mapping != nullptr;
+}
+
+std::size_t TensorFile::size() const {
+    return m_tensors.size();
+}
+
+const std::vector<TensorInfo>& TensorFile::tensors() const {
+    return m_tensors;
+}
+
+std::vector<std::string> TensorFile::names() const {
+    std::vector<std::string> result;
+    result.reserve(m_tensors.size());
+    for (const TensorInfo& tensor : m_tensors) {
+        result.push_back(tensor.name);
+    }
+    return result;
+}
+
+bool TensorFile::contains(const std::string& name) const {
+    return m_index.count(name) != 0;
+}
+
+const TensorInfo& TensorFile::info(const std::string& name) const {
+    const auto it = m_index.find(name);
+    if (it == m_index.end()) {
+        throw std::invalid_argument("No tensor named '" + name + "'.");
+    }
+    return m_tensors[it->second];
+}
+
+bool TensorFile::verify(const std::string& name) const {
+    const TensorInfo& tensor = info(name);
+    NN_PROFILE_SCOPE(Io, "TensorFile::verify", static_cast<double>(tensor.bytes), 0);
+    return crc32c(m_data + tensor.offset, tensor.bytes) == tensor.checksum;
+}
+
+void TensorFile::verifyAll() const {
+    NN_PROFILE_SCOPE(Io, "TensorFile::verify", static_cast<double>(m_bytes), 0);
+    for (const TensorInfo& tensor : m_tensors) {
+        if (crc32c(m_data + tensor.offset, tensor.bytes) != tensor.checksum) {
+            throw std::runtime_error("Checksum mismatch for tensor '" + tensor.name + "'.");
+        }
+    }
+}
+
+}
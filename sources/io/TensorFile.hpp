@@ -0,0 +1,283 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "half/Half.hpp"
+#include "matrix/Matrix.hpp"
+#include "memory/AlignedAllocator.hpp"
+#include "ndarray/NDArray.hpp"
+#include "vector/Vector.hpp"
+
+// Binary tensor files, for whole model checkpoints.
+//
+// A file holds any number of named tensors. It starts with a 64-byte header
+// (magic, version, byte order mark, tensor count, index size and checksum),
+// followed by an index with one record per tensor (dtype, shape, strides in
+// elements, offset and size of its data, CRC-32C of the data, name), then
+// the data blocks, each aligned on 64 bytes from the start of the file.
+// Everything is little-endian.
+//
+// TensorFile maps the file read-only and hands out views straight over the
+// mapped pages: loading a checkpoint costs a page fault per page actually
+// touched, and the page cache is shared between processes serving the same
+// model. Since the blocks are aligned on a cache line, those views satisfy
+// the same alignment as the library's own buffers.
+namespace io {
+
+enum class DType : std::uint32_t {
+    Float64,
+    Float32,
+    BFloat16,
+    Float16,
+    Int8,
+    UInt8,
+    Int16,
+    Int32,
+    Int64
+};
+
+template<typename T>
+constexpr bool isStorable =
+    std::is_same_v<T, double> || std::is_same_v<T, float> ||
+    std::is_same_v<T, BFloat16> || std::is_same_v<T, Float16> ||
+    std::is_same_v<T, std::int8_t> || std::is_same_v<T, std::uint8_t> ||
+    std::is_same_v<T, std::int16_t> || std::is_same_v<T, std::int32_t> || std::is_same_v<T, std::int64_t>;
+
+template<typename T>
+constexpr DType dtypeOf() {
+    static_assert(isStorable<T>, "Element type cannot be stored in a tensor file.");
+    if constexpr (std::is_same_v<T, double>) {
+        return DType::Float64;
+    } else if constexpr (std::is_same_v<T, float>) {
+        return DType::Float32;
+    } else if constexpr (std::is_same_v<T, BFloat16>) {
+        return DType::BFloat16;
+    } else if constexpr (std::is_same_v<T, Float16>) {
+        return DType::Float16;
+    } else if constexpr (std::is_same_v<T, std::int8_t>) {
+        return DType::Int8;
+    } else if constexpr (std::is_same_v<T, std::uint8_t>) {
+        return DType::UInt8;
+    } else if constexpr (std::is_same_v<T, std::int16_t>) {
+        return DType::Int16;
+    } else if constexpr (std::is_same_v<T, std::int32_t>) {
+        return DType::Int32;
+    } else {
+        return DType::Int64;
+    }
+}
+
+std::size_t dtypeSize(DType dtype);
+const char* dtypeName(DType dtype);
+
+// Index record of one tensor.
+struct TensorInfo {
+    std::string name;
+    DType dtype;
+    std::vector<std::size_t> shape;
+    // In elements, relative to the first element of the block.
+    std::vector<std::ptrdiff_t> strides;
+    // Position and size of the data block in the file.
+    std::uint64_t offset;
+    std::uint64_t bytes;
+    // CRC-32C of the data block.
+    std::uint32_t checksum;
+
+    std::size_t size() const;
+};
+
+// Collects tensors and writes them to one file. The writer keeps pointers to
+// contiguous sources and to the rows of matrices, so they must outlive
+// write(); other views are copied when added. Data blocks are stored
+// row-major and contiguous, whatever the layout of the source.
+class TensorWriter {
+
+    struct Entry {
+        std::string name;
+        DType dtype;
+        std::vector<std::size_t> shape;
+        // The block is rows runs of rowBytes bytes, rowPitch bytes apart,
+        // from data or from owned when it is not empty.
+        const std::byte* data;
+        std::size_t rows;
+        std::size_t rowBytes;
+        std::size_t rowPitch;
+        // Gathered copy of a non-contiguous view.
+        std::vector<std::byte> owned;
+    };
+
+    std::vector<Entry> m_entries;
+    std::unordered_map<std::string, std::size_t> m_names;
+
+    void addEntry(Entry entry);
+
+public:
+
+    template<typename T>
+    void add(const std::string& name, const NDArrayView<const T>& view) {
+        Entry entry{name, dtypeOf<T>(), view.shape(), nullptr, 1, view.size() * sizeof(T), 0, {}};
+        if (view.is_contiguous()) {
+            entry.data = reinterpret_cast<const std::byte*>(view.data());
+        } else {
+            const NDArray<T> copy = view.copy();
+            const std::byte* first = reinterpret_cast<const std::byte*>(copy.data());
+            entry.owned.assign(first, first + entry.rowBytes);
+        }
+        addEntry(std::move(entry));
+    }
+
+    template<typename T>
+    void add(const std::string& name, const NDArrayView<T>& view) {
+        add(name, NDArrayView<const T>(view));
+    }
+
+    template<typename T>
+    void add(const std::string& name, const NDArray<T>& array) {
+        add(name, array.view());
+    }
+
+    template<typename T>
+    void add(const std::string& name, const BasicMatrix<T>& m) {
+        addEntry(Entry{
+            name, dtypeOf<T>(), {m.nbRows(), m.nbCols()}, reinterpret_cast<const std::byte*>(m.data()),
+            m.nbRows(), m.nbCols() * sizeof(T), m.rowStride() * sizeof(T), {}
+        });
+    }
+
+    template<typename T>
+    void add(const std::string& name, const BasicVector<T>& v) {
+        addEntry(Entry{
+            name, dtypeOf<T>(), {v.size()}, reinterpret_cast<const std::byte*>(v.data()),
+            1, v.size() * sizeof(T), 0, {}
+        });
+    }
+
+    std::size_t size() const;
+    void clear();
+
+    // Writes every tensor added so far to path + ".tmp", then renames it
+    // over path, so that a TensorFile mapping the previous file keeps
+    // reading it. Throws std::runtime_error if the file cannot be written.
+    void write(const std::string& path) const;
+
+};
+
+// Read-only tensor file. The constructor maps the file and validates the
+// header and the index, so that every record lies within the file; the data
+// blocks are only checksummed on request, since that reads every page.
+// Views and pointers obtained from a TensorFile are valid as long as it is.
+class TensorFile {
+
+    const std::byte* m_data;
+    std::size_t m_bytes;
+    // Mapping to release, or nullptr when the file was read into m_buffer.
+    void* m_mapping;
+    std::vector<std::byte, AlignedAllocator<std::byte>> m_buffer;
+    std::vector<TensorInfo> m_tensors;
+    std::unordered_map<std::string, std::size_t> m_index;
+
+    void parse(const std::string& path);
+    void release();
+
+    template<typename T>
+    const TensorInfo& checkedInfo(const std::string& name) const {
+        const TensorInfo& result = info(name);
+        if (result.dtype != dtypeOf<T>()) {
+            throw std::invalid_argument("Tensor '" + name + "' is stored as " + dtypeName(result.dtype) + ".");
+        }
+        return result;
+    }
+
+public:
+
+    // Constructors
+    // Throws std::runtime_error if path cannot be read or is not a valid
+    // tensor file.
+    explicit TensorFile(const std::string& path);
+    TensorFile(const TensorFile& other) = delete;
+    TensorFile(TensorFile&& other) noexcept;
+
+    // Destructor
+    ~TensorFile();
+
+    // Operators
+    TensorFile& operator=(const TensorFile& other) = delete;
+    TensorFile& operator=(TensorFile&& other) noexcept;
+
+    // Other members
+    // True when the tensors are views of the mapped file rather than of a
+    // copy in memory (platforms without mmap).
+    bool isMapped() const;
+    std::size_t size() const;
+    const std::vector<TensorInfo>& tensors() const;
+    std::vector<std::string> names() const;
+    bool contains(const std::string& name) const;
+    // Throws std::invalid_argument for an unknown name.
+    const TensorInfo& info(const std::string& name) const;
+
+    // Recompute the data checksums. verify() returns false on a mismatch,
+    // verifyAll() throws std::runtime_error naming the first bad tensor.
+    bool verify(const std::string& name) const;
+    void verifyAll() const;
+
+    // Zero-copy access. T must be the stored type, or std::invalid_argument
+    // is thrown.
+    template<typename T>
+    NDArrayView<const T> view(const std::string& name) const {
+        const TensorInfo& tensor = checkedInfo<T>(name);
+        return NDArrayView<const T>(reinterpret_cast<const T*>(m_data + tensor.offset), tensor.shape, tensor.strides);
+    }
+
+    // First element, for the pointer and stride APIs (gemm, gemv); strides
+    // come from info(name).
+    template<typename T>
+    const T* data(const std::string& name) const {
+        return reinterpret_cast<const T*>(m_data + checkedInfo<T>(name).offset);
+    }
+
+    // Owning copies.
+    template<typename T>
+    NDArray<T> load(const std::string& name) const {
+        return NDArray<T>(view<T>(name));
+    }
+
+    // Matrix owns its storage, so a 2-D tensor is copied row by row, through
+    // the strides of its view.
+    template<typename T>
+    BasicMatrix<T> loadMatrix(const std::string& name) const {
+        const NDArrayView<const T> source = view<T>(name);
+        if (source.dim() != 2) {
+            throw std::invalid_argument("Tensor '" + name + "' is not 2-D.");
+        }
+        BasicMatrix<T> result(source.shape()[0], source.shape()[1]);
+        for (std::size_t i = 0; i < result.nbRows(); i++) {
+            const T* row = source.data() + static_cast<std::ptrdiff_t>(i) * source.strides()[0];
+            T* out = result.data() + i * result.rowStride();
+            for (std::size_t j = 0; j < result.nbCols(); j++) {
+                out[j] = row[static_cast<std::ptrdiff_t>(j) * source.strides()[1]];
+            }
+        }
+        return result;
+    }
+
+    template<typename T>
+    BasicVector<T> loadVector(const std::string& name) const {
+        const NDArrayView<const T> source = view<T>(name);
+        if (source.dim() != 1) {
+            throw std::invalid_argument("Tensor '" + name + "' is not 1-D.");
+        }
+        BasicVector<T> result(source.shape()[0]);
+        for (std::size_t i = 0; i < result.size(); i++) {
+            result[i] = source.data()[static_cast<std::ptrdiff_t>(i) * source.strides()[0]];
+        }
+        return result;
+    }
+
+};
+
+}
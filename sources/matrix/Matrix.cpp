@@ -1,345 +1,763 @@
 #include <algorithm>
-#include <functional>
-#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+#include "gemm/Gemm.hpp"
+#include "gemm/Gemv.hpp"
 #include "matrix/Matrix.hpp"
+#include "parallel/ThreadPool.hpp"
+#include "profile/Profiler.hpp"
+#include "simd/Simd.hpp"
+#include "transpose/Transpose.hpp"
+
+// BasicMatrixRow<T>
+
+template<typename T>
+BasicMatrixRow<T>::BasicMatrixRow(T* data, std::size_t size, std::size_t stride) :
+    m_data(data),
+    m_size(size),
+    m_stride(stride)
+{}
+
+template<typename T>
+BasicMatrixRow<T>& BasicMatrixRow<T>::operator=(const BasicVector<T>& other) {
+    if (other.size() != m_size) {
+        throw("Vector and Matrix row do not have the same dimension.");
+    }
+    for (std::size_t j = 0; j < m_size; j++) {
+        m_data[j * m_stride] = other[j];
+    }
+    return *this;
+}
+
+template<typename T>
+T& BasicMatrixRow<T>::operator[](unsigned int j) const {
+    return m_data[j * m_stride];
+}
+
+template<typename T>
+BasicMatrixRow<T>::operator BasicVector<T>() const {
+    BasicVector<T> result(m_size);
+    for (std::size_t j = 0; j < m_size; j++) {
+        result[j] = m_data[j * m_stride];
+    }
+    return result;
+}
+
+template<typename T>
+std::size_t BasicMatrixRow<T>::size() const {
+    return m_size;
+}
+
+template<typename T>
+std::size_t BasicMatrixRow<T>::stride() const {
+    return m_stride;
+}
+
+template<typename T>
+T* BasicMatrixRow<T>::data() const {
+    return m_data;
+}
+
+// BasicConstMatrixRow<T>
+
+template<typename T>
+BasicConstMatrixRow<T>::BasicConstMatrixRow(const T* data, std::size_t size, std::size_t stride) :
+    m_data(data),
+    m_size(size),
+    m_stride(stride)
+{}
+
+template<typename T>
+BasicConstMatrixRow<T>::BasicConstMatrixRow(const BasicMatrixRow<T>& row) :
+    m_data(row.data()),
+    m_size(row.size()),
+    m_stride(row.stride())
+{}
+
+template<typename T>
+const T& BasicConstMatrixRow<T>::operator[](unsigned int j) const {
+    return m_data[j * m_stride];
+}
+
+template<typename T>
+BasicConstMatrixRow<T>::operator BasicVector<T>() const {
+    BasicVector<T> result(m_size);
+    for (std::size_t j = 0; j < m_size; j++) {
+        result[j] = m_data[j * m_stride];
+    }
+    return result;
+}
+
+template<typename T>
+std::size_t BasicConstMatrixRow<T>::size() const {
+    return m_size;
+}
+
+template<typename T>
+std::size_t BasicConstMatrixRow<T>::stride() const {
+    return m_stride;
+}
+
+template<typename T>
+const T* BasicConstMatrixRow<T>::data() const {
+    return m_data;
+}
 
 // Constructors
 
-Matrix::Matrix() : 
-    m_mat()
+template<typename T>
+BasicMatrix<T>::BasicMatrix() : 
+    m_data(),
+    m_rows(0),
+    m_cols(0),
+    m_rowStride(0),
+    m_colStride(1)
+{}
+
+template<typename T>
+BasicMatrix<T>::BasicMatrix(std::size_t n, T value) :
+    BasicMatrix<T>(n, n, value)
 {}
 
-Matrix::Matrix(std::size_t n, double value) :
-    m_mat(n, Vector(n, value))
+template<typename T>
+BasicMatrix<T>::BasicMatrix(std::size_t row, std::size_t col, T value) :
+    m_data(row * col, value),
+    m_rows(row),
+    m_cols(col),
+    m_rowStride(col),
+    m_colStride(1)
 {}
 
-Matrix::Matrix(std::size_t row, std::size_t col, double value) :
-    m_mat(row, Vector(col, value))
+template<typename T>
+BasicMatrix<T>::BasicMatrix(BasicMatrix<T>&& other) noexcept :
+    m_data(std::move(other.m_data)),
+    m_rows(std::exchange(other.m_rows, 0)),
+    m_cols(std::exchange(other.m_cols, 0)),
+    m_rowStride(std::exchange(other.m_rowStride, 0)),
+    m_colStride(std::exchange(other.m_colStride, 1))
 {}
 
 // Operators
 
-Matrix& Matrix::operator+=(const Matrix& other) {
+template<typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator=(BasicMatrix<T>&& other) noexcept {
+    m_data = std::move(other.m_data);
+    m_rows = std::exchange(other.m_rows, 0);
+    m_cols = std::exchange(other.m_cols, 0);
+    m_rowStride = std::exchange(other.m_rowStride, 0);
+    m_colStride = std::exchange(other.m_colStride, 1);
+    return *this;
+}
+
+template<typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator+=(const BasicMatrix<T>& other) {
     checkMatDimOp(*this, other);
-    std::transform(
-        begin(), end(),
-        other.cbegin(),
-        begin(), std::plus<Vector>()
-    );
+    NN_PROFILE_SCOPE(Elementwise, "Matrix += Matrix", 3.0 * static_cast<double>(m_rows * m_cols * sizeof(T)), static_cast<double>(m_rows * m_cols));
+    const simd::BasicKernels<T>& k = simd::kernels<T>();
+    const T* o = other.data();
+    T* d = data();
+    parallelFor(0, m_data.size(), parallelGrain, [&](std::size_t first, std::size_t last) {
+        k.add(d + first, o + first, d + first, last - first);
+    });
     return *this;
 }
 
-Matrix& Matrix::operator+=(const Vector& other) {
+template<typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator+=(const BasicVector<T>& other) {
     checkVectMatDimOp(other, *this);
-    std::for_each(begin(), end(), [other](Vector& v){v += other;});
+    NN_PROFILE_SCOPE(Elementwise, "Matrix += Vector", static_cast<double>((2 * m_rows + 1) * m_cols * sizeof(T)), static_cast<double>(m_rows * m_cols));
+    const simd::BasicKernels<T>& k = simd::kernels<T>();
+    const std::size_t rowGrain = std::max<std::size_t>(1, parallelGrain / std::max<std::size_t>(1, m_cols));
+    parallelFor(0, m_rows, rowGrain, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) {
+            T* r = data() + i * m_rowStride;
+            k.add(r, other.data(), r, m_cols);
+        }
+    });
     return *this;
 }
 
-Matrix& Matrix::operator+=(double value) {
-    std::for_each(begin(), end(), [value](Vector& v){v += value;});
+template<typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator+=(T value) {
+    NN_PROFILE_SCOPE(Elementwise, "Matrix += scalar", 2.0 * static_cast<double>(m_rows * m_cols * sizeof(T)), static_cast<double>(m_rows * m_cols));
+    const simd::BasicKernels<T>& k = simd::kernels<T>();
+    T* d = data();
+    parallelFor(0, m_data.size(), parallelGrain, [&](std::size_t first, std::size_t last) {
+        k.addScalar(d + first, value, d + first, last - first);
+    });
     return *this;
 }
 
-Matrix& Matrix::operator-=(const Matrix& other) {
+template<typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator-=(const BasicMatrix<T>& other) {
     checkMatDimOp(*this, other);
-    std::transform(
-        begin(), end(),
-        other.cbegin(),
-        begin(), std::minus<Vector>()
-    );
+    NN_PROFILE_SCOPE(Elementwise, "Matrix -= Matrix", 3.0 * static_cast<double>(m_rows * m_cols * sizeof(T)), static_cast<double>(m_rows * m_cols));
+    const simd::BasicKernels<T>& k = simd::kernels<T>();
+    const T* o = other.data();
+    T* d = data();
+    parallelFor(0, m_data.size(), parallelGrain, [&](std::size_t first, std::size_t last) {
+        k.sub(d + first, o + first, d + first, last - first);
+    });
     return *this;
 }
 
-Matrix& Matrix::operator-=(const Vector& other) {
+template<typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator-=(const BasicVector<T>& other) {
     checkVectMatDimOp(other, *this);
-    std::for_each(begin(), end(), [other](Vector& v){v -= other;});
+    NN_PROFILE_SCOPE(Elementwise, "Matrix -= Vector", static_cast<double>((2 * m_rows + 1) * m_cols * sizeof(T)), static_cast<double>(m_rows * m_cols));
+    const simd::BasicKernels<T>& k = simd::kernels<T>();
+    const std::size_t rowGrain = std::max<std::size_t>(1, parallelGrain / std::max<std::size_t>(1, m_cols));
+    parallelFor(0, m_rows, rowGrain, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) {
+            T* r = data() + i * m_rowStride;
+            k.sub(r, other.data(), r, m_cols);
+        }
+    });
     return *this;
 }
 
-Matrix& Matrix::operator-=(double value) {
-    std::for_each(begin(), end(), [value](Vector& v){v -= value;});
+template<typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator-=(T value) {
+    NN_PROFILE_SCOPE(Elementwise, "Matrix -= scalar", 2.0 * static_cast<double>(m_rows * m_cols * sizeof(T)), static_cast<double>(m_rows * m_cols));
+    const simd::BasicKernels<T>& k = simd::kernels<T>();
+    T* d = data();
+    parallelFor(0, m_data.size(), parallelGrain, [&](std::size_t first, std::size_t last) {
+        k.subScalar(d + first, value, d + first, last - first);
+    });
     return *this;
 }
 
-Matrix& Matrix::operator*=(const Matrix& other) {
+template<typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator*=(const BasicMatrix<T>& other) {
     checkMatDimOp(*this, other);
-    std::transform(
-        begin(), end(),
-        other.cbegin(),
-        begin(), std::multiplies<Vector>()
-    );
+    NN_PROFILE_SCOPE(Elementwise, "Matrix *= Matrix", 3.0 * static_cast<double>(m_rows * m_cols * sizeof(T)), static_cast<double>(m_rows * m_cols));
+    const simd::BasicKernels<T>& k = simd::kernels<T>();
+    const T* o = other.data();
+    T* d = data();
+    parallelFor(0, m_data.size(), parallelGrain, [&](std::size_t first, std::size_t last) {
+        k.mul(d + first, o + first, d + first, last - first);
+    });
     return *this;
 }
 
-Matrix& Matrix::operator*=(const Vector& other) {
+template<typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator*=(const BasicVector<T>& other) {
     checkVectMatDimOp(other, *this);
-    std::for_each(begin(), end(), [other](Vector& v){v -= other;});
+    NN_PROFILE_SCOPE(Elementwise, "Matrix *= Vector", static_cast<double>((2 * m_rows + 1) * m_cols * sizeof(T)), static_cast<double>(m_rows * m_cols));
+    const simd::BasicKernels<T>& k = simd::kernels<T>();
+    const std::size_t rowGrain = std::max<std::size_t>(1, parallelGrain / std::max<std::size_t>(1, m_cols));
+    parallelFor(0, m_rows, rowGrain, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) {
+            T* r = data() + i * m_rowStride;
+            k.mul(r, other.data(), r, m_cols);
+        }
+    });
     return *this;
 }
 
-Matrix& Matrix::operator*=(double value) {
-    std::for_each(begin(), end(), [value](Vector& v){v *= value;});
+template<typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator*=(T value) {
+    NN_PROFILE_SCOPE(Elementwise, "Matrix *= scalar", 2.0 * static_cast<double>(m_rows * m_cols * sizeof(T)), static_cast<double>(m_rows * m_cols));
+    const simd::BasicKernels<T>& k = simd::kernels<T>();
+    T* d = data();
+    parallelFor(0, m_data.size(), parallelGrain, [&](std::size_t first, std::size_t last) {
+        k.mulScalar(d + first, value, d + first, last - first);
+    });
     return *this;
 }
 
-Matrix& Matrix::operator/=(const Matrix& other) {
+template<typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator/=(const BasicMatrix<T>& other) {
     checkMatDimOp(*this, other);
-    std::transform(
-        begin(), end(),
-        other.cbegin(),
-        begin(), std::divides<Vector>()
-    );
+    NN_PROFILE_SCOPE(Elementwise, "Matrix /= Matrix", 3.0 * static_cast<double>(m_rows * m_cols * sizeof(T)), static_cast<double>(m_rows * m_cols));
+    const simd::BasicKernels<T>& k = simd::kernels<T>();
+    const T* o = other.data();
+    T* d = data();
+    parallelFor(0, m_data.size(), parallelGrain, [&](std::size_t first, std::size_t last) {
+        k.div(d + first, o + first, d + first, last - first);
+    });
     return *this;
 }
 
-Matrix& Matrix::operator/=(const Vector& other) {
+template<typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator/=(const BasicVector<T>& other) {
     checkVectMatDimOp(other, *this);
-    std::for_each(begin(), end(), [other](Vector& v){v /= other;});
+    NN_PROFILE_SCOPE(Elementwise, "Matrix /= Vector", static_cast<double>((2 * m_rows + 1) * m_cols * sizeof(T)), static_cast<double>(m_rows * m_cols));
+    const simd::BasicKernels<T>& k = simd::kernels<T>();
+    const std::size_t rowGrain = std::max<std::size_t>(1, parallelGrain / std::max<std::size_t>(1, m_cols));
+    parallelFor(0, m_rows, rowGrain, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) {
+            T* r = data() + i * m_rowStride;
+            k.div(r, other.data(), r, m_cols);
+        }
+    });
     return *this;
 }
 
-Matrix& Matrix::operator/=(double value) {
-    std::for_each(begin(), end(), [value](Vector& v){v /= value;});
+template<typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator/=(T value) {
+    NN_PROFILE_SCOPE(Elementwise, "Matrix /= scalar", 2.0 * static_cast<double>(m_rows * m_cols * sizeof(T)), static_cast<double>(m_rows * m_cols));
+    const simd::BasicKernels<T>& k = simd::kernels<T>();
+    T* d = data();
+    parallelFor(0, m_data.size(), parallelGrain, [&](std::size_t first, std::size_t last) {
+        k.divScalar(d + first, value, d + first, last - first);
+    });
     return *this;
 }
 
-Vector& Matrix::operator[](unsigned int i) {
-    return m_mat[i];
+template<typename T>
+BasicMatrixRow<T> BasicMatrix<T>::operator[](unsigned int i) {
+    return row(i);
 }
 
-const Vector& Matrix::operator[](unsigned int i) const {
-    return m_mat[i];
+template<typename T>
+BasicConstMatrixRow<T> BasicMatrix<T>::operator[](unsigned int i) const {
+    return row(i);
+}
+
+template<typename T>
+T& BasicMatrix<T>::operator()(std::size_t i, std::size_t j) {
+    return m_data[i * m_rowStride + j * m_colStride];
+}
+
+template<typename T>
+const T& BasicMatrix<T>::operator()(std::size_t i, std::size_t j) const {
+    return m_data[i * m_rowStride + j * m_colStride];
 }
 
 // Other members 
 
-std::pair<std::size_t, std::size_t> Matrix::size() const {
+template<typename T>
+std::pair<std::size_t, std::size_t> BasicMatrix<T>::size() const {
     return std::pair<std::size_t, std::size_t>(nbRows(), nbCols());
 }
 
-std::size_t Matrix::nbRows() const {
-    return m_mat.size();
+template<typename T>
+std::size_t BasicMatrix<T>::nbRows() const {
+    return m_rows;
 }
 
-std::size_t Matrix::nbCols() const {
-    return m_mat[0].size();
+template<typename T>
+std::size_t BasicMatrix<T>::nbCols() const {
+    return m_cols;
 }
 
-Matrix Matrix::dot(const Matrix& other) const {
-    Matrix result(nbRows(), other.nbCols());
-    std::transform(
-        cbegin(), cend(),
-        result.begin(),
-        [other](const Vector& v){return v.dot(other);}
-    );
+template<typename T>
+std::size_t BasicMatrix<T>::rowStride() const {
+    return m_rowStride;
+}
+
+template<typename T>
+std::size_t BasicMatrix<T>::colStride() const {
+    return m_colStride;
+}
+
+template<typename T>
+T* BasicMatrix<T>::data() {
+    return m_data.data();
+}
+
+template<typename T>
+const T* BasicMatrix<T>::data() const {
+    return m_data.data();
+}
+
+template<typename T>
+BasicMatrixRow<T> BasicMatrix<T>::row(std::size_t i) {
+    return BasicMatrixRow<T>(data() + i * m_rowStride, m_cols, m_colStride);
+}
+
+template<typename T>
+BasicConstMatrixRow<T> BasicMatrix<T>::row(std::size_t i) const {
+    return BasicConstMatrixRow<T>(data() + i * m_rowStride, m_cols, m_colStride);
+}
+
+template<typename T>
+BasicMatrix<T> BasicMatrix<T>::dot(const BasicMatrix<T>& other) const {
+    BasicMatrix<T> result(nbRows(), other.nbCols());
+    ::dot(*this, other, result);
     return result;
 }
 
-Vector Matrix::dot(const Vector& other) const {
-    return std::inner_product(cbegin(), cend(), other.cbegin(), Vector(nbRows()));
+template<typename T>
+BasicVector<T> BasicMatrix<T>::dot(const BasicVector<T>& other) const {
+    BasicVector<T> result(nbRows());
+    ::dot(*this, other, result);
+    return result;
 }
 
-Matrix Matrix::transpose() const {
-    Matrix result(nbCols(), nbRows());
-    for (unsigned int i = 0; i < nbRows(); i++) {
-        for (unsigned int j = 0; j < nbCols(); j++) {
-            result[j][i] = m_mat[i][j];
-        }
+template<typename T>
+BasicMatrix<T> BasicMatrix<T>::transpose() const {
+    BasicMatrix<T> result(nbCols(), nbRows());
+    ::transpose(*this, result);
+    return result;
+}
+
+template<typename T>
+void BasicMatrix<T>::transposeInPlace() {
+    if (m_rows == m_cols) {
+        ::transposeInPlace(m_rows, data(), m_rowStride);
+        return;
+    }
+    *this = transpose();
+}
+
+template<typename T>
+BasicVector<T> BasicMatrix<T>::sum(std::size_t axis) const {
+    return reduction(Reduction::Sum, axis);
+}
+
+template<typename T>
+BasicVector<T> BasicMatrix<T>::mean(std::size_t axis) const {
+    return reduction(Reduction::Mean, axis);
+}
+
+template<typename T>
+BasicVector<T> BasicMatrix<T>::max(std::size_t axis) const {
+    return reduction(Reduction::Max, axis);
+}
+
+template<typename T>
+BasicVector<T> BasicMatrix<T>::min(std::size_t axis) const {
+    return reduction(Reduction::Min, axis);
+}
+
+template<typename T>
+BasicVector<T> BasicMatrix<T>::norm(std::size_t axis) const {
+    return reduction(Reduction::Norm, axis);
+}
+
+template<typename T>
+BasicVector<T> BasicMatrix<T>::variance(std::size_t axis) const {
+    return reduction(Reduction::Variance, axis);
+}
+
+template<typename T>
+std::vector<std::size_t> BasicMatrix<T>::argmax(std::size_t axis) const {
+    if (axis > 1) {
+        throw("Matrix axis must be 0 or 1.");
+    }
+    const std::size_t n = (axis == 0) ? m_rows : m_cols;
+    std::vector<std::size_t> result((axis == 0) ? m_cols : m_rows);
+    if (result.empty()) {
+        return result;
+    }
+    if (n == 0) {
+        throw("Cannot take the argmax along an empty axis.");
+    }
+    NN_PROFILE_SCOPE(Reduction, "Matrix argmax", static_cast<double>(m_rows * m_cols * sizeof(T)), static_cast<double>(m_rows * m_cols));
+    if (axis == 0) {
+        argmaxAxis(1, m_rows, m_cols, data(), 0, m_rowStride, result.data());
+    } else {
+        argmaxAxis(m_rows, m_cols, 1, data(), m_rowStride, 1, result.data());
     }
     return result;
 }
 
-std::vector<Vector>::iterator Matrix::begin() {
-    return m_mat.begin();
+template<typename T>
+typename BasicMatrix<T>::iterator BasicMatrix<T>::begin() {
+    return m_data.data();
 }
 
-std::vector<Vector>::const_iterator Matrix::begin() const {
-    return m_mat.cbegin();
+template<typename T>
+typename BasicMatrix<T>::const_iterator BasicMatrix<T>::begin() const {
+    return m_data.data();
 }
 
-std::vector<Vector>::iterator Matrix::end() {
-    return m_mat.end();
+template<typename T>
+typename BasicMatrix<T>::iterator BasicMatrix<T>::end() {
+    return m_data.data() + m_data.size();
 }
 
-std::vector<Vector>::const_iterator Matrix::end() const {
-    return m_mat.cend();
+template<typename T>
+typename BasicMatrix<T>::const_iterator BasicMatrix<T>::end() const {
+    return m_data.data() + m_data.size();
 }
 
-std::vector<Vector>::const_iterator Matrix::cbegin() const {
-    return m_mat.cbegin();
+template<typename T>
+typename BasicMatrix<T>::const_iterator BasicMatrix<T>::cbegin() const {
+    return m_data.data();
 }
 
-std::vector<Vector>::const_iterator Matrix::cend() const {
-    return m_mat.cend();
+template<typename T>
+typename BasicMatrix<T>::const_iterator BasicMatrix<T>::cend() const {
+    return m_data.data() + m_data.size();
+}
+
+// Private methods
+
+template<typename T>
+BasicVector<T> BasicMatrix<T>::reduction(Reduction op, std::size_t axis) const {
+    if (axis > 1) {
+        throw("Matrix axis must be 0 or 1.");
+    }
+    const std::size_t n = (axis == 0) ? m_rows : m_cols;
+    BasicVector<T> result((axis == 0) ? m_cols : m_rows);
+    if (result.size() == 0) {
+        return result;
+    }
+    if (n == 0 && op != Reduction::Sum && op != Reduction::Norm) {
+        throw("Cannot reduce along an empty axis.");
+    }
+    NN_PROFILE_SCOPE(Reduction, "Matrix reduction", static_cast<double>(m_rows * m_cols * sizeof(T)), static_cast<double>(m_rows * m_cols));
+    if (axis == 0) {
+        reduceAxis(op, 1, m_rows, m_cols, data(), 0, m_rowStride, result.data());
+    } else {
+        reduceAxis(op, m_rows, m_cols, 1, data(), m_rowStride, 1, result.data());
+    }
+    return result;
 }
 
 // Functions
 
-void checkMatDimOp(const Matrix& m1, const Matrix& m2) {
+template<typename T>
+void checkMatDimOp(const BasicMatrix<T>& m1, const BasicMatrix<T>& m2) {
     if (m1.size() != m2.size()) {
         throw("Matrix do not have the same dimensions.");
     }
     return;
 }
 
-void checkVectMatDimOp(const Vector& v, const Matrix& m) {
+template<typename T>
+void checkVectMatDimOp(const BasicVector<T>& v, const BasicMatrix<T>& m) {
     if (v.size() != m.nbCols()) {
         throw("Vector and Matrix do not have the right dimensions.");
     }
     return;
 }
 
-void checkMatVectDimDot(const Matrix& m, const Vector& v) {
+template<typename T>
+void checkMatVectDimDot(const BasicMatrix<T>& m, const BasicVector<T>& v) {
     if (m.nbCols() != v.size()) {
         throw("Vector and Matrix do not have the right dimensions for dot product.");
     }
     return;
 }
 
-void checkMatDimDot(const Matrix& m1, const Matrix& m2) {
+template<typename T>
+void checkMatDimDot(const BasicMatrix<T>& m1, const BasicMatrix<T>& m2) {
     if (m1.nbCols() != m2.nbRows()) {
         throw("Matrices do not have the right dimensions for dot product.");
     }
     return;
 }
 
-Matrix operator+(const Matrix& m1, const Matrix& m2) {
-    Matrix result(m1);
-    result += m2;
-    return result;
-}
-
-Matrix operator+(const Matrix& m, const Vector& v) {
-    Matrix result(m);
-    result += v;
-    return result;
-}
-
-Matrix operator+(const Vector& v, const Matrix& m) {
-    Matrix result(m);
-    result += v;
-    return result;
-}
-
-Matrix operator+(const Matrix& m, double value) {
-    Matrix result(m);
-    result += value;
-    return result;
-}
-
-Matrix operator+(double value, const Matrix& m) {
-    Matrix result(m);
-    result += value;
-    return result;
-}
-
-Matrix operator-(const Matrix& m1, const Matrix& m2) {
-    Matrix result(m1);
-    result -= m2;
-    return result;
-}
-
-Matrix operator-(const Matrix& m, const Vector& v) {
-    Matrix result(m);
-    result -= v;
-    return result;
+template<typename T>
+void checkMatDimGemm(const BasicMatrix<T>& a, const BasicMatrix<T>& b, const BasicMatrix<T>& c, bool transA, bool transB) {
+    const std::size_t m = transA ? a.nbCols() : a.nbRows();
+    const std::size_t ka = transA ? a.nbRows() : a.nbCols();
+    const std::size_t kb = transB ? b.nbCols() : b.nbRows();
+    const std::size_t n = transB ? b.nbRows() : b.nbCols();
+    if (ka != kb || c.nbRows() != m || c.nbCols() != n) {
+        throw("Matrices do not have the right dimensions for gemm.");
+    }
+    return;
 }
 
-Matrix operator-(const Vector& v, const Matrix& m) {
-    Matrix result(m);
-    result -= v;
-    return result;
+template<typename T>
+void checkMatDimGemv(const BasicMatrix<T>& a, const BasicVector<T>& x, const BasicVector<T>& y, bool transA) {
+    const std::size_t m = transA ? a.nbCols() : a.nbRows();
+    const std::size_t n = transA ? a.nbRows() : a.nbCols();
+    if (x.size() != n || y.size() != m) {
+        throw("Vector and Matrix do not have the right dimensions for gemv.");
+    }
+    return;
 }
 
-Matrix operator-(const Matrix& m, double value) {
-    Matrix result(m);
-    result -= value;
-    return result;
+template<typename T>
+std::pair<std::size_t, std::size_t> size(const BasicMatrix<T>& m) {
+    return m.size();
 }
 
-Matrix operator-(double value, const Matrix& m) {
-    Matrix result(m);
-    result -= value;
-    return result;
+template<typename T>
+BasicMatrix<T> dot(const BasicMatrix<T>& m1, const BasicMatrix<T>& m2) {
+    return m1.dot(m2);
 }
 
-Matrix operator*(const Matrix& m1, const Matrix& m2) {
-    Matrix result(m1);
-    result *= m2;
-    return result;
+template<typename T>
+BasicVector<T> dot(const BasicMatrix<T>& m, const BasicVector<T>& v) {
+    return m.dot(v);
 }
 
-Matrix operator*(const Matrix& m, const Vector& v) {
-    Matrix result(m);
-    result *= v;
-    return result;
+template<typename T>
+BasicVector<T> dot(const BasicVector<T>& v, const BasicMatrix<T>& m) {
+    return v.dot(m);
 }
 
-Matrix operator*(const Vector& v, const Matrix& m) {
-    Matrix result(m);
-    result *= v;
-    return result;
+template<typename T>
+BasicMatrix<T> transpose(const BasicMatrix<T>& m) {
+    return m.transpose();
 }
 
-Matrix operator*(const Matrix& m, double value) {
-    Matrix result(m);
-    result *= value;
-    return result;
+// Elementwise out = a op b with the given kernel, over the flat storage.
+template<typename T>
+static void elementwise(
+    const BasicMatrix<T>& a, const BasicMatrix<T>& b, BasicMatrix<T>& out,
+    void (*simd::BasicKernels<T>::*kernel)(const T*, const T*, T*, std::size_t)
+) {
+    checkMatDimOp(a, b);
+    checkMatDimOp(a, out);
+    NN_PROFILE_SCOPE(Elementwise, "Matrix elementwise", 3.0 * static_cast<double>(a.nbRows() * a.nbCols() * sizeof(T)), static_cast<double>(a.nbRows() * a.nbCols()));
+    const simd::BasicKernels<T>& k = simd::kernels<T>();
+    const T* x = a.data();
+    const T* y = b.data();
+    T* o = out.data();
+    parallelFor(0, a.nbRows() * a.rowStride(), parallelGrain, [&](std::size_t first, std::size_t last) {
+        (k.*kernel)(x + first, y + first, o + first, last - first);
+    });
 }
 
-Matrix operator*(double value, const Matrix& m) {
-    Matrix result(m);
-    result *= value;
-    return result;
+template<typename T>
+void add(const BasicMatrix<T>& a, const BasicMatrix<T>& b, BasicMatrix<T>& out) {
+    elementwise(a, b, out, &simd::BasicKernels<T>::add);
 }
 
-Matrix operator/(const Matrix& m1, const Matrix& m2) {
-    Matrix result(m1);
-    result /= m2;
-    return result;
+template<typename T>
+void sub(const BasicMatrix<T>& a, const BasicMatrix<T>& b, BasicMatrix<T>& out) {
+    elementwise(a, b, out, &simd::BasicKernels<T>::sub);
 }
 
-Matrix operator/(const Matrix& m, const Vector& v) {
-    Matrix result(m);
-    result /= v;
-    return result;
+template<typename T>
+void mul(const BasicMatrix<T>& a, const BasicMatrix<T>& b, BasicMatrix<T>& out) {
+    elementwise(a, b, out, &simd::BasicKernels<T>::mul);
 }
 
-Matrix operator/(const Vector& v, const Matrix& m) {
-    Matrix result(m);
-    result /= v;
-    return result;
+template<typename T>
+void div(const BasicMatrix<T>& a, const BasicMatrix<T>& b, BasicMatrix<T>& out) {
+    elementwise(a, b, out, &simd::BasicKernels<T>::div);
 }
 
-Matrix operator/(const Matrix& m, double value) {
-    Matrix result(m);
-    result /= value;
-    return result;
+template<typename T>
+void dot(const BasicMatrix<T>& m1, const BasicMatrix<T>& m2, BasicMatrix<T>& out) {
+    checkMatDimDot(m1, m2);
+    gemm(T(1), m1, m2, T(0), out);
 }
 
-Matrix operator/(double value, const Matrix& m) {
-    Matrix result(m);
-    result /= value;
-    return result;
+template<typename T>
+void dot(const BasicMatrix<T>& m, const BasicVector<T>& v, BasicVector<T>& out) {
+    checkMatVectDimDot(m, v);
+    gemv(T(1), m, v, T(0), out);
 }
 
-std::pair<std::size_t, std::size_t> size(const Matrix& m) {
-    return m.size();
+template<typename T>
+void dot(const BasicVector<T>& v, const BasicMatrix<T>& m, BasicVector<T>& out) {
+    checkVectMatDimDot(v, m);
+    gemv(T(1), m, v, T(0), out, true);
 }
 
-Matrix dot(const Matrix& m1, const Matrix& m2) {
-    return m1.dot(m2);
+template<typename T>
+void transpose(const BasicMatrix<T>& m, BasicMatrix<T>& out) {
+    if (out.nbRows() != m.nbCols() || out.nbCols() != m.nbRows()) {
+        throw("Matrices do not have the right dimensions for transpose.");
+    }
+    if (&out == &m) {
+        throw("Cannot transpose a Matrix into itself.");
+    }
+    ::transpose(m.nbRows(), m.nbCols(), m.data(), m.rowStride(), out.data(), out.rowStride());
+}
+
+template<typename T>
+void gemm(std::type_identity_t<T> alpha, const BasicMatrix<T>& a, const BasicMatrix<T>& b, std::type_identity_t<T> beta, BasicMatrix<T>& c, bool transA, bool transB) {
+    checkMatDimGemm(a, b, c, transA, transB);
+    ::gemm(
+        c.nbRows(), c.nbCols(), transA ? a.nbRows() : a.nbCols(),
+        alpha,
+        a.data(), transA ? a.colStride() : a.rowStride(), transA ? a.rowStride() : a.colStride(),
+        b.data(), transB ? b.colStride() : b.rowStride(), transB ? b.rowStride() : b.colStride(),
+        beta,
+        c.data(), c.rowStride(), c.colStride()
+    );
 }
 
-Vector dot(const Matrix& m, const Vector& v) {
-    return m.dot(v);
+template<typename T>
+void gemm(std::type_identity_t<T> alpha, const BasicMatrix<T>& a, const BasicMatrix<T>& b, std::type_identity_t<T> beta, BasicMatrix<T>& c, const GemmEpilogue<T>& epilogue, bool transA, bool transB) {
+    checkMatDimGemm(a, b, c, transA, transB);
+    ::gemm(
+        c.nbRows(), c.nbCols(), transA ? a.nbRows() : a.nbCols(),
+        alpha,
+        a.data(), transA ? a.colStride() : a.rowStride(), transA ? a.rowStride() : a.colStride(),
+        b.data(), transB ? b.colStride() : b.rowStride(), transB ? b.rowStride() : b.colStride(),
+        beta,
+        c.data(), c.rowStride(), c.colStride(),
+        epilogue
+    );
 }
 
-Vector dot(const Vector& v, const Matrix& m) {
-    return v.dot(m);
+template<typename T>
+void gemv(std::type_identity_t<T> alpha, const BasicMatrix<T>& a, const BasicVector<T>& x, std::type_identity_t<T> beta, BasicVector<T>& y, bool transA) {
+    checkMatDimGemv(a, x, y, transA);
+    if (x.data() == y.data()) {
+        throw("Cannot compute gemv in place.");
+    }
+    ::gemv(
+        y.size(), x.size(),
+        alpha,
+        a.data(), transA ? a.colStride() : a.rowStride(), transA ? a.rowStride() : a.colStride(),
+        x.data(),
+        beta,
+        y.data()
+    );
 }
 
-Matrix transpose(const Matrix& m) {
-    return m.transpose();
-}
\ No newline at end of file
+template<typename T>
+void gemvBatch(const BasicMatrix<T>& a, const BasicMatrix<T>& xs, BasicMatrix<T>& ys, bool transA) {
+    const std::size_t m = transA ? a.nbCols() : a.nbRows();
+    const std::size_t n = transA ? a.nbRows() : a.nbCols();
+    if (xs.nbCols() != n || ys.nbCols() != m || ys.nbRows() != xs.nbRows()) {
+        throw("Matrices do not have the right dimensions for gemvBatch.");
+    }
+    // Below one register tile of rows, packing A for GEMM costs more than
+    // streaming it once per vector.
+    if (xs.nbRows() < simd::gemmMR) {
+        for (std::size_t b = 0; b < xs.nbRows(); b++) {
+            ::gemv(
+                m, n,
+                T(1),
+                a.data(), transA ? a.colStride() : a.rowStride(), transA ? a.rowStride() : a.colStride(),
+                xs.data() + b * xs.rowStride(),
+                T(0),
+                ys.data() + b * ys.rowStride()
+            );
+        }
+        return;
+    }
+    // ys = xs * op(a)^T
+    gemm(T(1), xs, a, T(0), ys, false, !transA);
+}
+
+// Instantiations
+
+#define INSTANTIATE_MATRIX(T) \
+    template class BasicMatrixRow<T>; \
+    template class BasicConstMatrixRow<T>; \
+    template class BasicMatrix<T>; \
+    template void checkMatDimOp(const BasicMatrix<T>&, const BasicMatrix<T>&); \
+    template void checkVectMatDimOp(const BasicVector<T>&, const BasicMatrix<T>&); \
+    template void checkMatVectDimDot(const BasicMatrix<T>&, const BasicVector<T>&); \
+    template void checkMatDimDot(const BasicMatrix<T>&, const BasicMatrix<T>&); \
+    template void checkMatDimGemm(const BasicMatrix<T>&, const BasicMatrix<T>&, const BasicMatrix<T>&, bool, bool); \
+    template void checkMatDimGemv(const BasicMatrix<T>&, const BasicVector<T>&, const BasicVector<T>&, bool); \
+    template std::pair<std::size_t, std::size_t> size(const BasicMatrix<T>&); \
+    template BasicMatrix<T> dot(const BasicMatrix<T>&, const BasicMatrix<T>&); \
+    template BasicVector<T> dot(const BasicMatrix<T>&, const BasicVector<T>&); \
+    template BasicVector<T> dot(const BasicVector<T>&, const BasicMatrix<T>&); \
+    template BasicMatrix<T> transpose(const BasicMatrix<T>&); \
+    template void add(const BasicMatrix<T>&, const BasicMatrix<T>&, BasicMatrix<T>&); \
+    template void sub(const BasicMatrix<T>&, const BasicMatrix<T>&, BasicMatrix<T>&); \
+    template void mul(const BasicMatrix<T>&, const BasicMatrix<T>&, BasicMatrix<T>&); \
+    template void div(const BasicMatrix<T>&, const BasicMatrix<T>&, BasicMatrix<T>&); \
+    template void dot(const BasicMatrix<T>&, const BasicMatrix<T>&, BasicMatrix<T>&); \
+    template void dot(const BasicMatrix<T>&, const BasicVector<T>&, BasicVector<T>&); \
+    template void dot(const BasicVector<T>&, const BasicMatrix<T>&, BasicVector<T>&); \
+    template void transpose(const BasicMatrix<T>&, BasicMatrix<T>&); \
+    template void gemm<T>(T, const BasicMatrix<T>&, const BasicMatrix<T>&, T, BasicMatrix<T>&, bool, bool); \
+    template void gemm<T>(T, const BasicMatrix<T>&, const BasicMatrix<T>&, T, BasicMatrix<T>&, const GemmEpilogue<T>&, bool, bool); \
+    template void gemv<T>(T, const BasicMatrix<T>&, const BasicVector<T>&, T, BasicVector<T>&, bool); \
+    template void gemvBatch(const BasicMatrix<T>&, const BasicMatrix<T>&, BasicMatrix<T>&, bool);
+
+INSTANTIATE_MATRIX(double)
+INSTANTIATE_MATRIX(float)
+
+#undef INSTANTIATE_MATRIX
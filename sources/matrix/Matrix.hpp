@@ -1,91 +1,300 @@
 #pragma once
 
+#include <algorithm>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "expression/Expression.hpp"
+#include "gemm/Epilogue.hpp"
+#include "memory/AlignedAllocator.hpp"
+#include "parallel/ThreadPool.hpp"
+#include "profile/Profiler.hpp"
+#include "reduce/Reduce.hpp"
 #include "vector/Vector.hpp"
 
-class Vector;
+// Non-owning view over one row of a Matrix, so that m[i][j] keeps working
+// on the contiguous storage.
+template<typename T>
+class BasicMatrixRow {
 
-class Matrix {
+private:
+
+    T* m_data;
+    std::size_t m_size;
+    std::size_t m_stride;
+
+public:
+
+    using value_type = T;
+
+    // Constructors
+    BasicMatrixRow(T* data, std::size_t size, std::size_t stride = 1);
+
+    // Operators
+    BasicMatrixRow& operator=(const BasicVector<T>& other);
+    T& operator[](unsigned int j) const;
+    operator BasicVector<T>() const;
+
+    // Other members
+    std::size_t size() const;
+    std::size_t stride() const;
+    T* data() const;
+
+};
+
+template<typename T>
+class BasicConstMatrixRow {
 
 private:
 
-    std::vector<Vector> m_mat;
+    const T* m_data;
+    std::size_t m_size;
+    std::size_t m_stride;
 
 public:
 
+    using value_type = T;
+
     // Constructors
-    Matrix();
-    Matrix(std::size_t n, double value = 0.);
-    Matrix(std::size_t row, std::size_t col, double value = 0.);
-    Matrix(const Matrix& other) = default;
+    BasicConstMatrixRow(const T* data, std::size_t size, std::size_t stride = 1);
+    BasicConstMatrixRow(const BasicMatrixRow<T>& row);
+
+    // Operators
+    const T& operator[](unsigned int j) const;
+    operator BasicVector<T>() const;
+
+    // Other members
+    std::size_t size() const;
+    std::size_t stride() const;
+    const T* data() const;
+
+};
+
+// Row-major matrix stored in a single 64-byte aligned buffer. Element (i, j)
+// lives at i * rowStride() + j * colStride(). Matrix holds doubles and
+// FloatMatrix floats; both are instantiated in Matrix.cpp.
+template<typename T>
+class BasicMatrix {
+
+public:
+
+    using value_type = T;
+    using Storage = std::vector<T, AlignedAllocator<T>>;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+private:
+
+    Storage m_data;
+    std::size_t m_rows;
+    std::size_t m_cols;
+    std::size_t m_rowStride;
+    std::size_t m_colStride;
+
+    // Private methods
+    template<typename Op, typename E>
+    void evaluate(const E& e);
+    BasicVector<T> reduction(Reduction op, std::size_t axis) const;
+
+public:
+
+    // Constructors
+    BasicMatrix();
+    BasicMatrix(std::size_t n, T value = T());
+    BasicMatrix(std::size_t row, std::size_t col, T value = T());
+    BasicMatrix(const BasicMatrix& other) = default;
+    BasicMatrix(BasicMatrix&& other) noexcept;
+    template<typename E>
+    BasicMatrix(const MatrixExpression<E>& e);
 
     // Destructors
-    ~Matrix() = default;
+    ~BasicMatrix() = default;
 
     // Operators
-    Matrix& operator=(const Matrix& other) = default;
-    Matrix& operator+=(const Matrix& other);
-    Matrix& operator+=(const Vector& other);
-    Matrix& operator+=(double value);
-    Matrix& operator-=(const Matrix& other);
-    Matrix& operator-=(const Vector& other);
-    Matrix& operator-=(double value);
-    Matrix& operator*=(const Matrix& other);
-    Matrix& operator*=(const Vector& other);
-    Matrix& operator*=(double value);
-    Matrix& operator/=(const Matrix& other);
-    Matrix& operator/=(const Vector& other);
-    Matrix& operator/=(double value);
-    Vector& operator[](unsigned int i);
-    const Vector& operator[](unsigned int i) const;
+    BasicMatrix& operator=(const BasicMatrix& other) = default;
+    BasicMatrix& operator=(BasicMatrix&& other) noexcept;
+    BasicMatrix& operator+=(const BasicMatrix& other);
+    BasicMatrix& operator+=(const BasicVector<T>& other);
+    BasicMatrix& operator+=(T value);
+    BasicMatrix& operator-=(const BasicMatrix& other);
+    BasicMatrix& operator-=(const BasicVector<T>& other);
+    BasicMatrix& operator-=(T value);
+    BasicMatrix& operator*=(const BasicMatrix& other);
+    BasicMatrix& operator*=(const BasicVector<T>& other);
+    BasicMatrix& operator*=(T value);
+    BasicMatrix& operator/=(const BasicMatrix& other);
+    BasicMatrix& operator/=(const BasicVector<T>& other);
+    BasicMatrix& operator/=(T value);
+    template<typename E>
+    BasicMatrix& operator=(const MatrixExpression<E>& e);
+    template<typename E>
+    BasicMatrix& operator+=(const MatrixExpression<E>& e);
+    template<typename E>
+    BasicMatrix& operator-=(const MatrixExpression<E>& e);
+    template<typename E>
+    BasicMatrix& operator*=(const MatrixExpression<E>& e);
+    template<typename E>
+    BasicMatrix& operator/=(const MatrixExpression<E>& e);
+    BasicMatrixRow<T> operator[](unsigned int i);
+    BasicConstMatrixRow<T> operator[](unsigned int i) const;
+    T& operator()(std::size_t i, std::size_t j);
+    const T& operator()(std::size_t i, std::size_t j) const;
 
     // Other members
     std::pair<std::size_t, std::size_t> size() const;
     std::size_t nbRows() const;
     std::size_t nbCols() const;
-    Matrix dot(const Matrix& other) const;
-    Vector dot(const Vector& other) const;
-    Matrix transpose() const;
-    std::vector<Vector>::iterator begin();
-    std::vector<Vector>::const_iterator begin() const;
-    std::vector<Vector>::iterator end();
-    std::vector<Vector>::const_iterator end() const;
-    std::vector<Vector>::const_iterator cbegin() const;
-    std::vector<Vector>::const_iterator cend() const;
+    std::size_t rowStride() const;
+    std::size_t colStride() const;
+    T* data();
+    const T* data() const;
+    BasicMatrixRow<T> row(std::size_t i);
+    BasicConstMatrixRow<T> row(std::size_t i) const;
+    BasicMatrix dot(const BasicMatrix& other) const;
+    BasicVector<T> dot(const BasicVector<T>& other) const;
+    BasicMatrix transpose() const;
+    // Square matrices are transposed in place; others through a new buffer.
+    void transposeInPlace();
+    // Reductions along an axis: axis 0 reduces each column into a Vector of
+    // nbCols() elements, axis 1 each row into a Vector of nbRows() elements.
+    BasicVector<T> sum(std::size_t axis) const;
+    BasicVector<T> mean(std::size_t axis) const;
+    BasicVector<T> max(std::size_t axis) const;
+    BasicVector<T> min(std::size_t axis) const;
+    BasicVector<T> norm(std::size_t axis) const;
+    BasicVector<T> variance(std::size_t axis) const;
+    std::vector<std::size_t> argmax(std::size_t axis) const;
+    iterator begin();
+    const_iterator begin() const;
+    iterator end();
+    const_iterator end() const;
+    const_iterator cbegin() const;
+    const_iterator cend() const;
 
     // Friend functions
 
 };
 
 // Functions
-void checkMatDimOp(const Matrix& m1, const Matrix& m2);
-void checkVectMatDimOp(const Vector& v, const Matrix& m);
-void checkMatVectDimDot(const Matrix& m, const Vector& v);
-void checkMatDimDot(const Matrix& m1, const Matrix& m2);
-Matrix operator+(const Matrix& m1, const Matrix& m2);
-Matrix operator+(const Matrix& m, const Vector& v);
-Matrix operator+(const Vector& v, const Matrix& m);
-Matrix operator+(const Matrix& m, double value);
-Matrix operator+(double value, const Matrix& m);
-Matrix operator-(const Matrix& m1, const Matrix& m2);
-Matrix operator-(const Matrix& m, const Vector& v);
-Matrix operator-(const Vector& v, const Matrix& m);
-Matrix operator-(const Matrix& m, double value);
-Matrix operator-(double value, const Matrix& m);
-Matrix operator*(const Matrix& m1, const Matrix& m2);
-Matrix operator*(const Matrix& m, const Vector& v);
-Matrix operator*(const Vector& v, const Matrix& m);
-Matrix operator*(const Matrix& m, double value);
-Matrix operator*(double value, const Matrix& m);
-Matrix operator/(const Matrix& m1, const Matrix& m2);
-Matrix operator/(const Matrix& m, const Vector& v);
-Matrix operator/(const Vector& v, const Matrix& m);
-Matrix operator/(const Matrix& m, double value);
-Matrix operator/(double value, const Matrix& m);
-std::pair<std::size_t, std::size_t> size(const Matrix& m);
-Matrix dot(const Matrix& m1, const Matrix& m2);
-Vector dot(const Matrix& m, const Vector& v);
-Vector dot(const Vector& v, const Matrix& m);
-Matrix transpose(const Matrix& m);
\ No newline at end of file
+template<typename T>
+void checkMatDimOp(const BasicMatrix<T>& m1, const BasicMatrix<T>& m2);
+template<typename T>
+void checkVectMatDimOp(const BasicVector<T>& v, const BasicMatrix<T>& m);
+template<typename T>
+void checkMatVectDimDot(const BasicMatrix<T>& m, const BasicVector<T>& v);
+template<typename T>
+void checkMatDimDot(const BasicMatrix<T>& m1, const BasicMatrix<T>& m2);
+template<typename T>
+void checkMatDimGemm(const BasicMatrix<T>& a, const BasicMatrix<T>& b, const BasicMatrix<T>& c, bool transA, bool transB);
+template<typename T>
+void checkMatDimGemv(const BasicMatrix<T>& a, const BasicVector<T>& x, const BasicVector<T>& y, bool transA);
+template<typename T>
+std::pair<std::size_t, std::size_t> size(const BasicMatrix<T>& m);
+template<typename T>
+BasicMatrix<T> dot(const BasicMatrix<T>& m1, const BasicMatrix<T>& m2);
+template<typename T>
+BasicVector<T> dot(const BasicMatrix<T>& m, const BasicVector<T>& v);
+template<typename T>
+BasicVector<T> dot(const BasicVector<T>& v, const BasicMatrix<T>& m);
+template<typename T>
+BasicMatrix<T> transpose(const BasicMatrix<T>& m);
+// Destination-passing variants: the result is written into out, which must
+// already have the right dimensions and must not alias an input (add, sub,
+// mul and div allow out to be one of their operands).
+template<typename T>
+void add(const BasicMatrix<T>& a, const BasicMatrix<T>& b, BasicMatrix<T>& out);
+template<typename T>
+void sub(const BasicMatrix<T>& a, const BasicMatrix<T>& b, BasicMatrix<T>& out);
+template<typename T>
+void mul(const BasicMatrix<T>& a, const BasicMatrix<T>& b, BasicMatrix<T>& out);
+template<typename T>
+void div(const BasicMatrix<T>& a, const BasicMatrix<T>& b, BasicMatrix<T>& out);
+template<typename T>
+void dot(const BasicMatrix<T>& m1, const BasicMatrix<T>& m2, BasicMatrix<T>& out);
+template<typename T>
+void dot(const BasicMatrix<T>& m, const BasicVector<T>& v, BasicVector<T>& out);
+template<typename T>
+void dot(const BasicVector<T>& v, const BasicMatrix<T>& m, BasicVector<T>& out);
+template<typename T>
+void transpose(const BasicMatrix<T>& m, BasicMatrix<T>& out);
+template<typename T>
+void gemm(std::type_identity_t<T> alpha, const BasicMatrix<T>& a, const BasicMatrix<T>& b, std::type_identity_t<T> beta, BasicMatrix<T>& c, bool transA = false, bool transB = false);
+// Same with c = act(c + bias) fused into the product, see gemm/Epilogue.hpp.
+template<typename T>
+void gemm(std::type_identity_t<T> alpha, const BasicMatrix<T>& a, const BasicMatrix<T>& b, std::type_identity_t<T> beta, BasicMatrix<T>& c, const GemmEpilogue<T>& epilogue, bool transA = false, bool transB = false);
+// y = alpha * op(a) * x + beta * y, op(a) being a or its transpose.
+template<typename T>
+void gemv(std::type_identity_t<T> alpha, const BasicMatrix<T>& a, const BasicVector<T>& x, std::type_identity_t<T> beta, BasicVector<T>& y, bool transA = false);
+// Row b of ys = op(a) * row b of xs, for a batch of vectors stored as rows.
+// Batches large enough to amortize packing run as one GEMM.
+template<typename T>
+void gemvBatch(const BasicMatrix<T>& a, const BasicMatrix<T>& xs, BasicMatrix<T>& ys, bool transA = false);
+
+// Expression evaluation
+
+template<typename T>
+template<typename Op, typename E>
+void BasicMatrix<T>::evaluate(const E& e) {
+    if (e.nbRows() != m_rows || e.nbCols() != m_cols) {
+        throw("Matrix do not have the same dimensions.");
+    }
+    NN_PROFILE_SCOPE(Elementwise, "Matrix expression", static_cast<double>(m_rows * m_cols * sizeof(T)), 0);
+    T* d = data();
+    const std::size_t rowGrain = std::max<std::size_t>(1, parallelGrain / std::max<std::size_t>(1, m_cols));
+    parallelFor(0, m_rows, rowGrain, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) {
+            T* r = d + i * m_rowStride;
+            for (std::size_t j = 0; j < m_cols; j++) {
+                r[j] = static_cast<T>(Op::apply(r[j], e(i, j)));
+            }
+        }
+    });
+}
+
+template<typename T>
+template<typename E>
+BasicMatrix<T>::BasicMatrix(const MatrixExpression<E>& e) :
+    BasicMatrix(static_cast<const E&>(e).nbRows(), static_cast<const E&>(e).nbCols())
+{
+    evaluate<ExprAssign>(static_cast<const E&>(e));
+}
+
+template<typename T>
+template<typename E>
+BasicMatrix<T>& BasicMatrix<T>::operator=(const MatrixExpression<E>& e) {
+    const E& expr = static_cast<const E&>(e);
+    if (expr.nbRows() != m_rows || expr.nbCols() != m_cols) {
+        *this = BasicMatrix(expr.nbRows(), expr.nbCols());
+    }
+    evaluate<ExprAssign>(expr);
+    return *this;
+}
+
+template<typename T>
+template<typename E>
+BasicMatrix<T>& BasicMatrix<T>::operator+=(const MatrixExpression<E>& e) {
+    evaluate<ExprAdd>(static_cast<const E&>(e));
+    return *this;
+}
+
+template<typename T>
+template<typename E>
+BasicMatrix<T>& BasicMatrix<T>::operator-=(const MatrixExpression<E>& e) {
+    evaluate<ExprSub>(static_cast<const E&>(e));
+    return *this;
+}
+
+template<typename T>
+template<typename E>
+BasicMatrix<T>& BasicMatrix<T>::operator*=(const MatrixExpression<E>& e) {
+    evaluate<ExprMul>(static_cast<const E&>(e));
+    return *this;
+}
+
+template<typename T>
+template<typename E>
+BasicMatrix<T>& BasicMatrix<T>::operator/=(const MatrixExpression<E>& e) {
+    evaluate<ExprDiv>(static_cast<const E&>(e));
+    return *this;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <new>
+
+#include "memory/MemoryResource.hpp"
+
+// Standard allocator returning storage aligned on Alignment bytes, so that
+// every buffer handed to the vectorized kernels starts on a cache line.
+// Storage comes from memory::allocate(), i.e. from the calling thread's
+// current memory resource (the shared pool unless a scope selected another).
+template<typename T, std::size_t Alignment = 64>
+class AlignedAllocator {
+
+    static_assert(Alignment <= memory::alignment && memory::alignment % Alignment == 0, "Unsupported alignment.");
+
+public:
+
+    using value_type = T;
+
+    template<typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    // Constructors
+    AlignedAllocator() noexcept = default;
+
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+    // Other members
+    T* allocate(std::size_t n) {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(memory::allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t) noexcept {
+        memory::deallocate(p);
+    }
+
+};
+
+template<typename T, typename U, std::size_t Alignment>
+bool operator==(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&) {
+    return true;
+}
+
+template<typename T, typename U, std::size_t Alignment>
+bool operator!=(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&) {
+    return false;
+}
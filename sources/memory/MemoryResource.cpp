@@ -0,0 +1,297 @@
+#include <algorithm>
+#include <bit>
+#include <new>
+
+#include "memory/MemoryResource.hpp"
+#include "profile/Profiler.hpp"
+
+// Header in front of every block returned by memory::allocate(). It fills a
+// whole alignment unit so that the buffer behind it stays aligned.
+struct alignas(memory::alignment) BlockHeader {
+    memory::MemoryResource* owner;
+    std::size_t bytes;
+};
+
+static_assert(sizeof(BlockHeader) == memory::alignment);
+
+static std::atomic<memory::MemoryResource*> s_defaultResource(nullptr);
+static thread_local memory::MemoryResource* t_currentResource = nullptr;
+
+// bytes is the size requested, blockBytes the size of the block handed out.
+static void recordAllocation(memory::Stats& stats, std::size_t bytes, std::size_t blockBytes, bool hit) {
+    stats.allocations++;
+    stats.bytesAllocated += bytes;
+    stats.bytesInUse += blockBytes;
+    stats.peakBytesInUse = std::max(stats.peakBytesInUse, stats.bytesInUse);
+    (hit ? stats.hits : stats.misses)++;
+}
+
+// Four size classes per power of two, counted on the size of a block less
+// one header: class 0 holds blocks of up to 64 + 64 bytes, then sizes in
+// (2^p, 2^(p+1)] + 64 go to 2^p + k * 2^(p-2) + 64, k = 1..4. A buffer of
+// a power-of-two size behind the header of memory::allocate() thus gets a
+// block of exactly its size plus the header, not one of the next class.
+constexpr std::size_t minClassShift = 6;
+constexpr std::size_t headerBytes = sizeof(BlockHeader);
+
+namespace memory {
+
+double Stats::hitRate() const {
+    return (allocations == 0) ? 0. : static_cast<double>(hits) / static_cast<double>(allocations);
+}
+
+// HeapResource
+
+void* HeapResource::allocate(std::size_t bytes) {
+    void* p = ::operator new(bytes, std::align_val_t(alignment));
+    m_counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    m_counters.bytesAllocated.fetch_add(bytes, std::memory_order_relaxed);
+    const std::size_t inUse = m_counters.bytesInUse.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    std::size_t peak = m_counters.peakBytesInUse.load(std::memory_order_relaxed);
+    while (inUse > peak && !m_counters.peakBytesInUse.compare_exchange_weak(peak, inUse, std::memory_order_relaxed)) {
+    }
+    return p;
+}
+
+void HeapResource::deallocate(void* p, std::size_t bytes) noexcept {
+    m_counters.bytesInUse.fetch_sub(bytes, std::memory_order_relaxed);
+    ::operator delete(p, std::align_val_t(alignment));
+}
+
+Stats HeapResource::stats() const {
+    Stats result;
+    result.allocations = m_counters.allocations.load(std::memory_order_relaxed);
+    result.bytesAllocated = m_counters.bytesAllocated.load(std::memory_order_relaxed);
+    result.bytesInUse = m_counters.bytesInUse.load(std::memory_order_relaxed);
+    result.peakBytesInUse = m_counters.peakBytesInUse.load(std::memory_order_relaxed);
+    result.misses = result.allocations;
+    return result;
+}
+
+// PoolResource
+
+PoolResource::PoolResource(MemoryResource& upstream, std::size_t maxCachedBytes) :
+    m_upstream(upstream), m_mutex(), m_freeLists(sizeClass(maxPooledBytes) + 1, nullptr),
+    m_cachedBytes(0), m_maxCachedBytes(maxCachedBytes), m_stats()
+{}
+
+PoolResource::~PoolResource() {
+    release();
+}
+
+std::size_t PoolResource::sizeClass(std::size_t bytes) {
+    if (bytes <= (std::size_t(1) << minClassShift) + headerBytes) {
+        return 0;
+    }
+    const std::size_t payload = bytes - headerBytes;
+    const std::size_t p = std::bit_width(payload - 1) - 1;
+    const std::size_t step = std::size_t(1) << (p - 2);
+    const std::size_t k = (payload - (std::size_t(1) << p) + step - 1) / step;
+    return (p - minClassShift) * 4 + k;
+}
+
+std::size_t PoolResource::classBytes(std::size_t sizeClass) {
+    if (sizeClass == 0) {
+        return (std::size_t(1) << minClassShift) + headerBytes;
+    }
+    const std::size_t p = (sizeClass - 1) / 4 + minClassShift;
+    const std::size_t k = (sizeClass - 1) % 4 + 1;
+    return (std::size_t(1) << p) + k * (std::size_t(1) << (p - 2)) + headerBytes;
+}
+
+void* PoolResource::allocate(std::size_t bytes) {
+    if (bytes > maxPooledBytes) {
+        void* p = m_upstream.allocate(bytes);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        recordAllocation(m_stats, bytes, bytes, false);
+        return p;
+    }
+    const std::size_t c = sizeClass(bytes);
+    const std::size_t blockBytes = classBytes(c);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (FreeBlock* block = m_freeLists[c]) {
+            m_freeLists[c] = block->next;
+            m_cachedBytes -= blockBytes;
+            recordAllocation(m_stats, bytes, blockBytes, true);
+            return block;
+        }
+    }
+    void* p = m_upstream.allocate(blockBytes);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    recordAllocation(m_stats, bytes, blockBytes, false);
+    return p;
+}
+
+void PoolResource::deallocate(void* p, std::size_t bytes) noexcept {
+    if (bytes > maxPooledBytes) {
+        m_upstream.deallocate(p, bytes);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.bytesInUse -= bytes;
+        return;
+    }
+    const std::size_t c = sizeClass(bytes);
+    const std::size_t blockBytes = classBytes(c);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.bytesInUse -= blockBytes;
+        if (m_cachedBytes + blockBytes <= m_maxCachedBytes) {
+            FreeBlock* block = static_cast<FreeBlock*>(p);
+            block->next = m_freeLists[c];
+            m_freeLists[c] = block;
+            m_cachedBytes += blockBytes;
+            return;
+        }
+    }
+    m_upstream.deallocate(p, blockBytes);
+}
+
+Stats PoolResource::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void PoolResource::resetStats() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const std::size_t inUse = m_stats.bytesInUse;
+    m_stats = Stats();
+    m_stats.bytesInUse = inUse;
+    m_stats.peakBytesInUse = inUse;
+}
+
+void PoolResource::release() {
+    std::vector<FreeBlock*> lists;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        lists.swap(m_freeLists);
+        m_freeLists.assign(lists.size(), nullptr);
+        m_cachedBytes = 0;
+    }
+    for (std::size_t c = 0; c < lists.size(); c++) {
+        while (FreeBlock* block = lists[c]) {
+            lists[c] = block->next;
+            m_upstream.deallocate(block, classBytes(c));
+        }
+    }
+}
+
+std::size_t PoolResource::cachedBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_cachedBytes;
+}
+
+void PoolResource::setMaxCachedBytes(std::size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_maxCachedBytes = bytes;
+        if (m_cachedBytes <= bytes) {
+            return;
+        }
+    }
+    release();
+}
+
+// ArenaResource
+
+ArenaResource::ArenaResource(MemoryResource& upstream, std::size_t chunkBytes) :
+    m_upstream(upstream), m_chunkBytes(chunkBytes), m_chunks(), m_cursor(nullptr), m_limit(nullptr), m_stats()
+{}
+
+ArenaResource::~ArenaResource() {
+    reset();
+}
+
+void* ArenaResource::allocate(std::size_t bytes) {
+    const std::size_t rounded = (bytes + alignment - 1) / alignment * alignment;
+    const bool hit = m_cursor != nullptr && static_cast<std::size_t>(m_limit - m_cursor) >= rounded;
+    if (!hit) {
+        const std::size_t chunkBytes = std::max(m_chunkBytes, rounded);
+        char* chunk = static_cast<char*>(m_upstream.allocate(chunkBytes));
+        m_chunks.push_back({chunk, chunkBytes});
+        m_cursor = chunk;
+        m_limit = chunk + chunkBytes;
+    }
+    void* p = m_cursor;
+    m_cursor += rounded;
+    recordAllocation(m_stats, bytes, rounded, hit);
+    return p;
+}
+
+void ArenaResource::deallocate(void*, std::size_t bytes) noexcept {
+    m_stats.bytesInUse -= (bytes + alignment - 1) / alignment * alignment;
+}
+
+Stats ArenaResource::stats() const {
+    return m_stats;
+}
+
+void ArenaResource::reset() {
+    for (const Chunk& chunk : m_chunks) {
+        m_upstream.deallocate(chunk.data, chunk.bytes);
+    }
+    m_chunks.clear();
+    m_cursor = nullptr;
+    m_limit = nullptr;
+    m_stats.bytesInUse = 0;
+}
+
+// Resource selection
+
+HeapResource& heapResource() {
+    static HeapResource resource;
+    return resource;
+}
+
+PoolResource& defaultPool() {
+    // Never destroyed, so that buffers of static objects can still be freed
+    // during program exit.
+    static PoolResource* pool = new PoolResource(heapResource());
+    return *pool;
+}
+
+MemoryResource& defaultResource() {
+    MemoryResource* resource = s_defaultResource.load(std::memory_order_acquire);
+    return (resource != nullptr) ? *resource : defaultPool();
+}
+
+void setDefaultResource(MemoryResource* resource) {
+    s_defaultResource.store(resource, std::memory_order_release);
+}
+
+MemoryResource& currentResource() {
+    return (t_currentResource != nullptr) ? *t_currentResource : defaultResource();
+}
+
+void* allocate(std::size_t bytes) {
+    NN_PROFILE_ALLOCATION(bytes);
+    MemoryResource& resource = currentResource();
+    const std::size_t total = bytes + sizeof(BlockHeader);
+    BlockHeader* header = new (resource.allocate(total)) BlockHeader{&resource, total};
+    return header + 1;
+}
+
+void deallocate(void* p) noexcept {
+    if (p == nullptr) {
+        return;
+    }
+    BlockHeader* header = static_cast<BlockHeader*>(p) - 1;
+    header->owner->deallocate(header, header->bytes);
+}
+
+// Scopes
+
+ScopedResource::ScopedResource(MemoryResource& resource) : m_previous(t_currentResource) {
+    t_currentResource = &resource;
+}
+
+ScopedResource::~ScopedResource() {
+    t_currentResource = m_previous;
+}
+
+ScopedArena::ScopedArena(std::size_t chunkBytes) : m_arena(currentResource(), chunkBytes), m_scope(m_arena) {}
+
+ArenaResource& ScopedArena::arena() {
+    return m_arena;
+}
+
+}
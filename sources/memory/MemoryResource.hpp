@@ -0,0 +1,224 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// Memory resources behind AlignedAllocator, and therefore behind every
+// Vector, Matrix and NDArray buffer.
+//
+// Blocks are handed out through memory::allocate(), which takes them from the
+// calling thread's current resource and prefixes them with a one cache line
+// header naming that resource. memory::deallocate() reads the header back, so
+// a buffer always returns to the resource it came from, even when it is freed
+// outside the scope that selected that resource, and the allocator type
+// itself stays stateless.
+//
+// The default resource is a process-wide PoolResource: freed blocks go to
+// per-size-class free lists and are handed out again to the next request of
+// the same class, so the temporaries of a training step reuse the buffers of
+// the previous one instead of going back to malloc. ScopedArena switches the
+// current thread to a bump allocator for per-step scratch.
+namespace memory {
+
+// Every block is aligned on this many bytes, and so is every buffer
+// returned by memory::allocate().
+constexpr std::size_t alignment = 64;
+
+struct Stats {
+    std::size_t allocations = 0;   // number of allocate() calls
+    std::size_t bytesAllocated = 0;   // total bytes requested
+    std::size_t bytesInUse = 0;   // bytes of the blocks currently handed out
+    std::size_t peakBytesInUse = 0;
+    std::size_t hits = 0;   // requests served without going upstream
+    std::size_t misses = 0;
+
+    double hitRate() const;
+};
+
+class MemoryResource {
+
+public:
+
+    virtual ~MemoryResource() = default;
+
+    // Returns at least bytes bytes aligned on memory::alignment.
+    virtual void* allocate(std::size_t bytes) = 0;
+
+    // bytes is the value passed to the allocate() call that returned p.
+    virtual void deallocate(void* p, std::size_t bytes) noexcept = 0;
+
+    virtual Stats stats() const = 0;
+
+};
+
+// Aligned operator new / operator delete.
+class HeapResource : public MemoryResource {
+
+private:
+
+    struct Counters {
+        std::atomic<std::size_t> allocations{0};
+        std::atomic<std::size_t> bytesAllocated{0};
+        std::atomic<std::size_t> bytesInUse{0};
+        std::atomic<std::size_t> peakBytesInUse{0};
+    };
+
+    Counters m_counters;
+
+public:
+
+    void* allocate(std::size_t bytes) override;
+    void deallocate(void* p, std::size_t bytes) noexcept override;
+    Stats stats() const override;
+
+};
+
+// Thread-safe cache of freed blocks, in size classes spaced four per power
+// of two so that rounding up wastes at most a quarter of a block. Classes
+// are spaced on the size less the header of memory::allocate(), so that a
+// power-of-two buffer and its header fill a block exactly. Requests
+// above maxPooledBytes go straight to the upstream resource, and blocks are
+// released upstream instead of cached once maxCachedBytes are cached.
+class PoolResource : public MemoryResource {
+
+public:
+
+    static constexpr std::size_t maxPooledBytes = std::size_t(1) << 32;
+
+private:
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    MemoryResource& m_upstream;
+    mutable std::mutex m_mutex;
+    std::vector<FreeBlock*> m_freeLists;
+    std::size_t m_cachedBytes;
+    std::size_t m_maxCachedBytes;
+    Stats m_stats;
+
+public:
+
+    // Constructors
+    explicit PoolResource(MemoryResource& upstream, std::size_t maxCachedBytes = std::size_t(1) << 30);
+    PoolResource(const PoolResource& other) = delete;
+
+    // Destructors
+    ~PoolResource() override;
+
+    // Operators
+    PoolResource& operator=(const PoolResource& other) = delete;
+
+    // Other members
+    void* allocate(std::size_t bytes) override;
+    void deallocate(void* p, std::size_t bytes) noexcept override;
+    Stats stats() const override;
+    void resetStats();
+    // Returns every cached block to the upstream resource.
+    void release();
+    std::size_t cachedBytes() const;
+    void setMaxCachedBytes(std::size_t bytes);
+
+    // Size class of a request, and the block size of a class.
+    static std::size_t sizeClass(std::size_t bytes);
+    static std::size_t classBytes(std::size_t sizeClass);
+
+};
+
+// Bump allocator over chunks taken from an upstream resource. deallocate()
+// does not reclaim anything: the whole arena is recycled at once by
+// reset() or on destruction, which makes allocation a pointer increment.
+// Not thread-safe; meant to be the current resource of one thread.
+class ArenaResource : public MemoryResource {
+
+private:
+
+    struct Chunk {
+        char* data;
+        std::size_t bytes;
+    };
+
+    MemoryResource& m_upstream;
+    std::size_t m_chunkBytes;
+    std::vector<Chunk> m_chunks;
+    char* m_cursor;
+    char* m_limit;
+    Stats m_stats;
+
+public:
+
+    // Constructors
+    explicit ArenaResource(MemoryResource& upstream, std::size_t chunkBytes = std::size_t(1) << 20);
+    ArenaResource(const ArenaResource& other) = delete;
+
+    // Destructors
+    ~ArenaResource() override;
+
+    // Operators
+    ArenaResource& operator=(const ArenaResource& other) = delete;
+
+    // Other members
+    void* allocate(std::size_t bytes) override;
+    void deallocate(void* p, std::size_t bytes) noexcept override;
+    Stats stats() const override;
+    // Gives every chunk back upstream. Blocks still in use become invalid.
+    void reset();
+
+};
+
+HeapResource& heapResource();
+PoolResource& defaultPool();
+
+// Resource used by threads that did not select one: defaultPool() unless
+// changed by setDefaultResource(), which restores it when given nullptr.
+MemoryResource& defaultResource();
+void setDefaultResource(MemoryResource* resource);
+
+// Resource memory::allocate() uses on the calling thread.
+MemoryResource& currentResource();
+
+// Header-prefixed allocation from currentResource(), see above.
+void* allocate(std::size_t bytes);
+void deallocate(void* p) noexcept;
+
+// Makes resource the current resource of this thread until destruction.
+class ScopedResource {
+
+private:
+
+    MemoryResource* m_previous;
+
+public:
+
+    explicit ScopedResource(MemoryResource& resource);
+    ScopedResource(const ScopedResource& other) = delete;
+    ~ScopedResource();
+    ScopedResource& operator=(const ScopedResource& other) = delete;
+
+};
+
+// Per-step scratch: every buffer allocated by this thread in the scope
+// comes from an arena freed in one go when the scope ends. Buffers that
+// must outlive the scope have to be allocated before it. Work run on the
+// thread pool keeps allocating from the workers' own current resource.
+class ScopedArena {
+
+private:
+
+    ArenaResource m_arena;
+    ScopedResource m_scope;
+
+public:
+
+    explicit ScopedArena(std::size_t chunkBytes = std::size_t(1) << 20);
+    ScopedArena(const ScopedArena& other) = delete;
+    ScopedArena& operator=(const ScopedArena& other) = delete;
+
+    ArenaResource& arena();
+
+};
+
+}
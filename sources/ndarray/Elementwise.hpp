@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+#include "ndarray/StridedLoop.hpp"
+#include "parallel/ThreadPool.hpp"
+#include "profile/Profiler.hpp"
+#include "reduce/Reduce.hpp"
+#include "simd/Simd.hpp"
+
+// Elementwise operations shared by NDArray and NDArrayView. apply() is the
+// generic definition; vv, vs and sv are the SIMD kernels used for double and
+// float runs where both operands are contiguous (vv), the right one is
+// broadcast along the run (vs) or the left one is (sv). BFloat16 and Float16
+// elements go through apply(), which computes in float.
+
+struct ElementwiseAssign {
+    template<typename T>
+    static T apply(const T&, const T& b) { return b; }
+    template<typename T>
+    static void vv(const T*, const T* y, T* out, std::size_t n) { std::copy(y, y + n, out); }
+    template<typename T>
+    static void vs(const T*, T value, T* out, std::size_t n) { std::fill(out, out + n, value); }
+    template<typename T>
+    static void sv(T, const T* x, T* out, std::size_t n) { std::copy(x, x + n, out); }
+};
+
+struct ElementwiseAdd {
+    template<typename T>
+    static T apply(const T& a, const T& b) { return a + b; }
+    template<typename T>
+    static void vv(const T* x, const T* y, T* out, std::size_t n) { simd::kernels<T>().add(x, y, out, n); }
+    template<typename T>
+    static void vs(const T* x, T value, T* out, std::size_t n) { simd::kernels<T>().addScalar(x, value, out, n); }
+    template<typename T>
+    static void sv(T value, const T* x, T* out, std::size_t n) { simd::kernels<T>().addScalar(x, value, out, n); }
+};
+
+struct ElementwiseSub {
+    template<typename T>
+    static T apply(const T& a, const T& b) { return a - b; }
+    template<typename T>
+    static void vv(const T* x, const T* y, T* out, std::size_t n) { simd::kernels<T>().sub(x, y, out, n); }
+    template<typename T>
+    static void vs(const T* x, T value, T* out, std::size_t n) { simd::kernels<T>().subScalar(x, value, out, n); }
+    template<typename T>
+    static void sv(T value, const T* x, T* out, std::size_t n) { simd::kernels<T>().scalarSub(value, x, out, n); }
+};
+
+struct ElementwiseMul {
+    template<typename T>
+    static T apply(const T& a, const T& b) { return a * b; }
+    template<typename T>
+    static void vv(const T* x, const T* y, T* out, std::size_t n) { simd::kernels<T>().mul(x, y, out, n); }
+    template<typename T>
+    static void vs(const T* x, T value, T* out, std::size_t n) { simd::kernels<T>().mulScalar(x, value, out, n); }
+    template<typename T>
+    static void sv(T value, const T* x, T* out, std::size_t n) { simd::kernels<T>().mulScalar(x, value, out, n); }
+};
+
+struct ElementwiseDiv {
+    template<typename T>
+    static T apply(const T& a, const T& b) { return a / b; }
+    template<typename T>
+    static void vv(const T* x, const T* y, T* out, std::size_t n) { simd::kernels<T>().div(x, y, out, n); }
+    template<typename T>
+    static void vs(const T* x, T value, T* out, std::size_t n) { simd::kernels<T>().divScalar(x, value, out, n); }
+    template<typename T>
+    static void sv(T value, const T* x, T* out, std::size_t n) { simd::kernels<T>().scalarDiv(value, x, out, n); }
+};
+
+// out = a op b over shape, every operand with its own (possibly 0) strides.
+// out may alias a or b element for element.
+template<typename Op, typename T>
+void elementwise_apply(
+    const std::vector<std::size_t>& shape,
+    T* out, const std::vector<std::ptrdiff_t>& out_strides,
+    const T* a, const std::vector<std::ptrdiff_t>& a_strides,
+    const T* b, const std::vector<std::ptrdiff_t>& b_strides
+) {
+    NN_PROFILE_SCOPE(Elementwise, "NDArray elementwise", 3.0 * static_cast<double>(shape_size(shape) * sizeof(T)), static_cast<double>(shape_size(shape)));
+    strided_apply<3>(shape, {out_strides, a_strides, b_strides}, [&](const auto& offsets, const auto& strides, std::size_t n) {
+        T* o = out + offsets[0];
+        const T* x = a + offsets[1];
+        const T* y = b + offsets[2];
+        if constexpr (simd::hasKernels<T>) {
+            if (strides[0] == 1 && strides[1] == 1 && strides[2] == 1) {
+                Op::vv(x, y, o, n);
+                return;
+            }
+            if (strides[0] == 1 && strides[1] == 1 && strides[2] == 0) {
+                Op::vs(x, *y, o, n);
+                return;
+            }
+            if (strides[0] == 1 && strides[1] == 0 && strides[2] == 1) {
+                Op::sv(*x, y, o, n);
+                return;
+            }
+        }
+        for (std::size_t i = 0; i < n; i++) {
+            o[i * strides[0]] = Op::apply(x[i * strides[1]], y[i * strides[2]]);
+        }
+    });
+}
+
+// data[i] = data[i] op value over contiguous storage, split over the pool.
+template<typename Op, typename T>
+void elementwise_scalar(T* data, std::size_t n, const T& value) {
+    NN_PROFILE_SCOPE(Elementwise, "NDArray elementwise scalar", 2.0 * static_cast<double>(n * sizeof(T)), static_cast<double>(n));
+    parallelFor(0, n, parallelGrain, [&](std::size_t first, std::size_t last) {
+        if constexpr (simd::hasKernels<T>) {
+            Op::vs(data + first, value, data + first, last - first);
+        } else {
+            for (std::size_t i = first; i < last; i++) {
+                data[i] = Op::apply(data[i], value);
+            }
+        }
+    });
+}
+
+// out[i] = a[i] op b[i] over contiguous operands of the same size.
+template<typename Op, typename T>
+void elementwise_contiguous(T* out, const T* a, const T* b, std::size_t n) {
+    NN_PROFILE_SCOPE(Elementwise, "NDArray elementwise", 3.0 * static_cast<double>(n * sizeof(T)), static_cast<double>(n));
+    parallelFor(0, n, parallelGrain, [&](std::size_t first, std::size_t last) {
+        if constexpr (simd::hasKernels<T>) {
+            Op::vv(a + first, b + first, out + first, last - first);
+        } else {
+            for (std::size_t i = first; i < last; i++) {
+                out[i] = Op::apply(a[i], b[i]);
+            }
+        }
+    });
+}
+
+// Partial sums of 16-bit elements are kept in float and rounded once. See
+// Reduce.hpp for the blockwise pairwise summation.
+template<typename T>
+T contiguous_sum(const T* data, std::size_t n) {
+    NN_PROFILE_SCOPE(Reduction, "NDArray sum", static_cast<double>(n * sizeof(T)), static_cast<double>(n));
+    return reduceSum(data, n);
+}
+
+// n must be positive.
+template<typename T>
+T contiguous_max(const T* data, std::size_t n) {
+    NN_PROFILE_SCOPE(Reduction, "NDArray max", static_cast<double>(n * sizeof(T)), static_cast<double>(n));
+    return parallelReduce(
+        0, n, parallelGrain, data[0],
+        [data](std::size_t first, std::size_t last) {
+            if constexpr (simd::hasKernels<T>) {
+                return simd::kernels<T>().max(data + first, last - first);
+            } else {
+                return *std::max_element(data + first, data + last);
+            }
+        },
+        [](const T& a, const T& b) { return (b > a) ? b : a; }
+    );
+}
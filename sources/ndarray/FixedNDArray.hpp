@@ -0,0 +1,305 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "ndarray/IndexRange.hpp"
+#include "ndarray/NDArrayView.hpp"
+
+// Extents of a fixed-shape array, e.g. Shape<3, 3> for a 3x3 kernel.
+template<std::size_t... Extents>
+struct Shape {
+
+    static constexpr std::size_t rank = sizeof...(Extents);
+    static constexpr std::size_t size = (Extents * ... * std::size_t(1));
+    static constexpr std::array<std::size_t, rank> extents{Extents...};
+
+    static constexpr std::array<std::ptrdiff_t, rank> strides = [] {
+        std::array<std::ptrdiff_t, rank> result{};
+        std::ptrdiff_t stride = 1;
+        for (std::size_t i = rank; i-- > 0;) {
+            result[i] = stride;
+            stride *= static_cast<std::ptrdiff_t>(extents[i]);
+        }
+        return result;
+    }();
+
+};
+
+template<typename T, typename S>
+class FixedNDArray;
+
+// Small array whose whole shape is known at compile time, stored inline
+// without any heap allocation. Offsets are constant folded, loops have a
+// constant trip count the compiler fully unrolls, and index bounds are checked
+// only in debug builds or through at(). Operations run on the calling thread:
+// these arrays are far below the size where the pool pays off.
+template<typename T, std::size_t... Extents>
+class FixedNDArray<T, Shape<Extents...>> {
+
+public:
+
+    using shape_type = Shape<Extents...>;
+
+    static_assert(shape_type::rank > 0, "FixedNDArray needs at least one axis.");
+
+private:
+
+    // Members
+
+    std::array<T, shape_type::size> m_data;
+
+    // Private methods
+
+    template<typename... Indices>
+    static constexpr void check_indices(Indices... indices) {
+        std::size_t axis = 0;
+        if (!((static_cast<std::size_t>(indices) < shape_type::extents[axis++]) && ...)) {
+            throw std::invalid_argument("Index out of range.");
+        }
+    }
+
+    template<typename... Indices>
+    static constexpr std::size_t offset_of(Indices... indices) {
+        std::size_t offset = 0;
+        std::size_t axis = 0;
+        ((offset += static_cast<std::size_t>(indices) * static_cast<std::size_t>(shape_type::strides[axis++])), ...);
+        return offset;
+    }
+
+public:
+
+    // Constructors
+
+    constexpr FixedNDArray() : m_data{} {};
+
+    constexpr explicit FixedNDArray(const T& value) : m_data{} {
+        m_data.fill(value);
+    };
+
+    // Elements in row-major order.
+    constexpr FixedNDArray(const std::array<T, shape_type::size>& data) : m_data(data) {};
+
+    // Operators
+
+    template<typename... Indices>
+        requires (sizeof...(Indices) == shape_type::rank && (std::is_integral_v<Indices> && ...))
+    constexpr T& operator()(Indices... indices) {
+#ifndef NDEBUG
+        check_indices(indices...);
+#endif
+        return m_data[offset_of(indices...)];
+    }
+
+    template<typename... Indices>
+        requires (sizeof...(Indices) == shape_type::rank && (std::is_integral_v<Indices> && ...))
+    constexpr const T& operator()(Indices... indices) const {
+#ifndef NDEBUG
+        check_indices(indices...);
+#endif
+        return m_data[offset_of(indices...)];
+    }
+
+    constexpr FixedNDArray& operator+=(const T& value) {
+        for (T& t : m_data) {
+            t += value;
+        }
+        return *this;
+    }
+
+    constexpr FixedNDArray& operator-=(const T& value) {
+        for (T& t : m_data) {
+            t -= value;
+        }
+        return *this;
+    }
+
+    constexpr FixedNDArray& operator*=(const T& value) {
+        for (T& t : m_data) {
+            t *= value;
+        }
+        return *this;
+    }
+
+    constexpr FixedNDArray& operator/=(const T& value) {
+        for (T& t : m_data) {
+            t /= value;
+        }
+        return *this;
+    }
+
+    constexpr FixedNDArray& operator+=(const FixedNDArray& other) {
+        for (std::size_t i = 0; i < shape_type::size; i++) {
+            m_data[i] += other.m_data[i];
+        }
+        return *this;
+    }
+
+    constexpr FixedNDArray& operator-=(const FixedNDArray& other) {
+        for (std::size_t i = 0; i < shape_type::size; i++) {
+            m_data[i] -= other.m_data[i];
+        }
+        return *this;
+    }
+
+    constexpr FixedNDArray& operator*=(const FixedNDArray& other) {
+        for (std::size_t i = 0; i < shape_type::size; i++) {
+            m_data[i] *= other.m_data[i];
+        }
+        return *this;
+    }
+
+    constexpr FixedNDArray& operator/=(const FixedNDArray& other) {
+        for (std::size_t i = 0; i < shape_type::size; i++) {
+            m_data[i] /= other.m_data[i];
+        }
+        return *this;
+    }
+
+    constexpr bool operator==(const FixedNDArray& other) const = default;
+
+    // Methods
+
+    template<typename... Indices>
+        requires (sizeof...(Indices) == shape_type::rank && (std::is_integral_v<Indices> && ...))
+    constexpr T& at(Indices... indices) {
+        check_indices(indices...);
+        return m_data[offset_of(indices...)];
+    }
+
+    template<typename... Indices>
+        requires (sizeof...(Indices) == shape_type::rank && (std::is_integral_v<Indices> && ...))
+    constexpr const T& at(Indices... indices) const {
+        check_indices(indices...);
+        return m_data[offset_of(indices...)];
+    }
+
+    NDArrayView<T> view() {
+        return NDArrayView<T>(
+            m_data.data(),
+            std::vector<std::size_t>(shape_type::extents.begin(), shape_type::extents.end()),
+            std::vector<std::ptrdiff_t>(shape_type::strides.begin(), shape_type::strides.end())
+        );
+    }
+
+    NDArrayView<const T> view() const {
+        return NDArrayView<const T>(
+            m_data.data(),
+            std::vector<std::size_t>(shape_type::extents.begin(), shape_type::extents.end()),
+            std::vector<std::ptrdiff_t>(shape_type::strides.begin(), shape_type::strides.end())
+        );
+    }
+
+    IndexRange indices() const {
+        return IndexRange(shape_type::extents);
+    }
+
+    constexpr void fill(const T& value) {
+        m_data.fill(value);
+    }
+
+    constexpr T* data() {
+        return m_data.data();
+    }
+
+    constexpr const T* data() const {
+        return m_data.data();
+    }
+
+    constexpr T* begin() {
+        return m_data.data();
+    }
+
+    constexpr const T* begin() const {
+        return m_data.data();
+    }
+
+    constexpr T* end() {
+        return m_data.data() + shape_type::size;
+    }
+
+    constexpr const T* end() const {
+        return m_data.data() + shape_type::size;
+    }
+
+    static constexpr std::size_t dim() {
+        return shape_type::rank;
+    }
+
+    static constexpr std::size_t size() {
+        return shape_type::size;
+    }
+
+    static constexpr const std::array<std::size_t, shape_type::rank>& shape() {
+        return shape_type::extents;
+    }
+
+    static constexpr const std::array<std::ptrdiff_t, shape_type::rank>& strides() {
+        return shape_type::strides;
+    }
+
+    constexpr T sum() const {
+        T result = T();
+        for (const T& t : m_data) {
+            result += t;
+        }
+        return result;
+    }
+
+    constexpr T max() const {
+        return *std::max_element(m_data.begin(), m_data.end());
+    }
+
+};
+
+template<typename T, typename S>
+constexpr FixedNDArray<T, S> operator+(FixedNDArray<T, S> a, const FixedNDArray<T, S>& b) {
+    a += b;
+    return a;
+}
+
+template<typename T, typename S>
+constexpr FixedNDArray<T, S> operator-(FixedNDArray<T, S> a, const FixedNDArray<T, S>& b) {
+    a -= b;
+    return a;
+}
+
+template<typename T, typename S>
+constexpr FixedNDArray<T, S> operator*(FixedNDArray<T, S> a, const FixedNDArray<T, S>& b) {
+    a *= b;
+    return a;
+}
+
+template<typename T, typename S>
+constexpr FixedNDArray<T, S> operator/(FixedNDArray<T, S> a, const FixedNDArray<T, S>& b) {
+    a /= b;
+    return a;
+}
+
+template<typename T, typename S>
+constexpr FixedNDArray<T, S> operator+(FixedNDArray<T, S> a, const std::type_identity_t<T>& value) {
+    a += value;
+    return a;
+}
+
+template<typename T, typename S>
+constexpr FixedNDArray<T, S> operator-(FixedNDArray<T, S> a, const std::type_identity_t<T>& value) {
+    a -= value;
+    return a;
+}
+
+template<typename T, typename S>
+constexpr FixedNDArray<T, S> operator*(FixedNDArray<T, S> a, const std::type_identity_t<T>& value) {
+    a *= value;
+    return a;
+}
+
+template<typename T, typename S>
+constexpr FixedNDArray<T, S> operator/(FixedNDArray<T, S> a, const std::type_identity_t<T>& value) {
+    a /= value;
+    return a;
+}
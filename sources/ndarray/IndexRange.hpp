@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+
+#include "ndarray/StridedLoop.hpp"
+
+// Every multi-index of a shape, in row-major order:
+//
+//     for (auto index : a.indices()) { a(index) ... }
+//
+// The shape and the current index are stored inline (rank is bounded by
+// max_ndarray_rank), and dereferencing yields a span over the iterator's own
+// index, so iterating allocates nothing. The span is invalidated by ++.
+class IndexRange {
+
+public:
+
+    class iterator {
+
+    private:
+
+        const IndexRange* m_range;
+        std::array<std::size_t, max_ndarray_rank> m_index;
+        std::size_t m_position;
+
+    public:
+
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::span<const std::size_t>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = std::span<const std::size_t>;
+
+        iterator() : m_range(nullptr), m_index(), m_position(0) {};
+
+        iterator(const IndexRange* range, std::size_t position) : m_range(range), m_index(), m_position(position) {};
+
+        std::span<const std::size_t> operator*() const {
+            return std::span<const std::size_t>(m_index.data(), m_range->m_dim);
+        }
+
+        iterator& operator++() {
+            for (std::size_t i = m_range->m_dim; i-- > 0;) {
+                if (++m_index[i] < m_range->m_shape[i]) {
+                    break;
+                }
+                m_index[i] = 0;
+            }
+            m_position++;
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator result(*this);
+            ++*this;
+            return result;
+        }
+
+        bool operator==(const iterator& other) const {
+            return m_position == other.m_position;
+        }
+
+    };
+
+private:
+
+    std::array<std::size_t, max_ndarray_rank> m_shape;
+    std::size_t m_dim;
+    std::size_t m_size;
+
+public:
+
+    explicit IndexRange(std::span<const std::size_t> shape) : m_shape(), m_dim(shape.size()), m_size(1) {
+        if (shape.size() > max_ndarray_rank) {
+            throw std::invalid_argument("NDArray rank exceeds the supported maximum.");
+        }
+        for (std::size_t i = 0; i < m_dim; i++) {
+            m_shape[i] = shape[i];
+            m_size *= shape[i];
+        }
+    };
+
+    iterator begin() const {
+        return iterator(this, 0);
+    }
+
+    iterator end() const {
+        return iterator(this, m_size);
+    }
+
+    std::size_t size() const {
+        return m_size;
+    }
+
+};
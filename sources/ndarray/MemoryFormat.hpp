@@ -0,0 +1,167 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include "ndarray/Permute.hpp"
+#include "ndarray/StridedLoop.hpp"
+
+// Order in which the elements of an NDArray are stored. The shape and the
+// indices of an array do not depend on it: a channels-last array of shape
+// N x C x H x W is still indexed a(n, c, h, w), only its buffer is laid out
+// N x H x W x C. Kernels that prefer a format take arrays in it without a
+// copy and return results in it, so that a graph reorders its input once
+// rather than around every operation.
+enum class MemoryFormat {
+    // C order, the default: the last axis is contiguous.
+    RowMajor,
+    // Fortran order: the first axis is contiguous.
+    ColumnMajor,
+    // N x C x H x W arrays stored N x H x W x C (NHWC).
+    ChannelsLast,
+    // N x C x H x W arrays stored N x ceil(C / channel_block) x H x W x
+    // channel_block (NCHW16c). Channels past C in the last block are zero.
+    // No strides describe this format: such arrays have no view() and are
+    // only read by the kernels that support them, or reordered.
+    ChannelsBlocked
+};
+
+// Channels per block of ChannelsBlocked: one AVX-512 register of float, so
+// that a kernel processes a block of channels of a pixel as one vector.
+constexpr std::size_t channel_block = 16;
+
+inline const char* memory_format_name(MemoryFormat format) {
+    switch (format) {
+        case MemoryFormat::RowMajor: return "row-major";
+        case MemoryFormat::ColumnMajor: return "column-major";
+        case MemoryFormat::ChannelsLast: return "channels-last";
+        case MemoryFormat::ChannelsBlocked: return "channels-blocked";
+    }
+    return "unknown";
+}
+
+// Whether arrays of this format have strides, hence views.
+constexpr bool is_strided_format(MemoryFormat format) {
+    return format != MemoryFormat::ChannelsBlocked;
+}
+
+inline void check_memory_format(const std::vector<std::size_t>& shape, MemoryFormat format) {
+    if ((format == MemoryFormat::ChannelsLast || format == MemoryFormat::ChannelsBlocked) && shape.size() != 4) {
+        throw std::invalid_argument("Channel memory formats need 4D N x C x H x W arrays.");
+    }
+}
+
+// Shape of the buffer of an array of the given shape, in storage order.
+inline std::vector<std::size_t> storage_shape(const std::vector<std::size_t>& shape, MemoryFormat format) {
+    check_memory_format(shape, format);
+    switch (format) {
+        case MemoryFormat::ColumnMajor:
+            return std::vector<std::size_t>(shape.rbegin(), shape.rend());
+        case MemoryFormat::ChannelsLast:
+            return {shape[0], shape[2], shape[3], shape[1]};
+        case MemoryFormat::ChannelsBlocked:
+            return {shape[0], (shape[1] + channel_block - 1) / channel_block, shape[2], shape[3], channel_block};
+        default:
+            return shape;
+    }
+}
+
+// Strides of the axes of shape into a buffer of a strided format.
+inline std::vector<std::ptrdiff_t> format_strides(const std::vector<std::size_t>& shape, MemoryFormat format) {
+    if (!is_strided_format(format)) {
+        throw std::invalid_argument("Blocked memory formats have no strides.");
+    }
+    const std::vector<std::ptrdiff_t> storage = contiguous_strides(storage_shape(shape, format));
+    switch (format) {
+        case MemoryFormat::ColumnMajor:
+            return std::vector<std::ptrdiff_t>(storage.rbegin(), storage.rend());
+        case MemoryFormat::ChannelsLast:
+            return {storage[0], storage[3], storage[1], storage[2]};
+        default:
+            return storage;
+    }
+}
+
+// out = src for operands of the same shape, with the axes first sorted by
+// decreasing stride of out so that strided_copy() sees the destination in
+// storage order and turns the reorder into blocked transposes.
+template<typename T>
+void reorder_copy(
+    const std::vector<std::size_t>& shape,
+    T* out, const std::vector<std::ptrdiff_t>& out_strides,
+    const T* src, const std::vector<std::ptrdiff_t>& src_strides
+) {
+    std::vector<std::size_t> axes(shape.size());
+    std::iota(axes.begin(), axes.end(), std::size_t(0));
+    std::stable_sort(axes.begin(), axes.end(), [&](std::size_t a, std::size_t b) {
+        return out_strides[a] > out_strides[b];
+    });
+    std::vector<std::size_t> sorted_shape;
+    std::vector<std::ptrdiff_t> sorted_out, sorted_src;
+    for (std::size_t axis : axes) {
+        sorted_shape.push_back(shape[axis]);
+        sorted_out.push_back(out_strides[axis]);
+        sorted_src.push_back(src_strides[axis]);
+    }
+    strided_copy(sorted_shape, out, sorted_out, src, sorted_src);
+}
+
+// Copies the elements of an array of the given shape from a buffer in
+// src_format into a buffer in dst_format. Blocked buffers are described
+// block by block as N x blocks x H x W x lanes strided arrays, one for the
+// full blocks and one for the last partial block, whose padding channels in
+// dst are zeroed.
+template<typename T>
+void reorder(const std::vector<std::size_t>& shape, const T* src, MemoryFormat src_format, T* dst, MemoryFormat dst_format) {
+    const std::vector<std::size_t> src_storage = storage_shape(shape, src_format);
+    const std::vector<std::size_t> dst_storage = storage_shape(shape, dst_format);
+    if (src_format == dst_format) {
+        const std::size_t size = shape_size(src_storage);
+        strided_copy(std::vector<std::size_t>{size}, dst, std::vector<std::ptrdiff_t>{1}, src, std::vector<std::ptrdiff_t>{1});
+        return;
+    }
+    if (is_strided_format(src_format) && is_strided_format(dst_format)) {
+        reorder_copy(shape, dst, format_strides(shape, dst_format), src, format_strides(shape, src_format));
+        return;
+    }
+    const bool to_blocked = dst_format == MemoryFormat::ChannelsBlocked;
+    const std::vector<std::ptrdiff_t> strided = format_strides(shape, to_blocked ? src_format : dst_format);
+    const std::size_t n = shape[0], c = shape[1], h = shape[2], w = shape[3];
+    const std::size_t blocks = (c + channel_block - 1) / channel_block;
+    const std::size_t full = c / channel_block;
+    const std::size_t tail = c % channel_block;
+    const std::ptrdiff_t block_size = static_cast<std::ptrdiff_t>(h * w * channel_block);
+    const std::vector<std::ptrdiff_t> blocked_strides{
+        static_cast<std::ptrdiff_t>(blocks) * block_size, block_size,
+        static_cast<std::ptrdiff_t>(w * channel_block), static_cast<std::ptrdiff_t>(channel_block), 1
+    };
+    const std::vector<std::ptrdiff_t> split_strides{
+        strided[0], static_cast<std::ptrdiff_t>(channel_block) * strided[1], strided[2], strided[3], strided[1]
+    };
+    const auto copy = [&](std::size_t first, std::size_t count, std::size_t lanes) {
+        const std::vector<std::size_t> split{n, count, h, w, lanes};
+        const std::ptrdiff_t blocked_offset = static_cast<std::ptrdiff_t>(first) * block_size;
+        const std::ptrdiff_t strided_offset = static_cast<std::ptrdiff_t>(first * channel_block) * strided[1];
+        if (to_blocked) {
+            reorder_copy(split, dst + blocked_offset, blocked_strides, src + strided_offset, split_strides);
+        } else {
+            reorder_copy(split, dst + strided_offset, split_strides, src + blocked_offset, blocked_strides);
+        }
+    };
+    if (full > 0) {
+        copy(0, full, channel_block);
+    }
+    if (tail > 0) {
+        if (to_blocked) {
+            for (std::size_t i = 0; i < n; i++) {
+                T* last = dst + static_cast<std::ptrdiff_t>(i * blocks + full) * block_size;
+                std::fill(last, last + block_size, T(0));
+            }
+        }
+        copy(full, 1, tail);
+    }
+}
@@ -4,27 +4,145 @@
 #include <vector>
 #include <numeric>
 #include <algorithm>
+#include <array>
+#include <cmath>
 #include <functional>
 #include <ranges>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "memory/AlignedAllocator.hpp"
+#include "ndarray/IndexRange.hpp"
+#include "ndarray/MemoryFormat.hpp"
+#include "ndarray/NDArrayView.hpp"
+#include "parallel/ThreadPool.hpp"
+#include "profile/Profiler.hpp"
+#include "simd/Simd.hpp"
 
 template<typename T>
-class NDArray {
+std::ostream& operator<<(std::ostream& os, const NDArray<T>& a);
+
+// Array whose rank is only known at runtime; NDArray<T, Rank> below fixes it
+// at compile time. Its buffer is stored in one of the memory formats of
+// MemoryFormat.hpp, row-major unless another one is asked for.
+template<typename T>
+class NDArray<T, dynamic_rank> {
 
 private:
 
     // Members 
 
-    std::vector<T> m_data;
+    std::vector<T, AlignedAllocator<T>> m_data;
     std::vector<std::size_t> m_shape;
+    // Empty for blocked formats.
+    std::vector<std::ptrdiff_t> m_strides;
+    MemoryFormat m_format = MemoryFormat::RowMajor;
 
     // Private methods
 
+    void check_strided() const {
+        if (!is_strided_format(m_format)) {
+            throw std::invalid_argument("Blocked NDArrays have no strides: reorder them first.");
+        }
+    }
+
+    // Zeroes the channels past the last one in the last block of a blocked
+    // array, after an operation that may have written them.
+    void clear_padding() {
+        if (m_format != MemoryFormat::ChannelsBlocked || m_shape[1] % channel_block == 0) {
+            return;
+        }
+        const std::size_t blocks = (m_shape[1] + channel_block - 1) / channel_block;
+        const std::size_t pixels = m_shape[2] * m_shape[3];
+        for (std::size_t n = 0; n < m_shape[0]; n++) {
+            T* last = m_data.data() + ((n * blocks + blocks - 1) * pixels) * channel_block;
+            for (std::size_t i = 0; i < pixels; i++) {
+                std::fill(last + i * channel_block + m_shape[1] % channel_block, last + (i + 1) * channel_block, T(0));
+            }
+        }
+    }
+
+    std::size_t checked_offset(std::span<const std::size_t> indices) const {
+        check_strided();
+        if (indices.size() != m_shape.size()) {
+            throw std::invalid_argument("Number of indices does not match dimension of NDArray.");
+        }
+        std::size_t offset = 0;
+        for (std::size_t i = 0; i < indices.size(); i++) {
+            if (indices[i] >= m_shape[i]) {
+                throw std::invalid_argument("Index out of range.");
+            }
+            offset += indices[i] * static_cast<std::size_t>(m_strides[i]);
+        }
+        return offset;
+    }
+
+    template<typename... Indices>
+    void check_indices(Indices... indices) const {
+        check_strided();
+        if (sizeof...(Indices) != m_shape.size()) {
+            throw std::invalid_argument("Number of indices does not match dimension of NDArray.");
+        }
+        std::size_t axis = 0;
+        if (!((static_cast<std::size_t>(indices) < m_shape[axis++]) && ...)) {
+            throw std::invalid_argument("Index out of range.");
+        }
+    }
+
+    template<typename... Indices>
+    std::size_t offset_of(Indices... indices) const {
+        std::size_t offset = 0;
+        std::size_t axis = 0;
+        ((offset += static_cast<std::size_t>(indices) * static_cast<std::size_t>(m_strides[axis++])), ...);
+        return offset;
+    }
+
     void delete_unessecary_dimensions(std::vector<std::size_t>& shape) {
         shape | std::views::filter([](std::size_t s){return s > 1;});
         return;
     }
 
-    bool is_sub_shape(cons std::vector<std::size_t>& shape) const {
+    // The elements in row-major order: the buffer itself, or a reordered
+    // copy kept in scratch.
+    const T* row_major_data(NDArray<T>& scratch) const {
+        if (m_format == MemoryFormat::RowMajor) {
+            return m_data.data();
+        }
+        scratch = to_format(MemoryFormat::RowMajor);
+        return scratch.data();
+    }
+
+    std::vector<std::size_t> reduced_shape(std::size_t axis, bool keepdims) const {
+        if (axis >= m_shape.size()) {
+            throw std::invalid_argument("Axis out of range.");
+        }
+        std::vector<std::size_t> shape = m_shape;
+        if (keepdims) {
+            shape[axis] = 1;
+        } else {
+            shape.erase(shape.begin() + static_cast<std::ptrdiff_t>(axis));
+        }
+        return shape;
+    }
+
+    NDArray<T> reduce_axis(Reduction op, std::size_t axis, bool keepdims) const {
+        NDArray<T> result(reduced_shape(axis, keepdims));
+        const std::size_t n = m_shape[axis];
+        if (n == 0 && op != Reduction::Sum && op != Reduction::Norm) {
+            throw std::invalid_argument("Cannot reduce an empty axis.");
+        }
+        const auto split = m_shape.begin() + static_cast<std::ptrdiff_t>(axis);
+        const std::size_t outer = std::accumulate(m_shape.begin(), split, std::size_t(1), std::multiplies<std::size_t>());
+        const std::size_t inner = std::accumulate(split + 1, m_shape.end(), std::size_t(1), std::multiplies<std::size_t>());
+        NN_PROFILE_SCOPE(Reduction, "NDArray axis reduction", static_cast<double>((size() + result.size()) * sizeof(T)), static_cast<double>(size()));
+        NDArray<T> scratch;
+        reduceAxis(op, outer, n, inner, row_major_data(scratch), n * inner, inner, result.data());
+        return result;
+    }
+
+    bool is_sub_shape(const std::vector<std::size_t>& shape) const {
         if (shape.size() > m_shape.size()) {
             return false;
         }
@@ -47,7 +165,7 @@ public:
 
     // Constructors
 
-    NDArray() : m_data(), m_shape() {};
+    NDArray() : m_data(), m_shape(), m_strides() {};
 
     NDArray(std::vector<std::size_t> shape, const T& value = T()) {
         std::size_t size = std::accumulate(shape.begin(), shape.end(), 1, std::multiplies<std::size_t>());
@@ -55,99 +173,235 @@ public:
         reshape(shape);
     };
 
-    NDArray(const std::vector<T>& data) : m_data(data), m_shape(1, data.size()) {};
+    // Array in the given memory format, with the padding of blocked formats
+    // set to zero rather than value.
+    NDArray(const std::vector<std::size_t>& shape, MemoryFormat format, const T& value = T()) :
+        m_data(shape_size(::storage_shape(shape, format)), value),
+        m_shape(shape),
+        m_strides(is_strided_format(format) ? format_strides(shape, format) : std::vector<std::ptrdiff_t>()),
+        m_format(format)
+    {
+        clear_padding();
+    };
+
+    NDArray(const std::vector<T>& data) : m_data(data.begin(), data.end()), m_shape(1, data.size()), m_strides(1, 1) {};
 
+    // Copies the elements of a (possibly strided) view into a new contiguous
+    // array of the same shape.
+    template<typename U, typename = std::enable_if_t<std::is_same_v<std::remove_const_t<U>, T>>>
+    explicit NDArray(const NDArrayView<U>& view) : m_data(view.size()), m_shape(view.shape()), m_strides(contiguous_strides(m_shape)) {
+        this->view().assign(view);
+    };
 
 
     // Operators
 
+    // a(i, j, k): the offset is computed from the precomputed strides without
+    // allocating. Rank and bounds are only checked in debug builds; at() always
+    // checks them.
+    template<typename... Indices>
+        requires (sizeof...(Indices) > 0 && (std::is_integral_v<Indices> && ...))
+    T& operator()(Indices... indices) {
+#ifndef NDEBUG
+        check_indices(indices...);
+#endif
+        return m_data[offset_of(indices...)];
+    }
+
+    template<typename... Indices>
+        requires (sizeof...(Indices) > 0 && (std::is_integral_v<Indices> && ...))
+    const T& operator()(Indices... indices) const {
+#ifndef NDEBUG
+        check_indices(indices...);
+#endif
+        return m_data[offset_of(indices...)];
+    }
+
+    T& operator()(std::span<const std::size_t> indices) {
+        return m_data[checked_offset(indices)];
+    };
+
+    const T& operator()(std::span<const std::size_t> indices) const {
+        return m_data[checked_offset(indices)];
+    };
+
     T& operator()(const std::vector<std::size_t>& indices) {
-        if (indices.size() != m_shape.size()) {
-            throw std::invalid_argument("Number of indices does not match dimension of NDArray.");
-        }
-        std::size_t index = 0;
-        for (std::size_t i = 0; i < indices.size(); i++) {
-            if (indices[i] >= m_shape[i]) {
-                throw std::invalid_argument("Index out of range.");
-            }
-            index *= m_shape[i];
-            index += indices[i];
-        }
-        return m_data[index];
+        return m_data[checked_offset(indices)];
     };
 
     const T& operator()(const std::vector<std::size_t>& indices) const {
-        if (indices.size() != m_shape.size()) {
-            throw std::invalid_argument("Number of indices does not match dimension of NDArray.");
-        }
-        std::size_t index = 0;
-        for (std::size_t i = 0; i < indices.size(); i++) {
-            if (indices[i] >= m_shape[i]) {
-                throw std::invalid_argument("Index out of range.");
-            }
-            index *= m_shape[i];
-            index += indices[i];
-        }
-        return m_data[index];
+        return m_data[checked_offset(indices)];
     };
 
     NDArray<T>& operator+=(const T& value) {
-        std::for_each(m_data.begin(), m_data.end(), [&value](T& t) {t += value;});
+        elementwise_scalar<ElementwiseAdd>(m_data.data(), m_data.size(), value);
+        clear_padding();
         return *this;
     }
 
     NDArray<T>& operator-=(const T& value) {
-        std::for_each(m_data.begin(), m_data.end(), [&value](T& t) {t -= value;});
+        elementwise_scalar<ElementwiseSub>(m_data.data(), m_data.size(), value);
+        clear_padding();
         return *this;
     }
 
     NDArray<T>& operator*=(const T& value) {
-        std::for_each(m_data.begin(), m_data.end(), [&value](T& t) {t *= value;});
+        elementwise_scalar<ElementwiseMul>(m_data.data(), m_data.size(), value);
+        clear_padding();
         return *this;
     }
 
     NDArray<T>& operator/=(const T& value) {
-        std::for_each(m_data.begin(), m_data.end(), [&value](T& t) {t /= value;});
+        elementwise_scalar<ElementwiseDiv>(m_data.data(), m_data.size(), value);
+        clear_padding();
         return *this;
     }
 
+    // other is broadcast to the shape of this array; see broadcast_shapes().
     NDArray<T>& operator+=(const NDArray<T>& other) {
-        if (m_shape != other.m_shape) {
-            throw std::invalid_argument("Cannot add NDArrays with different shapes.");
-        }
-        std::transform(m_data.begin(), m_data.end(), other.m_data.begin(), m_data.begin(), std::plus<T>());
+        view() += other.view();
         return *this;
     }
 
     NDArray<T>& operator-=(const NDArray<T>& other) {
-        if (m_shape != other.m_shape) {
-            throw std::invalid_argument("Cannot subtract NDArrays with different shapes.");
-        }
-        std::transform(m_data.begin(), m_data.end(), other.m_data.begin(), m_data.begin(), std::minus<T>());
+        view() -= other.view();
         return *this;
     }
 
     NDArray<T>& operator*=(const NDArray<T>& other) {
-        if (m_shape != other.m_shape) {
-            throw std::invalid_argument("Cannot multiply NDArrays with different shapes.");
-        }
-        std::transform(m_data.begin(), m_data.end(), other.m_data.begin(), m_data.begin(), std::multiplies<T>());
+        view() *= other.view();
         return *this;
     }
 
     NDArray<T>& operator/=(const NDArray<T>& other) {
-        if (m_shape != other.m_shape) {
-            throw std::invalid_argument("Cannot divide NDArrays with different shapes.");
-        }
-        std::transform(m_data.begin(), m_data.end(), other.m_data.begin(), m_data.begin(), std::divides<T>());
+        view() /= other.view();
         return *this;
     }
 
+    NDArray<T>& operator+=(const NDArrayView<const T>& other) {
+        view() += other;
+        return *this;
+    }
+
+    NDArray<T>& operator-=(const NDArrayView<const T>& other) {
+        view() -= other;
+        return *this;
+    }
+
+    NDArray<T>& operator*=(const NDArrayView<const T>& other) {
+        view() *= other;
+        return *this;
+    }
 
+    NDArray<T>& operator/=(const NDArrayView<const T>& other) {
+        view() /= other;
+        return *this;
+    }
 
     // Methods
 
+    // Throws for blocked formats.
+    NDArrayView<T> view() {
+        check_strided();
+        return NDArrayView<T>(m_data.data(), m_shape, m_strides);
+    }
+
+    NDArrayView<const T> view() const {
+        check_strided();
+        return NDArrayView<const T>(m_data.data(), m_shape, m_strides);
+    }
+
+    NDArrayView<T> slice(std::size_t axis, std::size_t start, std::size_t stop, std::size_t step = 1) {
+        return view().slice(axis, start, stop, step);
+    }
+
+    NDArrayView<const T> slice(std::size_t axis, std::size_t start, std::size_t stop, std::size_t step = 1) const {
+        return view().slice(axis, start, stop, step);
+    }
+
+    NDArrayView<T> select(std::size_t axis, std::size_t index) {
+        return view().select(axis, index);
+    }
+
+    NDArrayView<const T> select(std::size_t axis, std::size_t index) const {
+        return view().select(axis, index);
+    }
+
+    NDArrayView<T> transpose() {
+        return view().transpose();
+    }
+
+    NDArrayView<const T> transpose() const {
+        return view().transpose();
+    }
+
+    NDArrayView<T> transpose(const std::vector<std::size_t>& axes) {
+        return view().transpose(axes);
+    }
+
+    NDArrayView<const T> transpose(const std::vector<std::size_t>& axes) const {
+        return view().transpose(axes);
+    }
+
+    NDArrayView<T> squeeze() {
+        return view().squeeze();
+    }
+
+    NDArrayView<const T> squeeze() const {
+        return view().squeeze();
+    }
+
+    NDArrayView<T> expand_dims(std::size_t axis) {
+        return view().expand_dims(axis);
+    }
+
+    NDArrayView<const T> expand_dims(std::size_t axis) const {
+        return view().expand_dims(axis);
+    }
+
+    // Same elements seen with another shape, without copying. reshape()
+    // changes the shape of the array itself.
+    NDArrayView<T> reshape_view(const std::vector<std::size_t>& shape) {
+        return view().reshape(shape);
+    }
+
+    NDArrayView<const T> reshape_view(const std::vector<std::size_t>& shape) const {
+        return view().reshape(shape);
+    }
+
+    // Always bounds-checked counterparts of operator().
+    template<typename... Indices>
+        requires (sizeof...(Indices) > 0 && (std::is_integral_v<Indices> && ...))
+    T& at(Indices... indices) {
+        check_indices(indices...);
+        return m_data[offset_of(indices...)];
+    }
+
+    template<typename... Indices>
+        requires (sizeof...(Indices) > 0 && (std::is_integral_v<Indices> && ...))
+    const T& at(Indices... indices) const {
+        check_indices(indices...);
+        return m_data[offset_of(indices...)];
+    }
+
+    IndexRange indices() const {
+        return IndexRange(m_shape);
+    }
+
+    T* data() {
+        return m_data.data();
+    }
+
+    const T* data() const {
+        return m_data.data();
+    }
+
+    // Only for row-major arrays; reorder the others first.
     void reshape(std::vector<std::size_t> shape) {
+        NN_PROFILE_SCOPE(Reshape, "NDArray reshape", 0, 0);
+        if (m_format != MemoryFormat::RowMajor) {
+            throw std::invalid_argument("Only row-major NDArrays can be reshaped.");
+        }
         delete_unessecary_dimensions(shape);
         std::size_t size = std::accumulate(shape.begin(), shape.end(), 1, std::multiplies<std::size_t>());
         if (size != m_data.size()) {
@@ -157,12 +411,15 @@ public:
         for (std::size_t s : shape) {
             m_shape.push_back(s);
         }
+        m_strides = contiguous_strides(m_shape);
         return;
     };
 
     void clear() {
         m_data.clear();
         m_shape.clear();
+        m_strides.clear();
+        m_format = MemoryFormat::RowMajor;
         return;
     }
 
@@ -170,14 +427,177 @@ public:
         return m_shape.size();
     };
 
+    // Number of elements, without the padding of blocked formats.
     std::size_t size() const {
-        return m_data.size();
+        return (m_format == MemoryFormat::ChannelsBlocked) ? shape_size(m_shape) : m_data.size();
     };
 
     std::vector<std::size_t> shape() const {
         return m_shape;
     };
 
+    // Empty for blocked formats.
+    const std::vector<std::ptrdiff_t>& strides() const {
+        return m_strides;
+    };
+
+    MemoryFormat format() const {
+        return m_format;
+    }
+
+    // Shape of the buffer in storage order, e.g. N x H x W x C for a
+    // channels-last array; data() points to a row-major array of this shape.
+    std::vector<std::size_t> storage_shape() const {
+        return ::storage_shape(m_shape, m_format);
+    }
+
+    // Copy in another memory format.
+    NDArray<T> to_format(MemoryFormat format) const {
+        NN_PROFILE_SCOPE(Transpose, "NDArray reorder", static_cast<double>(2 * m_data.size() * sizeof(T)), 0);
+        NDArray<T> result(m_shape, format);
+        ::reorder(m_shape, m_data.data(), m_format, result.data(), format);
+        return result;
+    }
+
+    T sum() const {
+        return contiguous_sum(m_data.data(), m_data.size());
+    }
+
+    T max() const {
+        if (m_data.empty()) {
+            throw std::invalid_argument("Cannot take the maximum of an empty NDArray.");
+        }
+        if (m_format == MemoryFormat::ChannelsBlocked && m_shape[1] % channel_block != 0) {
+            // The zero padding must not win: it is skipped in the last block.
+            const std::size_t blocks = (m_shape[1] + channel_block - 1) / channel_block;
+            const std::size_t pixels = m_shape[2] * m_shape[3];
+            const std::size_t lanes = m_shape[1] % channel_block;
+            T result = m_data[(blocks - 1) * pixels * channel_block];
+            for (std::size_t n = 0; n < m_shape[0]; n++) {
+                const T* first = m_data.data() + n * blocks * pixels * channel_block;
+                if (blocks > 1) {
+                    result = std::max(result, contiguous_max(first, (blocks - 1) * pixels * channel_block));
+                }
+                for (std::size_t i = 0; i < pixels; i++) {
+                    result = std::max(result, contiguous_max(first + ((blocks - 1) * pixels + i) * channel_block, lanes));
+                }
+            }
+            return result;
+        }
+        return contiguous_max(m_data.data(), m_data.size());
+    }
+
+    T min() const {
+        if (m_data.empty()) {
+            throw std::invalid_argument("Cannot take the minimum of an empty NDArray.");
+        }
+        NN_PROFILE_SCOPE(Reduction, "NDArray min", static_cast<double>(size() * sizeof(T)), static_cast<double>(size()));
+        NDArray<T> scratch;
+        return reduce(Reduction::Min, row_major_data(scratch), size());
+    }
+
+    T mean() const {
+        if (m_data.empty()) {
+            throw std::invalid_argument("Cannot take the mean of an empty NDArray.");
+        }
+        return static_cast<T>(static_cast<Accumulator<T>>(sum()) / static_cast<Accumulator<T>>(size()));
+    }
+
+    // Euclidean norm of all the elements.
+    T norm() const {
+        NN_PROFILE_SCOPE(Reduction, "NDArray norm", static_cast<double>(m_data.size() * sizeof(T)), 2.0 * static_cast<double>(m_data.size()));
+        return static_cast<T>(std::sqrt(static_cast<Accumulator<T>>(reduceDot(m_data.data(), m_data.data(), m_data.size()))));
+    }
+
+    // Population variance, as NumPy's var().
+    T var() const {
+        if (m_data.empty()) {
+            throw std::invalid_argument("Cannot take the variance of an empty NDArray.");
+        }
+        NN_PROFILE_SCOPE(Reduction, "NDArray variance", static_cast<double>(2 * size() * sizeof(T)), 3.0 * static_cast<double>(size()));
+        NDArray<T> scratch;
+        return reduce(Reduction::Variance, row_major_data(scratch), size());
+    }
+
+    // Row-major index of the first maximum.
+    std::size_t argmax() const {
+        if (m_data.empty()) {
+            throw std::invalid_argument("Cannot take the argmax of an empty NDArray.");
+        }
+        NN_PROFILE_SCOPE(Reduction, "NDArray argmax", static_cast<double>(size() * sizeof(T)), static_cast<double>(size()));
+        NDArray<T> scratch;
+        return reduceArgmax(row_major_data(scratch), size());
+    }
+
+    // Reductions along one axis, which is removed from the shape, or kept
+    // with size 1 with keepdims.
+    NDArray<T> sum(std::size_t axis, bool keepdims = false) const {
+        return reduce_axis(Reduction::Sum, axis, keepdims);
+    }
+
+    NDArray<T> mean(std::size_t axis, bool keepdims = false) const {
+        return reduce_axis(Reduction::Mean, axis, keepdims);
+    }
+
+    NDArray<T> max(std::size_t axis, bool keepdims = false) const {
+        return reduce_axis(Reduction::Max, axis, keepdims);
+    }
+
+    NDArray<T> min(std::size_t axis, bool keepdims = false) const {
+        return reduce_axis(Reduction::Min, axis, keepdims);
+    }
+
+    NDArray<T> norm(std::size_t axis, bool keepdims = false) const {
+        return reduce_axis(Reduction::Norm, axis, keepdims);
+    }
+
+    NDArray<T> var(std::size_t axis, bool keepdims = false) const {
+        return reduce_axis(Reduction::Variance, axis, keepdims);
+    }
+
+    NDArray<std::size_t> argmax(std::size_t axis, bool keepdims = false) const {
+        NDArray<std::size_t> result(reduced_shape(axis, keepdims), MemoryFormat::RowMajor);
+        const std::size_t n = m_shape[axis];
+        if (n == 0) {
+            throw std::invalid_argument("Cannot reduce an empty axis.");
+        }
+        const auto split = m_shape.begin() + static_cast<std::ptrdiff_t>(axis);
+        const std::size_t outer = std::accumulate(m_shape.begin(), split, std::size_t(1), std::multiplies<std::size_t>());
+        const std::size_t inner = std::accumulate(split + 1, m_shape.end(), std::size_t(1), std::multiplies<std::size_t>());
+        NN_PROFILE_SCOPE(Reduction, "NDArray axis argmax", static_cast<double>(size() * sizeof(T)), static_cast<double>(size()));
+        NDArray<T> scratch;
+        argmaxAxis(outer, n, inner, row_major_data(scratch), n * inner, inner, result.data());
+        return result;
+    }
+
+    // Copy with every element converted to U. Conversions between float and
+    // BFloat16 or Float16 go through the SIMD conversion kernels; the others
+    // through float when either side is a 16-bit type.
+    template<typename U>
+    NDArray<U> astype() const {
+        NN_PROFILE_SCOPE(Conversion, "NDArray astype", static_cast<double>(m_data.size() * (sizeof(T) + sizeof(U))), 0);
+        NDArray<U> result(m_shape, m_format);
+        const T* src = m_data.data();
+        U* dst = result.data();
+        parallelFor(0, m_data.size(), parallelGrain, [&](std::size_t first, std::size_t last) {
+            const std::size_t n = last - first;
+            if constexpr (std::is_same_v<T, float> && std::is_same_v<U, BFloat16>) {
+                simd::halfKernels().toBFloat16(src + first, dst + first, n);
+            } else if constexpr (std::is_same_v<T, BFloat16> && std::is_same_v<U, float>) {
+                simd::halfKernels().fromBFloat16(src + first, dst + first, n);
+            } else if constexpr (std::is_same_v<T, float> && std::is_same_v<U, Float16>) {
+                simd::halfKernels().toFloat16(src + first, dst + first, n);
+            } else if constexpr (std::is_same_v<T, Float16> && std::is_same_v<U, float>) {
+                simd::halfKernels().fromFloat16(src + first, dst + first, n);
+            } else {
+                for (std::size_t i = first; i < last; i++) {
+                    dst[i] = static_cast<U>(static_cast<Accumulator<T>>(src[i]));
+                }
+            }
+        });
+        return result;
+    }
+
     // Friend functions
 
     friend std::ostream& operator<< <T>(std::ostream& os, const NDArray<T>& a);
@@ -198,4 +618,556 @@ std::ostream& operator<<(std::ostream& os, const NDArray<T>& a) {
         os << a.m_data[i] << " ";
     }
     return os;
-}
\ No newline at end of file
+}
+// dst = src for arrays of the same shape, whatever their memory formats.
+template<typename T>
+void reorder(const NDArray<T>& src, NDArray<T>& dst) {
+    if (src.shape() != dst.shape()) {
+        throw std::invalid_argument("Cannot reorder between NDArrays of different shapes.");
+    }
+    NN_PROFILE_SCOPE(Transpose, "NDArray reorder", static_cast<double>((src.size() + dst.size()) * sizeof(T)), 0);
+    reorder(src.shape(), src.data(), src.format(), dst.data(), dst.format());
+}
+
+// Out-of-place elementwise operations. The result has the broadcast shape of
+// both operands (see broadcast_shapes()), which are read in place through
+// stride-0 axes rather than expanded first.
+template<typename Op, typename T>
+void broadcast_apply(const NDArrayView<const T>& a, const NDArrayView<const T>& b, const NDArrayView<T>& out) {
+    if (out.shape() != broadcast_shapes(a.shape(), b.shape())) {
+        throw std::invalid_argument("Output shape does not match the broadcast shape of the operands.");
+    }
+    const NDArrayView<const T> x = a.broadcast_to(out.shape());
+    const NDArrayView<const T> y = b.broadcast_to(out.shape());
+    elementwise_apply<Op, T>(out.shape(), out.data(), out.strides(), x.data(), x.strides(), y.data(), y.strides());
+}
+
+template<typename Op, typename T>
+NDArray<T> broadcast_apply(const NDArrayView<const T>& a, const NDArrayView<const T>& b) {
+    NDArray<T> result(broadcast_shapes(a.shape(), b.shape()));
+    broadcast_apply<Op, T>(a, b, result.view());
+    return result;
+}
+
+template<typename Op, typename T>
+NDArray<T> broadcast_apply(const NDArrayView<const T>& a, const T& value) {
+    return broadcast_apply<Op, T>(a, NDArrayView<const T>(&value, {}, {}));
+}
+
+template<typename Op, typename T>
+NDArray<T> broadcast_apply(const T& value, const NDArrayView<const T>& b) {
+    return broadcast_apply<Op, T>(NDArrayView<const T>(&value, {}, {}), b);
+}
+
+template<typename T>
+NDArray<T> operator+(const NDArray<T>& a, const NDArray<T>& b) {
+    return broadcast_apply<ElementwiseAdd, T>(a.view(), b.view());
+}
+
+template<typename T>
+NDArray<T> operator+(const NDArray<T>& a, const std::type_identity_t<T>& value) {
+    return broadcast_apply<ElementwiseAdd, T>(a.view(), value);
+}
+
+template<typename T>
+NDArray<T> operator+(const std::type_identity_t<T>& value, const NDArray<T>& b) {
+    return broadcast_apply<ElementwiseAdd, T>(value, b.view());
+}
+
+template<typename T>
+NDArray<T> operator-(const NDArray<T>& a, const NDArray<T>& b) {
+    return broadcast_apply<ElementwiseSub, T>(a.view(), b.view());
+}
+
+template<typename T>
+NDArray<T> operator-(const NDArray<T>& a, const std::type_identity_t<T>& value) {
+    return broadcast_apply<ElementwiseSub, T>(a.view(), value);
+}
+
+template<typename T>
+NDArray<T> operator-(const std::type_identity_t<T>& value, const NDArray<T>& b) {
+    return broadcast_apply<ElementwiseSub, T>(value, b.view());
+}
+
+template<typename T>
+NDArray<T> operator*(const NDArray<T>& a, const NDArray<T>& b) {
+    return broadcast_apply<ElementwiseMul, T>(a.view(), b.view());
+}
+
+template<typename T>
+NDArray<T> operator*(const NDArray<T>& a, const std::type_identity_t<T>& value) {
+    return broadcast_apply<ElementwiseMul, T>(a.view(), value);
+}
+
+template<typename T>
+NDArray<T> operator*(const std::type_identity_t<T>& value, const NDArray<T>& b) {
+    return broadcast_apply<ElementwiseMul, T>(value, b.view());
+}
+
+template<typename T>
+NDArray<T> operator/(const NDArray<T>& a, const NDArray<T>& b) {
+    return broadcast_apply<ElementwiseDiv, T>(a.view(), b.view());
+}
+
+template<typename T>
+NDArray<T> operator/(const NDArray<T>& a, const std::type_identity_t<T>& value) {
+    return broadcast_apply<ElementwiseDiv, T>(a.view(), value);
+}
+
+template<typename T>
+NDArray<T> operator/(const std::type_identity_t<T>& value, const NDArray<T>& b) {
+    return broadcast_apply<ElementwiseDiv, T>(value, b.view());
+}
+
+// A temporary left operand that already has the broadcast shape is updated
+// in place and returned, reusing its buffer.
+template<typename Op, typename T>
+NDArray<T> broadcast_apply(NDArray<T>&& a, const NDArrayView<const T>& b) {
+    if (broadcast_shapes(a.shape(), b.shape()) != a.shape()) {
+        return broadcast_apply<Op, T>(a.view(), b);
+    }
+    broadcast_apply<Op, T>(a.view(), b, a.view());
+    return std::move(a);
+}
+
+template<typename T>
+NDArray<T> operator+(NDArray<T>&& a, const NDArray<T>& b) {
+    return broadcast_apply<ElementwiseAdd, T>(std::move(a), b.view());
+}
+
+template<typename T>
+NDArray<T> operator+(NDArray<T>&& a, const std::type_identity_t<T>& value) {
+    a += value;
+    return std::move(a);
+}
+
+template<typename T>
+NDArray<T> operator-(NDArray<T>&& a, const NDArray<T>& b) {
+    return broadcast_apply<ElementwiseSub, T>(std::move(a), b.view());
+}
+
+template<typename T>
+NDArray<T> operator-(NDArray<T>&& a, const std::type_identity_t<T>& value) {
+    a -= value;
+    return std::move(a);
+}
+
+template<typename T>
+NDArray<T> operator*(NDArray<T>&& a, const NDArray<T>& b) {
+    return broadcast_apply<ElementwiseMul, T>(std::move(a), b.view());
+}
+
+template<typename T>
+NDArray<T> operator*(NDArray<T>&& a, const std::type_identity_t<T>& value) {
+    a *= value;
+    return std::move(a);
+}
+
+template<typename T>
+NDArray<T> operator/(NDArray<T>&& a, const NDArray<T>& b) {
+    return broadcast_apply<ElementwiseDiv, T>(std::move(a), b.view());
+}
+
+template<typename T>
+NDArray<T> operator/(NDArray<T>&& a, const std::type_identity_t<T>& value) {
+    a /= value;
+    return std::move(a);
+}
+
+// Destination-passing variants: out must already have the broadcast shape of
+// a and b. It may be one of them when that operand has the broadcast shape.
+
+template<typename T>
+void add(const NDArray<T>& a, const NDArray<T>& b, NDArray<T>& out) {
+    broadcast_apply<ElementwiseAdd, T>(a.view(), b.view(), out.view());
+}
+
+template<typename T>
+void sub(const NDArray<T>& a, const NDArray<T>& b, NDArray<T>& out) {
+    broadcast_apply<ElementwiseSub, T>(a.view(), b.view(), out.view());
+}
+
+template<typename T>
+void mul(const NDArray<T>& a, const NDArray<T>& b, NDArray<T>& out) {
+    broadcast_apply<ElementwiseMul, T>(a.view(), b.view(), out.view());
+}
+
+template<typename T>
+void div(const NDArray<T>& a, const NDArray<T>& b, NDArray<T>& out) {
+    broadcast_apply<ElementwiseDiv, T>(a.view(), b.view(), out.view());
+}
+
+// Array whose rank is a compile-time constant. Shape and strides are stored
+// inline, a(i, j, k) takes exactly Rank indices and its offset is a fold the
+// compiler unrolls; bounds are only checked in debug builds or through at().
+// view() gives access to everything NDArrayView provides.
+template<typename T, std::size_t Rank>
+class NDArray {
+
+    static_assert(Rank <= max_ndarray_rank, "NDArray rank exceeds the supported maximum.");
+
+public:
+
+    using shape_type = std::array<std::size_t, Rank>;
+    using strides_type = std::array<std::ptrdiff_t, Rank>;
+
+private:
+
+    // Members
+
+    std::vector<T, AlignedAllocator<T>> m_data;
+    shape_type m_shape;
+    strides_type m_strides;
+
+    // Private methods
+
+    static std::size_t size_of(const shape_type& shape) {
+        return std::accumulate(shape.begin(), shape.end(), std::size_t(1), std::multiplies<std::size_t>());
+    }
+
+    static strides_type contiguous(const shape_type& shape) {
+        strides_type strides{};
+        std::ptrdiff_t stride = 1;
+        for (std::size_t i = Rank; i-- > 0;) {
+            strides[i] = stride;
+            stride *= static_cast<std::ptrdiff_t>(shape[i]);
+        }
+        return strides;
+    }
+
+    static shape_type to_shape(const std::vector<std::size_t>& shape) {
+        if (shape.size() != Rank) {
+            throw std::invalid_argument("Dimension does not match the rank of NDArray.");
+        }
+        shape_type result{};
+        std::copy(shape.begin(), shape.end(), result.begin());
+        return result;
+    }
+
+    template<typename... Indices>
+    void check_indices(Indices... indices) const {
+        std::size_t axis = 0;
+        if (!((static_cast<std::size_t>(indices) < m_shape[axis++]) && ...)) {
+            throw std::invalid_argument("Index out of range.");
+        }
+    }
+
+    template<typename... Indices>
+    std::size_t offset_of(Indices... indices) const {
+        std::size_t offset = 0;
+        std::size_t axis = 0;
+        ((offset += static_cast<std::size_t>(indices) * static_cast<std::size_t>(m_strides[axis++])), ...);
+        return offset;
+    }
+
+public:
+
+    // Constructors
+
+    NDArray() : m_data(), m_shape{}, m_strides{} {};
+
+    explicit NDArray(const shape_type& shape, const T& value = T()) :
+        m_data(size_of(shape), value), m_shape(shape), m_strides(contiguous(shape))
+    {};
+
+    // Runtime shape, checked against Rank. A template so that a braced shape
+    // such as {2, 3} unambiguously selects the shape_type constructor.
+    template<typename ShapeVector>
+        requires std::is_same_v<ShapeVector, std::vector<std::size_t>>
+    explicit NDArray(const ShapeVector& shape, const T& value = T()) : NDArray(to_shape(shape), value) {};
+
+    template<typename U, typename = std::enable_if_t<std::is_same_v<std::remove_const_t<U>, T>>>
+    explicit NDArray(const NDArrayView<U>& view) : NDArray(to_shape(view.shape())) {
+        this->view().assign(view);
+    };
+
+    explicit NDArray(const NDArray<T>& other) : NDArray(other.view()) {};
+
+    // Operators
+
+    template<typename... Indices>
+        requires (sizeof...(Indices) == Rank && (std::is_integral_v<Indices> && ...))
+    T& operator()(Indices... indices) {
+#ifndef NDEBUG
+        check_indices(indices...);
+#endif
+        return m_data[offset_of(indices...)];
+    }
+
+    template<typename... Indices>
+        requires (sizeof...(Indices) == Rank && (std::is_integral_v<Indices> && ...))
+    const T& operator()(Indices... indices) const {
+#ifndef NDEBUG
+        check_indices(indices...);
+#endif
+        return m_data[offset_of(indices...)];
+    }
+
+    T& operator()(std::span<const std::size_t> indices) {
+        return view()(indices);
+    }
+
+    const T& operator()(std::span<const std::size_t> indices) const {
+        return view()(indices);
+    }
+
+    NDArray<T, Rank>& operator+=(const T& value) {
+        elementwise_scalar<ElementwiseAdd>(m_data.data(), m_data.size(), value);
+        return *this;
+    }
+
+    NDArray<T, Rank>& operator-=(const T& value) {
+        elementwise_scalar<ElementwiseSub>(m_data.data(), m_data.size(), value);
+        return *this;
+    }
+
+    NDArray<T, Rank>& operator*=(const T& value) {
+        elementwise_scalar<ElementwiseMul>(m_data.data(), m_data.size(), value);
+        return *this;
+    }
+
+    NDArray<T, Rank>& operator/=(const T& value) {
+        elementwise_scalar<ElementwiseDiv>(m_data.data(), m_data.size(), value);
+        return *this;
+    }
+
+    // other is broadcast to the shape of this array; see broadcast_shapes().
+    NDArray<T, Rank>& operator+=(const NDArray<T, Rank>& other) {
+        if (m_shape == other.m_shape) {
+            elementwise_contiguous<ElementwiseAdd>(m_data.data(), m_data.data(), other.data(), m_data.size());
+        } else {
+            view() += other.view();
+        }
+        return *this;
+    }
+
+    NDArray<T, Rank>& operator-=(const NDArray<T, Rank>& other) {
+        if (m_shape == other.m_shape) {
+            elementwise_contiguous<ElementwiseSub>(m_data.data(), m_data.data(), other.data(), m_data.size());
+        } else {
+            view() -= other.view();
+        }
+        return *this;
+    }
+
+    NDArray<T, Rank>& operator*=(const NDArray<T, Rank>& other) {
+        if (m_shape == other.m_shape) {
+            elementwise_contiguous<ElementwiseMul>(m_data.data(), m_data.data(), other.data(), m_data.size());
+        } else {
+            view() *= other.view();
+        }
+        return *this;
+    }
+
+    NDArray<T, Rank>& operator/=(const NDArray<T, Rank>& other) {
+        if (m_shape == other.m_shape) {
+            elementwise_contiguous<ElementwiseDiv>(m_data.data(), m_data.data(), other.data(), m_data.size());
+        } else {
+            view() /= other.view();
+        }
+        return *this;
+    }
+
+    NDArray<T, Rank>& operator+=(const NDArrayView<const T>& other) {
+        view() += other;
+        return *this;
+    }
+
+    NDArray<T, Rank>& operator-=(const NDArrayView<const T>& other) {
+        view() -= other;
+        return *this;
+    }
+
+    NDArray<T, Rank>& operator*=(const NDArrayView<const T>& other) {
+        view() *= other;
+        return *this;
+    }
+
+    NDArray<T, Rank>& operator/=(const NDArrayView<const T>& other) {
+        view() /= other;
+        return *this;
+    }
+
+    // Methods
+
+    NDArrayView<T> view() {
+        return NDArrayView<T>(
+            m_data.data(),
+            std::vector<std::size_t>(m_shape.begin(), m_shape.end()),
+            std::vector<std::ptrdiff_t>(m_strides.begin(), m_strides.end())
+        );
+    }
+
+    NDArrayView<const T> view() const {
+        return NDArrayView<const T>(
+            m_data.data(),
+            std::vector<std::size_t>(m_shape.begin(), m_shape.end()),
+            std::vector<std::ptrdiff_t>(m_strides.begin(), m_strides.end())
+        );
+    }
+
+    template<typename... Indices>
+        requires (sizeof...(Indices) == Rank && (std::is_integral_v<Indices> && ...))
+    T& at(Indices... indices) {
+        check_indices(indices...);
+        return m_data[offset_of(indices...)];
+    }
+
+    template<typename... Indices>
+        requires (sizeof...(Indices) == Rank && (std::is_integral_v<Indices> && ...))
+    const T& at(Indices... indices) const {
+        check_indices(indices...);
+        return m_data[offset_of(indices...)];
+    }
+
+    IndexRange indices() const {
+        return IndexRange(m_shape);
+    }
+
+    T* data() {
+        return m_data.data();
+    }
+
+    const T* data() const {
+        return m_data.data();
+    }
+
+    void reshape(const shape_type& shape) {
+        if (size_of(shape) != m_data.size()) {
+            throw std::invalid_argument("Cannot reshape NDArray to given shape.");
+        }
+        m_shape = shape;
+        m_strides = contiguous(shape);
+    }
+
+    static constexpr std::size_t dim() {
+        return Rank;
+    }
+
+    std::size_t size() const {
+        return m_data.size();
+    }
+
+    const shape_type& shape() const {
+        return m_shape;
+    }
+
+    const strides_type& strides() const {
+        return m_strides;
+    }
+
+    T sum() const {
+        return contiguous_sum(m_data.data(), m_data.size());
+    }
+
+    T max() const {
+        if (m_data.empty()) {
+            throw std::invalid_argument("Cannot take the maximum of an empty NDArray.");
+        }
+        return contiguous_max(m_data.data(), m_data.size());
+    }
+
+};
+
+// a is reused for the result when it already has the broadcast shape.
+template<typename Op, typename T, std::size_t Rank>
+NDArray<T, Rank> broadcast_apply(NDArray<T, Rank> a, const NDArray<T, Rank>& b) {
+    if (a.shape() == b.shape()) {
+        elementwise_contiguous<Op>(a.data(), a.data(), b.data(), a.size());
+        return a;
+    }
+    const NDArrayView<const T> x = std::as_const(a).view();
+    const NDArrayView<const T> y = b.view();
+    const std::vector<std::size_t> shape = broadcast_shapes(x.shape(), y.shape());
+    if (shape == x.shape()) {
+        broadcast_apply<Op, T>(x, y, a.view());
+        return a;
+    }
+    NDArray<T, Rank> result(shape);
+    broadcast_apply<Op, T>(x, y, result.view());
+    return result;
+}
+
+template<typename T, std::size_t Rank>
+    requires (Rank != dynamic_rank)
+NDArray<T, Rank> operator+(NDArray<T, Rank> a, const NDArray<T, Rank>& b) {
+    return broadcast_apply<ElementwiseAdd>(std::move(a), b);
+}
+
+template<typename T, std::size_t Rank>
+    requires (Rank != dynamic_rank)
+NDArray<T, Rank> operator+(NDArray<T, Rank> a, const std::type_identity_t<T>& value) {
+    a += value;
+    return a;
+}
+
+template<typename T, std::size_t Rank>
+    requires (Rank != dynamic_rank)
+NDArray<T, Rank> operator+(const std::type_identity_t<T>& value, const NDArray<T, Rank>& b) {
+    NDArray<T, Rank> result(b.shape(), value);
+    result += b;
+    return result;
+}
+
+template<typename T, std::size_t Rank>
+    requires (Rank != dynamic_rank)
+NDArray<T, Rank> operator-(NDArray<T, Rank> a, const NDArray<T, Rank>& b) {
+    return broadcast_apply<ElementwiseSub>(std::move(a), b);
+}
+
+template<typename T, std::size_t Rank>
+    requires (Rank != dynamic_rank)
+NDArray<T, Rank> operator-(NDArray<T, Rank> a, const std::type_identity_t<T>& value) {
+    a -= value;
+    return a;
+}
+
+template<typename T, std::size_t Rank>
+    requires (Rank != dynamic_rank)
+NDArray<T, Rank> operator-(const std::type_identity_t<T>& value, const NDArray<T, Rank>& b) {
+    NDArray<T, Rank> result(b.shape(), value);
+    result -= b;
+    return result;
+}
+
+template<typename T, std::size_t Rank>
+    requires (Rank != dynamic_rank)
+NDArray<T, Rank> operator*(NDArray<T, Rank> a, const NDArray<T, Rank>& b) {
+    return broadcast_apply<ElementwiseMul>(std::move(a), b);
+}
+
+template<typename T, std::size_t Rank>
+    requires (Rank != dynamic_rank)
+NDArray<T, Rank> operator*(NDArray<T, Rank> a, const std::type_identity_t<T>& value) {
+    a *= value;
+    return a;
+}
+
+template<typename T, std::size_t Rank>
+    requires (Rank != dynamic_rank)
+NDArray<T, Rank> operator*(const std::type_identity_t<T>& value, const NDArray<T, Rank>& b) {
+    NDArray<T, Rank> result(b.shape(), value);
+    result *= b;
+    return result;
+}
+
+template<typename T, std::size_t Rank>
+    requires (Rank != dynamic_rank)
+NDArray<T, Rank> operator/(NDArray<T, Rank> a, const NDArray<T, Rank>& b) {
+    return broadcast_apply<ElementwiseDiv>(std::move(a), b);
+}
+
+template<typename T, std::size_t Rank>
+    requires (Rank != dynamic_rank)
+NDArray<T, Rank> operator/(NDArray<T, Rank> a, const std::type_identity_t<T>& value) {
+    a /= value;
+    return a;
+}
+
+template<typename T, std::size_t Rank>
+    requires (Rank != dynamic_rank)
+NDArray<T, Rank> operator/(const std::type_identity_t<T>& value, const NDArray<T, Rank>& b) {
+    NDArray<T, Rank> result(b.shape(), value);
+    result /= b;
+    return result;
+}
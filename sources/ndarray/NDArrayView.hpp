@@ -0,0 +1,384 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "ndarray/Elementwise.hpp"
+#include "ndarray/IndexRange.hpp"
+#include "ndarray/Permute.hpp"
+#include "ndarray/StridedLoop.hpp"
+#include "profile/Profiler.hpp"
+
+template<typename T, std::size_t Rank = dynamic_rank>
+class NDArray;
+
+// Non-owning, strided window over NDArray storage. Element (i0, ..., id) lives
+// at data()[sum(ik * strides()[k])], with data() = base + offset. Slicing,
+// transposition, squeezing and reshaping a contiguous view all return new
+// views over the same memory without copying. Use NDArrayView<const T> for
+// read-only access.
+template<typename T>
+class NDArrayView {
+
+public:
+
+    using value_type = std::remove_const_t<T>;
+
+private:
+
+    // Members
+
+    T* m_base;
+    std::ptrdiff_t m_offset;
+    std::vector<std::size_t> m_shape;
+    std::vector<std::ptrdiff_t> m_strides;
+
+    // Private methods
+
+    void check_axis(std::size_t axis) const {
+        if (axis >= m_shape.size()) {
+            throw std::invalid_argument("Axis out of range.");
+        }
+    }
+
+    std::ptrdiff_t checked_offset(std::span<const std::size_t> indices) const {
+        if (indices.size() != m_shape.size()) {
+            throw std::invalid_argument("Number of indices does not match dimension of NDArrayView.");
+        }
+        std::ptrdiff_t offset = 0;
+        for (std::size_t i = 0; i < indices.size(); i++) {
+            if (indices[i] >= m_shape[i]) {
+                throw std::invalid_argument("Index out of range.");
+            }
+            offset += static_cast<std::ptrdiff_t>(indices[i]) * m_strides[i];
+        }
+        return offset;
+    }
+
+    template<typename... Indices>
+    void check_indices(Indices... indices) const {
+        if (sizeof...(Indices) != m_shape.size()) {
+            throw std::invalid_argument("Number of indices does not match dimension of NDArrayView.");
+        }
+        std::size_t axis = 0;
+        if (!((static_cast<std::size_t>(indices) < m_shape[axis++]) && ...)) {
+            throw std::invalid_argument("Index out of range.");
+        }
+    }
+
+    template<typename... Indices>
+    std::ptrdiff_t offset_of(Indices... indices) const {
+        std::ptrdiff_t offset = 0;
+        std::size_t axis = 0;
+        ((offset += static_cast<std::ptrdiff_t>(indices) * m_strides[axis++]), ...);
+        return offset;
+    }
+
+    template<typename U>
+    bool may_overlap(const NDArrayView<U>& other) const {
+        if (size() == 0 || other.size() == 0) {
+            return false;
+        }
+        auto [lo, hi] = extent();
+        auto [other_lo, other_hi] = other.extent();
+        return static_cast<const void*>(lo) <= static_cast<const void*>(other_hi)
+            && static_cast<const void*>(other_lo) <= static_cast<const void*>(hi);
+    }
+
+    // this = this op other, where other is broadcast to the shape of this.
+    template<typename Op>
+    void binary_assign(const NDArrayView<const value_type>& other, const char* error) {
+        if (m_shape != other.shape() && broadcast_shapes(m_shape, other.shape()) != m_shape) {
+            throw std::invalid_argument(error);
+        }
+        // A source over the same memory is only safe to read in place when it
+        // is exactly this view, element for element. Any other layout, and a
+        // broadcast source (smaller shape or zero strides), would be read
+        // after being partly overwritten, so it is copied first.
+        const bool identical = data() == other.data() && m_shape == other.shape() && m_strides == other.strides()
+            && std::find(m_strides.begin(), m_strides.end(), 0) == m_strides.end();
+        if (may_overlap(other) && !identical) {
+            const NDArray<value_type> copy(other);
+            binary_assign<Op>(copy.view(), error);
+            return;
+        }
+        const NDArrayView<const value_type> source = other.broadcast_to(m_shape);
+        if constexpr (std::is_same_v<Op, ElementwiseAssign>) {
+            strided_copy<value_type>(m_shape, data(), m_strides, source.data(), source.strides());
+        } else {
+            elementwise_apply<Op, value_type>(m_shape, data(), m_strides, data(), m_strides, source.data(), source.strides());
+        }
+    }
+
+    template<typename Op>
+    void scalar_assign(const value_type& value) {
+        // The scalar is an operand broadcast along every axis.
+        const std::vector<std::ptrdiff_t> zero(m_shape.size(), 0);
+        elementwise_apply<Op, value_type>(m_shape, data(), m_strides, data(), m_strides, &value, zero);
+    }
+
+public:
+
+    // Constructors
+
+    NDArrayView() : m_base(nullptr), m_offset(0), m_shape(), m_strides() {};
+
+    NDArrayView(T* base, std::vector<std::size_t> shape, std::vector<std::ptrdiff_t> strides, std::ptrdiff_t offset = 0) :
+        m_base(base), m_offset(offset), m_shape(std::move(shape)), m_strides(std::move(strides))
+    {
+        if (m_shape.size() != m_strides.size()) {
+            throw std::invalid_argument("Shape and strides of an NDArrayView must have the same length.");
+        }
+    };
+
+    // A mutable view converts to a read-only one.
+    template<typename U, typename = std::enable_if_t<std::is_same_v<const U, T> && !std::is_same_v<U, T>>>
+    NDArrayView(const NDArrayView<U>& other) :
+        m_base(other.base()), m_offset(other.offset()), m_shape(other.shape()), m_strides(other.strides())
+    {};
+
+    // Operators
+
+    // Same contract as NDArray::operator(): unchecked in release builds.
+    template<typename... Indices>
+        requires (sizeof...(Indices) > 0 && (std::is_integral_v<Indices> && ...))
+    T& operator()(Indices... indices) const {
+#ifndef NDEBUG
+        check_indices(indices...);
+#endif
+        return data()[offset_of(indices...)];
+    }
+
+    T& operator()(std::span<const std::size_t> indices) const {
+        return data()[checked_offset(indices)];
+    };
+
+    T& operator()(const std::vector<std::size_t>& indices) const {
+        return data()[checked_offset(indices)];
+    };
+
+    NDArrayView<T>& operator+=(const value_type& value) {
+        scalar_assign<ElementwiseAdd>(value);
+        return *this;
+    }
+
+    NDArrayView<T>& operator-=(const value_type& value) {
+        scalar_assign<ElementwiseSub>(value);
+        return *this;
+    }
+
+    NDArrayView<T>& operator*=(const value_type& value) {
+        scalar_assign<ElementwiseMul>(value);
+        return *this;
+    }
+
+    NDArrayView<T>& operator/=(const value_type& value) {
+        scalar_assign<ElementwiseDiv>(value);
+        return *this;
+    }
+
+    NDArrayView<T>& operator+=(const NDArrayView<const value_type>& other) {
+        binary_assign<ElementwiseAdd>(other, "Cannot add NDArrays with incompatible shapes.");
+        return *this;
+    }
+
+    NDArrayView<T>& operator-=(const NDArrayView<const value_type>& other) {
+        binary_assign<ElementwiseSub>(other, "Cannot subtract NDArrays with incompatible shapes.");
+        return *this;
+    }
+
+    NDArrayView<T>& operator*=(const NDArrayView<const value_type>& other) {
+        binary_assign<ElementwiseMul>(other, "Cannot multiply NDArrays with incompatible shapes.");
+        return *this;
+    }
+
+    NDArrayView<T>& operator/=(const NDArrayView<const value_type>& other) {
+        binary_assign<ElementwiseDiv>(other, "Cannot divide NDArrays with incompatible shapes.");
+        return *this;
+    }
+
+    // Methods
+
+    // Copies the elements of other, broadcast to the shape of this view, into
+    // the viewed memory.
+    void assign(const NDArrayView<const value_type>& other) {
+        binary_assign<ElementwiseAssign>(other, "Cannot assign NDArrays with incompatible shapes.");
+    }
+
+    // View of the same elements as an array of the given shape under NumPy
+    // broadcasting rules. Repeated elements share memory (stride 0), so the
+    // result must not be written through when it is a mutable view.
+    NDArrayView<T> broadcast_to(const std::vector<std::size_t>& shape) const {
+        if (shape == m_shape) {
+            return *this;
+        }
+        return NDArrayView<T>(m_base, shape, broadcast_strides(m_shape, m_strides, shape), m_offset);
+    }
+
+    NDArrayView<T> slice(std::size_t axis, std::size_t start, std::size_t stop, std::size_t step = 1) const {
+        check_axis(axis);
+        stop = std::min(stop, m_shape[axis]);
+        if (step == 0 || start > stop) {
+            throw std::invalid_argument("Invalid slice.");
+        }
+        NDArrayView<T> result(*this);
+        result.m_offset += static_cast<std::ptrdiff_t>(start) * m_strides[axis];
+        result.m_shape[axis] = (stop - start + step - 1) / step;
+        result.m_strides[axis] *= static_cast<std::ptrdiff_t>(step);
+        return result;
+    }
+
+    // Fixes axis to index, the result has one dimension less.
+    NDArrayView<T> select(std::size_t axis, std::size_t index) const {
+        check_axis(axis);
+        if (index >= m_shape[axis]) {
+            throw std::invalid_argument("Index out of range.");
+        }
+        NDArrayView<T> result(*this);
+        result.m_offset += static_cast<std::ptrdiff_t>(index) * m_strides[axis];
+        result.m_shape.erase(result.m_shape.begin() + axis);
+        result.m_strides.erase(result.m_strides.begin() + axis);
+        return result;
+    }
+
+    // Reverses the order of the axes.
+    NDArrayView<T> transpose() const {
+        NDArrayView<T> result(*this);
+        std::reverse(result.m_shape.begin(), result.m_shape.end());
+        std::reverse(result.m_strides.begin(), result.m_strides.end());
+        return result;
+    }
+
+    // Axis i of the result is axis axes[i] of this view.
+    NDArrayView<T> transpose(const std::vector<std::size_t>& axes) const {
+        if (axes.size() != m_shape.size()) {
+            throw std::invalid_argument("Axes do not match dimension of NDArrayView.");
+        }
+        std::vector<bool> seen(axes.size(), false);
+        NDArrayView<T> result(*this);
+        for (std::size_t i = 0; i < axes.size(); i++) {
+            check_axis(axes[i]);
+            if (seen[axes[i]]) {
+                throw std::invalid_argument("Axes are not a permutation.");
+            }
+            seen[axes[i]] = true;
+            result.m_shape[i] = m_shape[axes[i]];
+            result.m_strides[i] = m_strides[axes[i]];
+        }
+        return result;
+    }
+
+    // Removes every axis of length 1.
+    NDArrayView<T> squeeze() const {
+        NDArrayView<T> result(*this);
+        result.m_shape.clear();
+        result.m_strides.clear();
+        for (std::size_t i = 0; i < m_shape.size(); i++) {
+            if (m_shape[i] != 1) {
+                result.m_shape.push_back(m_shape[i]);
+                result.m_strides.push_back(m_strides[i]);
+            }
+        }
+        return result;
+    }
+
+    NDArrayView<T> squeeze(std::size_t axis) const {
+        check_axis(axis);
+        if (m_shape[axis] != 1) {
+            throw std::invalid_argument("Cannot squeeze an axis whose length is not 1.");
+        }
+        return select(axis, 0);
+    }
+
+    // Inserts an axis of length 1 at position axis.
+    NDArrayView<T> expand_dims(std::size_t axis) const {
+        if (axis > m_shape.size()) {
+            throw std::invalid_argument("Axis out of range.");
+        }
+        NDArrayView<T> result(*this);
+        result.m_shape.insert(result.m_shape.begin() + axis, 1);
+        result.m_strides.insert(result.m_strides.begin() + axis, 0);
+        return result;
+    }
+
+    // Only contiguous views can be reshaped without copying.
+    NDArrayView<T> reshape(const std::vector<std::size_t>& shape) const {
+        NN_PROFILE_SCOPE(Reshape, "NDArrayView reshape", 0, 0);
+        const std::size_t size = std::accumulate(shape.begin(), shape.end(), std::size_t(1), std::multiplies<std::size_t>());
+        if (size != this->size()) {
+            throw std::invalid_argument("Cannot reshape NDArrayView to given shape.");
+        }
+        if (!is_contiguous()) {
+            throw std::invalid_argument("Cannot reshape a non-contiguous NDArrayView without copying.");
+        }
+        return NDArrayView<T>(m_base, shape, contiguous_strides(shape), m_offset);
+    }
+
+    bool is_contiguous() const {
+        std::vector<std::size_t> shape(m_shape);
+        std::array<std::vector<std::ptrdiff_t>, 1> strides{m_strides};
+        coalesce_dimensions(shape, strides);
+        return shape.size() <= 1 && (strides[0].empty() || strides[0][0] == 1);
+    }
+
+    // Lowest and highest addresses touched by the view.
+    std::pair<T*, T*> extent() const {
+        T* lo = data();
+        T* hi = data();
+        for (std::size_t i = 0; i < m_shape.size(); i++) {
+            const std::ptrdiff_t span = static_cast<std::ptrdiff_t>(m_shape[i] - 1) * m_strides[i];
+            (span < 0 ? lo : hi) += span;
+        }
+        return {lo, hi};
+    }
+
+    template<typename... Indices>
+        requires (sizeof...(Indices) > 0 && (std::is_integral_v<Indices> && ...))
+    T& at(Indices... indices) const {
+        check_indices(indices...);
+        return data()[offset_of(indices...)];
+    }
+
+    IndexRange indices() const {
+        return IndexRange(m_shape);
+    }
+
+    NDArray<value_type> copy() const {
+        return NDArray<value_type>(*this);
+    }
+
+    T* data() const {
+        return m_base + m_offset;
+    };
+
+    T* base() const {
+        return m_base;
+    };
+
+    std::ptrdiff_t offset() const {
+        return m_offset;
+    };
+
+    std::size_t dim() const {
+        return m_shape.size();
+    };
+
+    std::size_t size() const {
+        return std::accumulate(m_shape.begin(), m_shape.end(), std::size_t(1), std::multiplies<std::size_t>());
+    };
+
+    const std::vector<std::size_t>& shape() const {
+        return m_shape;
+    };
+
+    const std::vector<std::ptrdiff_t>& strides() const {
+        return m_strides;
+    };
+
+};
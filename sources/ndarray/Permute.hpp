@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "ndarray/Elementwise.hpp"
+#include "ndarray/StridedLoop.hpp"
+#include "transpose/Transpose.hpp"
+
+// out = src for operands of the same shape.
+//
+// When src is an axis permutation of out, e.g. a transposed view copied into
+// a contiguous array, the axis src walks with stride 1 is not the innermost
+// axis of out, and copying along out's innermost axis reads src one element
+// per cache line. The two axes are then copied together as 2-D transposes by
+// the blocked transpose kernel, once per index of the remaining axes.
+// Anything else is an elementwise copy.
+template<typename T>
+void strided_copy(
+    std::vector<std::size_t> shape,
+    T* out, const std::vector<std::ptrdiff_t>& out_strides,
+    const T* src, const std::vector<std::ptrdiff_t>& src_strides
+) {
+    std::array<std::vector<std::ptrdiff_t>, 2> strides{out_strides, src_strides};
+    coalesce_dimensions(shape, strides);
+    const std::size_t d = shape.size() - 1;
+    std::size_t p = 0;
+    while (p + 1 < shape.size() && strides[1][p] != 1) {
+        p++;
+    }
+    if (shape.size() < 2 || p == d || strides[0][d] != 1 || strides[1][d] <= 0 || strides[0][p] <= 0) {
+        elementwise_apply<ElementwiseAssign, T>(shape, out, strides[0], out, strides[0], src, strides[1]);
+        return;
+    }
+    // Seen from the two axes, src is a shape[d] x shape[p] row-major block
+    // and out is its shape[p] x shape[d] transpose.
+    const std::size_t rows = shape[d];
+    const std::size_t cols = shape[p];
+    const std::size_t lda = static_cast<std::size_t>(strides[1][d]);
+    const std::size_t ldb = static_cast<std::size_t>(strides[0][p]);
+    std::vector<std::size_t> outer;
+    std::array<std::vector<std::ptrdiff_t>, 2> outer_strides;
+    for (std::size_t i = 0; i < d; i++) {
+        if (i != p) {
+            outer.push_back(shape[i]);
+            outer_strides[0].push_back(strides[0][i]);
+            outer_strides[1].push_back(strides[1][i]);
+        }
+    }
+    strided_apply<2>(outer, outer_strides, [&](const auto& offsets, const auto& inner_strides, std::size_t n) {
+        for (std::size_t k = 0; k < n; k++) {
+            const std::ptrdiff_t i = static_cast<std::ptrdiff_t>(k);
+            transpose(rows, cols, src + offsets[1] + i * inner_strides[1], lda, out + offsets[0] + i * inner_strides[0], ldb);
+        }
+    });
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include "parallel/ThreadPool.hpp"
+
+// Largest rank handled by the strided loops, as in NumPy.
+constexpr std::size_t max_ndarray_rank = 32;
+
+// Rank argument of NDArray<T, Rank> for arrays whose rank is a runtime value.
+constexpr std::size_t dynamic_rank = static_cast<std::size_t>(-1);
+
+// Number of elements of an array of the given shape.
+inline std::size_t shape_size(const std::vector<std::size_t>& shape) {
+    return std::accumulate(shape.begin(), shape.end(), std::size_t(1), std::multiplies<std::size_t>());
+}
+
+// Row-major strides, in elements, of a contiguous array of the given shape.
+inline std::vector<std::ptrdiff_t> contiguous_strides(const std::vector<std::size_t>& shape) {
+    std::vector<std::ptrdiff_t> strides(shape.size());
+    std::ptrdiff_t stride = 1;
+    for (std::size_t i = shape.size(); i-- > 0;) {
+        strides[i] = stride;
+        stride *= static_cast<std::ptrdiff_t>(shape[i]);
+    }
+    return strides;
+}
+
+// Drops size-1 axes and merges adjacent axes that every operand walks with
+// matching strides, so that the innermost run is as long as possible.
+template<std::size_t N>
+void coalesce_dimensions(std::vector<std::size_t>& shape, std::array<std::vector<std::ptrdiff_t>, N>& strides) {
+    std::size_t out = 0;
+    for (std::size_t i = 0; i < shape.size(); i++) {
+        if (shape[i] == 1) {
+            continue;
+        }
+        bool mergeable = out > 0;
+        for (std::size_t k = 0; k < N && mergeable; k++) {
+            mergeable = strides[k][out - 1] == strides[k][i] * static_cast<std::ptrdiff_t>(shape[i]);
+        }
+        if (mergeable) {
+            shape[out - 1] *= shape[i];
+            for (std::size_t k = 0; k < N; k++) {
+                strides[k][out - 1] = strides[k][i];
+            }
+        } else {
+            shape[out] = shape[i];
+            for (std::size_t k = 0; k < N; k++) {
+                strides[k][out] = strides[k][i];
+            }
+            out++;
+        }
+    }
+    shape.resize(out);
+    for (std::size_t k = 0; k < N; k++) {
+        strides[k].resize(out);
+    }
+}
+
+// Visits every element of shape for N operands. Operand k of the element at
+// index (i0, ..., id) lives at offset sum(i * strides[k]) from its base.
+// kernel(offsets, inner_strides, n) is called once per run of n elements along
+// the innermost axis, with the offset of the first element of the run for
+// every operand. Runs are distributed over the thread pool.
+template<std::size_t N, typename Kernel>
+void strided_apply(std::vector<std::size_t> shape, std::array<std::vector<std::ptrdiff_t>, N> strides, const Kernel& kernel) {
+    for (std::size_t s : shape) {
+        if (s == 0) {
+            return;
+        }
+    }
+    if (shape.size() > max_ndarray_rank) {
+        throw std::invalid_argument("NDArray rank exceeds the supported maximum.");
+    }
+    coalesce_dimensions(shape, strides);
+    std::array<std::ptrdiff_t, N> inner_strides{};
+    if (shape.empty()) {
+        kernel(std::array<std::ptrdiff_t, N>{}, inner_strides, std::size_t(1));
+        return;
+    }
+    // A single run, e.g. contiguous operands of the same shape, is split into
+    // chunks instead so that it still uses every thread.
+    if (shape.size() == 1) {
+        for (std::size_t k = 0; k < N; k++) {
+            inner_strides[k] = strides[k][0];
+        }
+        parallelFor(0, shape[0], parallelGrain, [&](std::size_t first, std::size_t last) {
+            std::array<std::ptrdiff_t, N> offsets{};
+            for (std::size_t k = 0; k < N; k++) {
+                offsets[k] = static_cast<std::ptrdiff_t>(first) * inner_strides[k];
+            }
+            kernel(offsets, inner_strides, last - first);
+        });
+        return;
+    }
+    const std::size_t d = shape.size() - 1;
+    const std::size_t inner = shape[d];
+    std::size_t outer = 1;
+    for (std::size_t i = 0; i < d; i++) {
+        outer *= shape[i];
+    }
+    for (std::size_t k = 0; k < N; k++) {
+        inner_strides[k] = strides[k][d];
+    }
+    const std::size_t grain = std::max<std::size_t>(1, parallelGrain / inner);
+    parallelFor(0, outer, grain, [&](std::size_t first, std::size_t last) {
+        std::size_t index[max_ndarray_rank];
+        std::array<std::ptrdiff_t, N> offsets{};
+        std::size_t rest = first;
+        for (std::size_t i = d; i-- > 0;) {
+            index[i] = rest % shape[i];
+            rest /= shape[i];
+            for (std::size_t k = 0; k < N; k++) {
+                offsets[k] += static_cast<std::ptrdiff_t>(index[i]) * strides[k][i];
+            }
+        }
+        for (std::size_t o = first; o < last; o++) {
+            kernel(offsets, inner_strides, inner);
+            for (std::size_t i = d; i-- > 0;) {
+                for (std::size_t k = 0; k < N; k++) {
+                    offsets[k] += strides[k][i];
+                }
+                if (++index[i] < shape[i]) {
+                    break;
+                }
+                for (std::size_t k = 0; k < N; k++) {
+                    offsets[k] -= static_cast<std::ptrdiff_t>(shape[i]) * strides[k][i];
+                }
+                index[i] = 0;
+            }
+        }
+    });
+}
+
+// Shape of the result of a binary operation between arrays of shapes a and b
+// under NumPy broadcasting rules: shapes are aligned on their last axis, and
+// along each axis the lengths must match or one of them must be 1.
+inline std::vector<std::size_t> broadcast_shapes(const std::vector<std::size_t>& a, const std::vector<std::size_t>& b) {
+    const std::size_t dim = std::max(a.size(), b.size());
+    std::vector<std::size_t> shape(dim);
+    for (std::size_t i = 0; i < dim; i++) {
+        const std::size_t sa = (i < dim - a.size()) ? 1 : a[i - (dim - a.size())];
+        const std::size_t sb = (i < dim - b.size()) ? 1 : b[i - (dim - b.size())];
+        if (sa != sb && sa != 1 && sb != 1) {
+            throw std::invalid_argument("Shapes cannot be broadcast together.");
+        }
+        shape[i] = (sa == 1) ? sb : sa;
+    }
+    return shape;
+}
+
+// Strides that present an array of the given shape and strides as an array
+// of shape target: new leading axes and stretched length-1 axes get a
+// stride of 0, so the broadcast operand is never expanded in memory.
+inline std::vector<std::ptrdiff_t> broadcast_strides(
+    const std::vector<std::size_t>& shape, const std::vector<std::ptrdiff_t>& strides,
+    const std::vector<std::size_t>& target
+) {
+    if (shape.size() > target.size()) {
+        throw std::invalid_argument("Cannot broadcast to a shape of lower dimension.");
+    }
+    const std::size_t lead = target.size() - shape.size();
+    std::vector<std::ptrdiff_t> result(target.size(), 0);
+    for (std::size_t i = 0; i < shape.size(); i++) {
+        if (shape[i] == target[lead + i]) {
+            result[lead + i] = strides[i];
+        } else if (shape[i] != 1) {
+            throw std::invalid_argument("Shapes cannot be broadcast together.");
+        }
+    }
+    return result;
+}
@@ -0,0 +1,646 @@
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "gemm/Gemm.hpp"
+#include "memory/AlignedAllocator.hpp"
+#include "nn/Convolution.hpp"
+#include "parallel/ThreadPool.hpp"
+#include "profile/Profiler.hpp"
+#include "simd/Simd.hpp"
+
+// Elements of the unfolded patch matrix built at a time: large images are
+// unfolded and multiplied in column (NCHW) or row (NHWC) blocks.
+static constexpr std::size_t im2colBudget = 1 << 20;
+
+// Auto takes the direct algorithm for NHWC inputs with at most this many
+// channels, such as the RGB input of a first layer: their patch rows are too
+// short for im2col to copy efficiently, while the direct algorithm reads a
+// whole S x C kernel row at once. With NCHW, im2col and GEMM were faster for
+// every shape measured.
+static constexpr std::size_t directMaxChannels = 3;
+
+struct ConvShape {
+    std::size_t n, c, h, w;
+    std::size_t k, r, s;
+    std::size_t p, q;
+    std::size_t strideH, strideW, dilationH, dilationW;
+    std::ptrdiff_t padH, padW;
+    nn::Layout layout;
+
+    std::size_t crs() const { return c * r * s; }
+    std::size_t pq() const { return p * q; }
+    std::size_t hw() const { return h * w; }
+    // 1 x 1 kernel with unit stride and no padding: the input is already the
+    // patch matrix.
+    bool pointwise() const { return r == 1 && s == 1 && strideH == 1 && strideW == 1 && padH == 0 && padW == 0; }
+    double flops() const { return 2.0 * static_cast<double>(n * pq()) * static_cast<double>(k * crs()); }
+};
+
+static ConvShape convShape(const std::vector<std::size_t>& input, const std::vector<std::size_t>& weights, const nn::Conv2dOptions& options) {
+    if (input.size() != 4 || weights.size() != 4) {
+        throw std::invalid_argument("Convolution needs 4D input and weights.");
+    }
+    if (options.strideH == 0 || options.strideW == 0 || options.dilationH == 0 || options.dilationW == 0) {
+        throw std::invalid_argument("Convolution strides and dilations must be positive.");
+    }
+    ConvShape g;
+    std::size_t channels;
+    if (options.layout == nn::Layout::NCHW) {
+        g.n = input[0]; g.c = input[1]; g.h = input[2]; g.w = input[3];
+        g.k = weights[0]; channels = weights[1]; g.r = weights[2]; g.s = weights[3];
+    } else {
+        g.n = input[0]; g.h = input[1]; g.w = input[2]; g.c = input[3];
+        g.r = weights[0]; g.s = weights[1]; channels = weights[2]; g.k = weights[3];
+    }
+    if (channels != g.c) {
+        throw std::invalid_argument("Convolution weights do not match the input channels.");
+    }
+    const std::size_t extentH = (g.r - 1) * options.dilationH + 1;
+    const std::size_t extentW = (g.s - 1) * options.dilationW + 1;
+    if (g.r == 0 || g.s == 0 || extentH > g.h + 2 * options.padH || extentW > g.w + 2 * options.padW) {
+        throw std::invalid_argument("Convolution kernel is larger than the padded input.");
+    }
+    g.p = (g.h + 2 * options.padH - extentH) / options.strideH + 1;
+    g.q = (g.w + 2 * options.padW - extentW) / options.strideW + 1;
+    g.strideH = options.strideH;
+    g.strideW = options.strideW;
+    g.dilationH = options.dilationH;
+    g.dilationW = options.dilationW;
+    g.padH = static_cast<std::ptrdiff_t>(options.padH);
+    g.padW = static_cast<std::ptrdiff_t>(options.padW);
+    g.layout = options.layout;
+    return g;
+}
+
+static std::vector<std::size_t> outputShape(const ConvShape& g) {
+    if (g.layout == nn::Layout::NCHW) {
+        return {g.n, g.k, g.p, g.q};
+    }
+    return {g.n, g.p, g.q, g.k};
+}
+
+// Range [lo, hi) of the i in [0, count) for which start + i * stride lies in
+// [0, width).
+static std::pair<std::size_t, std::size_t> validRange(std::ptrdiff_t start, std::size_t stride, std::size_t count, std::size_t width) {
+    const std::ptrdiff_t step = static_cast<std::ptrdiff_t>(stride);
+    const std::ptrdiff_t end = static_cast<std::ptrdiff_t>(width);
+    std::size_t lo = (start >= 0) ? 0 : static_cast<std::size_t>((-start + step - 1) / step);
+    std::size_t hi = (start >= end) ? 0 : static_cast<std::size_t>((end - start + step - 1) / step);
+    lo = std::min(lo, count);
+    hi = std::max(lo, std::min(hi, count));
+    return {lo, hi};
+}
+
+// dst[i] = src[start + i * stride] for i in [0, count), 0 outside the row.
+template<typename T>
+static void gatherRow(const T* src, std::size_t width, std::ptrdiff_t start, std::size_t stride, std::size_t count, T* dst) {
+    const auto [lo, hi] = validRange(start, stride, count, width);
+    std::fill(dst, dst + lo, T(0));
+    if (stride == 1) {
+        std::copy(src + start + static_cast<std::ptrdiff_t>(lo), src + start + static_cast<std::ptrdiff_t>(hi), dst + lo);
+    } else {
+        for (std::size_t i = lo; i < hi; i++) {
+            dst[i] = src[start + static_cast<std::ptrdiff_t>(i * stride)];
+        }
+    }
+    std::fill(dst + hi, dst + count, T(0));
+}
+
+// dst[start + i * stride] += src[i] for the i that fall inside the row.
+template<typename T>
+static void scatterRow(const T* src, std::size_t width, std::ptrdiff_t start, std::size_t stride, std::size_t count, T* dst) {
+    const auto [lo, hi] = validRange(start, stride, count, width);
+    if (stride == 1) {
+        T* out = dst + start + static_cast<std::ptrdiff_t>(lo);
+        simd::kernels<T>().add(out, src + lo, out, hi - lo);
+    } else {
+        for (std::size_t i = lo; i < hi; i++) {
+            dst[start + static_cast<std::ptrdiff_t>(i * stride)] += src[i];
+        }
+    }
+}
+
+// Calls fn(p, q0, n, offset) for the runs of output pixels j0 .. j0 + width
+// (in row-major order over P x Q) that share an output row p.
+template<typename F>
+static void forEachOutputRun(const ConvShape& g, std::size_t j0, std::size_t width, const F& fn) {
+    std::size_t j = j0;
+    while (j < j0 + width) {
+        const std::size_t p = j / g.q;
+        const std::size_t q0 = j % g.q;
+        const std::size_t n = std::min(g.q - q0, j0 + width - j);
+        fn(p, q0, n, j - j0);
+        j += n;
+    }
+}
+
+// NCHW patch matrix of one image: row (c, r, s), column j in [j0, j0 + width)
+// of the output pixels.
+template<typename T>
+static void im2colNCHW(const ConvShape& g, const T* image, std::size_t j0, std::size_t width, T* cols) {
+    parallelFor(0, g.crs(), std::max<std::size_t>(1, parallelGrain / width), [&](std::size_t first, std::size_t last) {
+        for (std::size_t row = first; row < last; row++) {
+            const std::size_t c = row / (g.r * g.s);
+            const std::size_t r = (row / g.s) % g.r;
+            const std::size_t s = row % g.s;
+            T* dst = cols + row * width;
+            forEachOutputRun(g, j0, width, [&](std::size_t p, std::size_t q0, std::size_t n, std::size_t offset) {
+                const std::ptrdiff_t ih = static_cast<std::ptrdiff_t>(p * g.strideH + r * g.dilationH) - g.padH;
+                if (ih < 0 || ih >= static_cast<std::ptrdiff_t>(g.h)) {
+                    std::fill(dst + offset, dst + offset + n, T(0));
+                    return;
+                }
+                const std::ptrdiff_t start = static_cast<std::ptrdiff_t>(q0 * g.strideW + s * g.dilationW) - g.padW;
+                gatherRow(image + (c * g.h + static_cast<std::size_t>(ih)) * g.w, g.w, start, g.strideW, n, dst + offset);
+            });
+        }
+    });
+}
+
+// Adds the patch matrix back into the image it was unfolded from. Each
+// channel is written by one thread.
+template<typename T>
+static void col2imNCHW(const ConvShape& g, const T* cols, std::size_t j0, std::size_t width, T* image) {
+    parallelFor(0, g.c, std::max<std::size_t>(1, parallelGrain / (width * g.r * g.s)), [&](std::size_t first, std::size_t last) {
+        for (std::size_t c = first; c < last; c++) {
+            for (std::size_t r = 0; r < g.r; r++) {
+                for (std::size_t s = 0; s < g.s; s++) {
+                    const T* src = cols + ((c * g.r + r) * g.s + s) * width;
+                    forEachOutputRun(g, j0, width, [&](std::size_t p, std::size_t q0, std::size_t n, std::size_t offset) {
+                        const std::ptrdiff_t ih = static_cast<std::ptrdiff_t>(p * g.strideH + r * g.dilationH) - g.padH;
+                        if (ih < 0 || ih >= static_cast<std::ptrdiff_t>(g.h)) {
+                            return;
+                        }
+                        const std::ptrdiff_t start = static_cast<std::ptrdiff_t>(q0 * g.strideW + s * g.dilationW) - g.padW;
+                        scatterRow(src + offset, g.w, start, g.strideW, n, image + (c * g.h + static_cast<std::size_t>(ih)) * g.w);
+                    });
+                }
+            }
+        }
+    });
+}
+
+// NHWC patch matrix: row i0 + i over the N x P x Q output pixels, column
+// (r, s, c).
+template<typename T>
+static void im2colNHWC(const ConvShape& g, const T* input, std::size_t i0, std::size_t rows, T* cols) {
+    const std::size_t crs = g.crs();
+    parallelFor(0, rows, std::max<std::size_t>(1, parallelGrain / crs), [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) {
+            const std::size_t pixel = i0 + i;
+            const std::size_t n = pixel / g.pq();
+            const std::size_t p = (pixel / g.q) % g.p;
+            const std::size_t q = pixel % g.q;
+            for (std::size_t r = 0; r < g.r; r++) {
+                const std::ptrdiff_t ih = static_cast<std::ptrdiff_t>(p * g.strideH + r * g.dilationH) - g.padH;
+                for (std::size_t s = 0; s < g.s; s++) {
+                    const std::ptrdiff_t iw = static_cast<std::ptrdiff_t>(q * g.strideW + s * g.dilationW) - g.padW;
+                    T* dst = cols + i * crs + (r * g.s + s) * g.c;
+                    if (ih < 0 || ih >= static_cast<std::ptrdiff_t>(g.h) || iw < 0 || iw >= static_cast<std::ptrdiff_t>(g.w)) {
+                        std::fill(dst, dst + g.c, T(0));
+                    } else {
+                        const T* src = input + ((n * g.h + static_cast<std::size_t>(ih)) * g.w + static_cast<std::size_t>(iw)) * g.c;
+                        std::copy(src, src + g.c, dst);
+                    }
+                }
+            }
+        }
+    });
+}
+
+// Patches overlap across pixels, so threads split the channels instead.
+template<typename T>
+static void col2imNHWC(const ConvShape& g, const T* cols, std::size_t i0, std::size_t rows, T* input) {
+    const std::size_t crs = g.crs();
+    const simd::BasicKernels<T>& kernels = simd::kernels<T>();
+    parallelFor(0, g.c, std::max<std::size_t>(1, parallelGrain / (rows * g.r * g.s)), [&](std::size_t c0, std::size_t c1) {
+        for (std::size_t i = 0; i < rows; i++) {
+            const std::size_t pixel = i0 + i;
+            const std::size_t n = pixel / g.pq();
+            const std::size_t p = (pixel / g.q) % g.p;
+            const std::size_t q = pixel % g.q;
+            for (std::size_t r = 0; r < g.r; r++) {
+                const std::ptrdiff_t ih = static_cast<std::ptrdiff_t>(p * g.strideH + r * g.dilationH) - g.padH;
+                if (ih < 0 || ih >= static_cast<std::ptrdiff_t>(g.h)) {
+                    continue;
+                }
+                for (std::size_t s = 0; s < g.s; s++) {
+                    const std::ptrdiff_t iw = static_cast<std::ptrdiff_t>(q * g.strideW + s * g.dilationW) - g.padW;
+                    if (iw < 0 || iw >= static_cast<std::ptrdiff_t>(g.w)) {
+                        continue;
+                    }
+                    const T* src = cols + i * crs + (r * g.s + s) * g.c + c0;
+                    T* dst = input + ((n * g.h + static_cast<std::size_t>(ih)) * g.w + static_cast<std::size_t>(iw)) * g.c + c0;
+                    kernels.add(dst, src, dst, c1 - c0);
+                }
+            }
+        }
+    });
+}
+
+// Output pixels (NCHW) or rows (NHWC) unfolded per block.
+static std::size_t im2colBlock(const ConvShape& g, std::size_t total) {
+    return std::max<std::size_t>(1, std::min(total, im2colBudget / std::max<std::size_t>(1, g.crs())));
+}
+
+template<typename T>
+static void forwardIm2col(const ConvShape& g, const T* input, const T* weights, T* output, const T* bias, Activation activation) {
+    const std::size_t crs = g.crs();
+    if (g.layout == nn::Layout::NCHW) {
+        const GemmEpilogue<T> epilogue{bias, true, activation};
+        if (g.pointwise()) {
+            for (std::size_t n = 0; n < g.n; n++) {
+                gemm(g.k, g.pq(), g.c, T(1), weights, g.c, 1, input + n * g.c * g.hw(), g.pq(), 1, T(0), output + n * g.k * g.pq(), g.pq(), 1, epilogue);
+            }
+            return;
+        }
+        const std::size_t block = im2colBlock(g, g.pq());
+        std::vector<T, AlignedAllocator<T>> cols(crs * block);
+        for (std::size_t n = 0; n < g.n; n++) {
+            for (std::size_t j0 = 0; j0 < g.pq(); j0 += block) {
+                const std::size_t width = std::min(block, g.pq() - j0);
+                im2colNCHW(g, input + n * g.c * g.hw(), j0, width, cols.data());
+                gemm(g.k, width, crs, T(1), weights, crs, 1, cols.data(), width, 1, T(0), output + n * g.k * g.pq() + j0, g.pq(), 1, epilogue);
+            }
+        }
+        return;
+    }
+    const GemmEpilogue<T> epilogue{bias, false, activation};
+    const std::size_t pixels = g.n * g.pq();
+    if (g.pointwise()) {
+        gemm(pixels, g.k, g.c, T(1), input, g.c, 1, weights, g.k, 1, T(0), output, g.k, 1, epilogue);
+        return;
+    }
+    const std::size_t block = im2colBlock(g, pixels);
+    std::vector<T, AlignedAllocator<T>> cols(crs * block);
+    for (std::size_t i0 = 0; i0 < pixels; i0 += block) {
+        const std::size_t rows = std::min(block, pixels - i0);
+        im2colNHWC(g, input, i0, rows, cols.data());
+        gemm(rows, g.k, crs, T(1), cols.data(), crs, 1, weights, g.k, 1, T(0), output + i0 * g.k, g.k, 1, epilogue);
+    }
+}
+
+// y[0, n) += sum over i < rows of alpha[i] * a[i * lda, i * lda + n), four rows
+// per kernel call.
+template<typename T>
+static void accumulateRows(const simd::BasicKernels<T>& kernels, const T* alpha, const T* a, std::size_t lda, std::size_t rows, T* y, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 4 <= rows; i += 4) {
+        kernels.axpy4(alpha + i, a + i * lda, lda, y, n);
+    }
+    for (; i < rows; i++) {
+        kernels.axpy(alpha[i], a + i * lda, y, n);
+    }
+}
+
+// dst[q] += weight * row[start + q * stride] over the q in [first, last).
+template<typename T>
+static void accumulateStrided(T weight, const T* row, std::ptrdiff_t start, std::size_t stride, std::size_t first, std::size_t last, T* dst) {
+    for (std::size_t q = first; q < last; q++) {
+        dst[q] += weight * row[start + static_cast<std::ptrdiff_t>(q * stride)];
+    }
+}
+
+// NCHW: each output row accumulates weight * shifted input row. With unit
+// stride, four taps (s .. s + 3) of a kernel row are one axpy4 over input rows
+// shifted by the dilation, on the columns where all four are inside the
+// input. NHWC: each output pixel accumulates input value * weight row over
+// the output channels, a whole kernel row (S x C contiguous inputs) at a time
+// when it lies inside the input.
+template<typename T>
+static void forwardDirect(const ConvShape& g, const T* input, const T* weights, T* output, const T* bias, Activation activation) {
+    const simd::BasicKernels<T>& kernels = simd::kernels<T>();
+    if (g.layout == nn::Layout::NCHW) {
+        const std::size_t work = g.crs() * g.pq();
+        parallelFor(0, g.n * g.k, std::max<std::size_t>(1, parallelGrain / std::max<std::size_t>(1, work)), [&](std::size_t first, std::size_t last) {
+            for (std::size_t plane = first; plane < last; plane++) {
+                const std::size_t n = plane / g.k;
+                const std::size_t k = plane % g.k;
+                T* out = output + plane * g.pq();
+                std::fill(out, out + g.pq(), (bias != nullptr) ? bias[k] : T(0));
+                for (std::size_t c = 0; c < g.c; c++) {
+                    const T* image = input + (n * g.c + c) * g.hw();
+                    for (std::size_t r = 0; r < g.r; r++) {
+                        const T* taps = weights + ((k * g.c + c) * g.r + r) * g.s;
+                        for (std::size_t p = 0; p < g.p; p++) {
+                            const std::ptrdiff_t ih = static_cast<std::ptrdiff_t>(p * g.strideH + r * g.dilationH) - g.padH;
+                            if (ih < 0 || ih >= static_cast<std::ptrdiff_t>(g.h)) {
+                                continue;
+                            }
+                            const T* row = image + static_cast<std::size_t>(ih) * g.w;
+                            T* dst = out + p * g.q;
+                            std::size_t s = 0;
+                            if (g.strideW == 1) {
+                                for (; s + 4 <= g.s; s += 4) {
+                                    const std::ptrdiff_t start = static_cast<std::ptrdiff_t>(s * g.dilationW) - g.padW;
+                                    const std::ptrdiff_t dilation = static_cast<std::ptrdiff_t>(g.dilationW);
+                                    // Columns valid for the first tap start
+                                    // lowest, those of the last end lowest.
+                                    const std::size_t lo = validRange(start, 1, g.q, g.w).first;
+                                    const std::size_t hi = std::max(lo, validRange(start + 3 * dilation, 1, g.q, g.w).second);
+                                    if (hi > lo) {
+                                        kernels.axpy4(taps + s, row + start + static_cast<std::ptrdiff_t>(lo), g.dilationW, dst + lo, hi - lo);
+                                    }
+                                    for (std::size_t j = 0; j < 4; j++) {
+                                        const std::ptrdiff_t tap = start + static_cast<std::ptrdiff_t>(j) * dilation;
+                                        const auto [tapLo, tapHi] = validRange(tap, 1, g.q, g.w);
+                                        if (hi > lo) {
+                                            accumulateStrided(taps[s + j], row, tap, 1, tapLo, std::min(tapHi, lo), dst);
+                                            accumulateStrided(taps[s + j], row, tap, 1, std::max(tapLo, hi), tapHi, dst);
+                                        } else {
+                                            accumulateStrided(taps[s + j], row, tap, 1, tapLo, tapHi, dst);
+                                        }
+                                    }
+                                }
+                            }
+                            for (; s < g.s; s++) {
+                                const std::ptrdiff_t start = static_cast<std::ptrdiff_t>(s * g.dilationW) - g.padW;
+                                const auto [lo, hi] = validRange(start, g.strideW, g.q, g.w);
+                                if (g.strideW == 1 && hi > lo) {
+                                    kernels.axpy(taps[s], row + start + static_cast<std::ptrdiff_t>(lo), dst + lo, hi - lo);
+                                } else {
+                                    accumulateStrided(taps[s], row, start, g.strideW, lo, hi, dst);
+                                }
+                            }
+                        }
+                    }
+                }
+                ::activate(activation, out, g.pq());
+            }
+        });
+        return;
+    }
+    const std::size_t work = g.q * g.crs() * g.k;
+    parallelFor(0, g.n * g.p, std::max<std::size_t>(1, parallelGrain / std::max<std::size_t>(1, work)), [&](std::size_t first, std::size_t last) {
+        for (std::size_t row = first; row < last; row++) {
+            const std::size_t n = row / g.p;
+            const std::size_t p = row % g.p;
+            for (std::size_t q = 0; q < g.q; q++) {
+                T* out = output + (row * g.q + q) * g.k;
+                if (bias != nullptr) {
+                    std::copy(bias, bias + g.k, out);
+                } else {
+                    std::fill(out, out + g.k, T(0));
+                }
+                const std::ptrdiff_t iw0 = static_cast<std::ptrdiff_t>(q * g.strideW) - g.padW;
+                const bool rowInside = g.dilationW == 1 && iw0 >= 0 && iw0 + static_cast<std::ptrdiff_t>(g.s) <= static_cast<std::ptrdiff_t>(g.w);
+                for (std::size_t r = 0; r < g.r; r++) {
+                    const std::ptrdiff_t ih = static_cast<std::ptrdiff_t>(p * g.strideH + r * g.dilationH) - g.padH;
+                    if (ih < 0 || ih >= static_cast<std::ptrdiff_t>(g.h)) {
+                        continue;
+                    }
+                    const T* line = input + (n * g.h + static_cast<std::size_t>(ih)) * g.w * g.c;
+                    const T* w = weights + r * g.s * g.c * g.k;
+                    if (rowInside) {
+                        accumulateRows(kernels, line + static_cast<std::size_t>(iw0) * g.c, w, g.k, g.s * g.c, out, g.k);
+                        continue;
+                    }
+                    for (std::size_t s = 0; s < g.s; s++) {
+                        const std::ptrdiff_t iw = iw0 + static_cast<std::ptrdiff_t>(s * g.dilationW);
+                        if (iw >= 0 && iw < static_cast<std::ptrdiff_t>(g.w)) {
+                            accumulateRows(kernels, line + static_cast<std::size_t>(iw) * g.c, w + s * g.c * g.k, g.k, g.c, out, g.k);
+                        }
+                    }
+                }
+                ::activate(activation, out, g.k);
+            }
+        }
+    });
+}
+
+// A channels-last array is NCHW to its users and NHWC in memory: it goes
+// through the NHWC kernels without a copy, with R x S x C x K weights as for
+// NHWC. Returns the options those kernels see.
+template<typename T>
+static nn::Conv2dOptions storageOptions(const NDArray<T>& activations, const NDArray<T>& weights, const nn::Conv2dOptions& options) {
+    if (weights.format() != MemoryFormat::RowMajor) {
+        throw std::invalid_argument("Convolution weights must be row-major.");
+    }
+    if (activations.format() == MemoryFormat::RowMajor) {
+        return options;
+    }
+    if (activations.format() != MemoryFormat::ChannelsLast || options.layout != nn::Layout::NCHW) {
+        throw std::invalid_argument("Convolution takes row-major arrays, or NCHW arrays in the channels-last format.");
+    }
+    nn::Conv2dOptions storage = options;
+    storage.layout = nn::Layout::NHWC;
+    return storage;
+}
+
+template<typename T>
+static void checkConv2d(const ConvShape& g, const NDArray<T>& output, MemoryFormat format) {
+    if (output.format() != format) {
+        throw std::invalid_argument("Convolution arrays must share their memory format.");
+    }
+    if (output.storage_shape() != outputShape(g)) {
+        throw std::invalid_argument("Output does not have the right shape for conv2d.");
+    }
+}
+
+namespace nn {
+
+std::vector<std::size_t> conv2dOutputShape(const std::vector<std::size_t>& input, const std::vector<std::size_t>& weights, const Conv2dOptions& options) {
+    return outputShape(convShape(input, weights, options));
+}
+
+ConvAlgorithm conv2dAlgorithm(const std::vector<std::size_t>& input, const std::vector<std::size_t>& weights, const Conv2dOptions& options) {
+    const ConvShape g = convShape(input, weights, options);
+    if (options.algorithm != ConvAlgorithm::Auto) {
+        return options.algorithm;
+    }
+    if (g.pointwise()) {
+        return ConvAlgorithm::Im2col;
+    }
+    return (g.layout == Layout::NHWC && g.c <= directMaxChannels) ? ConvAlgorithm::Direct : ConvAlgorithm::Im2col;
+}
+
+MemoryFormat conv2dPreferredFormat(const std::vector<std::size_t>& input, const Conv2dOptions& options) {
+    if (input.size() != 4) {
+        throw std::invalid_argument("Convolution needs 4D input and weights.");
+    }
+    // The direct algorithm is faster on NHWC than on NCHW.
+    const bool direct = options.algorithm == ConvAlgorithm::Direct || (options.algorithm == ConvAlgorithm::Auto && input[1] <= directMaxChannels);
+    return (options.layout == Layout::NCHW && direct) ? MemoryFormat::ChannelsLast : MemoryFormat::RowMajor;
+}
+
+template<typename T>
+void conv2d(const NDArray<T>& input, const NDArray<T>& weights, NDArray<T>& output, const Conv2dOptions& options) {
+    const Conv2dOptions storage = storageOptions(input, weights, options);
+    const ConvShape g = convShape(input.storage_shape(), weights.shape(), storage);
+    checkConv2d(g, output, input.format());
+    NN_PROFILE_SCOPE(Dot, "conv2d", static_cast<double>((input.size() + weights.size() + output.size()) * sizeof(T)), g.flops());
+    if (conv2dAlgorithm(input.storage_shape(), weights.shape(), storage) == ConvAlgorithm::Direct) {
+        forwardDirect(g, input.data(), weights.data(), output.data(), static_cast<const T*>(nullptr), Activation::Identity);
+    } else {
+        forwardIm2col(g, input.data(), weights.data(), output.data(), static_cast<const T*>(nullptr), Activation::Identity);
+    }
+}
+
+template<typename T>
+void conv2d(const NDArray<T>& input, const NDArray<T>& weights, const NDArray<T>& bias, NDArray<T>& output, const Conv2dOptions& options, Activation activation) {
+    const Conv2dOptions storage = storageOptions(input, weights, options);
+    const ConvShape g = convShape(input.storage_shape(), weights.shape(), storage);
+    checkConv2d(g, output, input.format());
+    if (bias.shape() != std::vector<std::size_t>{g.k}) {
+        throw std::invalid_argument("Bias must have one entry per output channel.");
+    }
+    NN_PROFILE_SCOPE(Dot, "conv2d", static_cast<double>((input.size() + weights.size() + output.size()) * sizeof(T)), g.flops());
+    if (conv2dAlgorithm(input.storage_shape(), weights.shape(), storage) == ConvAlgorithm::Direct) {
+        forwardDirect(g, input.data(), weights.data(), output.data(), bias.data(), activation);
+    } else {
+        forwardIm2col(g, input.data(), weights.data(), output.data(), bias.data(), activation);
+    }
+}
+
+template<typename T>
+NDArray<T> conv2d(const NDArray<T>& input, const NDArray<T>& weights, const Conv2dOptions& options) {
+    std::vector<std::size_t> shape = outputShape(convShape(input.storage_shape(), weights.shape(), storageOptions(input, weights, options)));
+    if (input.format() == MemoryFormat::ChannelsLast) {
+        shape = {shape[0], shape[3], shape[1], shape[2]};
+    }
+    NDArray<T> output(shape, input.format());
+    conv2d(input, weights, output, options);
+    return output;
+}
+
+// The patch-matrix gradient W^T dY is computed block by block and folded
+// back into the input gradient.
+template<typename T>
+void conv2dBackwardData(const NDArray<T>& gradOutput, const NDArray<T>& weights, NDArray<T>& gradInput, const Conv2dOptions& options) {
+    const ConvShape g = convShape(gradInput.storage_shape(), weights.shape(), storageOptions(gradInput, weights, options));
+    checkConv2d(g, gradOutput, gradInput.format());
+    NN_PROFILE_SCOPE(Dot, "conv2d backward data", static_cast<double>((gradInput.size() + weights.size() + gradOutput.size()) * sizeof(T)), g.flops());
+    const std::size_t crs = g.crs();
+    const T* w = weights.data();
+    const T* dy = gradOutput.data();
+    T* dx = gradInput.data();
+    if (g.layout == Layout::NCHW) {
+        if (g.pointwise()) {
+            for (std::size_t n = 0; n < g.n; n++) {
+                gemm(g.c, g.pq(), g.k, T(1), w, 1, g.c, dy + n * g.k * g.pq(), g.pq(), 1, T(0), dx + n * g.c * g.hw(), g.hw(), 1);
+            }
+            return;
+        }
+        std::fill(dx, dx + gradInput.size(), T(0));
+        const std::size_t block = im2colBlock(g, g.pq());
+        std::vector<T, AlignedAllocator<T>> cols(crs * block);
+        for (std::size_t n = 0; n < g.n; n++) {
+            for (std::size_t j0 = 0; j0 < g.pq(); j0 += block) {
+                const std::size_t width = std::min(block, g.pq() - j0);
+                gemm(crs, width, g.k, T(1), w, 1, crs, dy + n * g.k * g.pq() + j0, g.pq(), 1, T(0), cols.data(), width, 1);
+                col2imNCHW(g, cols.data(), j0, width, dx + n * g.c * g.hw());
+            }
+        }
+        return;
+    }
+    const std::size_t pixels = g.n * g.pq();
+    if (g.pointwise()) {
+        gemm(pixels, g.c, g.k, T(1), dy, g.k, 1, w, 1, g.k, T(0), dx, g.c, 1);
+        return;
+    }
+    std::fill(dx, dx + gradInput.size(), T(0));
+    const std::size_t block = im2colBlock(g, pixels);
+    std::vector<T, AlignedAllocator<T>> cols(crs * block);
+    for (std::size_t i0 = 0; i0 < pixels; i0 += block) {
+        const std::size_t rows = std::min(block, pixels - i0);
+        gemm(rows, crs, g.k, T(1), dy + i0 * g.k, g.k, 1, w, 1, g.k, T(0), cols.data(), crs, 1);
+        col2imNHWC(g, cols.data(), i0, rows, dx);
+    }
+}
+
+// dW = dY cols^T (NCHW) or cols^T dY (NHWC), accumulated over the blocks.
+template<typename T>
+void conv2dBackwardWeights(const NDArray<T>& input, const NDArray<T>& gradOutput, NDArray<T>& gradWeights, const Conv2dOptions& options) {
+    const ConvShape g = convShape(input.storage_shape(), gradWeights.shape(), storageOptions(input, gradWeights, options));
+    checkConv2d(g, gradOutput, input.format());
+    NN_PROFILE_SCOPE(Dot, "conv2d backward weights", static_cast<double>((input.size() + gradWeights.size() + gradOutput.size()) * sizeof(T)), g.flops());
+    const std::size_t crs = g.crs();
+    const T* x = input.data();
+    const T* dy = gradOutput.data();
+    T* dw = gradWeights.data();
+    std::fill(dw, dw + gradWeights.size(), T(0));
+    if (g.layout == Layout::NCHW) {
+        if (g.pointwise()) {
+            for (std::size_t n = 0; n < g.n; n++) {
+                gemm(g.k, g.c, g.pq(), T(1), dy + n * g.k * g.pq(), g.pq(), 1, x + n * g.c * g.hw(), 1, g.hw(), T(1), dw, g.c, 1);
+            }
+            return;
+        }
+        const std::size_t block = im2colBlock(g, g.pq());
+        std::vector<T, AlignedAllocator<T>> cols(crs * block);
+        for (std::size_t n = 0; n < g.n; n++) {
+            for (std::size_t j0 = 0; j0 < g.pq(); j0 += block) {
+                const std::size_t width = std::min(block, g.pq() - j0);
+                im2colNCHW(g, x + n * g.c * g.hw(), j0, width, cols.data());
+                gemm(g.k, crs, width, T(1), dy + n * g.k * g.pq() + j0, g.pq(), 1, cols.data(), 1, width, T(1), dw, crs, 1);
+            }
+        }
+        return;
+    }
+    const std::size_t pixels = g.n * g.pq();
+    if (g.pointwise()) {
+        gemm(g.c, g.k, pixels, T(1), x, 1, g.c, dy, g.k, 1, T(0), dw, g.k, 1);
+        return;
+    }
+    const std::size_t block = im2colBlock(g, pixels);
+    std::vector<T, AlignedAllocator<T>> cols(crs * block);
+    for (std::size_t i0 = 0; i0 < pixels; i0 += block) {
+        const std::size_t rows = std::min(block, pixels - i0);
+        im2colNHWC(g, x, i0, rows, cols.data());
+        gemm(crs, g.k, rows, T(1), cols.data(), 1, crs, dy + i0 * g.k, g.k, 1, T(1), dw, g.k, 1);
+    }
+}
+
+template<typename T>
+void conv2dBackwardBias(const NDArray<T>& gradOutput, NDArray<T>& gradBias, Layout layout) {
+    if (gradOutput.dim() != 4) {
+        throw std::invalid_argument("Convolution gradients are 4D.");
+    }
+    if (gradOutput.format() == MemoryFormat::ChannelsLast && layout == Layout::NCHW) {
+        layout = Layout::NHWC;
+    } else if (gradOutput.format() != MemoryFormat::RowMajor) {
+        throw std::invalid_argument("Convolution takes row-major arrays, or NCHW arrays in the channels-last format.");
+    }
+    const std::vector<std::size_t> shape = gradOutput.storage_shape();
+    const std::size_t k = (layout == Layout::NCHW) ? shape[1] : shape[3];
+    if (gradBias.shape() != std::vector<std::size_t>{k}) {
+        throw std::invalid_argument("Bias must have one entry per output channel.");
+    }
+    const simd::BasicKernels<T>& kernels = simd::kernels<T>();
+    const T* dy = gradOutput.data();
+    T* db = gradBias.data();
+    if (layout == Layout::NCHW) {
+        const std::size_t plane = shape[2] * shape[3];
+        parallelFor(0, k, std::max<std::size_t>(1, parallelGrain / std::max<std::size_t>(1, shape[0] * plane)), [&](std::size_t first, std::size_t last) {
+            for (std::size_t c = first; c < last; c++) {
+                T sum = T(0);
+                for (std::size_t n = 0; n < shape[0]; n++) {
+                    sum += kernels.sum(dy + (n * k + c) * plane, plane);
+                }
+                db[c] = sum;
+            }
+        });
+        return;
+    }
+    std::fill(db, db + k, T(0));
+    const std::size_t pixels = shape[0] * shape[1] * shape[2];
+    for (std::size_t i = 0; i < pixels; i++) {
+        kernels.add(db, dy + i * k, db, k);
+    }
+}
+
+// Instantiations
+
+#define INSTANTIATE_CONVOLUTION(T) \
+    template void conv2d<T>(const NDArray<T>&, const NDArray<T>&, NDArray<T>&, const Conv2dOptions&); \
+    template void conv2d<T>(const NDArray<T>&, const NDArray<T>&, const NDArray<T>&, NDArray<T>&, const Conv2dOptions&, Activation); \
+    template NDArray<T> conv2d<T>(const NDArray<T>&, const NDArray<T>&, const Conv2dOptions&); \
+    template void conv2dBackwardData<T>(const NDArray<T>&, const NDArray<T>&, NDArray<T>&, const Conv2dOptions&); \
+    template void conv2dBackwardWeights<T>(const NDArray<T>&, const NDArray<T>&, NDArray<T>&, const Conv2dOptions&); \
+    template void conv2dBackwardBias<T>(const NDArray<T>&, NDArray<T>&, Layout);
+
+INSTANTIATE_CONVOLUTION(float)
+INSTANTIATE_CONVOLUTION(double)
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "gemm/Epilogue.hpp"
+#include "ndarray/NDArray.hpp"
+#include "nn/Layout.hpp"
+
+namespace nn {
+
+enum class ConvAlgorithm {
+    // Direct for NHWC inputs with few channels, im2col otherwise.
+    Auto,
+    // Patches unfolded into a matrix, then one GEMM.
+    Im2col,
+    // Accumulates shifted input rows into the output without unfolding.
+    Direct
+};
+
+// Weights are K x C x R x S (output channels, input channels, kernel height
+// and width) for NCHW tensors, and R x S x C x K for NHWC ones, so that both
+// are the right operand of a row-major GEMM without transposition.
+//
+// Activations are row-major, or NCHW arrays in the channels-last memory
+// format. The latter are NHWC in memory and take R x S x C x K weights; the
+// results are then channels-last as well.
+struct Conv2dOptions {
+    std::size_t strideH = 1;
+    std::size_t strideW = 1;
+    std::size_t padH = 0;
+    std::size_t padW = 0;
+    std::size_t dilationH = 1;
+    std::size_t dilationW = 1;
+    Layout layout = Layout::NCHW;
+    ConvAlgorithm algorithm = ConvAlgorithm::Auto;
+};
+
+std::vector<std::size_t> conv2dOutputShape(const std::vector<std::size_t>& input, const std::vector<std::size_t>& weights, const Conv2dOptions& options);
+
+// Algorithm Auto resolves to for these shapes.
+ConvAlgorithm conv2dAlgorithm(const std::vector<std::size_t>& input, const std::vector<std::size_t>& weights, const Conv2dOptions& options);
+
+// Memory format the convolution of NCHW activations of this shape runs
+// fastest in: channels-last when the direct algorithm runs, row-major
+// otherwise.
+MemoryFormat conv2dPreferredFormat(const std::vector<std::size_t>& input, const Conv2dOptions& options = Conv2dOptions());
+
+// output must have the shape given by conv2dOutputShape(). bias has one entry
+// per output channel; it and the activation are applied as the output is
+// written.
+template<typename T>
+void conv2d(const NDArray<T>& input, const NDArray<T>& weights, NDArray<T>& output, const Conv2dOptions& options = Conv2dOptions());
+template<typename T>
+void conv2d(const NDArray<T>& input, const NDArray<T>& weights, const NDArray<T>& bias, NDArray<T>& output, const Conv2dOptions& options = Conv2dOptions(), Activation activation = Activation::Identity);
+template<typename T>
+NDArray<T> conv2d(const NDArray<T>& input, const NDArray<T>& weights, const Conv2dOptions& options = Conv2dOptions());
+
+// Gradients with respect to the input, the weights and the bias, from the
+// gradient of the output. The results are overwritten, not accumulated into.
+template<typename T>
+void conv2dBackwardData(const NDArray<T>& gradOutput, const NDArray<T>& weights, NDArray<T>& gradInput, const Conv2dOptions& options = Conv2dOptions());
+template<typename T>
+void conv2dBackwardWeights(const NDArray<T>& input, const NDArray<T>& gradOutput, NDArray<T>& gradWeights, const Conv2dOptions& options = Conv2dOptions());
+template<typename T>
+void conv2dBackwardBias(const NDArray<T>& gradOutput, NDArray<T>& gradBias, Layout layout = Layout::NCHW);
+
+}
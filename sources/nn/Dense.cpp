@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+#include "gemm/Gemm.hpp"
+#include "nn/Dense.hpp"
+
+namespace nn {
+
+// Constructors
+
+template<typename T>
+BasicDense<T>::BasicDense(std::size_t inputs, std::size_t outputs, Activation activation) :
+    m_weights(inputs, outputs), m_bias(outputs), m_activation(activation)
+{}
+
+template<typename T>
+BasicDense<T>::BasicDense(BasicMatrix<T> weights, BasicVector<T> bias, Activation activation) :
+    m_weights(std::move(weights)), m_bias(std::move(bias)), m_activation(activation)
+{
+    if (m_bias.size() != m_weights.nbCols()) {
+        throw std::invalid_argument("Dense bias must have one entry per output.");
+    }
+}
+
+// Other members
+
+template<typename T>
+std::size_t BasicDense<T>::inputs() const {
+    return m_weights.nbRows();
+}
+
+template<typename T>
+std::size_t BasicDense<T>::outputs() const {
+    return m_weights.nbCols();
+}
+
+template<typename T>
+Activation BasicDense<T>::activation() const {
+    return m_activation;
+}
+
+template<typename T>
+BasicMatrix<T>& BasicDense<T>::weights() {
+    return m_weights;
+}
+
+template<typename T>
+const BasicMatrix<T>& BasicDense<T>::weights() const {
+    return m_weights;
+}
+
+template<typename T>
+BasicVector<T>& BasicDense<T>::bias() {
+    return m_bias;
+}
+
+template<typename T>
+const BasicVector<T>& BasicDense<T>::bias() const {
+    return m_bias;
+}
+
+template<typename T>
+void BasicDense<T>::initialize(std::uint64_t seed) {
+    const bool rectifier = (m_activation == Activation::Relu || m_activation == Activation::Gelu);
+    const double fan = rectifier ? static_cast<double>(inputs()) / 2 : static_cast<double>(inputs() + outputs()) / 2;
+    const double limit = std::sqrt(3.0 / std::max(fan, 1.0));
+    std::mt19937_64 engine(seed);
+    std::uniform_real_distribution<double> distribution(-limit, limit);
+    for (std::size_t i = 0; i < inputs(); i++) {
+        for (std::size_t j = 0; j < outputs(); j++) {
+            m_weights(i, j) = static_cast<T>(distribution(engine));
+        }
+    }
+    for (T& b : m_bias) {
+        b = T(0);
+    }
+}
+
+template<typename T>
+void BasicDense<T>::forward(const BasicMatrix<T>& x, BasicMatrix<T>& out) const {
+    if (x.nbCols() != inputs() || out.nbRows() != x.nbRows() || out.nbCols() != outputs()) {
+        throw std::invalid_argument("Matrices do not have the right dimensions for Dense forward.");
+    }
+    gemm(T(1), x, m_weights, T(0), out, GemmEpilogue<T>{m_bias.data(), false, m_activation});
+}
+
+template<typename T>
+BasicMatrix<T> BasicDense<T>::forward(const BasicMatrix<T>& x) const {
+    BasicMatrix<T> out(x.nbRows(), outputs());
+    forward(x, out);
+    return out;
+}
+
+template<typename T>
+BasicVector<T> BasicDense<T>::forward(const BasicVector<T>& x) const {
+    if (x.size() != inputs()) {
+        throw std::invalid_argument("Vector does not have the right dimension for Dense forward.");
+    }
+    BasicVector<T> out(outputs());
+    ::gemm(
+        1, outputs(), inputs(),
+        T(1),
+        x.data(), inputs(), 1,
+        m_weights.data(), m_weights.rowStride(), 1,
+        T(0),
+        out.data(), outputs(), 1,
+        GemmEpilogue<T>{m_bias.data(), false, m_activation}
+    );
+    return out;
+}
+
+// Instantiations
+
+template class BasicDense<double>;
+template class BasicDense<float>;
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "gemm/Epilogue.hpp"
+#include "matrix/Matrix.hpp"
+#include "vector/Vector.hpp"
+
+namespace nn {
+
+// Fully connected layer y = act(x W + b) over mini-batches: x holds one
+// sample per row (batch x inputs), W is inputs x outputs and b has one entry
+// per output. The whole batch is one GEMM whose epilogue adds the bias and
+// applies the activation while each output tile is written, so the output
+// is streamed through memory once.
+template<typename T>
+class BasicDense {
+
+    BasicMatrix<T> m_weights;
+    BasicVector<T> m_bias;
+    Activation m_activation;
+
+public:
+
+    // Constructors
+    // Zero weights and bias, see initialize().
+    BasicDense(std::size_t inputs, std::size_t outputs, Activation activation = Activation::Identity);
+    BasicDense(BasicMatrix<T> weights, BasicVector<T> bias, Activation activation = Activation::Identity);
+
+    // Other members
+    std::size_t inputs() const;
+    std::size_t outputs() const;
+    Activation activation() const;
+    BasicMatrix<T>& weights();
+    const BasicMatrix<T>& weights() const;
+    BasicVector<T>& bias();
+    const BasicVector<T>& bias() const;
+
+    // Uniform random weights scaled for the activation (He for ReLU and
+    // GELU, Glorot otherwise) and a zero bias.
+    void initialize(std::uint64_t seed);
+
+    // out must be batch x outputs, and not alias x.
+    void forward(const BasicMatrix<T>& x, BasicMatrix<T>& out) const;
+    BasicMatrix<T> forward(const BasicMatrix<T>& x) const;
+    // Single sample.
+    BasicVector<T> forward(const BasicVector<T>& x) const;
+
+};
+
+using Dense = BasicDense<double>;
+using FloatDense = BasicDense<float>;
+
+}
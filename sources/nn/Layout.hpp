@@ -0,0 +1,13 @@
+#pragma once
+
+namespace nn {
+
+// Order of the axes of 4D image tensors: batch, channels, height and width.
+// It is the order of the shape, whatever the memory format of the array: a
+// channels-last array is NCHW even though it is stored NHWC.
+enum class Layout {
+    NCHW,
+    NHWC
+};
+
+}
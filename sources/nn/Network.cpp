@@ -0,0 +1,112 @@
+#include <stdexcept>
+#include <utility>
+
+#include "nn/Network.hpp"
+
+namespace nn {
+
+// Constructors
+
+template<typename T>
+BasicNetwork<T>::BasicNetwork() :
+    m_layers(), m_buffers()
+{}
+
+// Operators
+
+template<typename T>
+BasicDense<T>& BasicNetwork<T>::operator[](std::size_t i) {
+    return m_layers[i];
+}
+
+template<typename T>
+const BasicDense<T>& BasicNetwork<T>::operator[](std::size_t i) const {
+    return m_layers[i];
+}
+
+// Other members
+
+template<typename T>
+BasicNetwork<T>& BasicNetwork<T>::add(BasicDense<T> layer) {
+    if (!m_layers.empty() && layer.inputs() != outputs()) {
+        throw std::invalid_argument("Layer inputs do not match the outputs of the network.");
+    }
+    m_layers.push_back(std::move(layer));
+    return *this;
+}
+
+template<typename T>
+BasicNetwork<T>& BasicNetwork<T>::add(std::size_t outputs, Activation activation) {
+    if (m_layers.empty()) {
+        throw std::invalid_argument("The first layer of a network needs its number of inputs.");
+    }
+    return add(BasicDense<T>(this->outputs(), outputs, activation));
+}
+
+template<typename T>
+std::size_t BasicNetwork<T>::size() const {
+    return m_layers.size();
+}
+
+template<typename T>
+std::size_t BasicNetwork<T>::inputs() const {
+    return m_layers.empty() ? 0 : m_layers.front().inputs();
+}
+
+template<typename T>
+std::size_t BasicNetwork<T>::outputs() const {
+    return m_layers.empty() ? 0 : m_layers.back().outputs();
+}
+
+template<typename T>
+const std::vector<BasicDense<T>>& BasicNetwork<T>::layers() const {
+    return m_layers;
+}
+
+template<typename T>
+void BasicNetwork<T>::initialize(std::uint64_t seed) {
+    std::uint64_t state = seed;
+    for (BasicDense<T>& layer : m_layers) {
+        // splitmix64 step, so that layers of the same shape differ.
+        state += 0x9E3779B97F4A7C15ull;
+        std::uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        layer.initialize(z ^ (z >> 31));
+    }
+}
+
+template<typename T>
+void BasicNetwork<T>::forward(const BasicMatrix<T>& x, BasicMatrix<T>& out) {
+    if (m_layers.empty()) {
+        throw std::invalid_argument("Cannot run an empty network.");
+    }
+    if (x.nbCols() != inputs() || out.nbRows() != x.nbRows() || out.nbCols() != outputs()) {
+        throw std::invalid_argument("Matrices do not have the right dimensions for Network forward.");
+    }
+    m_buffers.resize(m_layers.size() - 1);
+    const BasicMatrix<T>* input = &x;
+    for (std::size_t l = 0; l + 1 < m_layers.size(); l++) {
+        BasicMatrix<T>& buffer = m_buffers[l];
+        if (buffer.nbRows() != x.nbRows() || buffer.nbCols() != m_layers[l].outputs()) {
+            buffer = BasicMatrix<T>(x.nbRows(), m_layers[l].outputs());
+        }
+        m_layers[l].forward(*input, buffer);
+        input = &buffer;
+    }
+    m_layers.back().forward(*input, out);
+}
+
+template<typename T>
+BasicMatrix<T> BasicNetwork<T>::forward(const BasicMatrix<T>& x) {
+    BasicMatrix<T> out(x.nbRows(), outputs());
+    forward(x, out);
+    return out;
+}
+
+// Instantiations
+
+template class BasicNetwork<double>;
+template class BasicNetwork<float>;
+
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "matrix/Matrix.hpp"
+#include "nn/Dense.hpp"
+
+namespace nn {
+
+// Sequential stack of Dense layers (a multilayer perceptron). forward()
+// runs the layers over a whole mini-batch, each as one fused GEMM, with the
+// intermediate activations in one buffer per hidden layer, reused from call
+// to call and only reallocated when the batch size changes: a Network is
+// therefore not safe to run from several threads at once.
+template<typename T>
+class BasicNetwork {
+
+    std::vector<BasicDense<T>> m_layers;
+    // Outputs of the hidden layers, batch x outputs of each.
+    std::vector<BasicMatrix<T>> m_buffers;
+
+public:
+
+    // Constructors
+    BasicNetwork();
+
+    // Operators
+    BasicDense<T>& operator[](std::size_t i);
+    const BasicDense<T>& operator[](std::size_t i) const;
+
+    // Other members
+    // Appends a layer, whose inputs must match the outputs of the last one.
+    BasicNetwork& add(BasicDense<T> layer);
+    BasicNetwork& add(std::size_t outputs, Activation activation);
+    std::size_t size() const;
+    std::size_t inputs() const;
+    std::size_t outputs() const;
+    const std::vector<BasicDense<T>>& layers() const;
+
+    // Initializes every layer, from seeds derived from seed.
+    void initialize(std::uint64_t seed);
+
+    // x is batch x inputs(); out must be batch x outputs().
+    void forward(const BasicMatrix<T>& x, BasicMatrix<T>& out);
+    BasicMatrix<T> forward(const BasicMatrix<T>& x);
+
+};
+
+using Network = BasicNetwork<double>;
+using FloatNetwork = BasicNetwork<float>;
+
+}
@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "nn/Optimizer.hpp"
+#include "parallel/ThreadPool.hpp"
+#include "profile/Profiler.hpp"
+#include "simd/Simd.hpp"
+
+static void checkOptions(const nn::OptimizerOptions& options) {
+    if (!(options.learningRate >= 0)) {
+        throw std::invalid_argument("Learning rate must be non-negative.");
+    }
+    if (!(options.momentum >= 0)) {
+        throw std::invalid_argument("Momentum must be non-negative.");
+    }
+    if (options.nesterov && options.momentum == 0) {
+        throw std::invalid_argument("Nesterov momentum needs a positive momentum.");
+    }
+    if (!(options.beta1 >= 0 && options.beta1 < 1 && options.beta2 >= 0 && options.beta2 < 1)) {
+        throw std::invalid_argument("Adam betas must be in [0, 1).");
+    }
+    if (!(options.epsilon > 0)) {
+        throw std::invalid_argument("Adam epsilon must be positive.");
+    }
+    if (!(options.weightDecay >= 0)) {
+        throw std::invalid_argument("Weight decay must be non-negative.");
+    }
+}
+
+namespace nn {
+
+// Constructors
+
+template<typename T>
+BasicOptimizer<T>::BasicOptimizer(const OptimizerOptions& options) :
+    m_options(options), m_parameters(), m_size(0), m_steps(0), m_first(), m_second()
+{
+    checkOptions(m_options);
+}
+
+// Other members
+
+template<typename T>
+void BasicOptimizer<T>::add(BasicMatrix<T>& value, const BasicMatrix<T>& gradient) {
+    if (value.size() != gradient.size() || value.rowStride() != gradient.rowStride()) {
+        throw std::invalid_argument("Parameter and gradient do not have the same dimensions.");
+    }
+    add(value.data(), gradient.data(), value.nbRows() * value.rowStride());
+}
+
+template<typename T>
+void BasicOptimizer<T>::add(BasicVector<T>& value, const BasicVector<T>& gradient) {
+    if (value.size() != gradient.size()) {
+        throw std::invalid_argument("Parameter and gradient do not have the same dimensions.");
+    }
+    add(value.data(), gradient.data(), value.size());
+}
+
+template<typename T>
+void BasicOptimizer<T>::add(NDArray<T>& value, const NDArray<T>& gradient) {
+    if (value.shape() != gradient.shape() || value.format() != gradient.format()) {
+        throw std::invalid_argument("Parameter and gradient do not have the same shape and memory format.");
+    }
+    // Blocked padding is zero in both, and stays zero.
+    add(value.data(), gradient.data(), shape_size(value.storage_shape()));
+}
+
+template<typename T>
+void BasicOptimizer<T>::add(T* value, const T* gradient, std::size_t size) {
+    if (size == 0) {
+        return;
+    }
+    m_parameters.push_back({value, gradient, size, m_size});
+    m_size += size;
+}
+
+template<typename T>
+void BasicOptimizer<T>::step() {
+    const bool adam = m_options.algorithm != OptimizerAlgorithm::Sgd;
+    const bool moments = adam || m_options.momentum != 0;
+    if (moments && m_first.size() < m_size) {
+        m_first.resize(m_size, T(0));
+    }
+    if (adam && m_second.size() < m_size) {
+        m_second.resize(m_size, T(0));
+    }
+    m_steps++;
+    const double rate = m_options.learningRate;
+    const bool decoupled = m_options.algorithm == OptimizerAlgorithm::AdamW;
+    const simd::SgdUpdate<T> sgd{
+        static_cast<T>(rate), static_cast<T>(m_options.momentum), static_cast<T>(m_options.weightDecay), m_options.nesterov
+    };
+    const double t = static_cast<double>(m_steps);
+    const simd::AdamUpdate<T> update{
+        static_cast<T>(m_options.beta1),
+        static_cast<T>(m_options.beta2),
+        static_cast<T>(m_options.epsilon),
+        static_cast<T>(decoupled ? 0.0 : m_options.weightDecay),
+        static_cast<T>(decoupled ? 1.0 - rate * m_options.weightDecay : 1.0),
+        static_cast<T>(rate / (1.0 - std::pow(m_options.beta1, t))),
+        static_cast<T>(1.0 / std::sqrt(1.0 - std::pow(m_options.beta2, t)))
+    };
+    // Streams: weights, gradients and moments read, weights and moments
+    // written.
+    NN_PROFILE_SCOPE(Elementwise, adam ? "Adam step" : "SGD step", (adam ? 7.0 : (moments ? 5.0 : 3.0)) * static_cast<double>(m_size * sizeof(T)), (adam ? 12.0 : 4.0) * static_cast<double>(m_size));
+    const simd::BasicKernels<T>& kernels = simd::kernels<T>();
+    parallelFor(0, m_size, parallelGrain, [&](std::size_t first, std::size_t last) {
+        // Last parameter starting at or before first, then the following
+        // ones up to last.
+        auto p = std::upper_bound(m_parameters.begin(), m_parameters.end(), first, [](std::size_t i, const Parameter& q) {
+            return i < q.offset;
+        }) - 1;
+        for (; p != m_parameters.end() && p->offset < last; ++p) {
+            const std::size_t begin = std::max(first, p->offset);
+            const std::size_t end = std::min(last, p->offset + p->size);
+            T* w = p->value + (begin - p->offset);
+            const T* g = p->gradient + (begin - p->offset);
+            if (adam) {
+                kernels.adam(w, g, m_first.data() + begin, m_second.data() + begin, end - begin, update);
+            } else {
+                kernels.sgd(w, g, moments ? m_first.data() + begin : nullptr, end - begin, sgd);
+            }
+        }
+    });
+}
+
+template<typename T>
+const OptimizerOptions& BasicOptimizer<T>::options() const {
+    return m_options;
+}
+
+template<typename T>
+void BasicOptimizer<T>::setLearningRate(double learningRate) {
+    OptimizerOptions options = m_options;
+    options.learningRate = learningRate;
+    checkOptions(options);
+    m_options = options;
+}
+
+template<typename T>
+std::uint64_t BasicOptimizer<T>::steps() const {
+    return m_steps;
+}
+
+template<typename T>
+std::size_t BasicOptimizer<T>::size() const {
+    return m_size;
+}
+
+template<typename T>
+std::size_t BasicOptimizer<T>::stateBytes() const {
+    return (m_first.size() + m_second.size()) * sizeof(T);
+}
+
+// Instantiations
+
+template class BasicOptimizer<double>;
+template class BasicOptimizer<float>;
+
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "matrix/Matrix.hpp"
+#include "memory/AlignedAllocator.hpp"
+#include "ndarray/NDArray.hpp"
+#include "vector/Vector.hpp"
+
+namespace nn {
+
+enum class OptimizerAlgorithm {
+    // Stochastic gradient descent, with optional (Nesterov) momentum.
+    Sgd,
+    Adam,
+    // Adam with weight decay decoupled from the gradient.
+    AdamW
+};
+
+// weightDecay is an L2 penalty added to the gradient for Sgd and Adam, and
+// shrinks the weights by learningRate * weightDecay at every step for AdamW.
+struct OptimizerOptions {
+    OptimizerAlgorithm algorithm = OptimizerAlgorithm::Sgd;
+    double learningRate = 0.01;
+    double momentum = 0.0;
+    bool nesterov = false;
+    double beta1 = 0.9;
+    double beta2 = 0.999;
+    double epsilon = 1e-8;
+    double weightDecay = 0.0;
+};
+
+// Updates parameters in place from their gradients. The parameters are
+// registered once with add(); step() then reads the gradients currently in
+// their buffers.
+//
+// Each step is one fused pass of the SIMD sgd or adam kernel over every
+// parameter, its gradient and its moments, without temporaries. The moments
+// of all the parameters live in one flat buffer, and the parameters are
+// treated as consecutive ranges of a single index space that is split over
+// the thread pool as a whole, so that many small tensors (biases, norms)
+// cost one parallel pass rather than one each. Parameters that are already
+// slices of one contiguous buffer can be added as a single range.
+template<typename T>
+class BasicOptimizer {
+
+    // Elements [offset, offset + size) of the flat index space.
+    struct Parameter {
+        T* value;
+        const T* gradient;
+        std::size_t size;
+        std::size_t offset;
+    };
+
+    OptimizerOptions m_options;
+    std::vector<Parameter> m_parameters;
+    std::size_t m_size;
+    std::uint64_t m_steps;
+    // Velocity for SGD with momentum, first and second moments for Adam, in
+    // the flat index space. Grown with zeros when parameters are added.
+    std::vector<T, AlignedAllocator<T>> m_first;
+    std::vector<T, AlignedAllocator<T>> m_second;
+
+public:
+
+    // Constructors
+    explicit BasicOptimizer(const OptimizerOptions& options = OptimizerOptions());
+
+    // Other members
+    // value and gradient must have the same dimensions and outlive the
+    // optimizer, or at least its steps.
+    void add(BasicMatrix<T>& value, const BasicMatrix<T>& gradient);
+    void add(BasicVector<T>& value, const BasicVector<T>& gradient);
+    void add(NDArray<T>& value, const NDArray<T>& gradient);
+    void add(T* value, const T* gradient, std::size_t size);
+
+    void step();
+
+    const OptimizerOptions& options() const;
+    // For learning rate schedules; takes effect at the next step.
+    void setLearningRate(double learningRate);
+    std::uint64_t steps() const;
+    // Number of parameters (scalars) updated by a step.
+    std::size_t size() const;
+    // Bytes held by the moment buffers.
+    std::size_t stateBytes() const;
+
+};
+
+using Optimizer = BasicOptimizer<double>;
+using FloatOptimizer = BasicOptimizer<float>;
+
+}
@@ -0,0 +1,270 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "nn/Pooling.hpp"
+#include "parallel/ThreadPool.hpp"
+#include "profile/Profiler.hpp"
+
+// Every layout is walked as planes of H x W pixels of `lanes` contiguous
+// elements: N x C planes of single elements for NCHW, N planes of C channels
+// for NHWC and channels-last arrays, and N x C / 16 planes of 16 channels for
+// channels-blocked ones. Windows never cross planes, so each plane is one
+// task.
+struct PoolShape {
+    std::size_t planes, lanes;
+    std::size_t h, w;
+    std::size_t p, q;
+    std::size_t kernelH, kernelW, strideH, strideW;
+    std::ptrdiff_t padH, padW;
+    std::vector<std::size_t> outputShape;
+    MemoryFormat format;
+
+    std::size_t inputPlane() const { return h * w * lanes; }
+    std::size_t outputPlane() const { return p * q * lanes; }
+};
+
+static PoolShape poolShape(const std::vector<std::size_t>& input, const nn::Pool2dOptions& options, MemoryFormat format = MemoryFormat::RowMajor) {
+    if (input.size() != 4) {
+        throw std::invalid_argument("Pooling needs a 4D input.");
+    }
+    if (format == MemoryFormat::ColumnMajor) {
+        throw std::invalid_argument("Pooling does not take column-major arrays.");
+    }
+    if (format != MemoryFormat::RowMajor && options.layout != nn::Layout::NCHW) {
+        throw std::invalid_argument("Channels-last and channels-blocked arrays are NCHW.");
+    }
+    if (options.kernelH == 0 || options.kernelW == 0 || options.strideH == 0 || options.strideW == 0) {
+        throw std::invalid_argument("Pooling kernel sizes and strides must be positive.");
+    }
+    if (options.padH >= options.kernelH || options.padW >= options.kernelW) {
+        throw std::invalid_argument("Pooling padding must be smaller than the kernel.");
+    }
+    PoolShape g;
+    const bool nchw = options.layout == nn::Layout::NCHW;
+    g.h = nchw ? input[2] : input[1];
+    g.w = nchw ? input[3] : input[2];
+    if (format == MemoryFormat::ChannelsLast) {
+        g.planes = input[0];
+        g.lanes = input[1];
+    } else if (format == MemoryFormat::ChannelsBlocked) {
+        g.planes = input[0] * ((input[1] + channel_block - 1) / channel_block);
+        g.lanes = channel_block;
+    } else {
+        g.planes = nchw ? input[0] * input[1] : input[0];
+        g.lanes = nchw ? 1 : input[3];
+    }
+    if (options.kernelH > g.h + 2 * options.padH || options.kernelW > g.w + 2 * options.padW) {
+        throw std::invalid_argument("Pooling kernel is larger than the padded input.");
+    }
+    g.p = (g.h + 2 * options.padH - options.kernelH) / options.strideH + 1;
+    g.q = (g.w + 2 * options.padW - options.kernelW) / options.strideW + 1;
+    g.kernelH = options.kernelH;
+    g.kernelW = options.kernelW;
+    g.strideH = options.strideH;
+    g.strideW = options.strideW;
+    g.padH = static_cast<std::ptrdiff_t>(options.padH);
+    g.padW = static_cast<std::ptrdiff_t>(options.padW);
+    g.outputShape = nchw ? std::vector<std::size_t>{input[0], input[1], g.p, g.q} : std::vector<std::size_t>{input[0], g.p, g.q, input[3]};
+    g.format = format;
+    return g;
+}
+
+struct Window {
+    std::size_t h0, h1, w0, w1;
+
+    std::size_t count() const { return (h1 - h0) * (w1 - w0); }
+};
+
+// Input rows and columns covered by output pixel (p, q), clipped to the input.
+static Window window(const PoolShape& g, std::size_t p, std::size_t q) {
+    const std::ptrdiff_t h0 = static_cast<std::ptrdiff_t>(p * g.strideH) - g.padH;
+    const std::ptrdiff_t w0 = static_cast<std::ptrdiff_t>(q * g.strideW) - g.padW;
+    return Window{
+        static_cast<std::size_t>(std::max<std::ptrdiff_t>(h0, 0)),
+        std::min(static_cast<std::size_t>(h0 + static_cast<std::ptrdiff_t>(g.kernelH)), g.h),
+        static_cast<std::size_t>(std::max<std::ptrdiff_t>(w0, 0)),
+        std::min(static_cast<std::size_t>(w0 + static_cast<std::ptrdiff_t>(g.kernelW)), g.w)
+    };
+}
+
+// Calls fn(plane) for every plane, split over the pool.
+template<typename F>
+static void forEachPlane(const PoolShape& g, const F& fn) {
+    const std::size_t work = std::max<std::size_t>(1, g.outputPlane() * g.kernelH * g.kernelW);
+    parallelFor(0, g.planes, std::max<std::size_t>(1, parallelGrain / work), [&](std::size_t first, std::size_t last) {
+        for (std::size_t plane = first; plane < last; plane++) {
+            fn(plane);
+        }
+    });
+}
+
+template<typename T>
+static void checkPool2d(const PoolShape& g, const NDArray<T>& output) {
+    if (output.shape() != g.outputShape) {
+        throw std::invalid_argument("Output does not have the right shape for pooling.");
+    }
+    if (output.format() != g.format) {
+        throw std::invalid_argument("Output does not have the memory format of the pooling input.");
+    }
+}
+
+namespace nn {
+
+std::vector<std::size_t> pool2dOutputShape(const std::vector<std::size_t>& input, const Pool2dOptions& options) {
+    return poolShape(input, options).outputShape;
+}
+
+MemoryFormat pool2dPreferredFormat(const Pool2dOptions& options) {
+    return (options.layout == Layout::NCHW) ? MemoryFormat::ChannelsBlocked : MemoryFormat::RowMajor;
+}
+
+template<typename T>
+void maxPool2d(const NDArray<T>& input, NDArray<T>& output, const Pool2dOptions& options) {
+    const PoolShape g = poolShape(input.shape(), options, input.format());
+    checkPool2d(g, output);
+    NN_PROFILE_SCOPE(Reduction, "maxPool2d", static_cast<double>((input.size() + output.size()) * sizeof(T)), static_cast<double>(output.size() * g.kernelH * g.kernelW));
+    forEachPlane(g, [&](std::size_t plane) {
+        const T* in = input.data() + plane * g.inputPlane();
+        T* out = output.data() + plane * g.outputPlane();
+        for (std::size_t p = 0; p < g.p; p++) {
+            for (std::size_t q = 0; q < g.q; q++) {
+                const Window win = window(g, p, q);
+                T* o = out + (p * g.q + q) * g.lanes;
+                const T* first = in + (win.h0 * g.w + win.w0) * g.lanes;
+                std::copy(first, first + g.lanes, o);
+                for (std::size_t ih = win.h0; ih < win.h1; ih++) {
+                    for (std::size_t iw = win.w0; iw < win.w1; iw++) {
+                        const T* x = in + (ih * g.w + iw) * g.lanes;
+                        for (std::size_t l = 0; l < g.lanes; l++) {
+                            o[l] = std::max(o[l], x[l]);
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+template<typename T>
+NDArray<T> maxPool2d(const NDArray<T>& input, const Pool2dOptions& options) {
+    NDArray<T> output(pool2dOutputShape(input.shape(), options), input.format());
+    maxPool2d(input, output, options);
+    return output;
+}
+
+template<typename T>
+void avgPool2d(const NDArray<T>& input, NDArray<T>& output, const Pool2dOptions& options) {
+    const PoolShape g = poolShape(input.shape(), options, input.format());
+    checkPool2d(g, output);
+    NN_PROFILE_SCOPE(Reduction, "avgPool2d", static_cast<double>((input.size() + output.size()) * sizeof(T)), static_cast<double>(output.size() * g.kernelH * g.kernelW));
+    forEachPlane(g, [&](std::size_t plane) {
+        const T* in = input.data() + plane * g.inputPlane();
+        T* out = output.data() + plane * g.outputPlane();
+        for (std::size_t p = 0; p < g.p; p++) {
+            for (std::size_t q = 0; q < g.q; q++) {
+                const Window win = window(g, p, q);
+                T* o = out + (p * g.q + q) * g.lanes;
+                std::fill(o, o + g.lanes, T(0));
+                for (std::size_t ih = win.h0; ih < win.h1; ih++) {
+                    for (std::size_t iw = win.w0; iw < win.w1; iw++) {
+                        const T* x = in + (ih * g.w + iw) * g.lanes;
+                        for (std::size_t l = 0; l < g.lanes; l++) {
+                            o[l] += x[l];
+                        }
+                    }
+                }
+                const T scale = T(1) / static_cast<T>(win.count());
+                for (std::size_t l = 0; l < g.lanes; l++) {
+                    o[l] *= scale;
+                }
+            }
+        }
+    });
+}
+
+template<typename T>
+NDArray<T> avgPool2d(const NDArray<T>& input, const Pool2dOptions& options) {
+    NDArray<T> output(pool2dOutputShape(input.shape(), options), input.format());
+    avgPool2d(input, output, options);
+    return output;
+}
+
+template<typename T>
+void maxPool2dBackward(const NDArray<T>& input, const NDArray<T>& gradOutput, NDArray<T>& gradInput, const Pool2dOptions& options) {
+    const PoolShape g = poolShape(input.shape(), options, input.format());
+    checkPool2d(g, gradOutput);
+    if (gradInput.shape() != input.shape() || gradInput.format() != input.format()) {
+        throw std::invalid_argument("Input gradient must have the shape and memory format of the input.");
+    }
+    NN_PROFILE_SCOPE(Reduction, "maxPool2d backward", static_cast<double>((2 * input.size() + gradOutput.size()) * sizeof(T)), static_cast<double>(gradOutput.size() * g.kernelH * g.kernelW));
+    forEachPlane(g, [&](std::size_t plane) {
+        const T* in = input.data() + plane * g.inputPlane();
+        const T* dy = gradOutput.data() + plane * g.outputPlane();
+        T* dx = gradInput.data() + plane * g.inputPlane();
+        std::fill(dx, dx + g.inputPlane(), T(0));
+        // Offset of the max so far of each lane.
+        std::vector<std::size_t> best(g.lanes);
+        for (std::size_t p = 0; p < g.p; p++) {
+            for (std::size_t q = 0; q < g.q; q++) {
+                const Window win = window(g, p, q);
+                std::fill(best.begin(), best.end(), (win.h0 * g.w + win.w0) * g.lanes);
+                for (std::size_t ih = win.h0; ih < win.h1; ih++) {
+                    for (std::size_t iw = win.w0; iw < win.w1; iw++) {
+                        const std::size_t offset = (ih * g.w + iw) * g.lanes;
+                        for (std::size_t l = 0; l < g.lanes; l++) {
+                            if (in[offset + l] > in[best[l] + l]) {
+                                best[l] = offset;
+                            }
+                        }
+                    }
+                }
+                const T* d = dy + (p * g.q + q) * g.lanes;
+                for (std::size_t l = 0; l < g.lanes; l++) {
+                    dx[best[l] + l] += d[l];
+                }
+            }
+        }
+    });
+}
+
+template<typename T>
+void avgPool2dBackward(const NDArray<T>& gradOutput, NDArray<T>& gradInput, const Pool2dOptions& options) {
+    const PoolShape g = poolShape(gradInput.shape(), options, gradInput.format());
+    checkPool2d(g, gradOutput);
+    NN_PROFILE_SCOPE(Reduction, "avgPool2d backward", static_cast<double>((gradInput.size() + gradOutput.size()) * sizeof(T)), static_cast<double>(gradOutput.size() * g.kernelH * g.kernelW));
+    forEachPlane(g, [&](std::size_t plane) {
+        const T* dy = gradOutput.data() + plane * g.outputPlane();
+        T* dx = gradInput.data() + plane * g.inputPlane();
+        std::fill(dx, dx + g.inputPlane(), T(0));
+        for (std::size_t p = 0; p < g.p; p++) {
+            for (std::size_t q = 0; q < g.q; q++) {
+                const Window win = window(g, p, q);
+                const T scale = T(1) / static_cast<T>(win.count());
+                const T* d = dy + (p * g.q + q) * g.lanes;
+                for (std::size_t ih = win.h0; ih < win.h1; ih++) {
+                    for (std::size_t iw = win.w0; iw < win.w1; iw++) {
+                        T* x = dx + (ih * g.w + iw) * g.lanes;
+                        for (std::size_t l = 0; l < g.lanes; l++) {
+                            x[l] += d[l] * scale;
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+// Instantiations
+
+#define INSTANTIATE_POOLING(T) \
+    template void maxPool2d<T>(const NDArray<T>&, NDArray<T>&, const Pool2dOptions&); \
+    template NDArray<T> maxPool2d<T>(const NDArray<T>&, const Pool2dOptions&); \
+    template void avgPool2d<T>(const NDArray<T>&, NDArray<T>&, const Pool2dOptions&); \
+    template NDArray<T> avgPool2d<T>(const NDArray<T>&, const Pool2dOptions&); \
+    template void maxPool2dBackward<T>(const NDArray<T>&, const NDArray<T>&, NDArray<T>&, const Pool2dOptions&); \
+    template void avgPool2dBackward<T>(const NDArray<T>&, NDArray<T>&, const Pool2dOptions&);
+
+INSTANTIATE_POOLING(float)
+INSTANTIATE_POOLING(double)
+
+}
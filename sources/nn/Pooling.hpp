@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "ndarray/NDArray.hpp"
+#include "nn/Layout.hpp"
+
+namespace nn {
+
+// Windows that overhang the padding only cover their valid elements: padding
+// never wins a max and is not counted in an average.
+//
+// Besides row-major arrays in either layout, pooling takes NCHW arrays in the
+// channels-last and channels-blocked memory formats, and returns its results
+// in the format of its input.
+struct Pool2dOptions {
+    std::size_t kernelH = 2;
+    std::size_t kernelW = 2;
+    std::size_t strideH = 2;
+    std::size_t strideW = 2;
+    std::size_t padH = 0;
+    std::size_t padW = 0;
+    Layout layout = Layout::NCHW;
+};
+
+std::vector<std::size_t> pool2dOutputShape(const std::vector<std::size_t>& input, const Pool2dOptions& options);
+
+// Memory format pooling runs fastest in: channels-blocked for NCHW, whose
+// windows are then reduced 16 channels at a time.
+MemoryFormat pool2dPreferredFormat(const Pool2dOptions& options = Pool2dOptions());
+
+// output must have the shape given by pool2dOutputShape().
+template<typename T>
+void maxPool2d(const NDArray<T>& input, NDArray<T>& output, const Pool2dOptions& options = Pool2dOptions());
+template<typename T>
+NDArray<T> maxPool2d(const NDArray<T>& input, const Pool2dOptions& options = Pool2dOptions());
+template<typename T>
+void avgPool2d(const NDArray<T>& input, NDArray<T>& output, const Pool2dOptions& options = Pool2dOptions());
+template<typename T>
+NDArray<T> avgPool2d(const NDArray<T>& input, const Pool2dOptions& options = Pool2dOptions());
+
+// Gradients with respect to the input, overwritten. The max of each window is
+// found again from the input; ties go to its first element.
+template<typename T>
+void maxPool2dBackward(const NDArray<T>& input, const NDArray<T>& gradOutput, NDArray<T>& gradInput, const Pool2dOptions& options = Pool2dOptions());
+template<typename T>
+void avgPool2dBackward(const NDArray<T>& gradOutput, NDArray<T>& gradInput, const Pool2dOptions& options = Pool2dOptions());
+
+}
@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "nn/Softmax.hpp"
+#include "parallel/ThreadPool.hpp"
+#include "profile/Profiler.hpp"
+#include "simd/Simd.hpp"
+
+// Every operand is seen as rows x cols elements with row i at
+// data + i * stride: the rows of a Matrix, or the last axis of a row-major
+// NDArray.
+template<typename T>
+struct Rows {
+    T* data;
+    std::size_t rows, cols, stride;
+
+    T* row(std::size_t i) const { return data + i * stride; }
+};
+
+template<typename T>
+static Rows<const T> rowsOf(const BasicMatrix<T>& m) {
+    return {m.data(), m.nbRows(), m.nbCols(), m.rowStride()};
+}
+
+template<typename T>
+static Rows<T> rowsOf(BasicMatrix<T>& m) {
+    return {m.data(), m.nbRows(), m.nbCols(), m.rowStride()};
+}
+
+template<typename T>
+static Rows<const T> rowsOf(const NDArray<T>& a) {
+    if (a.dim() == 0) {
+        throw std::invalid_argument("Softmax needs an array with at least one axis.");
+    }
+    if (a.format() != MemoryFormat::RowMajor) {
+        throw std::invalid_argument("Softmax takes row-major arrays.");
+    }
+    const std::size_t cols = a.shape().back();
+    std::size_t rows = 1;
+    for (std::size_t i = 0; i + 1 < a.dim(); i++) {
+        rows *= a.shape()[i];
+    }
+    return {a.data(), rows, cols, cols};
+}
+
+template<typename T>
+static Rows<T> rowsOf(NDArray<T>& a) {
+    const Rows<const T> rows = rowsOf(static_cast<const NDArray<T>&>(a));
+    return {a.data(), rows.rows, rows.cols, rows.stride};
+}
+
+template<typename T>
+static void checkSameDims(const BasicMatrix<T>& a, const BasicMatrix<T>& b) {
+    if (a.size() != b.size()) {
+        throw std::invalid_argument("Softmax operands do not have the same dimensions.");
+    }
+}
+
+template<typename T>
+static void checkSameDims(const NDArray<T>& a, const NDArray<T>& b) {
+    if (a.shape() != b.shape()) {
+        throw std::invalid_argument("Softmax operands do not have the same shape.");
+    }
+}
+
+template<typename T>
+static void checkLabels(const Rows<const T>& x, const std::vector<std::size_t>& labels) {
+    if (labels.size() != x.rows) {
+        throw std::invalid_argument("Cross-entropy needs one label per row.");
+    }
+    for (std::size_t label : labels) {
+        if (label >= x.cols) {
+            throw std::invalid_argument("Cross-entropy label out of range.");
+        }
+    }
+}
+
+// Calls fn(i) for every row, split over the pool.
+template<typename F>
+static void forEachRow(std::size_t rows, std::size_t cols, const F& fn) {
+    parallelFor(0, rows, std::max<std::size_t>(1, parallelGrain / std::max<std::size_t>(1, cols)), [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) {
+            fn(i);
+        }
+    });
+}
+
+template<typename T>
+static void softmaxRows(const Rows<const T>& x, const Rows<T>& out, bool log) {
+    NN_PROFILE_SCOPE(Elementwise, log ? "logSoftmax" : "softmax", 3.0 * static_cast<double>(x.rows * x.cols * sizeof(T)), 3.0 * static_cast<double>(x.rows * x.cols));
+    const simd::BasicKernels<T>& kernels = simd::kernels<T>();
+    forEachRow(x.rows, x.cols, [&](std::size_t i) {
+        T max;
+        const T sum = kernels.sumExp(x.row(i), x.cols, &max);
+        if (log) {
+            kernels.subScalars(x.row(i), max, std::log(sum), out.row(i), x.cols);
+        } else {
+            kernels.exp(x.row(i), max, T(1) / sum, out.row(i), x.cols);
+        }
+    });
+}
+
+template<typename T>
+static void softmaxBackwardRows(const Rows<const T>& y, const Rows<const T>& gradY, const Rows<T>& gradX, bool log) {
+    NN_PROFILE_SCOPE(Elementwise, log ? "logSoftmax backward" : "softmax backward", 3.0 * static_cast<double>(y.rows * y.cols * sizeof(T)), 4.0 * static_cast<double>(y.rows * y.cols));
+    const simd::BasicKernels<T>& kernels = simd::kernels<T>();
+    forEachRow(y.rows, y.cols, [&](std::size_t i) {
+        const T* yi = y.row(i);
+        const T* gy = gradY.row(i);
+        T* gx = gradX.row(i);
+        if (log) {
+            kernels.exp(yi, T(0), -kernels.sum(gy, y.cols), gx, y.cols);
+            kernels.add(gx, gy, gx, y.cols);
+        } else {
+            kernels.subScalar(gy, kernels.dot(gy, yi, y.cols), gx, y.cols);
+            kernels.mul(gx, yi, gx, y.cols);
+        }
+    });
+}
+
+// Sum of the losses of the rows, and their gradients when gradient is set.
+template<typename T>
+static T crossEntropyRows(const Rows<const T>& x, const std::vector<std::size_t>& labels, const Rows<T>* gradient) {
+    checkLabels(x, labels);
+    if (x.rows == 0) {
+        return T(0);
+    }
+    NN_PROFILE_SCOPE(Elementwise, "softmaxCrossEntropy", ((gradient != nullptr) ? 2.0 : 1.0) * static_cast<double>(x.rows * x.cols * sizeof(T)), 3.0 * static_cast<double>(x.rows * x.cols));
+    const simd::BasicKernels<T>& kernels = simd::kernels<T>();
+    const T scale = T(1) / static_cast<T>(x.rows);
+    const std::size_t grain = std::max<std::size_t>(1, parallelGrain / std::max<std::size_t>(1, x.cols));
+    const T total = parallelReduce(
+        0, x.rows, grain, T(0),
+        [&](std::size_t first, std::size_t last) {
+            T sum = T(0);
+            for (std::size_t i = first; i < last; i++) {
+                const T* xi = x.row(i);
+                T max;
+                const T sumExp = kernels.sumExp(xi, x.cols, &max);
+                sum += std::log(sumExp) - (xi[labels[i]] - max);
+                if (gradient != nullptr) {
+                    T* g = gradient->row(i);
+                    kernels.exp(xi, max, scale / sumExp, g, x.cols);
+                    g[labels[i]] -= scale;
+                }
+            }
+            return sum;
+        },
+        [](T a, T b) { return a + b; }
+    );
+    return total * scale;
+}
+
+namespace nn {
+
+template<typename T>
+void softmax(const BasicMatrix<T>& x, BasicMatrix<T>& out) {
+    checkSameDims(x, out);
+    softmaxRows(rowsOf(x), rowsOf(out), false);
+}
+
+template<typename T>
+BasicMatrix<T> softmax(const BasicMatrix<T>& x) {
+    BasicMatrix<T> out(x.nbRows(), x.nbCols());
+    softmax(x, out);
+    return out;
+}
+
+template<typename T>
+void softmax(const NDArray<T>& x, NDArray<T>& out) {
+    checkSameDims(x, out);
+    softmaxRows(rowsOf(x), rowsOf(out), false);
+}
+
+template<typename T>
+NDArray<T> softmax(const NDArray<T>& x) {
+    NDArray<T> out(x.shape(), MemoryFormat::RowMajor);
+    softmax(x, out);
+    return out;
+}
+
+template<typename T>
+void logSoftmax(const BasicMatrix<T>& x, BasicMatrix<T>& out) {
+    checkSameDims(x, out);
+    softmaxRows(rowsOf(x), rowsOf(out), true);
+}
+
+template<typename T>
+BasicMatrix<T> logSoftmax(const BasicMatrix<T>& x) {
+    BasicMatrix<T> out(x.nbRows(), x.nbCols());
+    logSoftmax(x, out);
+    return out;
+}
+
+template<typename T>
+void logSoftmax(const NDArray<T>& x, NDArray<T>& out) {
+    checkSameDims(x, out);
+    softmaxRows(rowsOf(x), rowsOf(out), true);
+}
+
+template<typename T>
+NDArray<T> logSoftmax(const NDArray<T>& x) {
+    NDArray<T> out(x.shape(), MemoryFormat::RowMajor);
+    logSoftmax(x, out);
+    return out;
+}
+
+template<typename T>
+void softmaxBackward(const BasicMatrix<T>& y, const BasicMatrix<T>& gradY, BasicMatrix<T>& gradX) {
+    checkSameDims(y, gradY);
+    checkSameDims(y, gradX);
+    softmaxBackwardRows(rowsOf(y), rowsOf(gradY), rowsOf(gradX), false);
+}
+
+template<typename T>
+void softmaxBackward(const NDArray<T>& y, const NDArray<T>& gradY, NDArray<T>& gradX) {
+    checkSameDims(y, gradY);
+    checkSameDims(y, gradX);
+    softmaxBackwardRows(rowsOf(y), rowsOf(gradY), rowsOf(gradX), false);
+}
+
+template<typename T>
+void logSoftmaxBackward(const BasicMatrix<T>& y, const BasicMatrix<T>& gradY, BasicMatrix<T>& gradX) {
+    checkSameDims(y, gradY);
+    checkSameDims(y, gradX);
+    softmaxBackwardRows(rowsOf(y), rowsOf(gradY), rowsOf(gradX), true);
+}
+
+template<typename T>
+void logSoftmaxBackward(const NDArray<T>& y, const NDArray<T>& gradY, NDArray<T>& gradX) {
+    checkSameDims(y, gradY);
+    checkSameDims(y, gradX);
+    softmaxBackwardRows(rowsOf(y), rowsOf(gradY), rowsOf(gradX), true);
+}
+
+template<typename T>
+T softmaxCrossEntropy(const BasicMatrix<T>& logits, const std::vector<std::size_t>& labels) {
+    return crossEntropyRows<T>(rowsOf(logits), labels, nullptr);
+}
+
+template<typename T>
+T softmaxCrossEntropy(const BasicMatrix<T>& logits, const std::vector<std::size_t>& labels, BasicMatrix<T>& gradient) {
+    checkSameDims(logits, gradient);
+    const Rows<T> g = rowsOf(gradient);
+    return crossEntropyRows<T>(rowsOf(logits), labels, &g);
+}
+
+template<typename T>
+T softmaxCrossEntropy(const NDArray<T>& logits, const std::vector<std::size_t>& labels) {
+    return crossEntropyRows<T>(rowsOf(logits), labels, nullptr);
+}
+
+template<typename T>
+T softmaxCrossEntropy(const NDArray<T>& logits, const std::vector<std::size_t>& labels, NDArray<T>& gradient) {
+    checkSameDims(logits, gradient);
+    const Rows<T> g = rowsOf(gradient);
+    return crossEntropyRows<T>(rowsOf(logits), labels, &g);
+}
+
+// Instantiations
+
+#define INSTANTIATE_SOFTMAX(T) \
+    template void softmax<T>(const BasicMatrix<T>&, BasicMatrix<T>&); \
+    template BasicMatrix<T> softmax<T>(const BasicMatrix<T>&); \
+    template void softmax<T>(const NDArray<T>&, NDArray<T>&); \
+    template NDArray<T> softmax<T>(const NDArray<T>&); \
+    template void logSoftmax<T>(const BasicMatrix<T>&, BasicMatrix<T>&); \
+    template BasicMatrix<T> logSoftmax<T>(const BasicMatrix<T>&); \
+    template void logSoftmax<T>(const NDArray<T>&, NDArray<T>&); \
+    template NDArray<T> logSoftmax<T>(const NDArray<T>&); \
+    template void softmaxBackward<T>(const BasicMatrix<T>&, const BasicMatrix<T>&, BasicMatrix<T>&); \
+    template void softmaxBackward<T>(const NDArray<T>&, const NDArray<T>&, NDArray<T>&); \
+    template void logSoftmaxBackward<T>(const BasicMatrix<T>&, const BasicMatrix<T>&, BasicMatrix<T>&); \
+    template void logSoftmaxBackward<T>(const NDArray<T>&, const NDArray<T>&, NDArray<T>&); \
+    template T softmaxCrossEntropy<T>(const BasicMatrix<T>&, const std::vector<std::size_t>&); \
+    template T softmaxCrossEntropy<T>(const BasicMatrix<T>&, const std::vector<std::size_t>&, BasicMatrix<T>&); \
+    template T softmaxCrossEntropy<T>(const NDArray<T>&, const std::vector<std::size_t>&); \
+    template T softmaxCrossEntropy<T>(const NDArray<T>&, const std::vector<std::size_t>&, NDArray<T>&);
+
+INSTANTIATE_SOFTMAX(float)
+INSTANTIATE_SOFTMAX(double)
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "matrix/Matrix.hpp"
+#include "ndarray/NDArray.hpp"
+
+namespace nn {
+
+// Softmax, log-softmax and the softmax cross-entropy loss over the rows of a
+// Matrix, or over the last axis of a row-major NDArray, one row at a time.
+// Each row is read twice: once for its maximum m and the sum s of
+// exp(x - m), both kept as running values in a single pass, then once to
+// write softmax(x) = exp(x - m) / s or log-softmax(x) = (x - m) - log(s).
+// Subtracting m keeps large logits from overflowing, and from losing
+// precision against a rounded log-sum-exp. Rows are spread over the thread
+// pool.
+//
+// The forward results may be written over their input; the gradients must
+// not alias any operand.
+
+template<typename T>
+void softmax(const BasicMatrix<T>& x, BasicMatrix<T>& out);
+template<typename T>
+BasicMatrix<T> softmax(const BasicMatrix<T>& x);
+template<typename T>
+void softmax(const NDArray<T>& x, NDArray<T>& out);
+template<typename T>
+NDArray<T> softmax(const NDArray<T>& x);
+
+template<typename T>
+void logSoftmax(const BasicMatrix<T>& x, BasicMatrix<T>& out);
+template<typename T>
+BasicMatrix<T> logSoftmax(const BasicMatrix<T>& x);
+template<typename T>
+void logSoftmax(const NDArray<T>& x, NDArray<T>& out);
+template<typename T>
+NDArray<T> logSoftmax(const NDArray<T>& x);
+
+// Gradients with respect to x from y = softmax(x) (or log-softmax(x)) and
+// the gradient of y: gradX = y * (gradY - dot(gradY, y)) for softmax, and
+// gradX = gradY - softmax(x) * sum(gradY) for log-softmax, per row.
+template<typename T>
+void softmaxBackward(const BasicMatrix<T>& y, const BasicMatrix<T>& gradY, BasicMatrix<T>& gradX);
+template<typename T>
+void softmaxBackward(const NDArray<T>& y, const NDArray<T>& gradY, NDArray<T>& gradX);
+template<typename T>
+void logSoftmaxBackward(const BasicMatrix<T>& y, const BasicMatrix<T>& gradY, BasicMatrix<T>& gradX);
+template<typename T>
+void logSoftmaxBackward(const NDArray<T>& y, const NDArray<T>& gradY, NDArray<T>& gradX);
+
+// Mean over the rows of -log(softmax(logits)[label]), labels holding the
+// class of each row, computed as log(s) - (logits[label] - m) without
+// forming the probabilities. The overloads with gradient also write the
+// gradient of the loss with respect to the logits,
+// (softmax(logits) - onehot(label)) / rows, in the same second pass.
+template<typename T>
+T softmaxCrossEntropy(const BasicMatrix<T>& logits, const std::vector<std::size_t>& labels);
+template<typename T>
+T softmaxCrossEntropy(const BasicMatrix<T>& logits, const std::vector<std::size_t>& labels, BasicMatrix<T>& gradient);
+template<typename T>
+T softmaxCrossEntropy(const NDArray<T>& logits, const std::vector<std::size_t>& labels);
+template<typename T>
+T softmaxCrossEntropy(const NDArray<T>& logits, const std::vector<std::size_t>& labels, NDArray<T>& gradient);
+
+}
@@ -0,0 +1,204 @@
+#include <cstdlib>
+#include <string>
+
+#include "parallel/ThreadPool.hpp"
+
+// Set on pool workers, and on the caller while it runs a parallel loop, so
+// that nested loops run serially instead of waiting on the busy pool.
+static thread_local bool t_inParallelRegion = false;
+static thread_local std::size_t t_maxThreads = 0;
+
+static std::size_t defaultNbThreads() {
+    if (const char* env = std::getenv("NN_NUM_THREADS")) {
+        try {
+            const std::size_t n = std::stoul(env);
+            if (n > 0) {
+                return n;
+            }
+        } catch (const std::exception&) {
+        }
+    }
+    return std::max<std::size_t>(1, std::thread::hardware_concurrency());
+}
+
+// Constructors
+
+ThreadPool::ThreadPool(std::size_t nbThreads) :
+    m_workers(),
+    m_slots(),
+    m_job(nullptr),
+    m_generation(0),
+    m_active(0),
+    m_stop(false)
+{
+    start(nbThreads);
+}
+
+// Destructors
+
+ThreadPool::~ThreadPool() {
+    stop();
+}
+
+// Other members
+
+ThreadPool& ThreadPool::global() {
+    static ThreadPool pool(defaultNbThreads());
+    return pool;
+}
+
+std::size_t ThreadPool::nbThreads() const {
+    return m_workers.size() + 1;
+}
+
+void ThreadPool::setNbThreads(std::size_t nbThreads) {
+    std::lock_guard<std::mutex> submit(m_submitMutex);
+    stop();
+    start(nbThreads);
+}
+
+void ThreadPool::parallelFor(std::size_t begin, std::size_t end, std::size_t grain, RangeFunction fn, std::size_t maxThreads) {
+    if (end <= begin) {
+        return;
+    }
+    grain = std::max<std::size_t>(grain, 1);
+    std::unique_lock<std::mutex> submit(m_submitMutex, std::try_to_lock);
+    if (t_inParallelRegion || !submit.owns_lock() || m_workers.empty()) {
+        fn(begin, end);
+        return;
+    }
+
+    const std::size_t n = end - begin;
+    std::size_t nbSlots = std::min(nbThreads(), (n + grain - 1) / grain);
+    if (maxThreads > 0) {
+        nbSlots = std::min(nbSlots, maxThreads);
+    }
+    if (nbSlots <= 1) {
+        fn(begin, end);
+        return;
+    }
+    // Even split of the range, each piece ends on a grain boundary so the
+    // owner and the thieves consume whole grains.
+    const std::size_t grainsPerSlot = ((n + grain - 1) / grain + nbSlots - 1) / nbSlots;
+    for (std::size_t s = 0; s < nbSlots; s++) {
+        const std::size_t first = std::min(end, begin + s * grainsPerSlot * grain);
+        m_slots[s].next.store(first, std::memory_order_relaxed);
+        m_slots[s].end = std::min(end, first + grainsPerSlot * grain);
+    }
+
+    Job job{fn, grain, nbSlots, {1}, {}, {}};
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_generation++;
+    }
+    m_wakeCv.notify_all();
+
+    t_inParallelRegion = true;
+    work(job, 0);
+    t_inParallelRegion = false;
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_job = nullptr;
+        m_doneCv.wait(lock, [this]() { return m_active == 0; });
+    }
+    if (job.error) {
+        std::rethrow_exception(job.error);
+    }
+}
+
+void ThreadPool::start(std::size_t nbThreads) {
+    nbThreads = std::max<std::size_t>(nbThreads, 1);
+    m_stop = false;
+    m_slots.reset(new Slot[nbThreads]);
+    for (std::size_t i = 1; i < nbThreads; i++) {
+        m_workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+void ThreadPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wakeCv.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+    m_workers.clear();
+}
+
+void ThreadPool::workerLoop() {
+    t_inParallelRegion = true;
+    std::size_t seen = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    seen = m_generation;
+    while (true) {
+        m_wakeCv.wait(lock, [&]() { return m_stop || m_generation != seen; });
+        if (m_stop) {
+            return;
+        }
+        seen = m_generation;
+        Job* job = m_job;
+        if (job == nullptr) {
+            continue;
+        }
+        m_active++;
+        lock.unlock();
+        const std::size_t slot = job->joined.fetch_add(1);
+        if (slot < job->nbSlots) {
+            work(*job, slot);
+        }
+        lock.lock();
+        if (--m_active == 0) {
+            m_doneCv.notify_all();
+        }
+    }
+}
+
+void ThreadPool::work(Job& job, std::size_t slot) {
+    for (std::size_t i = 0; i < job.nbSlots; i++) {
+        Slot& victim = m_slots[(slot + i) % job.nbSlots];
+        while (true) {
+            const std::size_t first = victim.next.fetch_add(job.grain, std::memory_order_relaxed);
+            if (first >= victim.end) {
+                break;
+            }
+            try {
+                job.fn(first, std::min(victim.end, first + job.grain));
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(job.errorMutex);
+                if (!job.error) {
+                    job.error = std::current_exception();
+                }
+            }
+        }
+    }
+}
+
+// ScopedNbThreads
+
+ScopedNbThreads::ScopedNbThreads(std::size_t nbThreads) :
+    m_previous(t_maxThreads)
+{
+    t_maxThreads = nbThreads;
+}
+
+ScopedNbThreads::~ScopedNbThreads() {
+    t_maxThreads = m_previous;
+}
+
+// Functions
+
+std::size_t nbThreads() {
+    return ThreadPool::global().nbThreads();
+}
+
+void setNbThreads(std::size_t nbThreads) {
+    ThreadPool::global().setNbThreads(nbThreads);
+}
+
+std::size_t maxThreadsLimit() {
+    return t_maxThreads;
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Below this many elements an elementwise operation stays on the calling
+// thread, the wake-up cost of the pool would dominate.
+constexpr std::size_t parallelGrain = 1 << 15;
+
+// Non-owning reference to a callable invoked on [begin, end) ranges. It only
+// stores two pointers, so handing work to the pool never allocates.
+class RangeFunction {
+
+private:
+
+    const void* m_object;
+    void (*m_call)(const void*, std::size_t, std::size_t);
+
+public:
+
+    // Constructors
+    template<typename F>
+    RangeFunction(const F& f) :
+        m_object(&f),
+        m_call([](const void* object, std::size_t begin, std::size_t end) {
+            (*static_cast<const F*>(object))(begin, end);
+        })
+    {}
+
+    // Operators
+    void operator()(std::size_t begin, std::size_t end) const {
+        m_call(m_object, begin, end);
+    }
+
+};
+
+// Work-stealing pool. A parallel loop is cut into one contiguous range per
+// participating thread; each thread consumes its own range grain by grain
+// and, once it runs dry, steals grains from the ranges of the others. The
+// calling thread takes part in the work.
+class ThreadPool {
+
+private:
+
+    struct alignas(64) Slot {
+        std::atomic<std::size_t> next;
+        std::size_t end;
+    };
+
+    struct Job {
+        RangeFunction fn;
+        std::size_t grain;
+        std::size_t nbSlots;
+        std::atomic<std::size_t> joined;
+        std::mutex errorMutex;
+        std::exception_ptr error;
+    };
+
+    std::vector<std::thread> m_workers;
+    std::unique_ptr<Slot[]> m_slots;
+    std::mutex m_submitMutex;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeCv;
+    std::condition_variable m_doneCv;
+    Job* m_job;
+    std::size_t m_generation;
+    std::size_t m_active;
+    bool m_stop;
+
+    void start(std::size_t nbThreads);
+    void stop();
+    void workerLoop();
+    void work(Job& job, std::size_t slot);
+
+public:
+
+    // Constructors
+    explicit ThreadPool(std::size_t nbThreads);
+    ThreadPool(const ThreadPool& other) = delete;
+
+    // Destructors
+    ~ThreadPool();
+
+    // Operators
+    ThreadPool& operator=(const ThreadPool& other) = delete;
+
+    // Other members
+    static ThreadPool& global();
+    std::size_t nbThreads() const;
+    void setNbThreads(std::size_t nbThreads);
+    // Runs fn over [begin, end) in grains of at least grain elements on at
+    // most maxThreads threads (0 means all of them), and returns once every
+    // grain is done. The first exception thrown by fn is rethrown here.
+    // Calls made from inside a parallel region, or while another thread
+    // owns the pool, run serially.
+    void parallelFor(std::size_t begin, std::size_t end, std::size_t grain, RangeFunction fn, std::size_t maxThreads = 0);
+
+};
+
+// Restricts the parallel loops started by the current thread to at most
+// nbThreads threads while it is alive, e.g. to pin one model per core group.
+class ScopedNbThreads {
+
+private:
+
+    std::size_t m_previous;
+
+public:
+
+    // Constructors
+    explicit ScopedNbThreads(std::size_t nbThreads);
+    ScopedNbThreads(const ScopedNbThreads& other) = delete;
+
+    // Destructors
+    ~ScopedNbThreads();
+
+    // Operators
+    ScopedNbThreads& operator=(const ScopedNbThreads& other) = delete;
+
+};
+
+// Functions
+
+// Number of threads of the global pool, including the calling thread. It is
+// read from NN_NUM_THREADS, or std::thread::hardware_concurrency() when unset.
+std::size_t nbThreads();
+void setNbThreads(std::size_t nbThreads);
+// Limit set by the innermost ScopedNbThreads of the current thread, 0 if none.
+std::size_t maxThreadsLimit();
+
+template<typename F>
+void parallelFor(std::size_t begin, std::size_t end, std::size_t grain, const F& fn) {
+    if (end <= begin) {
+        return;
+    }
+    if (end - begin <= grain || nbThreads() == 1 || maxThreadsLimit() == 1) {
+        fn(begin, end);
+        return;
+    }
+    ThreadPool::global().parallelFor(begin, end, grain, RangeFunction(fn), maxThreadsLimit());
+}
+
+// Reduces [begin, end) by combining map(b, e) over consecutive chunks. The
+// chunking only depends on the range and grain, never on the number of
+// threads, so results are reproducible from one machine to another.
+template<typename T, typename Map, typename Combine>
+T parallelReduce(std::size_t begin, std::size_t end, std::size_t grain, T init, const Map& map, const Combine& combine) {
+    constexpr std::size_t maxChunks = 64;
+    if (end <= begin) {
+        return init;
+    }
+    const std::size_t n = end - begin;
+    const std::size_t chunk = std::max(grain, (n + maxChunks - 1) / maxChunks);
+    const std::size_t nbChunks = (n + chunk - 1) / chunk;
+    if (nbChunks == 1) {
+        return combine(init, map(begin, end));
+    }
+    T partials[maxChunks];
+    parallelFor(0, nbChunks, 1, [&](std::size_t first, std::size_t last) {
+        for (std::size_t c = first; c < last; c++) {
+            partials[c] = map(begin + c * chunk, std::min(end, begin + (c + 1) * chunk));
+        }
+    });
+    // Partials are combined as a balanced tree, which keeps the rounding
+    // error of sums logarithmic in the number of chunks.
+    for (std::size_t width = 1; width < nbChunks; width *= 2) {
+        for (std::size_t c = 0; c + width < nbChunks; c += 2 * width) {
+            partials[c] = combine(partials[c], partials[c + width]);
+        }
+    }
+    return combine(init, partials[0]);
+}
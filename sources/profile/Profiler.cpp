@@ -0,0 +1,329 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "profile/Profiler.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+static const char* const allocationName = "memory::allocate";
+
+// Counters and events of one thread. Its mutex is only contended while
+// another thread reads or resets them.
+struct ThreadRecorder {
+    std::mutex mutex;
+    std::uint32_t thread;
+    std::unordered_map<const char*, profile::OpStats> stats;
+    std::vector<profile::TraceEvent> events;
+    std::size_t dropped = 0;
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadRecorder>> recorders;
+    std::atomic<bool> tracing{false};
+};
+
+// Never destroyed, so that threads still running at exit can record.
+static Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+static ThreadRecorder& localRecorder() {
+    thread_local std::shared_ptr<ThreadRecorder> recorder = [] {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        auto result = std::make_shared<ThreadRecorder>();
+        result->thread = static_cast<std::uint32_t>(r.recorders.size());
+        r.recorders.push_back(result);
+        return result;
+    }();
+    return *recorder;
+}
+
+static thread_local profile::Scope* t_currentScope = nullptr;
+
+static std::int64_t nowNs() {
+    static const Clock::time_point epoch = Clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch).count();
+}
+
+static profile::OpStats& statsOf(ThreadRecorder& recorder, const char* name, profile::Category category) {
+    auto it = recorder.stats.find(name);
+    if (it == recorder.stats.end()) {
+        it = recorder.stats.emplace(name, profile::OpStats{
+            name, category, 0, 0, std::numeric_limits<double>::infinity(), 0, 0, 0, 0, 0
+        }).first;
+    }
+    return it->second;
+}
+
+static void merge(profile::OpStats& into, const profile::OpStats& other) {
+    into.calls += other.calls;
+    into.totalNs += other.totalNs;
+    into.minNs = std::min(into.minNs, other.minNs);
+    into.maxNs = std::max(into.maxNs, other.maxNs);
+    into.bytes += other.bytes;
+    into.flops += other.flops;
+    into.allocations += other.allocations;
+    into.allocatedBytes += other.allocatedBytes;
+}
+
+static std::string jsonString(const char* text) {
+    std::string result = "\"";
+    for (; *text != '\0'; text++) {
+        if (*text == '"' || *text == '\\') {
+            result += '\\';
+        }
+        result += *text;
+    }
+    return result + "\"";
+}
+
+namespace profile {
+
+const char* categoryName(Category category) {
+    switch (category) {
+        case Category::Dot: return "dot";
+        case Category::Transpose: return "transpose";
+        case Category::Elementwise: return "elementwise";
+        case Category::Reduction: return "reduction";
+        case Category::Reshape: return "reshape";
+        case Category::Allocation: return "allocation";
+        case Category::Conversion: return "conversion";
+        case Category::Io: return "io";
+    }
+    return "unknown";
+}
+
+double OpStats::averageNs() const {
+    return (calls == 0) ? 0 : totalNs / static_cast<double>(calls);
+}
+
+// Scope
+
+Scope::Scope(Category category, const char* name, double bytes, double flops) :
+    m_name(name), m_category(category), m_bytes(bytes), m_flops(flops),
+    m_start(nowNs()), m_allocations(0), m_allocatedBytes(0), m_parent(t_currentScope)
+{
+    t_currentScope = this;
+}
+
+Scope::~Scope() {
+    const std::int64_t duration = nowNs() - m_start;
+    t_currentScope = m_parent;
+    if (m_parent != nullptr) {
+        m_parent->m_allocations += m_allocations;
+        m_parent->m_allocatedBytes += m_allocatedBytes;
+    }
+    ThreadRecorder& recorder = localRecorder();
+    std::lock_guard<std::mutex> lock(recorder.mutex);
+    OpStats& s = statsOf(recorder, m_name, m_category);
+    const double ns = static_cast<double>(duration);
+    s.calls++;
+    s.totalNs += ns;
+    s.minNs = std::min(s.minNs, ns);
+    s.maxNs = std::max(s.maxNs, ns);
+    s.bytes += m_bytes;
+    s.flops += m_flops;
+    s.allocations += m_allocations;
+    s.allocatedBytes += m_allocatedBytes;
+    if (registry().tracing.load(std::memory_order_relaxed)) {
+        if (recorder.events.size() < maxTraceEvents) {
+            recorder.events.push_back(TraceEvent{m_name, m_category, m_start, duration, recorder.thread, m_bytes, m_flops});
+        } else {
+            recorder.dropped++;
+        }
+    }
+}
+
+void Scope::addAllocation(std::size_t bytes) {
+    m_allocations++;
+    m_allocatedBytes += bytes;
+}
+
+// Functions
+
+bool isEnabled() {
+#ifdef NN_ENABLE_PROFILING
+    return true;
+#else
+    return false;
+#endif
+}
+
+void recordAllocation(std::size_t bytes) {
+    if (t_currentScope != nullptr) {
+        t_currentScope->addAllocation(bytes);
+    }
+    ThreadRecorder& recorder = localRecorder();
+    std::lock_guard<std::mutex> lock(recorder.mutex);
+    OpStats& s = statsOf(recorder, allocationName, Category::Allocation);
+    s.calls++;
+    s.minNs = 0;
+    s.bytes += static_cast<double>(bytes);
+    s.allocations++;
+    s.allocatedBytes += bytes;
+}
+
+void setTracing(bool enabled) {
+    registry().tracing.store(enabled, std::memory_order_relaxed);
+}
+
+bool isTracing() {
+    return registry().tracing.load(std::memory_order_relaxed);
+}
+
+std::vector<OpStats> stats() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> registryLock(r.mutex);
+    std::unordered_map<std::string, OpStats> merged;
+    for (const std::shared_ptr<ThreadRecorder>& recorder : r.recorders) {
+        std::lock_guard<std::mutex> lock(recorder->mutex);
+        for (const auto& [name, s] : recorder->stats) {
+            const auto [it, inserted] = merged.emplace(s.name, s);
+            if (!inserted) {
+                merge(it->second, s);
+            }
+        }
+    }
+    std::vector<OpStats> result;
+    result.reserve(merged.size());
+    for (auto& [name, s] : merged) {
+        result.push_back(std::move(s));
+    }
+    std::sort(result.begin(), result.end(), [](const OpStats& a, const OpStats& b) {
+        return (a.totalNs != b.totalNs) ? a.totalNs > b.totalNs : a.name < b.name;
+    });
+    return result;
+}
+
+std::vector<TraceEvent> events() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> registryLock(r.mutex);
+    std::vector<TraceEvent> result;
+    for (const std::shared_ptr<ThreadRecorder>& recorder : r.recorders) {
+        std::lock_guard<std::mutex> lock(recorder->mutex);
+        result.insert(result.end(), recorder->events.begin(), recorder->events.end());
+    }
+    std::stable_sort(result.begin(), result.end(), [](const TraceEvent& a, const TraceEvent& b) {
+        return a.startNs < b.startNs;
+    });
+    return result;
+}
+
+std::size_t droppedEvents() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> registryLock(r.mutex);
+    std::size_t result = 0;
+    for (const std::shared_ptr<ThreadRecorder>& recorder : r.recorders) {
+        std::lock_guard<std::mutex> lock(recorder->mutex);
+        result += recorder->dropped;
+    }
+    return result;
+}
+
+void reset() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> registryLock(r.mutex);
+    for (const std::shared_ptr<ThreadRecorder>& recorder : r.recorders) {
+        std::lock_guard<std::mutex> lock(recorder->mutex);
+        recorder->stats.clear();
+        recorder->events.clear();
+        recorder->dropped = 0;
+    }
+}
+
+void printSummary(std::ostream& os) {
+    if (!isEnabled()) {
+        os << "Profiling is disabled, build with NN_ENABLE_PROFILING.\n";
+        return;
+    }
+    const std::vector<OpStats> all = stats();
+    char line[256];
+    std::snprintf(
+        line, sizeof(line), "%-28s %-12s %10s %12s %10s %10s %10s %9s %9s %9s %10s\n",
+        "Operation", "Category", "Calls", "Total (ms)", "Avg (us)", "Min (us)", "Max (us)", "GB/s", "GFLOP/s", "Allocs", "Alloc (MB)"
+    );
+    os << line;
+    struct Totals {
+        std::uint64_t calls = 0;
+        double totalNs = 0;
+        double bytes = 0;
+        double flops = 0;
+        std::uint64_t allocations = 0;
+    };
+    Totals categories[nbCategories];
+    for (const OpStats& s : all) {
+        const bool timed = s.totalNs > 0;
+        std::snprintf(
+            line, sizeof(line), "%-28s %-12s %10llu %12.3f %10.3f %10.3f %10.3f %9.2f %9.2f %9llu %10.2f\n",
+            s.name.c_str(), categoryName(s.category), static_cast<unsigned long long>(s.calls), s.totalNs / 1e6,
+            s.averageNs() / 1e3, s.minNs / 1e3, s.maxNs / 1e3,
+            timed ? s.bytes / s.totalNs : 0.0, timed ? s.flops / s.totalNs : 0.0,
+            static_cast<unsigned long long>(s.allocations), static_cast<double>(s.allocatedBytes) / 1e6
+        );
+        os << line;
+        Totals& t = categories[static_cast<std::size_t>(s.category)];
+        t.calls += s.calls;
+        t.totalNs += s.totalNs;
+        t.bytes += s.bytes;
+        t.flops += s.flops;
+        t.allocations += s.allocations;
+    }
+    os << "\n";
+    std::snprintf(line, sizeof(line), "%-12s %10s %12s %12s %12s %9s\n", "Category", "Calls", "Total (ms)", "Bytes (MB)", "GFLOP", "Allocs");
+    os << line;
+    for (std::size_t c = 0; c < nbCategories; c++) {
+        const Totals& t = categories[c];
+        if (t.calls == 0) {
+            continue;
+        }
+        std::snprintf(
+            line, sizeof(line), "%-12s %10llu %12.3f %12.2f %12.3f %9llu\n",
+            categoryName(static_cast<Category>(c)), static_cast<unsigned long long>(t.calls), t.totalNs / 1e6,
+            t.bytes / 1e6, t.flops / 1e9, static_cast<unsigned long long>(t.allocations)
+        );
+        os << line;
+    }
+    const std::size_t dropped = droppedEvents();
+    if (dropped > 0) {
+        os << dropped << " trace events dropped.\n";
+    }
+}
+
+void writeChromeTrace(std::ostream& os) {
+    const std::vector<TraceEvent> all = events();
+    os << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    char numbers[160];
+    for (std::size_t i = 0; i < all.size(); i++) {
+        const TraceEvent& e = all[i];
+        std::snprintf(
+            numbers, sizeof(numbers),
+            ", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %u, \"args\": {\"bytes\": %.0f, \"flops\": %.0f}}",
+            static_cast<double>(e.startNs) / 1e3, static_cast<double>(e.durationNs) / 1e3, e.thread, e.bytes, e.flops
+        );
+        os << (i == 0 ? "\n" : ",\n")
+           << "{\"name\": " << jsonString(e.name) << ", \"cat\": " << jsonString(categoryName(e.category)) << numbers;
+    }
+    os << "\n]}\n";
+}
+
+void writeChromeTrace(const std::string& path) {
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error("Cannot open '" + path + "' for writing.");
+    }
+    writeChromeTrace(file);
+}
+
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Per-operation counters and a trace of the hot paths.
+//
+// The library's entry points (GEMM, GEMV, transposes, elementwise kernels,
+// reductions, reshapes, allocations) open an NN_PROFILE_SCOPE naming the
+// operation with the bytes it moves and the flops it performs. With
+// NN_ENABLE_PROFILING defined (the CMake option of the same name), each
+// scope adds its duration to the counters of its operation, and to a
+// timeline when tracing is on. Without it the macros expand to nothing and
+// their arguments are not evaluated, so a production build pays nothing.
+//
+// Counters are kept per thread and merged when read, so recording never
+// contends. Scopes measure inclusive time: an operation that calls another
+// one instrumented is counted in both.
+namespace profile {
+
+enum class Category {
+    Dot,
+    Transpose,
+    Elementwise,
+    Reduction,
+    Reshape,
+    Allocation,
+    Conversion,
+    Io
+};
+
+constexpr std::size_t nbCategories = 8;
+
+const char* categoryName(Category category);
+
+// Counters of one operation since the last reset().
+struct OpStats {
+    std::string name;
+    Category category;
+    std::uint64_t calls;
+    double totalNs;
+    double minNs;
+    double maxNs;
+    double bytes;
+    double flops;
+    // Allocations made while the operation was running, and their size.
+    std::uint64_t allocations;
+    std::uint64_t allocatedBytes;
+
+    double averageNs() const;
+};
+
+// Complete event of the timeline, in nanoseconds since the profiler started.
+struct TraceEvent {
+    const char* name;
+    Category category;
+    std::int64_t startNs;
+    std::int64_t durationNs;
+    std::uint32_t thread;
+    double bytes;
+    double flops;
+};
+
+// Events kept per thread; later ones are dropped and counted.
+constexpr std::size_t maxTraceEvents = std::size_t(1) << 20;
+
+// Times the enclosing block. name must be a string literal (or outlive the
+// profiler).
+class Scope {
+
+    const char* m_name;
+    Category m_category;
+    double m_bytes;
+    double m_flops;
+    std::int64_t m_start;
+    std::uint64_t m_allocations;
+    std::uint64_t m_allocatedBytes;
+    Scope* m_parent;
+
+public:
+
+    // Constructors
+    Scope(Category category, const char* name, double bytes = 0, double flops = 0);
+    Scope(const Scope& other) = delete;
+
+    // Destructor
+    ~Scope();
+
+    // Operators
+    Scope& operator=(const Scope& other) = delete;
+
+    // Other members
+    void addAllocation(std::size_t bytes);
+
+};
+
+// True when the library was built with NN_ENABLE_PROFILING.
+bool isEnabled();
+
+// Counts an allocation of bytes, against the allocation counters and the
+// innermost open scope of the calling thread.
+void recordAllocation(std::size_t bytes);
+
+// Timeline recording, off by default since it grows with every call.
+void setTracing(bool enabled);
+bool isTracing();
+
+// Merged counters of every thread, by decreasing total time.
+std::vector<OpStats> stats();
+// Events of every thread, by start time.
+std::vector<TraceEvent> events();
+std::size_t droppedEvents();
+void reset();
+
+// Table of the counters: per operation, then per category.
+void printSummary(std::ostream& os);
+// Chrome trace-event JSON, for chrome://tracing or Perfetto.
+void writeChromeTrace(std::ostream& os);
+void writeChromeTrace(const std::string& path);
+
+}
+
+#define NN_PROFILE_CONCAT_IMPL(a, b) a##b
+#define NN_PROFILE_CONCAT(a, b) NN_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef NN_ENABLE_PROFILING
+#define NN_PROFILE_SCOPE(category, name, bytes, flops) \
+    profile::Scope NN_PROFILE_CONCAT(profileScope, __LINE__)(profile::Category::category, name, bytes, flops)
+#define NN_PROFILE_ALLOCATION(bytes) profile::recordAllocation(bytes)
+#else
+#define NN_PROFILE_SCOPE(category, name, bytes, flops) static_cast<void>(0)
+#define NN_PROFILE_ALLOCATION(bytes) static_cast<void>(0)
+#endif
@@ -0,0 +1,292 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+#include "gemm/Gemm.hpp"
+#include "parallel/ThreadPool.hpp"
+#include "profile/Profiler.hpp"
+#include "quant/Quantize.hpp"
+
+// Flat storage seen as outer x channels x inner, channels running along the
+// quantization axis.
+struct ChannelLayout {
+    std::size_t outer;
+    std::size_t channels;
+    std::size_t inner;
+};
+
+static ChannelLayout channelLayout(const std::vector<std::size_t>& shape, std::size_t axis) {
+    const std::size_t size = std::accumulate(shape.begin(), shape.end(), std::size_t(1), std::multiplies<std::size_t>());
+    if (axis == quant::perTensor) {
+        return ChannelLayout{1, 1, size};
+    }
+    if (axis >= shape.size()) {
+        throw std::invalid_argument("Quantization axis out of range.");
+    }
+    ChannelLayout layout{1, shape[axis], 1};
+    for (std::size_t i = 0; i < axis; i++) {
+        layout.outer *= shape[i];
+    }
+    for (std::size_t i = axis + 1; i < shape.size(); i++) {
+        layout.inner *= shape[i];
+    }
+    return layout;
+}
+
+// Calls fn(first, last, channel) over the pool, for runs of the flat index
+// that share one channel.
+template<typename F>
+static void forEachRun(const ChannelLayout& layout, F fn) {
+    if (layout.channels == 1) {
+        parallelFor(0, layout.outer * layout.inner, parallelGrain, [&](std::size_t first, std::size_t last) {
+            fn(first, last, 0);
+        });
+        return;
+    }
+    const std::size_t grain = std::max<std::size_t>(1, parallelGrain / std::max<std::size_t>(1, layout.inner));
+    parallelFor(0, layout.outer * layout.channels, grain, [&](std::size_t first, std::size_t last) {
+        for (std::size_t run = first; run < last; run++) {
+            fn(run * layout.inner, (run + 1) * layout.inner, run % layout.channels);
+        }
+    });
+}
+
+static std::int8_t quantizeValue(float x, float inverseScale, std::int32_t zeroPoint) {
+    const long q = std::lrint(x * inverseScale) + zeroPoint;
+    return static_cast<std::int8_t>(std::clamp<long>(q, -128, 127));
+}
+
+template<typename T>
+static quant::QuantizedTensor quantizeData(const T* x, const std::vector<std::size_t>& shape, quant::Scheme scheme, std::size_t axis) {
+    NN_PROFILE_SCOPE(Conversion, "quantize", static_cast<double>(shape_size(shape) * (2 * sizeof(T) + 1)), 0);
+    const ChannelLayout layout = channelLayout(shape, axis);
+
+    // Range of every channel, always containing 0 so that 0 is exact.
+    std::vector<float> lo(layout.channels, 0.f);
+    std::vector<float> hi(layout.channels, 0.f);
+    for (std::size_t o = 0; o < layout.outer; o++) {
+        for (std::size_t c = 0; c < layout.channels; c++) {
+            const T* run = x + (o * layout.channels + c) * layout.inner;
+            for (std::size_t i = 0; i < layout.inner; i++) {
+                lo[c] = std::min(lo[c], static_cast<float>(run[i]));
+                hi[c] = std::max(hi[c], static_cast<float>(run[i]));
+            }
+        }
+    }
+
+    std::vector<float> scales(layout.channels);
+    std::vector<std::int32_t> zeroPoints(layout.channels);
+    for (std::size_t c = 0; c < layout.channels; c++) {
+        float scale;
+        std::int32_t zeroPoint;
+        if (scheme == quant::Scheme::Symmetric) {
+            scale = std::max(-lo[c], hi[c]) / 127.f;
+            zeroPoint = 0;
+        } else {
+            scale = (hi[c] - lo[c]) / 255.f;
+            zeroPoint = (scale > 0.f) ? static_cast<std::int32_t>(std::clamp<long>(std::lrint(-128.f - lo[c] / scale), -128, 127)) : 0;
+        }
+        scales[c] = (scale > 0.f && std::isfinite(scale)) ? scale : 1.f;
+        zeroPoints[c] = zeroPoint;
+    }
+
+    quant::QuantizedTensor q(shape, std::move(scales), std::move(zeroPoints), axis);
+    std::int8_t* out = q.data();
+    forEachRun(layout, [&](std::size_t first, std::size_t last, std::size_t c) {
+        const float inverseScale = 1.f / q.scale(c);
+        const std::int32_t zeroPoint = q.zeroPoint(c);
+        for (std::size_t i = first; i < last; i++) {
+            out[i] = quantizeValue(static_cast<float>(x[i]), inverseScale, zeroPoint);
+        }
+    });
+    return q;
+}
+
+template<typename T>
+static void dequantizeData(const quant::QuantizedTensor& q, T* out) {
+    NN_PROFILE_SCOPE(Conversion, "dequantize", static_cast<double>(q.size() * (1 + sizeof(T))), 0);
+    const std::int8_t* x = q.data();
+    forEachRun(channelLayout(q.shape(), q.axis()), [&](std::size_t first, std::size_t last, std::size_t c) {
+        const float scale = q.scale(c);
+        const std::int32_t zeroPoint = q.zeroPoint(c);
+        for (std::size_t i = first; i < last; i++) {
+            out[i] = static_cast<T>(scale * static_cast<float>(x[i] - zeroPoint));
+        }
+    });
+}
+
+namespace quant {
+
+// Constructors
+
+QuantizedTensor::QuantizedTensor() :
+    m_data(),
+    m_shape(),
+    m_scales(1, 1.f),
+    m_zeroPoints(1, 0),
+    m_axis(perTensor)
+{}
+
+QuantizedTensor::QuantizedTensor(
+    std::vector<std::size_t> shape,
+    std::vector<float> scales, std::vector<std::int32_t> zeroPoints,
+    std::size_t axis
+) :
+    m_data(),
+    m_shape(std::move(shape)),
+    m_scales(std::move(scales)),
+    m_zeroPoints(std::move(zeroPoints)),
+    m_axis(axis)
+{
+    const std::size_t channels = channelLayout(m_shape, m_axis).channels;
+    if (m_scales.size() != channels || m_zeroPoints.size() != channels) {
+        throw std::invalid_argument("Quantization parameters do not match the channels of the tensor.");
+    }
+    m_data.resize(std::accumulate(m_shape.begin(), m_shape.end(), std::size_t(1), std::multiplies<std::size_t>()));
+}
+
+// Other members
+
+std::size_t QuantizedTensor::dim() const {
+    return m_shape.size();
+}
+
+std::size_t QuantizedTensor::size() const {
+    return m_data.size();
+}
+
+const std::vector<std::size_t>& QuantizedTensor::shape() const {
+    return m_shape;
+}
+
+std::int8_t* QuantizedTensor::data() {
+    return m_data.data();
+}
+
+const std::int8_t* QuantizedTensor::data() const {
+    return m_data.data();
+}
+
+std::size_t QuantizedTensor::axis() const {
+    return m_axis;
+}
+
+bool QuantizedTensor::isPerTensor() const {
+    return m_axis == perTensor;
+}
+
+const std::vector<float>& QuantizedTensor::scales() const {
+    return m_scales;
+}
+
+const std::vector<std::int32_t>& QuantizedTensor::zeroPoints() const {
+    return m_zeroPoints;
+}
+
+float QuantizedTensor::scale(std::size_t c) const {
+    return isPerTensor() ? m_scales[0] : m_scales[c];
+}
+
+std::int32_t QuantizedTensor::zeroPoint(std::size_t c) const {
+    return isPerTensor() ? m_zeroPoints[0] : m_zeroPoints[c];
+}
+
+// Functions
+
+QuantizedTensor quantize(const NDArray<float>& a, Scheme scheme, std::size_t axis) {
+    if (a.format() != MemoryFormat::RowMajor) {
+        throw std::invalid_argument("Only row-major NDArrays can be quantized.");
+    }
+    return quantizeData(a.data(), a.shape(), scheme, axis);
+}
+
+template<typename T>
+QuantizedTensor quantize(const BasicMatrix<T>& m, Scheme scheme, std::size_t axis) {
+    return quantizeData(m.data(), {m.nbRows(), m.nbCols()}, scheme, axis);
+}
+
+NDArray<float> dequantize(const QuantizedTensor& q) {
+    NDArray<float> result(q.shape());
+    dequantizeData(q, result.data());
+    return result;
+}
+
+template<typename T>
+void dequantize(const QuantizedTensor& q, BasicMatrix<T>& out) {
+    if (q.dim() != 2 || out.nbRows() != q.shape()[0] || out.nbCols() != q.shape()[1]) {
+        throw std::invalid_argument("Matrix does not have the dimensions of the quantized tensor.");
+    }
+    dequantizeData(q, out.data());
+}
+
+void dot(const QuantizedTensor& a, const QuantizedTensor& b, FloatMatrix& out) {
+    if (a.dim() != 2 || b.dim() != 2 || a.shape()[1] != b.shape()[0]) {
+        throw std::invalid_argument("Quantized tensors do not have the right dimensions for dot product.");
+    }
+    if ((!a.isPerTensor() && a.axis() != 0) || (!b.isPerTensor() && b.axis() != 1)) {
+        throw std::invalid_argument("Quantized dot product needs per-row parameters for a and per-column ones for b.");
+    }
+    const std::size_t m = a.shape()[0];
+    const std::size_t k = a.shape()[1];
+    const std::size_t n = b.shape()[1];
+    if (out.nbRows() != m || out.nbCols() != n) {
+        throw std::invalid_argument("Matrix does not have the right dimensions for quantized dot product.");
+    }
+
+    std::vector<std::int32_t, AlignedAllocator<std::int32_t>> acc(m * n);
+    ::gemm(m, n, k, a.data(), k, 1, b.data(), n, 1, acc.data(), n, 1);
+
+    // sum_k (a - za)(b - zb) = sum_k a b - zb sum_k a - za sum_k b + k za zb
+    const bool zeroA = std::all_of(a.zeroPoints().begin(), a.zeroPoints().end(), [](std::int32_t z) { return z == 0; });
+    const bool zeroB = std::all_of(b.zeroPoints().begin(), b.zeroPoints().end(), [](std::int32_t z) { return z == 0; });
+    std::vector<std::int32_t> rowSums(zeroB ? 0 : m, 0);
+    std::vector<std::int32_t> colSums(zeroA ? 0 : n, 0);
+    for (std::size_t i = 0; i < rowSums.size(); i++) {
+        const std::int8_t* row = a.data() + i * k;
+        rowSums[i] = std::accumulate(row, row + k, std::int32_t(0));
+    }
+    for (std::size_t p = 0; p < k && !colSums.empty(); p++) {
+        const std::int8_t* row = b.data() + p * n;
+        for (std::size_t j = 0; j < n; j++) {
+            colSums[j] += row[j];
+        }
+    }
+
+    float* o = out.data();
+    const std::size_t rowGrain = std::max<std::size_t>(1, parallelGrain / std::max<std::size_t>(1, n));
+    parallelFor(0, m, rowGrain, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) {
+            const float sa = a.scale(i);
+            const std::int64_t za = a.zeroPoint(i);
+            const std::int64_t rowSum = zeroB ? 0 : rowSums[i];
+            for (std::size_t j = 0; j < n; j++) {
+                const std::int64_t zb = b.zeroPoint(j);
+                const std::int64_t colSum = zeroA ? 0 : colSums[j];
+                const std::int64_t exact = acc[i * n + j] - zb * rowSum - za * colSum + static_cast<std::int64_t>(k) * za * zb;
+                o[i * out.rowStride() + j] = sa * b.scale(j) * static_cast<float>(exact);
+            }
+        }
+    });
+}
+
+FloatMatrix dot(const QuantizedTensor& a, const QuantizedTensor& b) {
+    if (a.dim() != 2 || b.dim() != 2) {
+        throw std::invalid_argument("Quantized tensors do not have the right dimensions for dot product.");
+    }
+    FloatMatrix result(a.shape()[0], b.shape()[1]);
+    dot(a, b, result);
+    return result;
+}
+
+FloatMatrix dot(const FloatMatrix& x, const QuantizedTensor& w) {
+    return dot(quantize(x, Scheme::Asymmetric), w);
+}
+
+template QuantizedTensor quantize(const BasicMatrix<double>&, Scheme, std::size_t);
+template QuantizedTensor quantize(const BasicMatrix<float>&, Scheme, std::size_t);
+template void dequantize(const QuantizedTensor&, BasicMatrix<double>&);
+template void dequantize(const QuantizedTensor&, BasicMatrix<float>&);
+
+}
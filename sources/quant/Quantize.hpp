@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "matrix/Matrix.hpp"
+#include "memory/AlignedAllocator.hpp"
+#include "ndarray/NDArray.hpp"
+
+// Int8 quantized tensors for inference.
+//
+// An element q stands for scale * (q - zeroPoint). The scale and zero point
+// are either shared by the whole tensor or given per channel along one axis,
+// typically the output features of a weight matrix, whose ranges can differ
+// by orders of magnitude. Symmetric quantization maps [-max |x|, max |x|] to
+// [-127, 127] with a zero point of 0, which keeps the integer products free
+// of correction terms; asymmetric quantization maps [min, max] to
+// [-128, 127] and suits one-sided data such as activations after a ReLU.
+namespace quant {
+
+enum class Scheme {
+    Symmetric,
+    Asymmetric
+};
+
+// Channel axis of a tensor whose parameters are shared by every element.
+constexpr std::size_t perTensor = static_cast<std::size_t>(-1);
+
+class QuantizedTensor {
+
+public:
+
+    using Storage = std::vector<std::int8_t, AlignedAllocator<std::int8_t>>;
+
+private:
+
+    Storage m_data;
+    std::vector<std::size_t> m_shape;
+    std::vector<float> m_scales;
+    std::vector<std::int32_t> m_zeroPoints;
+    std::size_t m_axis;
+
+public:
+
+    // Constructors
+    QuantizedTensor();
+    // Zero-filled tensor. scales and zeroPoints hold one entry, or one per
+    // index along axis.
+    QuantizedTensor(
+        std::vector<std::size_t> shape,
+        std::vector<float> scales, std::vector<std::int32_t> zeroPoints,
+        std::size_t axis = perTensor
+    );
+
+    // Other members
+    std::size_t dim() const;
+    std::size_t size() const;
+    const std::vector<std::size_t>& shape() const;
+    std::int8_t* data();
+    const std::int8_t* data() const;
+    std::size_t axis() const;
+    bool isPerTensor() const;
+    const std::vector<float>& scales() const;
+    const std::vector<std::int32_t>& zeroPoints() const;
+    // Parameters of channel c, ignored for per-tensor parameters.
+    float scale(std::size_t c = 0) const;
+    std::int32_t zeroPoint(std::size_t c = 0) const;
+
+};
+
+// Functions
+QuantizedTensor quantize(const NDArray<float>& a, Scheme scheme = Scheme::Symmetric, std::size_t axis = perTensor);
+template<typename T>
+QuantizedTensor quantize(const BasicMatrix<T>& m, Scheme scheme = Scheme::Symmetric, std::size_t axis = perTensor);
+NDArray<float> dequantize(const QuantizedTensor& q);
+// q must be 2-D; out must already have its dimensions.
+template<typename T>
+void dequantize(const QuantizedTensor& q, BasicMatrix<T>& out);
+// out = dequantize(a) * dequantize(b) through the int8 GEMM, for a (m x k)
+// quantized per tensor or per row (axis 0) and b (k x n) per tensor or per
+// column (axis 1). Zero points are folded into the int32 result with the
+// row sums of a and the column sums of b.
+void dot(const QuantizedTensor& a, const QuantizedTensor& b, FloatMatrix& out);
+FloatMatrix dot(const QuantizedTensor& a, const QuantizedTensor& b);
+// Dynamic quantization: x is quantized per tensor, asymmetrically, on each
+// call, and multiplied by the int8 weights w.
+FloatMatrix dot(const FloatMatrix& x, const QuantizedTensor& w);
+
+}
@@ -0,0 +1,405 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+#include "half/Half.hpp"
+#include "memory/AlignedAllocator.hpp"
+#include "parallel/ThreadPool.hpp"
+#include "simd/Simd.hpp"
+
+// Reductions of contiguous runs and of one axis of strided arrays, shared by
+// NDArray, Matrix and Vector.
+//
+// Sums (and the sums behind means, norms and variances) are computed
+// pairwise at every level: the SIMD kernels add leaves of simd::sumLeaf
+// elements pairwise within blocks of reduceBlock elements, and the block
+// results are added pairwise, so the rounding error grows with the
+// logarithm of the length rather than with the length, on every
+// instruction set. Blocks are spread over the thread pool, and their
+// boundaries only depend on the length, so results do not depend on the
+// number of threads.
+//
+// An axis is reduced either along contiguous runs (the last axis), one run
+// per output element, or across them: whole rows of the inner axes are then
+// combined elementwise by the SIMD kernels, pairwise over the reduced axis,
+// in column blocks that keep the accumulators in L1.
+//
+// Elements of 16-bit types are accumulated in float.
+
+enum class Reduction {
+    Sum,
+    Mean,
+    Max,
+    Min,
+    // Euclidean norm, without rescaling against overflow.
+    Norm,
+    // Population variance (divided by n), from the deviations to the mean.
+    Variance
+};
+
+// Elements per block of the blockwise sums.
+constexpr std::size_t reduceBlock = 4096;
+
+// Rows accumulated directly before being combined pairwise, and inner
+// elements per column block, when reducing across contiguous runs.
+constexpr std::size_t reducePairwiseRows = 32;
+constexpr std::size_t reduceColumnBlock = 1024;
+
+inline const char* reductionName(Reduction op) {
+    switch (op) {
+        case Reduction::Sum: return "sum";
+        case Reduction::Mean: return "mean";
+        case Reduction::Max: return "max";
+        case Reduction::Min: return "min";
+        case Reduction::Norm: return "norm";
+        case Reduction::Variance: return "variance";
+    }
+    return "unknown";
+}
+
+// p[0] + ... + p[m - 1] (m > 0) added as a balanced tree, overwriting p.
+template<typename A>
+A pairwiseCombine(A* p, std::size_t m) {
+    while (m > 1) {
+        for (std::size_t i = 0; i < m / 2; i++) {
+            p[i] = p[2 * i] + p[2 * i + 1];
+        }
+        if (m % 2 == 1) {
+            p[m / 2] = p[m - 1];
+        }
+        m = (m + 1) / 2;
+    }
+    return p[0];
+}
+
+// Sum of block(first, last) over the blocks of [0, n), added pairwise.
+template<typename A, typename Block>
+A blockwiseSum(std::size_t n, const Block& block) {
+    if (n <= reduceBlock) {
+        return block(0, n);
+    }
+    constexpr std::size_t maxStackBlocks = 64;
+    const std::size_t nbBlocks = (n + reduceBlock - 1) / reduceBlock;
+    A stackPartials[maxStackBlocks]{};
+    std::vector<A> heapPartials((nbBlocks > maxStackBlocks) ? nbBlocks : 0);
+    A* partials = (nbBlocks > maxStackBlocks) ? heapPartials.data() : stackPartials;
+    parallelFor(0, nbBlocks, std::max<std::size_t>(1, parallelGrain / reduceBlock), [&](std::size_t first, std::size_t last) {
+        for (std::size_t b = first; b < last; b++) {
+            partials[b] = block(b * reduceBlock, std::min(n, (b + 1) * reduceBlock));
+        }
+    });
+    return pairwiseCombine(partials, nbBlocks);
+}
+
+// Contiguous runs
+
+template<typename T>
+Accumulator<T> sumRun(const T* x, std::size_t n) {
+    if constexpr (simd::hasKernels<T>) {
+        return simd::kernels<T>().sum(x, n);
+    } else if constexpr (std::is_same_v<T, BFloat16>) {
+        return simd::halfKernels().sumBFloat16(x, n);
+    } else if constexpr (std::is_same_v<T, Float16>) {
+        return simd::halfKernels().sumFloat16(x, n);
+    } else {
+        return std::accumulate(x, x + n, Accumulator<T>());
+    }
+}
+
+template<typename T>
+Accumulator<T> dotRun(const T* x, const T* y, std::size_t n) {
+    if constexpr (simd::hasKernels<T>) {
+        return simd::kernels<T>().dot(x, y, n);
+    } else if constexpr (std::is_same_v<T, BFloat16>) {
+        return simd::halfKernels().dotBFloat16(x, y, n);
+    } else if constexpr (std::is_same_v<T, Float16>) {
+        return simd::halfKernels().dotFloat16(x, y, n);
+    } else {
+        using A = Accumulator<T>;
+        A result = A();
+        for (std::size_t i = 0; i < n; i++) {
+            result += static_cast<A>(x[i]) * static_cast<A>(y[i]);
+        }
+        return result;
+    }
+}
+
+// Sum of (x[i] - mean)^2 over a run of at most reduceBlock elements.
+template<typename T>
+Accumulator<T> squaredDeviationRun(const T* x, Accumulator<T> mean, std::size_t n) {
+    if constexpr (simd::hasKernels<T>) {
+        alignas(64) T deviations[reduceBlock];
+        const simd::BasicKernels<T>& kernels = simd::kernels<T>();
+        kernels.subScalar(x, mean, deviations, n);
+        return kernels.dot(deviations, deviations, n);
+    } else {
+        using A = Accumulator<T>;
+        A result = A();
+        for (std::size_t i = 0; i < n; i++) {
+            const A d = static_cast<A>(x[i]) - mean;
+            result += d * d;
+        }
+        return result;
+    }
+}
+
+template<typename T>
+T extremumRun(bool max, const T* x, std::size_t n) {
+    if constexpr (simd::hasKernels<T>) {
+        return max ? simd::kernels<T>().max(x, n) : simd::kernels<T>().min(x, n);
+    } else if (max) {
+        return *std::max_element(x, x + n, [](const T& a, const T& b) { return static_cast<Accumulator<T>>(a) < static_cast<Accumulator<T>>(b); });
+    } else {
+        return *std::min_element(x, x + n, [](const T& a, const T& b) { return static_cast<Accumulator<T>>(a) < static_cast<Accumulator<T>>(b); });
+    }
+}
+
+template<typename T>
+T reduceSum(const T* x, std::size_t n) {
+    using A = Accumulator<T>;
+    return static_cast<T>(blockwiseSum<A>(n, [x](std::size_t first, std::size_t last) { return sumRun(x + first, last - first); }));
+}
+
+template<typename T>
+T reduceDot(const T* x, const T* y, std::size_t n) {
+    using A = Accumulator<T>;
+    return static_cast<T>(blockwiseSum<A>(n, [x, y](std::size_t first, std::size_t last) { return dotRun(x + first, y + first, last - first); }));
+}
+
+// op over x[0 .. n). n must be positive except for Sum and Norm.
+template<typename T>
+T reduce(Reduction op, const T* x, std::size_t n) {
+    using A = Accumulator<T>;
+    switch (op) {
+        case Reduction::Sum:
+            return reduceSum(x, n);
+        case Reduction::Mean:
+            return static_cast<T>(static_cast<A>(reduceSum(x, n)) / static_cast<A>(n));
+        case Reduction::Max:
+        case Reduction::Min: {
+            const bool max = op == Reduction::Max;
+            return parallelReduce(
+                0, n, parallelGrain, x[0],
+                [x, max](std::size_t first, std::size_t last) { return extremumRun(max, x + first, last - first); },
+                [max](const T& a, const T& b) {
+                    const A u = static_cast<A>(a), v = static_cast<A>(b);
+                    return (max ? (v > u) : (v < u)) ? b : a;
+                }
+            );
+        }
+        case Reduction::Norm:
+            return static_cast<T>(std::sqrt(static_cast<A>(reduceDot(x, x, n))));
+        case Reduction::Variance: {
+            const A mean = static_cast<A>(blockwiseSum<A>(n, [x](std::size_t first, std::size_t last) { return sumRun(x + first, last - first); })) / static_cast<A>(n);
+            const A squares = blockwiseSum<A>(n, [x, mean](std::size_t first, std::size_t last) {
+                return squaredDeviationRun(x + first, mean, last - first);
+            });
+            return static_cast<T>(squares / static_cast<A>(n));
+        }
+    }
+    return T();
+}
+
+// Index of the first maximum of x[0 .. n), n > 0.
+template<typename T>
+std::size_t reduceArgmax(const T* x, std::size_t n) {
+    const T max = reduce(Reduction::Max, x, n);
+    const T* found = std::find_if(x, x + n, [max](const T& v) { return !(static_cast<Accumulator<T>>(v) < static_cast<Accumulator<T>>(max)); });
+    return (found == x + n) ? 0 : static_cast<std::size_t>(found - x);
+}
+
+// Across contiguous runs
+
+// acc[i] op= row[i] for the reductions accumulated across runs.
+template<typename T>
+void accumulateRow(Reduction op, Accumulator<T>* acc, const T* row, std::size_t width) {
+    using A = Accumulator<T>;
+    if constexpr (simd::hasKernels<T>) {
+        const simd::BasicKernels<T>& kernels = simd::kernels<T>();
+        switch (op) {
+            case Reduction::Max: kernels.maximum(acc, row, acc, width); return;
+            case Reduction::Min: kernels.minimum(acc, row, acc, width); return;
+            case Reduction::Norm: kernels.fma(row, row, acc, acc, width); return;
+            default: kernels.add(acc, row, acc, width); return;
+        }
+    } else {
+        for (std::size_t i = 0; i < width; i++) {
+            const A v = static_cast<A>(row[i]);
+            switch (op) {
+                case Reduction::Max: acc[i] = (v > acc[i]) ? v : acc[i]; break;
+                case Reduction::Min: acc[i] = (v < acc[i]) ? v : acc[i]; break;
+                case Reduction::Norm: acc[i] += v * v; break;
+                default: acc[i] += v; break;
+            }
+        }
+    }
+}
+
+// acc[i] += (row[i] - mean[i])^2, through the deviations buffer.
+template<typename T>
+void accumulateDeviations(Accumulator<T>* acc, const T* row, const Accumulator<T>* mean, Accumulator<T>* deviations, std::size_t width) {
+    if constexpr (simd::hasKernels<T>) {
+        const simd::BasicKernels<T>& kernels = simd::kernels<T>();
+        kernels.sub(row, mean, deviations, width);
+        kernels.fma(deviations, deviations, acc, acc, width);
+    } else {
+        for (std::size_t i = 0; i < width; i++) {
+            const Accumulator<T> d = static_cast<Accumulator<T>>(row[i]) - mean[i];
+            acc[i] += d * d;
+        }
+    }
+}
+
+// acc = sum over the rows j in [first, last) of row(acc, j), which adds the
+// contribution of row j into acc. Halves are summed into the scratch rows
+// below and added pairwise.
+template<typename A, typename Row>
+void pairwiseRows(std::size_t first, std::size_t last, A* acc, A* scratch, std::size_t width, const Row& row) {
+    if (last - first <= reducePairwiseRows) {
+        std::fill(acc, acc + width, A(0));
+        for (std::size_t j = first; j < last; j++) {
+            row(acc, j);
+        }
+        return;
+    }
+    const std::size_t middle = first + (last - first) / 2;
+    pairwiseRows(first, middle, acc, scratch + width, width, row);
+    pairwiseRows(middle, last, scratch, scratch + width, width, row);
+    if constexpr (simd::hasKernels<A>) {
+        simd::kernels<A>().add(acc, scratch, acc, width);
+    } else {
+        for (std::size_t i = 0; i < width; i++) {
+            acc[i] += scratch[i];
+        }
+    }
+}
+
+// out[i] = op over j of x[j * stride + i], for i in [0, width).
+template<typename T>
+void reduceColumns(Reduction op, std::size_t n, const T* x, std::size_t stride, std::size_t width, T* out, Accumulator<T>* buffer) {
+    using A = Accumulator<T>;
+    A* acc = buffer;
+    A* mean = buffer + width;
+    A* scratch = buffer + 2 * width;
+    if (op == Reduction::Max || op == Reduction::Min) {
+        for (std::size_t i = 0; i < width; i++) {
+            acc[i] = static_cast<A>(x[i]);
+        }
+        for (std::size_t j = 1; j < n; j++) {
+            accumulateRow(op, acc, x + j * stride, width);
+        }
+    } else if (op == Reduction::Variance) {
+        pairwiseRows(0, n, mean, scratch, width, [&](A* sum, std::size_t j) {
+            accumulateRow(Reduction::Sum, sum, x + j * stride, width);
+        });
+        for (std::size_t i = 0; i < width; i++) {
+            mean[i] /= static_cast<A>(n);
+        }
+        // The first scratch row holds the deviations, the pairwise halves
+        // use the following ones.
+        pairwiseRows(0, n, acc, scratch + width, width, [&](A* sum, std::size_t j) {
+            accumulateDeviations(sum, x + j * stride, mean, scratch, width);
+        });
+        for (std::size_t i = 0; i < width; i++) {
+            acc[i] /= static_cast<A>(n);
+        }
+    } else {
+        pairwiseRows(0, n, acc, scratch, width, [&](A* sum, std::size_t j) {
+            accumulateRow(op, sum, x + j * stride, width);
+        });
+        for (std::size_t i = 0; i < width; i++) {
+            if (op == Reduction::Mean) {
+                acc[i] /= static_cast<A>(n);
+            } else if (op == Reduction::Norm) {
+                acc[i] = std::sqrt(acc[i]);
+            }
+        }
+    }
+    for (std::size_t i = 0; i < width; i++) {
+        out[i] = static_cast<T>(acc[i]);
+    }
+}
+
+// Calls fn(o, i0, width) over the column blocks of an outer x inner output,
+// spread over the pool, each task covering the n rows of its block.
+template<typename F>
+void forEachColumnBlock(std::size_t outer, std::size_t n, std::size_t inner, const F& fn) {
+    const std::size_t width = std::min(inner, reduceColumnBlock);
+    const std::size_t blocks = (inner + width - 1) / width;
+    const std::size_t work = std::max<std::size_t>(1, n * width);
+    parallelFor(0, outer * blocks, std::max<std::size_t>(1, parallelGrain / work), [&](std::size_t first, std::size_t last) {
+        for (std::size_t t = first; t < last; t++) {
+            const std::size_t i0 = (t % blocks) * width;
+            fn(t / blocks, i0, std::min(width, inner - i0));
+        }
+    });
+}
+
+// out[o * inner + i] = op over j in [0, n) of x[o * outerStride + j * stride + i]:
+// the middle axis of an outer x n x inner array whose inner axis is
+// contiguous is reduced. n must be positive except for Sum and Norm.
+template<typename T>
+void reduceAxis(Reduction op, std::size_t outer, std::size_t n, std::size_t inner, const T* x, std::size_t outerStride, std::size_t stride, T* out) {
+    using A = Accumulator<T>;
+    if (inner == 1) {
+        parallelFor(0, outer, std::max<std::size_t>(1, parallelGrain / std::max<std::size_t>(1, n)), [&](std::size_t first, std::size_t last) {
+            for (std::size_t o = first; o < last; o++) {
+                out[o] = reduce(op, x + o * outerStride, n);
+            }
+        });
+        return;
+    }
+    if (n == 0) {
+        std::fill(out, out + outer * inner, T(0));
+        return;
+    }
+    // acc, mean, deviations, then one row per level of the pairwise sums.
+    std::size_t levels = 1;
+    while ((reducePairwiseRows << levels) < n) {
+        levels++;
+    }
+    const std::size_t width = std::min(inner, reduceColumnBlock);
+    forEachColumnBlock(outer, n, inner, [&](std::size_t o, std::size_t i0, std::size_t w) {
+        std::vector<A, AlignedAllocator<A>> buffer((levels + 3) * width);
+        reduceColumns(op, n, x + o * outerStride + i0, stride, w, out + o * inner + i0, buffer.data());
+    });
+}
+
+// out[o * inner + i] = index j of the first maximum over j, as reduceAxis().
+// n must be positive.
+template<typename T>
+void argmaxAxis(std::size_t outer, std::size_t n, std::size_t inner, const T* x, std::size_t outerStride, std::size_t stride, std::size_t* out) {
+    using A = Accumulator<T>;
+    if (inner == 1) {
+        parallelFor(0, outer, std::max<std::size_t>(1, parallelGrain / std::max<std::size_t>(1, n)), [&](std::size_t first, std::size_t last) {
+            for (std::size_t o = first; o < last; o++) {
+                out[o] = reduceArgmax(x + o * outerStride, n);
+            }
+        });
+        return;
+    }
+    forEachColumnBlock(outer, n, inner, [&](std::size_t o, std::size_t i0, std::size_t w) {
+        const T* base = x + o * outerStride + i0;
+        std::size_t* index = out + o * inner + i0;
+        std::vector<A, AlignedAllocator<A>> best(w);
+        for (std::size_t i = 0; i < w; i++) {
+            best[i] = static_cast<A>(base[i]);
+            index[i] = 0;
+        }
+        for (std::size_t j = 1; j < n; j++) {
+            const T* row = base + j * stride;
+            for (std::size_t i = 0; i < w; i++) {
+                const A v = static_cast<A>(row[i]);
+                if (v > best[i]) {
+                    best[i] = v;
+                    index[i] = j;
+                }
+            }
+        }
+    });
+}
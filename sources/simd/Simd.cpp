@@ -0,0 +1,129 @@
+#include <atomic>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "simd/Simd.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define NN_SIMD_X86 1
+#endif
+
+static const simd::KernelSet& tableFor(simd::Isa isa) {
+    switch (isa) {
+#ifdef NN_SIMD_X86
+        case simd::Isa::Sse2:
+            return simd::sse2Kernels();
+        case simd::Isa::Avx2:
+            return simd::avx2Kernels();
+        case simd::Isa::Avx512:
+            return simd::avx512Kernels();
+#endif
+        default:
+            return simd::scalarKernels();
+    }
+}
+
+static const simd::KernelSet* initialKernels() {
+    simd::Isa isa = simd::detectIsa();
+    if (const char* env = std::getenv("NN_SIMD_ISA")) {
+        try {
+            const simd::Isa requested = simd::parseIsa(env);
+            if (simd::isSupported(requested)) {
+                isa = requested;
+            }
+        } catch (const std::invalid_argument&) {
+        }
+    }
+    return &tableFor(isa);
+}
+
+static std::atomic<const simd::KernelSet*>& activeKernels() {
+    static std::atomic<const simd::KernelSet*> active(initialKernels());
+    return active;
+}
+
+namespace simd {
+
+bool isSupported(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar:
+            return true;
+#ifdef NN_SIMD_X86
+        case Isa::Sse2:
+            return __builtin_cpu_supports("sse2");
+        case Isa::Avx2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c");
+        case Isa::Avx512:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+        default:
+            return false;
+    }
+}
+
+Isa detectIsa() {
+    for (Isa isa : {Isa::Avx512, Isa::Avx2, Isa::Sse2}) {
+        if (isSupported(isa)) {
+            return isa;
+        }
+    }
+    return Isa::Scalar;
+}
+
+Isa activeIsa() {
+    return activeKernels().load(std::memory_order_acquire)->isa;
+}
+
+void setIsa(Isa isa) {
+    if (!isSupported(isa)) {
+        throw std::invalid_argument(std::string("Instruction set not supported by this CPU: ") + isaName(isa));
+    }
+    activeKernels().store(&tableFor(isa), std::memory_order_release);
+}
+
+const Kernels& kernels() {
+    return activeKernels().load(std::memory_order_acquire)->f64;
+}
+
+template<>
+const BasicKernels<double>& kernels<double>() {
+    return kernels();
+}
+
+template<>
+const BasicKernels<float>& kernels<float>() {
+    return activeKernels().load(std::memory_order_acquire)->f32;
+}
+
+const HalfKernels& halfKernels() {
+    return activeKernels().load(std::memory_order_acquire)->half;
+}
+
+const Int8Kernels& int8Kernels() {
+    return activeKernels().load(std::memory_order_acquire)->i8;
+}
+
+const char* isaName(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar:
+            return "scalar";
+        case Isa::Sse2:
+            return "sse2";
+        case Isa::Avx2:
+            return "avx2";
+        case Isa::Avx512:
+            return "avx512";
+    }
+    return "unknown";
+}
+
+Isa parseIsa(const std::string& name) {
+    for (Isa isa : {Isa::Scalar, Isa::Sse2, Isa::Avx2, Isa::Avx512}) {
+        if (name == isaName(isa)) {
+            return isa;
+        }
+    }
+    throw std::invalid_argument("Unknown instruction set: " + name);
+}
+
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include "half/Half.hpp"
+
+namespace simd {
+
+// Instruction sets with a dedicated kernel table, from the most portable to
+// the widest.
+enum class Isa {
+    Scalar,
+    Sse2,
+    Avx2,
+    Avx512
+};
+
+// Register tile of the GEMM micro-kernel (rows x columns of C) for double.
+constexpr std::size_t gemmMR = 4;
+constexpr std::size_t gemmNR = 8;
+
+// Columns of the register tile for element type T: a row of the tile spans
+// the same number of bytes, hence the same number of registers, for every
+// type.
+template<typename T>
+constexpr std::size_t gemmNRFor = gemmNR * sizeof(double) / sizeof(T);
+
+// Elements per leaf of the pairwise sums and dot products: a multiple of
+// every register width.
+constexpr std::size_t sumLeaf = 128;
+
+// Coefficients of one SGD step over parameters w with gradients g:
+// d = g + weightDecay * w, then with momentum v = momentum * v + d and
+// d = v, or d + momentum * v for Nesterov momentum, and w -= learningRate * d.
+template<typename T>
+struct SgdUpdate {
+    T learningRate;
+    T momentum;
+    T weightDecay;
+    bool nesterov;
+};
+
+// Coefficients of step t of Adam, folded by the caller: g' = g + weightDecay
+// * w (an L2 penalty), m = beta1 * m + (1 - beta1) * g', v = beta2 * v +
+// (1 - beta2) * g'^2 and w = decay * w - stepSize * m / (sqrt(v) *
+// correction2 + epsilon), with stepSize = learningRate / (1 - beta1^t),
+// correction2 = 1 / sqrt(1 - beta2^t), and decay = 1 - learningRate *
+// weight decay for AdamW's decoupled decay.
+template<typename T>
+struct AdamUpdate {
+    T beta1;
+    T beta2;
+    T epsilon;
+    T weightDecay;
+    T decay;
+    T stepSize;
+    T correction2;
+};
+
+// Elementwise and reduction kernels on T (double or float) for one
+// instruction set. Pointers do not need to be aligned, and out may alias x
+// or y.
+template<typename T>
+struct BasicKernels {
+    Isa isa;
+    // out = x op y
+    void (*add)(const T* x, const T* y, T* out, std::size_t n);
+    void (*sub)(const T* x, const T* y, T* out, std::size_t n);
+    void (*mul)(const T* x, const T* y, T* out, std::size_t n);
+    void (*div)(const T* x, const T* y, T* out, std::size_t n);
+    // out = max(x, y) and min(x, y), elementwise
+    void (*maximum)(const T* x, const T* y, T* out, std::size_t n);
+    void (*minimum)(const T* x, const T* y, T* out, std::size_t n);
+    // out = x op value
+    void (*addScalar)(const T* x, T value, T* out, std::size_t n);
+    void (*subScalar)(const T* x, T value, T* out, std::size_t n);
+    void (*mulScalar)(const T* x, T value, T* out, std::size_t n);
+    void (*divScalar)(const T* x, T value, T* out, std::size_t n);
+    // out = value op x
+    void (*scalarSub)(T value, const T* x, T* out, std::size_t n);
+    void (*scalarDiv)(T value, const T* x, T* out, std::size_t n);
+    // out = (x - a) - b, with x - a rounded first
+    void (*subScalars)(const T* x, T a, T b, T* out, std::size_t n);
+    // out = x * y + z
+    void (*fma)(const T* x, const T* y, const T* z, T* out, std::size_t n);
+    // y += alpha * x
+    void (*axpy)(T alpha, const T* x, T* y, std::size_t n);
+    // dot and sum add leaves of sumLeaf elements pairwise, so that their
+    // rounding error grows with log(n) on every instruction set.
+    T (*dot)(const T* x, const T* y, std::size_t n);
+    // GEMV building blocks over four rows a, a + lda, a + 2 lda, a + 3 lda:
+    // out[r] = dot(row r, x), and y += sum over r of alpha[r] * row r. Each
+    // element of x or y is loaded once for the four rows.
+    void (*dot4)(const T* a, std::size_t lda, const T* x, T* out, std::size_t n);
+    void (*axpy4)(const T* alpha, const T* a, std::size_t lda, T* y, std::size_t n);
+    T (*sum)(const T* x, std::size_t n);
+    // Undefined for n == 0.
+    T (*max)(const T* x, std::size_t n);
+    T (*min)(const T* x, std::size_t n);
+    // out = scale * exp(x - shift), to a few ulps.
+    void (*exp)(const T* x, T shift, T scale, T* out, std::size_t n);
+    // Sum of exp(x - max) in one pass with a running maximum, max being set
+    // to the maximum of x. Softmax-style normalizations then subtract max
+    // exactly and only divide by the sum.
+    T (*sumExp)(const T* x, std::size_t n, T* max);
+    // Optimizer steps updating w and its moment buffers in place, in one
+    // pass. velocity is not read without momentum and may then be null.
+    void (*sgd)(T* w, const T* g, T* velocity, std::size_t n, const SgdUpdate<T>& u);
+    void (*adam)(T* w, const T* g, T* m, T* v, std::size_t n, const AdamUpdate<T>& u);
+    // c[gemmMR][gemmNRFor<T>] = sum over kc of the packed a and b slivers.
+    void (*gemmTile)(std::size_t kc, const T* a, const T* b, T* c);
+    // b[j * ldb + i] = a[i * lda + j] for the rows x cols block a, through
+    // register tile transposes. a and b must not overlap.
+    void (*transpose)(const T* a, std::size_t lda, T* b, std::size_t ldb, std::size_t rows, std::size_t cols);
+};
+
+using Kernels = BasicKernels<double>;
+using FloatKernels = BasicKernels<float>;
+
+// Conversions between float and the 16-bit storage types, and reductions
+// over 16-bit operands that widen them in registers and accumulate in float.
+struct HalfKernels {
+    void (*fromBFloat16)(const BFloat16* x, float* out, std::size_t n);
+    void (*toBFloat16)(const float* x, BFloat16* out, std::size_t n);
+    void (*fromFloat16)(const Float16* x, float* out, std::size_t n);
+    void (*toFloat16)(const float* x, Float16* out, std::size_t n);
+    float (*dotBFloat16)(const BFloat16* x, const BFloat16* y, std::size_t n);
+    float (*dotFloat16)(const Float16* x, const Float16* y, std::size_t n);
+    float (*sumBFloat16)(const BFloat16* x, std::size_t n);
+    float (*sumFloat16)(const Float16* x, std::size_t n);
+};
+
+// Integer kernels of the int8 GEMM. Packing widens the int8 operands to
+// int16 and interleaves consecutive pairs of k, so that one pmaddwd (or
+// vpdpwssd where AVX-512 VNNI is available) multiplies both terms of a pair
+// and adds them into an int32 lane. Products of int8 values cannot
+// saturate there, unlike the u8 x s8 pmaddubsw form.
+struct Int8Kernels {
+    // c[gemmMR][gemmNRFor<std::int32_t>] = sum over kc (even) of the packed
+    // a and b slivers. Each k pair of a holds the gemmMR rows as int16 pairs,
+    // and of b the columns as int16 pairs.
+    void (*gemmTile)(std::size_t kc, const std::int16_t* a, const std::int16_t* b, std::int32_t* c);
+};
+
+// Every table of one instruction set.
+struct KernelSet {
+    Isa isa;
+    BasicKernels<double> f64;
+    BasicKernels<float> f32;
+    HalfKernels half;
+    Int8Kernels i8;
+};
+
+// Best instruction set supported by the running CPU.
+Isa detectIsa();
+
+bool isSupported(Isa isa);
+
+// Instruction set used by kernels(). Defaults to detectIsa(), unless the
+// NN_SIMD_ISA environment variable (scalar, sse2, avx2 or avx512) names a
+// supported one.
+Isa activeIsa();
+
+// Forces the kernels used from now on, mostly for testing. Throws if the CPU
+// does not support isa.
+void setIsa(Isa isa);
+
+const Kernels& kernels();
+
+// Tables of the active instruction set for T = double or float, and for the
+// 16-bit types.
+template<typename T>
+constexpr bool hasKernels = std::is_same_v<T, double> || std::is_same_v<T, float>;
+
+template<typename T>
+const BasicKernels<T>& kernels();
+template<>
+const BasicKernels<double>& kernels<double>();
+template<>
+const BasicKernels<float>& kernels<float>();
+const HalfKernels& halfKernels();
+const Int8Kernels& int8Kernels();
+
+const char* isaName(Isa isa);
+Isa parseIsa(const std::string& name);
+
+// Per instruction set tables, prefer kernels(). Only the ones reported by
+// isSupported() may be called.
+const KernelSet& scalarKernels();
+const KernelSet& sse2Kernels();
+const KernelSet& avx2Kernels();
+const KernelSet& avx512Kernels();
+
+}
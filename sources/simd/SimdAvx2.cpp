@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "simd/Simd.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma,f16c"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2,fma,f16c")
+#endif
+
+namespace simd::avx2 {
+
+struct Regs {
+    using value_type = double;
+    using reg = __m256d;
+    static constexpr std::size_t width = 4;
+    static reg load(const double* p) { return _mm256_loadu_pd(p); }
+    static void store(double* p, reg r) { _mm256_storeu_pd(p, r); }
+    static reg set1(double value) { return _mm256_set1_pd(value); }
+    static reg zero() { return _mm256_setzero_pd(); }
+    static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+    static reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+    static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+    static reg div(reg a, reg b) { return _mm256_div_pd(a, b); }
+    static reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_pd(a, b, c); }
+    static reg sqrt(reg r) { return _mm256_sqrt_pd(r); }
+    static reg max(reg a, reg b) { return _mm256_max_pd(a, b); }
+    static reg min(reg a, reg b) { return _mm256_min_pd(a, b); }
+    static double hsum(reg r) {
+        const __m128d h = _mm_add_pd(_mm256_castpd256_pd128(r), _mm256_extractf128_pd(r, 1));
+        return _mm_cvtsd_f64(_mm_add_sd(h, _mm_unpackhi_pd(h, h)));
+    }
+    static double hmax(reg r) {
+        const __m128d h = _mm_max_pd(_mm256_castpd256_pd128(r), _mm256_extractf128_pd(r, 1));
+        return _mm_cvtsd_f64(_mm_max_sd(h, _mm_unpackhi_pd(h, h)));
+    }
+    static double hmin(reg r) {
+        const __m128d h = _mm_min_pd(_mm256_castpd256_pd128(r), _mm256_extractf128_pd(r, 1));
+        return _mm_cvtsd_f64(_mm_min_sd(h, _mm_unpackhi_pd(h, h)));
+    }
+    static reg round(reg r) { return _mm256_round_pd(r, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    static reg pow2(reg k) {
+        const __m128i e = _mm_add_epi32(_mm256_cvtpd_epi32(k), _mm_set1_epi32(1023));
+        return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_cvtepi32_epi64(e), 52));
+    }
+    static void transposeTile(const double* a, std::size_t lda, double* b, std::size_t ldb) {
+        const reg r0 = _mm256_loadu_pd(a);
+        const reg r1 = _mm256_loadu_pd(a + lda);
+        const reg r2 = _mm256_loadu_pd(a + 2 * lda);
+        const reg r3 = _mm256_loadu_pd(a + 3 * lda);
+        // t0 = (a00 a10 a02 a12), t1 = (a01 a11 a03 a13), likewise for rows 2, 3.
+        const reg t0 = _mm256_unpacklo_pd(r0, r1);
+        const reg t1 = _mm256_unpackhi_pd(r0, r1);
+        const reg t2 = _mm256_unpacklo_pd(r2, r3);
+        const reg t3 = _mm256_unpackhi_pd(r2, r3);
+        _mm256_storeu_pd(b, _mm256_permute2f128_pd(t0, t2, 0x20));
+        _mm256_storeu_pd(b + ldb, _mm256_permute2f128_pd(t1, t3, 0x20));
+        _mm256_storeu_pd(b + 2 * ldb, _mm256_permute2f128_pd(t0, t2, 0x31));
+        _mm256_storeu_pd(b + 3 * ldb, _mm256_permute2f128_pd(t1, t3, 0x31));
+    }
+};
+
+struct FloatRegs {
+    using value_type = float;
+    using reg = __m256;
+    static constexpr std::size_t width = 8;
+    static reg load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, reg r) { _mm256_storeu_ps(p, r); }
+    static reg set1(float value) { return _mm256_set1_ps(value); }
+    static reg zero() { return _mm256_setzero_ps(); }
+    static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+    static reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+    static reg div(reg a, reg b) { return _mm256_div_ps(a, b); }
+    static reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_ps(a, b, c); }
+    static reg sqrt(reg r) { return _mm256_sqrt_ps(r); }
+    static reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+    static reg min(reg a, reg b) { return _mm256_min_ps(a, b); }
+    static float hsum(reg r) {
+        __m128 h = _mm_add_ps(_mm256_castps256_ps128(r), _mm256_extractf128_ps(r, 1));
+        h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+        return _mm_cvtss_f32(_mm_add_ss(h, _mm_shuffle_ps(h, h, 1)));
+    }
+    static float hmax(reg r) {
+        __m128 h = _mm_max_ps(_mm256_castps256_ps128(r), _mm256_extractf128_ps(r, 1));
+        h = _mm_max_ps(h, _mm_movehl_ps(h, h));
+        return _mm_cvtss_f32(_mm_max_ss(h, _mm_shuffle_ps(h, h, 1)));
+    }
+    static float hmin(reg r) {
+        __m128 h = _mm_min_ps(_mm256_castps256_ps128(r), _mm256_extractf128_ps(r, 1));
+        h = _mm_min_ps(h, _mm_movehl_ps(h, h));
+        return _mm_cvtss_f32(_mm_min_ss(h, _mm_shuffle_ps(h, h, 1)));
+    }
+    static reg round(reg r) { return _mm256_round_ps(r, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    static reg pow2(reg k) {
+        return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(k), _mm256_set1_epi32(127)), 23));
+    }
+    static void transposeTile(const float* a, std::size_t lda, float* b, std::size_t ldb) {
+        reg r[8];
+        for (std::size_t i = 0; i < 8; i++) {
+            r[i] = _mm256_loadu_ps(a + i * lda);
+        }
+        reg t[8];
+        for (std::size_t i = 0; i < 8; i += 2) {
+            t[i] = _mm256_unpacklo_ps(r[i], r[i + 1]);
+            t[i + 1] = _mm256_unpackhi_ps(r[i], r[i + 1]);
+        }
+        // u[4g + c], lane L: column 4L + c of rows 4g to 4g + 3.
+        reg u[8];
+        for (std::size_t g = 0; g < 8; g += 4) {
+            u[g] = _mm256_shuffle_ps(t[g], t[g + 2], 0x44);
+            u[g + 1] = _mm256_shuffle_ps(t[g], t[g + 2], 0xEE);
+            u[g + 2] = _mm256_shuffle_ps(t[g + 1], t[g + 3], 0x44);
+            u[g + 3] = _mm256_shuffle_ps(t[g + 1], t[g + 3], 0xEE);
+        }
+        for (std::size_t c = 0; c < 4; c++) {
+            _mm256_storeu_ps(b + c * ldb, _mm256_permute2f128_ps(u[c], u[c + 4], 0x20));
+            _mm256_storeu_ps(b + (c + 4) * ldb, _mm256_permute2f128_ps(u[c], u[c + 4], 0x31));
+        }
+    }
+    static reg loadBFloat16(const BFloat16* p) {
+        const __m256i h = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+        return _mm256_castsi256_ps(_mm256_slli_epi32(h, 16));
+    }
+    static void storeBFloat16(BFloat16* p, reg r) {
+        const __m256i bits = _mm256_castps_si256(r);
+        const __m256i odd = _mm256_and_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(1));
+        const __m256i rounded = _mm256_add_epi32(bits, _mm256_add_epi32(odd, _mm256_set1_epi32(0x7FFF)));
+        const __m256i quiet = _mm256_or_si256(bits, _mm256_set1_epi32(0x400000));
+        const __m256i nan = _mm256_castps_si256(_mm256_cmp_ps(r, r, _CMP_UNORD_Q));
+        const __m256i result = _mm256_srai_epi32(_mm256_blendv_epi8(rounded, quiet, nan), 16);
+        const __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(result), _mm256_extracti128_si256(result, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), packed);
+    }
+    static reg loadFloat16(const Float16* p) {
+        return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    }
+    static void storeFloat16(Float16* p, reg r) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm256_cvtps_ph(r, _MM_FROUND_TO_NEAREST_INT));
+    }
+};
+
+struct IntRegs {
+    using reg = __m256i;
+    static constexpr std::size_t width = 8;
+    static reg load(const std::int16_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void store(std::int32_t* p, reg r) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), r); }
+    static reg set1(std::int32_t pair) { return _mm256_set1_epi32(pair); }
+    static reg zero() { return _mm256_setzero_si256(); }
+    static reg madd(reg a, reg b, reg c) { return _mm256_add_epi32(c, _mm256_madd_epi16(a, b)); }
+};
+
+#include "simd/SimdKernels.inl"
+
+}
+
+const simd::KernelSet& simd::avx2Kernels() {
+    static const KernelSet k = avx2::makeKernelSet<avx2::Regs, avx2::FloatRegs, avx2::IntRegs>(Isa::Avx2);
+    return k;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif
@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "simd/Simd.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f,avx512bw"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw")
+// GCC 12 flags the placeholder operands of the AVX-512 intrinsics as
+// uninitialized (GCC bug 105593).
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+namespace simd::avx512 {
+
+struct Regs {
+    using value_type = double;
+    using reg = __m512d;
+    static constexpr std::size_t width = 8;
+    static reg load(const double* p) { return _mm512_loadu_pd(p); }
+    static void store(double* p, reg r) { _mm512_storeu_pd(p, r); }
+    static reg set1(double value) { return _mm512_set1_pd(value); }
+    static reg zero() { return _mm512_setzero_pd(); }
+    static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+    static reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+    static reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+    static reg div(reg a, reg b) { return _mm512_div_pd(a, b); }
+    static reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_pd(a, b, c); }
+    static reg sqrt(reg r) { return _mm512_sqrt_pd(r); }
+    static reg max(reg a, reg b) { return _mm512_max_pd(a, b); }
+    static reg min(reg a, reg b) { return _mm512_min_pd(a, b); }
+    static double hsum(reg r) { return _mm512_reduce_add_pd(r); }
+    static double hmax(reg r) { return _mm512_reduce_max_pd(r); }
+    static double hmin(reg r) { return _mm512_reduce_min_pd(r); }
+    static reg round(reg r) { return _mm512_roundscale_pd(r, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    static reg pow2(reg k) { return _mm512_scalef_pd(_mm512_set1_pd(1.), k); }
+    static void transposeTile(const double* a, std::size_t lda, double* b, std::size_t ldb) {
+        reg r[8];
+        for (std::size_t i = 0; i < 8; i++) {
+            r[i] = _mm512_loadu_pd(a + i * lda);
+        }
+        // Interleave row pairs: t[2k] = (a00 a10 a02 a12 ...), t[2k + 1] = (a01 a11 a03 a13 ...)
+        // for rows 2k and 2k + 1.
+        reg t[8];
+        for (std::size_t i = 0; i < 8; i += 2) {
+            t[i] = _mm512_unpacklo_pd(r[i], r[i + 1]);
+            t[i + 1] = _mm512_unpackhi_pd(r[i], r[i + 1]);
+        }
+        // Gather four rows per column: u[0] = (a00 a10 a20 a30 a04 a14 a24 a34), then
+        // columns 1 and 5, 2 and 6, 3 and 7; the same for rows 4 to 7 in u[4..7].
+        const __m512i even = _mm512_set_epi64(13, 12, 5, 4, 9, 8, 1, 0);
+        const __m512i odd = _mm512_set_epi64(15, 14, 7, 6, 11, 10, 3, 2);
+        reg u[8];
+        for (std::size_t i = 0; i < 8; i += 4) {
+            u[i] = _mm512_permutex2var_pd(t[i], even, t[i + 2]);
+            u[i + 1] = _mm512_permutex2var_pd(t[i + 1], even, t[i + 3]);
+            u[i + 2] = _mm512_permutex2var_pd(t[i], odd, t[i + 2]);
+            u[i + 3] = _mm512_permutex2var_pd(t[i + 1], odd, t[i + 3]);
+        }
+        for (std::size_t j = 0; j < 4; j++) {
+            _mm512_storeu_pd(b + j * ldb, _mm512_shuffle_f64x2(u[j], u[j + 4], 0x44));
+            _mm512_storeu_pd(b + (j + 4) * ldb, _mm512_shuffle_f64x2(u[j], u[j + 4], 0xEE));
+        }
+    }
+};
+
+struct FloatRegs {
+    using value_type = float;
+    using reg = __m512;
+    static constexpr std::size_t width = 16;
+    static reg load(const float* p) { return _mm512_loadu_ps(p); }
+    static void store(float* p, reg r) { _mm512_storeu_ps(p, r); }
+    static reg set1(float value) { return _mm512_set1_ps(value); }
+    static reg zero() { return _mm512_setzero_ps(); }
+    static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+    static reg sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+    static reg div(reg a, reg b) { return _mm512_div_ps(a, b); }
+    static reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_ps(a, b, c); }
+    static reg sqrt(reg r) { return _mm512_sqrt_ps(r); }
+    static reg max(reg a, reg b) { return _mm512_max_ps(a, b); }
+    static reg min(reg a, reg b) { return _mm512_min_ps(a, b); }
+    static float hsum(reg r) { return _mm512_reduce_add_ps(r); }
+    static float hmax(reg r) { return _mm512_reduce_max_ps(r); }
+    static float hmin(reg r) { return _mm512_reduce_min_ps(r); }
+    static reg round(reg r) { return _mm512_roundscale_ps(r, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    static reg pow2(reg k) { return _mm512_scalef_ps(_mm512_set1_ps(1.f), k); }
+    static void transposeTile(const float* a, std::size_t lda, float* b, std::size_t ldb) {
+        reg r[16];
+        for (std::size_t i = 0; i < 16; i++) {
+            r[i] = _mm512_loadu_ps(a + i * lda);
+        }
+        reg t[16];
+        for (std::size_t i = 0; i < 16; i += 2) {
+            t[i] = _mm512_unpacklo_ps(r[i], r[i + 1]);
+            t[i + 1] = _mm512_unpackhi_ps(r[i], r[i + 1]);
+        }
+        // u[4g + c], 128-bit lane L: column 4L + c of rows 4g to 4g + 3.
+        reg u[16];
+        for (std::size_t g = 0; g < 16; g += 4) {
+            u[g] = _mm512_shuffle_ps(t[g], t[g + 2], 0x44);
+            u[g + 1] = _mm512_shuffle_ps(t[g], t[g + 2], 0xEE);
+            u[g + 2] = _mm512_shuffle_ps(t[g + 1], t[g + 3], 0x44);
+            u[g + 3] = _mm512_shuffle_ps(t[g + 1], t[g + 3], 0xEE);
+        }
+        // Column 4L + c gathers lane L of u[c], u[4 + c], u[8 + c] and
+        // u[12 + c]: a 4 x 4 transpose of 128-bit lanes.
+        for (std::size_t c = 0; c < 4; c++) {
+            const reg v0 = _mm512_shuffle_f32x4(u[c], u[c + 4], 0x88);
+            const reg v1 = _mm512_shuffle_f32x4(u[c], u[c + 4], 0xDD);
+            const reg v2 = _mm512_shuffle_f32x4(u[c + 8], u[c + 12], 0x88);
+            const reg v3 = _mm512_shuffle_f32x4(u[c + 8], u[c + 12], 0xDD);
+            _mm512_storeu_ps(b + c * ldb, _mm512_shuffle_f32x4(v0, v2, 0x88));
+            _mm512_storeu_ps(b + (c + 4) * ldb, _mm512_shuffle_f32x4(v1, v3, 0x88));
+            _mm512_storeu_ps(b + (c + 8) * ldb, _mm512_shuffle_f32x4(v0, v2, 0xDD));
+            _mm512_storeu_ps(b + (c + 12) * ldb, _mm512_shuffle_f32x4(v1, v3, 0xDD));
+        }
+    }
+    static reg loadBFloat16(const BFloat16* p) {
+        const __m512i h = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+        return _mm512_castsi512_ps(_mm512_slli_epi32(h, 16));
+    }
+    static void storeBFloat16(BFloat16* p, reg r) {
+        const __m512i bits = _mm512_castps_si512(r);
+        const __m512i odd = _mm512_and_si512(_mm512_srli_epi32(bits, 16), _mm512_set1_epi32(1));
+        const __m512i rounded = _mm512_add_epi32(bits, _mm512_add_epi32(odd, _mm512_set1_epi32(0x7FFF)));
+        const __m512i quiet = _mm512_or_si512(bits, _mm512_set1_epi32(0x400000));
+        const __mmask16 nan = _mm512_cmp_ps_mask(r, r, _CMP_UNORD_Q);
+        const __m512i result = _mm512_srli_epi32(_mm512_mask_blend_epi32(nan, rounded, quiet), 16);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm512_cvtepi32_epi16(result));
+    }
+    static reg loadFloat16(const Float16* p) {
+        return _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+    }
+    static void storeFloat16(Float16* p, reg r) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm512_cvtps_ph(r, _MM_FROUND_TO_NEAREST_INT));
+    }
+};
+
+struct IntRegs {
+    using reg = __m512i;
+    static constexpr std::size_t width = 16;
+    static reg load(const std::int16_t* p) { return _mm512_loadu_si512(p); }
+    static void store(std::int32_t* p, reg r) { _mm512_storeu_si512(p, r); }
+    static reg set1(std::int32_t pair) { return _mm512_set1_epi32(pair); }
+    static reg zero() { return _mm512_setzero_si512(); }
+    static reg madd(reg a, reg b, reg c) { return _mm512_add_epi32(c, _mm512_madd_epi16(a, b)); }
+};
+
+#include "simd/SimdKernels.inl"
+
+// VNNI fuses the multiply-add and the accumulation into one vpdpwssd. It is
+// only instantiated here, under its own target, and picked at run time.
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512vnni"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx512vnni")
+#endif
+
+struct VnniIntRegs : IntRegs {
+    static reg madd(reg a, reg b, reg c) { return _mm512_dpwssd_epi32(c, a, b); }
+};
+
+template void gemmTileInt8<VnniIntRegs, gemmMR, gemmNRFor<std::int32_t>>(std::size_t, const std::int16_t*, const std::int16_t*, std::int32_t*);
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+}
+
+const simd::KernelSet& simd::avx512Kernels() {
+    static const KernelSet k = [] {
+        KernelSet set = avx512::makeKernelSet<avx512::Regs, avx512::FloatRegs, avx512::IntRegs>(Isa::Avx512);
+        if (__builtin_cpu_supports("avx512vnni")) {
+            set.i8.gemmTile = &avx512::gemmTileInt8<avx512::VnniIntRegs, gemmMR, gemmNRFor<std::int32_t>>;
+        }
+        return set;
+    }();
+    return k;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC diagnostic pop
+#pragma GCC pop_options
+#endif
+
+#endif
@@ -0,0 +1,765 @@
+// Generic kernel bodies, written once against a register traits type R and
+// included by every SimdXxx.cpp inside its own namespace and target region,
+// so each instruction set gets its own compiled copy.
+//
+// R provides value_type, reg, width, and the static functions load, store,
+// set1, zero, add, sub, mul, div, fmadd (a * b + c), sqrt, max, min, hsum,
+// hmax, hmin, round (to the nearest integer, ties to even), pow2 (2^k for
+// integral k within the exponent range of normal numbers) and
+// transposeTile, which transposes a width x width tile in registers. The
+// float traits also provide loadBFloat16, storeBFloat16, loadFloat16 and
+// storeFloat16, which convert width elements between registers and 16-bit
+// storage.
+//
+// The int8 GEMM uses integer traits I instead: reg, width (int32 lanes),
+// load (width int16 pairs), set1 (one int16 pair broadcast as an int32),
+// zero, store, and madd(a, b, c), which adds the pairwise products of the
+// int16 lanes of a and b to the int32 lanes of c.
+
+template<typename R>
+struct AddOp {
+    static typename R::reg vec(typename R::reg a, typename R::reg b) { return R::add(a, b); }
+    static typename R::value_type one(typename R::value_type a, typename R::value_type b) { return a + b; }
+};
+
+template<typename R>
+struct SubOp {
+    static typename R::reg vec(typename R::reg a, typename R::reg b) { return R::sub(a, b); }
+    static typename R::value_type one(typename R::value_type a, typename R::value_type b) { return a - b; }
+};
+
+template<typename R>
+struct MulOp {
+    static typename R::reg vec(typename R::reg a, typename R::reg b) { return R::mul(a, b); }
+    static typename R::value_type one(typename R::value_type a, typename R::value_type b) { return a * b; }
+};
+
+template<typename R>
+struct DivOp {
+    static typename R::reg vec(typename R::reg a, typename R::reg b) { return R::div(a, b); }
+    static typename R::value_type one(typename R::value_type a, typename R::value_type b) { return a / b; }
+};
+
+// max and min follow the x86 instructions: the second operand is returned
+// when the first is not greater (or less), including when either is NaN.
+template<typename R>
+struct MaxOp {
+    static typename R::reg vec(typename R::reg a, typename R::reg b) { return R::max(a, b); }
+    static typename R::value_type one(typename R::value_type a, typename R::value_type b) { return (a > b) ? a : b; }
+    static typename R::value_type horizontal(typename R::reg r) { return R::hmax(r); }
+};
+
+template<typename R>
+struct MinOp {
+    static typename R::reg vec(typename R::reg a, typename R::reg b) { return R::min(a, b); }
+    static typename R::value_type one(typename R::value_type a, typename R::value_type b) { return (a < b) ? a : b; }
+    static typename R::value_type horizontal(typename R::reg r) { return R::hmin(r); }
+};
+
+template<typename R, typename Op>
+void binary(const typename R::value_type* x, const typename R::value_type* y, typename R::value_type* out, std::size_t n) {
+    constexpr std::size_t W = R::width;
+    std::size_t i = 0;
+    for (; i + 4 * W <= n; i += 4 * W) {
+        const typename R::reg r0 = Op::vec(R::load(x + i), R::load(y + i));
+        const typename R::reg r1 = Op::vec(R::load(x + i + W), R::load(y + i + W));
+        const typename R::reg r2 = Op::vec(R::load(x + i + 2 * W), R::load(y + i + 2 * W));
+        const typename R::reg r3 = Op::vec(R::load(x + i + 3 * W), R::load(y + i + 3 * W));
+        R::store(out + i, r0);
+        R::store(out + i + W, r1);
+        R::store(out + i + 2 * W, r2);
+        R::store(out + i + 3 * W, r3);
+    }
+    for (; i + W <= n; i += W) {
+        R::store(out + i, Op::vec(R::load(x + i), R::load(y + i)));
+    }
+    for (; i < n; i++) {
+        out[i] = Op::one(x[i], y[i]);
+    }
+}
+
+// out = x op value, or value op x when ScalarFirst is set.
+template<typename R, typename Op, bool ScalarFirst>
+void binaryScalar(const typename R::value_type* x, typename R::value_type value, typename R::value_type* out, std::size_t n) {
+    constexpr std::size_t W = R::width;
+    const typename R::reg v = R::set1(value);
+    std::size_t i = 0;
+    for (; i + 2 * W <= n; i += 2 * W) {
+        const typename R::reg x0 = R::load(x + i);
+        const typename R::reg x1 = R::load(x + i + W);
+        R::store(out + i, ScalarFirst ? Op::vec(v, x0) : Op::vec(x0, v));
+        R::store(out + i + W, ScalarFirst ? Op::vec(v, x1) : Op::vec(x1, v));
+    }
+    for (; i + W <= n; i += W) {
+        const typename R::reg x0 = R::load(x + i);
+        R::store(out + i, ScalarFirst ? Op::vec(v, x0) : Op::vec(x0, v));
+    }
+    for (; i < n; i++) {
+        out[i] = ScalarFirst ? Op::one(value, x[i]) : Op::one(x[i], value);
+    }
+}
+
+// out = (x - a) - b, in that order: with a close to x the first difference is
+// exact, which x - (a + b) would not preserve.
+template<typename R>
+void subScalars(const typename R::value_type* x, typename R::value_type a, typename R::value_type b, typename R::value_type* out, std::size_t n) {
+    constexpr std::size_t W = R::width;
+    const typename R::reg va = R::set1(a);
+    const typename R::reg vb = R::set1(b);
+    std::size_t i = 0;
+    for (; i + 2 * W <= n; i += 2 * W) {
+        const typename R::reg x0 = R::load(x + i);
+        const typename R::reg x1 = R::load(x + i + W);
+        R::store(out + i, R::sub(R::sub(x0, va), vb));
+        R::store(out + i + W, R::sub(R::sub(x1, va), vb));
+    }
+    for (; i + W <= n; i += W) {
+        R::store(out + i, R::sub(R::sub(R::load(x + i), va), vb));
+    }
+    for (; i < n; i++) {
+        out[i] = (x[i] - a) - b;
+    }
+}
+
+template<typename R>
+void fma(const typename R::value_type* x, const typename R::value_type* y, const typename R::value_type* z, typename R::value_type* out, std::size_t n) {
+    constexpr std::size_t W = R::width;
+    std::size_t i = 0;
+    for (; i + W <= n; i += W) {
+        R::store(out + i, R::fmadd(R::load(x + i), R::load(y + i), R::load(z + i)));
+    }
+    for (; i < n; i++) {
+        out[i] = x[i] * y[i] + z[i];
+    }
+}
+
+template<typename R>
+void axpy(typename R::value_type alpha, const typename R::value_type* x, typename R::value_type* y, std::size_t n) {
+    constexpr std::size_t W = R::width;
+    const typename R::reg a = R::set1(alpha);
+    std::size_t i = 0;
+    for (; i + 2 * W <= n; i += 2 * W) {
+        R::store(y + i, R::fmadd(a, R::load(x + i), R::load(y + i)));
+        R::store(y + i + W, R::fmadd(a, R::load(x + i + W), R::load(y + i + W)));
+    }
+    for (; i + W <= n; i += W) {
+        R::store(y + i, R::fmadd(a, R::load(x + i), R::load(y + i)));
+    }
+    for (; i < n; i++) {
+        y[i] += alpha * x[i];
+    }
+}
+
+// Reductions keep four independent accumulators to hide the add latency.
+// Sums and dot products are accumulated over leaves of at most
+// simd::sumLeaf elements, whose registers are then added pairwise and
+// reduced horizontally once: each lane adds at most sumLeaf / W terms in
+// sequence, so the rounding error grows with log(n) whatever the width.
+
+// Pairwise sum of the registers leaf(first, last) over consecutive leaves
+// of sumLeaf elements of [0, n). partial[level] holds the sum of the last
+// 2^level complete leaves, merged like the carries of a binary counter, so
+// the tree is built in one pass without recursion.
+template<typename R, typename Leaf>
+typename R::reg pairwise(std::size_t n, const Leaf& leaf) {
+    typename R::reg partial[8 * sizeof(std::size_t)];
+    std::size_t leaves = 0;
+    for (std::size_t first = 0; first < n; first += simd::sumLeaf, leaves++) {
+        typename R::reg s = leaf(first, std::min(first + simd::sumLeaf, n));
+        std::size_t level = 0;
+        for (; (leaves >> level) & 1; level++) {
+            s = R::add(partial[level], s);
+        }
+        partial[level] = s;
+    }
+    typename R::reg total = R::zero();
+    for (std::size_t level = 0; (leaves >> level) != 0; level++) {
+        if ((leaves >> level) & 1) {
+            total = R::add(partial[level], total);
+        }
+    }
+    return total;
+}
+
+template<typename R>
+typename R::value_type dot(const typename R::value_type* x, const typename R::value_type* y, std::size_t n) {
+    constexpr std::size_t W = R::width;
+    const std::size_t vectorized = n - n % W;
+    const typename R::reg total = pairwise<R>(vectorized, [x, y](std::size_t first, std::size_t last) {
+        typename R::reg s0 = R::zero(), s1 = R::zero(), s2 = R::zero(), s3 = R::zero();
+        std::size_t i = first;
+        for (; i + 4 * W <= last; i += 4 * W) {
+            s0 = R::fmadd(R::load(x + i), R::load(y + i), s0);
+            s1 = R::fmadd(R::load(x + i + W), R::load(y + i + W), s1);
+            s2 = R::fmadd(R::load(x + i + 2 * W), R::load(y + i + 2 * W), s2);
+            s3 = R::fmadd(R::load(x + i + 3 * W), R::load(y + i + 3 * W), s3);
+        }
+        for (; i < last; i += W) {
+            s0 = R::fmadd(R::load(x + i), R::load(y + i), s0);
+        }
+        return R::add(R::add(s0, s1), R::add(s2, s3));
+    });
+    typename R::value_type result = R::hsum(total);
+    for (std::size_t i = vectorized; i < n; i++) {
+        result += x[i] * y[i];
+    }
+    return result;
+}
+
+template<typename R>
+void dot4(const typename R::value_type* a, std::size_t lda, const typename R::value_type* x, typename R::value_type* out, std::size_t n) {
+    constexpr std::size_t W = R::width;
+    const typename R::value_type* a0 = a;
+    const typename R::value_type* a1 = a + lda;
+    const typename R::value_type* a2 = a + 2 * lda;
+    const typename R::value_type* a3 = a + 3 * lda;
+    typename R::reg s0 = R::zero(), s1 = R::zero(), s2 = R::zero(), s3 = R::zero();
+    std::size_t i = 0;
+    for (; i + W <= n; i += W) {
+        const typename R::reg xi = R::load(x + i);
+        s0 = R::fmadd(R::load(a0 + i), xi, s0);
+        s1 = R::fmadd(R::load(a1 + i), xi, s1);
+        s2 = R::fmadd(R::load(a2 + i), xi, s2);
+        s3 = R::fmadd(R::load(a3 + i), xi, s3);
+    }
+    typename R::value_type r0 = R::hsum(s0), r1 = R::hsum(s1), r2 = R::hsum(s2), r3 = R::hsum(s3);
+    for (; i < n; i++) {
+        r0 += a0[i] * x[i];
+        r1 += a1[i] * x[i];
+        r2 += a2[i] * x[i];
+        r3 += a3[i] * x[i];
+    }
+    out[0] = r0;
+    out[1] = r1;
+    out[2] = r2;
+    out[3] = r3;
+}
+
+template<typename R>
+void axpy4(const typename R::value_type* alpha, const typename R::value_type* a, std::size_t lda, typename R::value_type* y, std::size_t n) {
+    constexpr std::size_t W = R::width;
+    const typename R::value_type* a0 = a;
+    const typename R::value_type* a1 = a + lda;
+    const typename R::value_type* a2 = a + 2 * lda;
+    const typename R::value_type* a3 = a + 3 * lda;
+    const typename R::reg c0 = R::set1(alpha[0]), c1 = R::set1(alpha[1]), c2 = R::set1(alpha[2]), c3 = R::set1(alpha[3]);
+    std::size_t i = 0;
+    for (; i + W <= n; i += W) {
+        typename R::reg yi = R::load(y + i);
+        yi = R::fmadd(c0, R::load(a0 + i), yi);
+        yi = R::fmadd(c1, R::load(a1 + i), yi);
+        yi = R::fmadd(c2, R::load(a2 + i), yi);
+        yi = R::fmadd(c3, R::load(a3 + i), yi);
+        R::store(y + i, yi);
+    }
+    for (; i < n; i++) {
+        y[i] += alpha[0] * a0[i] + alpha[1] * a1[i] + alpha[2] * a2[i] + alpha[3] * a3[i];
+    }
+}
+
+template<typename R>
+typename R::value_type sum(const typename R::value_type* x, std::size_t n) {
+    constexpr std::size_t W = R::width;
+    const std::size_t vectorized = n - n % W;
+    const typename R::reg total = pairwise<R>(vectorized, [x](std::size_t first, std::size_t last) {
+        typename R::reg s0 = R::zero(), s1 = R::zero(), s2 = R::zero(), s3 = R::zero();
+        std::size_t i = first;
+        for (; i + 4 * W <= last; i += 4 * W) {
+            s0 = R::add(R::load(x + i), s0);
+            s1 = R::add(R::load(x + i + W), s1);
+            s2 = R::add(R::load(x + i + 2 * W), s2);
+            s3 = R::add(R::load(x + i + 3 * W), s3);
+        }
+        for (; i < last; i += W) {
+            s0 = R::add(R::load(x + i), s0);
+        }
+        return R::add(R::add(s0, s1), R::add(s2, s3));
+    });
+    typename R::value_type result = R::hsum(total);
+    for (std::size_t i = vectorized; i < n; i++) {
+        result += x[i];
+    }
+    return result;
+}
+
+// Max or min of x, with Op MaxOp or MinOp.
+template<typename R, typename Op>
+typename R::value_type extremum(const typename R::value_type* x, std::size_t n) {
+    constexpr std::size_t W = R::width;
+    typename R::value_type result = x[0];
+    std::size_t i = 0;
+    if (n >= W) {
+        typename R::reg m0 = R::load(x);
+        typename R::reg m1 = m0;
+        for (i = W; i + 2 * W <= n; i += 2 * W) {
+            m0 = Op::vec(m0, R::load(x + i));
+            m1 = Op::vec(m1, R::load(x + i + W));
+        }
+        for (; i + W <= n; i += W) {
+            m0 = Op::vec(m0, R::load(x + i));
+        }
+        result = Op::horizontal(Op::vec(m0, m1));
+    }
+    for (; i < n; i++) {
+        result = Op::one(x[i], result);
+    }
+    return result;
+}
+
+// Constants of expReg(): the range x is clamped to, beyond which exp(x)
+// rounds to 0 or infinity, ln(2) split into a head whose products with k
+// are exact and a tail, and the coefficients of the polynomial P with
+// exp(r) ~ 1 + r + r^2 P(r) on |r| <= ln(2) / 2, highest degree first
+// (Cephes for float, Taylor for double).
+template<typename T>
+struct ExpConstants;
+
+template<>
+struct ExpConstants<float> {
+    static constexpr float lo = -104.f;
+    static constexpr float hi = 89.f;
+    static constexpr float log2e = 1.44269504088896341f;
+    static constexpr float ln2Hi = 0.693359375f;
+    static constexpr float ln2Lo = -2.12194440e-4f;
+    static constexpr float coefficients[] = {
+        1.9875691500e-4f, 1.3981999507e-3f, 8.3334519073e-3f, 4.1665795894e-2f, 1.6666665459e-1f, 5.0000001201e-1f
+    };
+};
+
+template<>
+struct ExpConstants<double> {
+    static constexpr double lo = -746.;
+    static constexpr double hi = 710.;
+    static constexpr double log2e = 1.4426950408889634;
+    static constexpr double ln2Hi = 6.93145751953125e-1;
+    static constexpr double ln2Lo = 1.42860682030941723212e-6;
+    static constexpr double coefficients[] = {
+        1. / 6227020800., 1. / 479001600., 1. / 39916800., 1. / 3628800., 1. / 362880., 1. / 40320.,
+        1. / 5040., 1. / 720., 1. / 120., 1. / 24., 1. / 6., 1. / 2.
+    };
+};
+
+// exp(x) in every lane, to a few ulps: x = k ln(2) + r with k integral, the
+// polynomial gives exp(r), and 2^k is applied in two halves so that results
+// below the normal range underflow gradually to 0 (exp(-inf) = 0) and
+// results above it overflow to infinity. NaNs propagate.
+template<typename R>
+typename R::reg expReg(typename R::reg x) {
+    using C = ExpConstants<typename R::value_type>;
+    // max and min return their second operand when either is NaN.
+    x = R::min(R::set1(C::hi), R::max(R::set1(C::lo), x));
+    const typename R::reg k = R::round(R::mul(x, R::set1(C::log2e)));
+    typename R::reg r = R::fmadd(k, R::set1(-C::ln2Hi), x);
+    r = R::fmadd(k, R::set1(-C::ln2Lo), r);
+    typename R::reg p = R::zero();
+    for (typename R::value_type c : C::coefficients) {
+        p = R::fmadd(p, r, R::set1(c));
+    }
+    p = R::fmadd(R::mul(p, r), r, R::add(r, R::set1(1)));
+    const typename R::reg half = R::round(R::mul(k, R::set1(0.5)));
+    return R::mul(R::mul(p, R::pow2(half)), R::pow2(R::sub(k, half)));
+}
+
+// out = scale * exp(x - shift). The tail goes through a padded register, so
+// that every element is rounded as in the vector loop.
+template<typename R>
+void exp(const typename R::value_type* x, typename R::value_type shift, typename R::value_type scale, typename R::value_type* out, std::size_t n) {
+    using T = typename R::value_type;
+    constexpr std::size_t W = R::width;
+    const typename R::reg s = R::set1(shift);
+    const typename R::reg c = R::set1(scale);
+    std::size_t i = 0;
+    for (; i + 2 * W <= n; i += 2 * W) {
+        const typename R::reg r0 = R::mul(c, expReg<R>(R::sub(R::load(x + i), s)));
+        const typename R::reg r1 = R::mul(c, expReg<R>(R::sub(R::load(x + i + W), s)));
+        R::store(out + i, r0);
+        R::store(out + i + W, r1);
+    }
+    for (; i + W <= n; i += W) {
+        R::store(out + i, R::mul(c, expReg<R>(R::sub(R::load(x + i), s))));
+    }
+    if (i < n) {
+        T buffer[W] = {};
+        std::memcpy(buffer, x + i, (n - i) * sizeof(T));
+        R::store(buffer, R::mul(c, expReg<R>(R::sub(R::load(buffer), s))));
+        std::memcpy(out + i, buffer, (n - i) * sizeof(T));
+    }
+}
+
+// Sum of exp(x - max) with max the maximum of x, in one pass over x. Each
+// lane keeps a running maximum m and the sum of exp(x - m), rescaled by
+// exp(m - m') when a block of 4 registers raises the maximum to m'; the
+// lanes are merged the same way. The sum is 0 for n == 0 or when every x is
+// -inf.
+template<typename R>
+typename R::value_type sumExp(const typename R::value_type* x, std::size_t n, typename R::value_type* max) {
+    using T = typename R::value_type;
+    using reg = typename R::reg;
+    constexpr std::size_t W = R::width;
+    constexpr T lowest = -std::numeric_limits<T>::max();
+    reg m = R::set1(lowest);
+    reg s = R::zero();
+    std::size_t i = 0;
+    for (; i + 4 * W <= n; i += 4 * W) {
+        const reg v0 = R::load(x + i);
+        const reg v1 = R::load(x + i + W);
+        const reg v2 = R::load(x + i + 2 * W);
+        const reg v3 = R::load(x + i + 3 * W);
+        const reg next = R::max(m, R::max(R::max(v0, v1), R::max(v2, v3)));
+        const reg e0 = R::add(expReg<R>(R::sub(v0, next)), expReg<R>(R::sub(v1, next)));
+        const reg e1 = R::add(expReg<R>(R::sub(v2, next)), expReg<R>(R::sub(v3, next)));
+        s = R::fmadd(s, expReg<R>(R::sub(m, next)), R::add(e0, e1));
+        m = next;
+    }
+    for (; i < n; i += W) {
+        reg v;
+        if (i + W <= n) {
+            v = R::load(x + i);
+        } else {
+            T buffer[W];
+            std::fill(buffer, buffer + W, -std::numeric_limits<T>::infinity());
+            std::memcpy(buffer, x + i, (n - i) * sizeof(T));
+            v = R::load(buffer);
+        }
+        const reg next = R::max(m, v);
+        s = R::fmadd(s, expReg<R>(R::sub(m, next)), expReg<R>(R::sub(v, next)));
+        m = next;
+    }
+    *max = R::hmax(m);
+    return R::hsum(R::mul(s, expReg<R>(R::sub(m, R::set1(*max)))));
+}
+
+template<typename R, bool Momentum, bool Nesterov>
+void sgdUpdate(typename R::value_type* w, const typename R::value_type* g, typename R::value_type* velocity, std::size_t n, const simd::SgdUpdate<typename R::value_type>& u) {
+    using T = typename R::value_type;
+    constexpr std::size_t W = R::width;
+    const typename R::reg rate = R::set1(-u.learningRate);
+    const typename R::reg momentum = R::set1(u.momentum);
+    const typename R::reg decay = R::set1(u.weightDecay);
+    std::size_t i = 0;
+    for (; i + W <= n; i += W) {
+        const typename R::reg wi = R::load(w + i);
+        typename R::reg d = R::fmadd(decay, wi, R::load(g + i));
+        if constexpr (Momentum) {
+            const typename R::reg v = R::fmadd(momentum, R::load(velocity + i), d);
+            R::store(velocity + i, v);
+            d = Nesterov ? R::fmadd(momentum, v, d) : v;
+        }
+        R::store(w + i, R::fmadd(rate, d, wi));
+    }
+    for (; i < n; i++) {
+        T d = g[i] + u.weightDecay * w[i];
+        if constexpr (Momentum) {
+            velocity[i] = u.momentum * velocity[i] + d;
+            d = Nesterov ? d + u.momentum * velocity[i] : velocity[i];
+        }
+        w[i] -= u.learningRate * d;
+    }
+}
+
+// One SGD step, see simd::SgdUpdate.
+template<typename R>
+void sgd(typename R::value_type* w, const typename R::value_type* g, typename R::value_type* velocity, std::size_t n, const simd::SgdUpdate<typename R::value_type>& u) {
+    if (u.momentum == 0) {
+        sgdUpdate<R, false, false>(w, g, velocity, n, u);
+    } else if (u.nesterov) {
+        sgdUpdate<R, true, true>(w, g, velocity, n, u);
+    } else {
+        sgdUpdate<R, true, false>(w, g, velocity, n, u);
+    }
+}
+
+// One Adam step, see simd::AdamUpdate.
+template<typename R>
+void adam(typename R::value_type* w, const typename R::value_type* g, typename R::value_type* m, typename R::value_type* v, std::size_t n, const simd::AdamUpdate<typename R::value_type>& u) {
+    using T = typename R::value_type;
+    constexpr std::size_t W = R::width;
+    const typename R::reg beta1 = R::set1(u.beta1);
+    const typename R::reg beta2 = R::set1(u.beta2);
+    const typename R::reg rest1 = R::set1(T(1) - u.beta1);
+    const typename R::reg rest2 = R::set1(T(1) - u.beta2);
+    const typename R::reg epsilon = R::set1(u.epsilon);
+    const typename R::reg weightDecay = R::set1(u.weightDecay);
+    const typename R::reg decay = R::set1(u.decay);
+    const typename R::reg stepSize = R::set1(-u.stepSize);
+    const typename R::reg correction2 = R::set1(u.correction2);
+    std::size_t i = 0;
+    for (; i + W <= n; i += W) {
+        const typename R::reg wi = R::load(w + i);
+        const typename R::reg gi = R::fmadd(weightDecay, wi, R::load(g + i));
+        const typename R::reg mi = R::fmadd(beta1, R::load(m + i), R::mul(rest1, gi));
+        const typename R::reg vi = R::fmadd(beta2, R::load(v + i), R::mul(rest2, R::mul(gi, gi)));
+        R::store(m + i, mi);
+        R::store(v + i, vi);
+        const typename R::reg denominator = R::fmadd(R::sqrt(vi), correction2, epsilon);
+        R::store(w + i, R::fmadd(stepSize, R::div(mi, denominator), R::mul(decay, wi)));
+    }
+    for (; i < n; i++) {
+        const T gi = g[i] + u.weightDecay * w[i];
+        m[i] = u.beta1 * m[i] + (T(1) - u.beta1) * gi;
+        v[i] = u.beta2 * v[i] + (T(1) - u.beta2) * gi * gi;
+        w[i] = u.decay * w[i] - u.stepSize * m[i] / (std::sqrt(v[i]) * u.correction2 + u.epsilon);
+    }
+}
+
+// MR x NR outer-product accumulation over packed GEMM slivers. The
+// accumulators stay in registers for the whole kc loop.
+template<typename R, std::size_t MR, std::size_t NR>
+void gemmTile(std::size_t kc, const typename R::value_type* a, const typename R::value_type* b, typename R::value_type* c) {
+    constexpr std::size_t NV = NR / R::width;
+    typename R::reg acc[MR][NV];
+#pragma GCC unroll 16
+    for (std::size_t r = 0; r < MR; r++) {
+#pragma GCC unroll 16
+        for (std::size_t v = 0; v < NV; v++) {
+            acc[r][v] = R::zero();
+        }
+    }
+    for (std::size_t p = 0; p < kc; p++) {
+        typename R::reg bv[NV];
+#pragma GCC unroll 16
+        for (std::size_t v = 0; v < NV; v++) {
+            bv[v] = R::load(b + v * R::width);
+        }
+#pragma GCC unroll 16
+        for (std::size_t r = 0; r < MR; r++) {
+            const typename R::reg ar = R::set1(a[r]);
+#pragma GCC unroll 16
+            for (std::size_t v = 0; v < NV; v++) {
+                acc[r][v] = R::fmadd(ar, bv[v], acc[r][v]);
+            }
+        }
+        a += MR;
+        b += NR;
+    }
+#pragma GCC unroll 16
+    for (std::size_t r = 0; r < MR; r++) {
+#pragma GCC unroll 16
+        for (std::size_t v = 0; v < NV; v++) {
+            R::store(c + r * NR + v * R::width, acc[r][v]);
+        }
+    }
+}
+
+// Same tile as gemmTile for the int8 GEMM, over kc / 2 pairs of k.
+template<typename I, std::size_t MR, std::size_t NR>
+void gemmTileInt8(std::size_t kc, const std::int16_t* a, const std::int16_t* b, std::int32_t* c) {
+    constexpr std::size_t NV = NR / I::width;
+    typename I::reg acc[MR][NV];
+#pragma GCC unroll 16
+    for (std::size_t r = 0; r < MR; r++) {
+#pragma GCC unroll 16
+        for (std::size_t v = 0; v < NV; v++) {
+            acc[r][v] = I::zero();
+        }
+    }
+    for (std::size_t p = 0; p < kc; p += 2) {
+        typename I::reg bv[NV];
+#pragma GCC unroll 16
+        for (std::size_t v = 0; v < NV; v++) {
+            bv[v] = I::load(b + 2 * v * I::width);
+        }
+#pragma GCC unroll 16
+        for (std::size_t r = 0; r < MR; r++) {
+            std::int32_t pair;
+            std::memcpy(&pair, a + 2 * r, sizeof(pair));
+            const typename I::reg ar = I::set1(pair);
+#pragma GCC unroll 16
+            for (std::size_t v = 0; v < NV; v++) {
+                acc[r][v] = I::madd(ar, bv[v], acc[r][v]);
+            }
+        }
+        a += 2 * MR;
+        b += 2 * NR;
+    }
+#pragma GCC unroll 16
+    for (std::size_t r = 0; r < MR; r++) {
+#pragma GCC unroll 16
+        for (std::size_t v = 0; v < NV; v++) {
+            I::store(c + r * NR + v * I::width, acc[r][v]);
+        }
+    }
+}
+
+template<typename R>
+void transposeBlock(
+    const typename R::value_type* a, std::size_t lda,
+    typename R::value_type* b, std::size_t ldb,
+    std::size_t rows, std::size_t cols
+) {
+    constexpr std::size_t W = R::width;
+    std::size_t i = 0;
+    for (; i + W <= rows; i += W) {
+        std::size_t j = 0;
+        for (; j + W <= cols; j += W) {
+            R::transposeTile(a + i * lda + j, lda, b + j * ldb + i, ldb);
+        }
+        for (; j < cols; j++) {
+            for (std::size_t r = i; r < i + W; r++) {
+                b[j * ldb + r] = a[r * lda + j];
+            }
+        }
+    }
+    for (; i < rows; i++) {
+        for (std::size_t j = 0; j < cols; j++) {
+            b[j * ldb + i] = a[i * lda + j];
+        }
+    }
+}
+
+// 16-bit storage: blocks are widened to float registers as they are loaded.
+
+template<typename R, typename H>
+typename R::reg loadHalf(const H* p) {
+    if constexpr (std::is_same_v<H, BFloat16>) {
+        return R::loadBFloat16(p);
+    } else {
+        return R::loadFloat16(p);
+    }
+}
+
+template<typename R, typename H>
+void storeHalf(H* p, typename R::reg r) {
+    if constexpr (std::is_same_v<H, BFloat16>) {
+        R::storeBFloat16(p, r);
+    } else {
+        R::storeFloat16(p, r);
+    }
+}
+
+template<typename R, typename H>
+void widen(const H* x, float* out, std::size_t n) {
+    constexpr std::size_t W = R::width;
+    std::size_t i = 0;
+    for (; i + W <= n; i += W) {
+        R::store(out + i, loadHalf<R>(x + i));
+    }
+    for (; i < n; i++) {
+        out[i] = x[i];
+    }
+}
+
+template<typename R, typename H>
+void narrow(const float* x, H* out, std::size_t n) {
+    constexpr std::size_t W = R::width;
+    std::size_t i = 0;
+    for (; i + W <= n; i += W) {
+        storeHalf<R>(out + i, R::load(x + i));
+    }
+    for (; i < n; i++) {
+        out[i] = H(x[i]);
+    }
+}
+
+template<typename R, typename H>
+float dotHalf(const H* x, const H* y, std::size_t n) {
+    constexpr std::size_t W = R::width;
+    const std::size_t vectorized = n - n % W;
+    const typename R::reg total = pairwise<R>(vectorized, [x, y](std::size_t first, std::size_t last) {
+        typename R::reg s0 = R::zero(), s1 = R::zero();
+        std::size_t i = first;
+        for (; i + 2 * W <= last; i += 2 * W) {
+            s0 = R::fmadd(loadHalf<R>(x + i), loadHalf<R>(y + i), s0);
+            s1 = R::fmadd(loadHalf<R>(x + i + W), loadHalf<R>(y + i + W), s1);
+        }
+        for (; i < last; i += W) {
+            s0 = R::fmadd(loadHalf<R>(x + i), loadHalf<R>(y + i), s0);
+        }
+        return R::add(s0, s1);
+    });
+    float result = R::hsum(total);
+    for (std::size_t i = vectorized; i < n; i++) {
+        result += float(x[i]) * float(y[i]);
+    }
+    return result;
+}
+
+template<typename R, typename H>
+float sumHalf(const H* x, std::size_t n) {
+    constexpr std::size_t W = R::width;
+    const std::size_t vectorized = n - n % W;
+    const typename R::reg total = pairwise<R>(vectorized, [x](std::size_t first, std::size_t last) {
+        typename R::reg s0 = R::zero(), s1 = R::zero();
+        std::size_t i = first;
+        for (; i + 2 * W <= last; i += 2 * W) {
+            s0 = R::add(loadHalf<R>(x + i), s0);
+            s1 = R::add(loadHalf<R>(x + i + W), s1);
+        }
+        for (; i < last; i += W) {
+            s0 = R::add(loadHalf<R>(x + i), s0);
+        }
+        return R::add(s0, s1);
+    });
+    float result = R::hsum(total);
+    for (std::size_t i = vectorized; i < n; i++) {
+        result += float(x[i]);
+    }
+    return result;
+}
+
+template<typename R>
+simd::BasicKernels<typename R::value_type> makeKernels(simd::Isa isa) {
+    using T = typename R::value_type;
+    simd::BasicKernels<T> k;
+    k.isa = isa;
+    k.add = &binary<R, AddOp<R>>;
+    k.sub = &binary<R, SubOp<R>>;
+    k.mul = &binary<R, MulOp<R>>;
+    k.div = &binary<R, DivOp<R>>;
+    k.maximum = &binary<R, MaxOp<R>>;
+    k.minimum = &binary<R, MinOp<R>>;
+    k.addScalar = &binaryScalar<R, AddOp<R>, false>;
+    k.subScalar = &binaryScalar<R, SubOp<R>, false>;
+    k.mulScalar = &binaryScalar<R, MulOp<R>, false>;
+    k.divScalar = &binaryScalar<R, DivOp<R>, false>;
+    k.scalarSub = [](T value, const T* x, T* out, std::size_t n) {
+        binaryScalar<R, SubOp<R>, true>(x, value, out, n);
+    };
+    k.scalarDiv = [](T value, const T* x, T* out, std::size_t n) {
+        binaryScalar<R, DivOp<R>, true>(x, value, out, n);
+    };
+    k.subScalars = &subScalars<R>;
+    k.fma = &fma<R>;
+    k.axpy = &axpy<R>;
+    k.dot = &dot<R>;
+    k.dot4 = &dot4<R>;
+    k.axpy4 = &axpy4<R>;
+    k.sum = &sum<R>;
+    k.max = &extremum<R, MaxOp<R>>;
+    k.min = &extremum<R, MinOp<R>>;
+    k.exp = &exp<R>;
+    k.sumExp = &sumExp<R>;
+    k.sgd = &sgd<R>;
+    k.adam = &adam<R>;
+    k.gemmTile = &gemmTile<R, simd::gemmMR, simd::gemmNRFor<T>>;
+    k.transpose = &transposeBlock<R>;
+    return k;
+}
+
+template<typename F>
+simd::HalfKernels makeHalfKernels() {
+    simd::HalfKernels k;
+    k.fromBFloat16 = &widen<F, BFloat16>;
+    k.toBFloat16 = &narrow<F, BFloat16>;
+    k.fromFloat16 = &widen<F, Float16>;
+    k.toFloat16 = &narrow<F, Float16>;
+    k.dotBFloat16 = &dotHalf<F, BFloat16>;
+    k.dotFloat16 = &dotHalf<F, Float16>;
+    k.sumBFloat16 = &sumHalf<F, BFloat16>;
+    k.sumFloat16 = &sumHalf<F, Float16>;
+    return k;
+}
+
+template<typename I>
+simd::Int8Kernels makeInt8Kernels() {
+    simd::Int8Kernels k;
+    k.gemmTile = &gemmTileInt8<I, simd::gemmMR, simd::gemmNRFor<std::int32_t>>;
+    return k;
+}
+
+// Double, float, 16-bit and int8 tables of one instruction set, from the
+// double traits D, the float traits F and the integer traits I.
+template<typename D, typename F, typename I>
+simd::KernelSet makeKernelSet(simd::Isa isa) {
+    return simd::KernelSet{isa, makeKernels<D>(isa), makeKernels<F>(isa), makeHalfKernels<F>(), makeInt8Kernels<I>()};
+}
@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "simd/Simd.hpp"
+
+namespace simd::scalar {
+
+struct Regs {
+    using value_type = double;
+    using reg = double;
+    static constexpr std::size_t width = 1;
+    static reg load(const double* p) { return *p; }
+    static void store(double* p, reg r) { *p = r; }
+    static reg set1(double value) { return value; }
+    static reg zero() { return 0.; }
+    static reg add(reg a, reg b) { return a + b; }
+    static reg sub(reg a, reg b) { return a - b; }
+    static reg mul(reg a, reg b) { return a * b; }
+    static reg div(reg a, reg b) { return a / b; }
+    static reg fmadd(reg a, reg b, reg c) { return a * b + c; }
+    static reg sqrt(reg r) { return std::sqrt(r); }
+    static reg max(reg a, reg b) { return (a > b) ? a : b; }
+    static reg min(reg a, reg b) { return (a < b) ? a : b; }
+    static double hsum(reg r) { return r; }
+    static double hmax(reg r) { return r; }
+    static double hmin(reg r) { return r; }
+    static reg round(reg r) { return std::nearbyint(r); }
+    static reg pow2(reg k) { return std::exp2(k); }
+    static void transposeTile(const double* a, std::size_t, double* b, std::size_t) { *b = *a; }
+};
+
+struct FloatRegs {
+    using value_type = float;
+    using reg = float;
+    static constexpr std::size_t width = 1;
+    static reg load(const float* p) { return *p; }
+    static void store(float* p, reg r) { *p = r; }
+    static reg set1(float value) { return value; }
+    static reg zero() { return 0.f; }
+    static reg add(reg a, reg b) { return a + b; }
+    static reg sub(reg a, reg b) { return a - b; }
+    static reg mul(reg a, reg b) { return a * b; }
+    static reg div(reg a, reg b) { return a / b; }
+    static reg fmadd(reg a, reg b, reg c) { return a * b + c; }
+    static reg sqrt(reg r) { return std::sqrt(r); }
+    static reg max(reg a, reg b) { return (a > b) ? a : b; }
+    static reg min(reg a, reg b) { return (a < b) ? a : b; }
+    static float hsum(reg r) { return r; }
+    static float hmax(reg r) { return r; }
+    static float hmin(reg r) { return r; }
+    static reg round(reg r) { return std::nearbyint(r); }
+    static reg pow2(reg k) { return std::exp2(k); }
+    static void transposeTile(const float* a, std::size_t, float* b, std::size_t) { *b = *a; }
+    static reg loadBFloat16(const BFloat16* p) { return *p; }
+    static void storeBFloat16(BFloat16* p, reg r) { *p = BFloat16(r); }
+    static reg loadFloat16(const Float16* p) { return *p; }
+    static void storeFloat16(Float16* p, reg r) { *p = Float16(r); }
+};
+
+// One int32 lane holding an int16 pair, or the sum of the products of two.
+struct IntRegs {
+    using reg = std::int32_t;
+    static constexpr std::size_t width = 1;
+    static reg load(const std::int16_t* p) {
+        reg r;
+        std::memcpy(&r, p, sizeof(r));
+        return r;
+    }
+    static void store(std::int32_t* p, reg r) { *p = r; }
+    static reg set1(std::int32_t pair) { return pair; }
+    static reg zero() { return 0; }
+    static reg madd(reg a, reg b, reg c) {
+        std::int16_t x[2], y[2];
+        std::memcpy(x, &a, sizeof(a));
+        std::memcpy(y, &b, sizeof(b));
+        return c + std::int32_t(x[0]) * y[0] + std::int32_t(x[1]) * y[1];
+    }
+};
+
+#include "simd/SimdKernels.inl"
+
+}
+
+const simd::KernelSet& simd::scalarKernels() {
+    static const KernelSet k = scalar::makeKernelSet<scalar::Regs, scalar::FloatRegs, scalar::IntRegs>(Isa::Scalar);
+    return k;
+}
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "simd/Simd.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+namespace simd::sse2 {
+
+struct Regs {
+    using value_type = double;
+    using reg = __m128d;
+    static constexpr std::size_t width = 2;
+    static reg load(const double* p) { return _mm_loadu_pd(p); }
+    static void store(double* p, reg r) { _mm_storeu_pd(p, r); }
+    static reg set1(double value) { return _mm_set1_pd(value); }
+    static reg zero() { return _mm_setzero_pd(); }
+    static reg add(reg a, reg b) { return _mm_add_pd(a, b); }
+    static reg sub(reg a, reg b) { return _mm_sub_pd(a, b); }
+    static reg mul(reg a, reg b) { return _mm_mul_pd(a, b); }
+    static reg div(reg a, reg b) { return _mm_div_pd(a, b); }
+    static reg fmadd(reg a, reg b, reg c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+    static reg sqrt(reg r) { return _mm_sqrt_pd(r); }
+    static reg max(reg a, reg b) { return _mm_max_pd(a, b); }
+    static reg min(reg a, reg b) { return _mm_min_pd(a, b); }
+    static double hsum(reg r) { return _mm_cvtsd_f64(_mm_add_sd(r, _mm_unpackhi_pd(r, r))); }
+    static double hmax(reg r) { return _mm_cvtsd_f64(_mm_max_sd(r, _mm_unpackhi_pd(r, r))); }
+    static double hmin(reg r) { return _mm_cvtsd_f64(_mm_min_sd(r, _mm_unpackhi_pd(r, r))); }
+    // No roundpd before SSE4.1: through int32, under the default rounding mode.
+    static reg round(reg r) { return _mm_cvtepi32_pd(_mm_cvtpd_epi32(r)); }
+    static reg pow2(reg k) {
+        const __m128i e = _mm_add_epi32(_mm_cvtpd_epi32(k), _mm_set1_epi32(1023));
+        return _mm_castsi128_pd(_mm_slli_epi64(_mm_unpacklo_epi32(e, _mm_setzero_si128()), 52));
+    }
+    static void transposeTile(const double* a, std::size_t lda, double* b, std::size_t ldb) {
+        const reg r0 = _mm_loadu_pd(a);
+        const reg r1 = _mm_loadu_pd(a + lda);
+        _mm_storeu_pd(b, _mm_unpacklo_pd(r0, r1));
+        _mm_storeu_pd(b + ldb, _mm_unpackhi_pd(r0, r1));
+    }
+};
+
+struct FloatRegs {
+    using value_type = float;
+    using reg = __m128;
+    static constexpr std::size_t width = 4;
+    static reg load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, reg r) { _mm_storeu_ps(p, r); }
+    static reg set1(float value) { return _mm_set1_ps(value); }
+    static reg zero() { return _mm_setzero_ps(); }
+    static reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+    static reg sub(reg a, reg b) { return _mm_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+    static reg div(reg a, reg b) { return _mm_div_ps(a, b); }
+    static reg fmadd(reg a, reg b, reg c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    static reg sqrt(reg r) { return _mm_sqrt_ps(r); }
+    static reg max(reg a, reg b) { return _mm_max_ps(a, b); }
+    static reg min(reg a, reg b) { return _mm_min_ps(a, b); }
+    static float hsum(reg r) {
+        const reg h = _mm_add_ps(r, _mm_movehl_ps(r, r));
+        return _mm_cvtss_f32(_mm_add_ss(h, _mm_shuffle_ps(h, h, 1)));
+    }
+    static float hmax(reg r) {
+        const reg h = _mm_max_ps(r, _mm_movehl_ps(r, r));
+        return _mm_cvtss_f32(_mm_max_ss(h, _mm_shuffle_ps(h, h, 1)));
+    }
+    static float hmin(reg r) {
+        const reg h = _mm_min_ps(r, _mm_movehl_ps(r, r));
+        return _mm_cvtss_f32(_mm_min_ss(h, _mm_shuffle_ps(h, h, 1)));
+    }
+    static reg round(reg r) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(r)); }
+    static reg pow2(reg k) {
+        return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(k), _mm_set1_epi32(127)), 23));
+    }
+    static void transposeTile(const float* a, std::size_t lda, float* b, std::size_t ldb) {
+        reg r0 = _mm_loadu_ps(a);
+        reg r1 = _mm_loadu_ps(a + lda);
+        reg r2 = _mm_loadu_ps(a + 2 * lda);
+        reg r3 = _mm_loadu_ps(a + 3 * lda);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_storeu_ps(b, r0);
+        _mm_storeu_ps(b + ldb, r1);
+        _mm_storeu_ps(b + 2 * ldb, r2);
+        _mm_storeu_ps(b + 3 * ldb, r3);
+    }
+    // bfloat16 is the top half of a float: widening interleaves zeros below.
+    static reg loadBFloat16(const BFloat16* p) {
+        const __m128i h = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+        return _mm_castsi128_ps(_mm_unpacklo_epi16(_mm_setzero_si128(), h));
+    }
+    // Rounds to nearest even as BFloat16::fromFloat, quieting NaNs.
+    static void storeBFloat16(BFloat16* p, reg r) {
+        const __m128i bits = _mm_castps_si128(r);
+        const __m128i odd = _mm_and_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(1));
+        const __m128i rounded = _mm_add_epi32(bits, _mm_add_epi32(odd, _mm_set1_epi32(0x7FFF)));
+        const __m128i nan = _mm_castps_si128(_mm_cmpunord_ps(r, r));
+        const __m128i quiet = _mm_or_si128(bits, _mm_set1_epi32(0x400000));
+        const __m128i result = _mm_or_si128(_mm_andnot_si128(nan, rounded), _mm_and_si128(nan, quiet));
+        // The arithmetic shift keeps the top halves in int16 range, so the
+        // saturating pack leaves them unchanged.
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packs_epi32(_mm_srai_epi32(result, 16), _mm_setzero_si128()));
+    }
+    // No binary16 conversion instructions before F16C.
+    static reg loadFloat16(const Float16* p) {
+        return _mm_setr_ps(p[0], p[1], p[2], p[3]);
+    }
+    static void storeFloat16(Float16* p, reg r) {
+        alignas(16) float values[4];
+        _mm_store_ps(values, r);
+        for (std::size_t i = 0; i < 4; i++) {
+            p[i] = Float16(values[i]);
+        }
+    }
+};
+
+struct IntRegs {
+    using reg = __m128i;
+    static constexpr std::size_t width = 4;
+    static reg load(const std::int16_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static void store(std::int32_t* p, reg r) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), r); }
+    static reg set1(std::int32_t pair) { return _mm_set1_epi32(pair); }
+    static reg zero() { return _mm_setzero_si128(); }
+    static reg madd(reg a, reg b, reg c) { return _mm_add_epi32(c, _mm_madd_epi16(a, b)); }
+};
+
+#include "simd/SimdKernels.inl"
+
+}
+
+const simd::KernelSet& simd::sse2Kernels() {
+    static const KernelSet k = sse2::makeKernelSet<sse2::Regs, sse2::FloatRegs, sse2::IntRegs>(Isa::Sse2);
+    return k;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif
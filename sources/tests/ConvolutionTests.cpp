@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "gemm/Epilogue.hpp"
+#include "ndarray/NDArray.hpp"
+#include "nn/Convolution.hpp"
+#include "nn/Pooling.hpp"
+#include "tests/Test.hpp"
+
+using Shape = std::vector<std::size_t>;
+
+static NDArray<double> randomArray(const Shape& shape, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    NDArray<double> a(shape, MemoryFormat::RowMajor);
+    for (std::size_t i = 0; i < a.size(); i++) {
+        a.data()[i] = uniform(rng);
+    }
+    return a;
+}
+
+// The three ways activations can be stored: NCHW row-major, NHWC row-major,
+// and NCHW in the channels-last memory format. The references below work on
+// NCHW row-major arrays and K x C x R x S weights.
+enum class Storage {
+    NCHW,
+    NHWC,
+    ChannelsLast
+};
+
+const Storage storages[] = {Storage::NCHW, Storage::NHWC, Storage::ChannelsLast};
+
+static nn::Layout layoutOf(Storage storage) {
+    return (storage == Storage::NHWC) ? nn::Layout::NHWC : nn::Layout::NCHW;
+}
+
+static NDArray<double> store(const NDArray<double>& nchw, Storage storage) {
+    switch (storage) {
+        case Storage::NHWC: return nchw.transpose({0, 2, 3, 1}).copy();
+        case Storage::ChannelsLast: return nchw.to_format(MemoryFormat::ChannelsLast);
+        default: return nchw;
+    }
+}
+
+static NDArray<double> canonical(const NDArray<double>& a, Storage storage) {
+    switch (storage) {
+        case Storage::NHWC: return a.transpose({0, 3, 1, 2}).copy();
+        case Storage::ChannelsLast: return a.to_format(MemoryFormat::RowMajor);
+        default: return a;
+    }
+}
+
+// K x C x R x S weights as the convolution of storage takes them.
+static NDArray<double> storeWeights(const NDArray<double>& kcrs, Storage storage) {
+    return (storage == Storage::NCHW) ? kcrs : kcrs.transpose({2, 3, 1, 0}).copy();
+}
+
+static NDArray<double> canonicalWeights(const NDArray<double>& w, Storage storage) {
+    return (storage == Storage::NCHW) ? w : w.transpose({3, 2, 0, 1}).copy();
+}
+
+static double maxDifference(const NDArray<double>& a, const NDArray<double>& b) {
+    CHECK(a.shape() == b.shape());
+    double error = 0;
+    for (std::size_t i = 0; i < std::min(a.size(), b.size()); i++) {
+        error = std::max(error, std::abs(a.data()[i] - b.data()[i]));
+    }
+    return error;
+}
+
+// Calls fn(n, k, c, oh, ow, h, w, r, s) for every product of the convolution
+// that reads a real input element rather than the padding.
+template<typename F>
+static void forEachTap(const Shape& input, const Shape& weights, const Shape& output, const nn::Conv2dOptions& o, F fn) {
+    for (std::size_t n = 0; n < output[0]; n++) {
+        for (std::size_t k = 0; k < output[1]; k++) {
+            for (std::size_t oh = 0; oh < output[2]; oh++) {
+                for (std::size_t ow = 0; ow < output[3]; ow++) {
+                    for (std::size_t c = 0; c < input[1]; c++) {
+                        for (std::size_t r = 0; r < weights[2]; r++) {
+                            for (std::size_t s = 0; s < weights[3]; s++) {
+                                const long h = static_cast<long>(oh * o.strideH + r * o.dilationH) - static_cast<long>(o.padH);
+                                const long w = static_cast<long>(ow * o.strideW + s * o.dilationW) - static_cast<long>(o.padW);
+                                if (h >= 0 && w >= 0 && h < static_cast<long>(input[2]) && w < static_cast<long>(input[3])) {
+                                    fn(n, k, c, oh, ow, static_cast<std::size_t>(h), static_cast<std::size_t>(w), r, s);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+struct ConvCase {
+    std::size_t stride, pad, dilation;
+};
+
+const ConvCase convCases[] = {{1, 0, 1}, {2, 1, 1}, {1, 2, 2}, {2, 1, 2}, {3, 0, 1}};
+
+TEST(conv2dForward) {
+    const NDArray<double> input = randomArray({2, 3, 11, 9}, 1);
+    const NDArray<double> weights = randomArray({5, 3, 3, 2}, 2);
+    const NDArray<double> bias = randomArray({5}, 3);
+    for (const ConvCase& cc : convCases) {
+        nn::Conv2dOptions o;
+        o.strideH = cc.stride;
+        o.strideW = cc.stride + 1;
+        o.padH = cc.pad;
+        o.padW = cc.pad;
+        o.dilationH = cc.dilation;
+        o.dilationW = cc.dilation;
+        const Shape shape = nn::conv2dOutputShape(input.shape(), weights.shape(), o);
+        NDArray<double> expected(shape, MemoryFormat::RowMajor, 0.0);
+        forEachTap(input.shape(), weights.shape(), shape, o, [&](auto n, auto k, auto c, auto oh, auto ow, auto h, auto w, auto r, auto s) {
+            expected(n, k, oh, ow) += input(n, c, h, w) * weights(k, c, r, s);
+        });
+        NDArray<double> activated = expected;
+        for (std::size_t i = 0; i < activated.size(); i++) {
+            const double value = activated.data()[i] + bias.data()[(i / (shape[2] * shape[3])) % shape[1]];
+            activated.data()[i] = activate<Activation::Tanh>(value);
+        }
+        for (Storage storage : storages) {
+            for (nn::ConvAlgorithm algorithm : {nn::ConvAlgorithm::Auto, nn::ConvAlgorithm::Im2col, nn::ConvAlgorithm::Direct}) {
+                o.layout = layoutOf(storage);
+                o.algorithm = algorithm;
+                const NDArray<double> x = store(input, storage);
+                const NDArray<double> w = storeWeights(weights, storage);
+                const NDArray<double> y = nn::conv2d(x, w, o);
+                CHECK(y.format() == x.format());
+                CHECK_NEAR(maxDifference(canonical(y, storage), expected), 0.0, 1e-14);
+                NDArray<double> fused(y.shape(), y.format());
+                nn::conv2d(x, w, bias, fused, o, Activation::Tanh);
+                CHECK_NEAR(maxDifference(canonical(fused, storage), activated), 0.0, 1e-14);
+            }
+        }
+    }
+    nn::Conv2dOptions o;
+    o.strideH = 0;
+    CHECK_THROWS(nn::conv2d(input, weights, o), const std::invalid_argument&);
+    CHECK_THROWS(nn::conv2d(input, randomArray({5, 4, 3, 3}, 4)), const std::invalid_argument&);
+}
+
+TEST(conv2dBackward) {
+    const NDArray<double> input = randomArray({2, 4, 10, 7}, 5);
+    const NDArray<double> weights = randomArray({3, 4, 2, 3}, 6);
+    for (const ConvCase& cc : convCases) {
+        nn::Conv2dOptions o;
+        o.strideH = cc.stride;
+        o.strideW = cc.stride;
+        o.padH = cc.pad;
+        o.padW = cc.pad + 1;
+        o.dilationH = cc.dilation;
+        o.dilationW = 1;
+        const Shape shape = nn::conv2dOutputShape(input.shape(), weights.shape(), o);
+        const NDArray<double> gradOutput = randomArray(shape, 7);
+        NDArray<double> gradInput(input.shape(), MemoryFormat::RowMajor, 0.0);
+        NDArray<double> gradWeights(weights.shape(), MemoryFormat::RowMajor, 0.0);
+        NDArray<double> gradBias(Shape{shape[1]}, MemoryFormat::RowMajor, 0.0);
+        forEachTap(input.shape(), weights.shape(), shape, o, [&](auto n, auto k, auto c, auto oh, auto ow, auto h, auto w, auto r, auto s) {
+            gradInput(n, c, h, w) += gradOutput(n, k, oh, ow) * weights(k, c, r, s);
+            gradWeights(k, c, r, s) += gradOutput(n, k, oh, ow) * input(n, c, h, w);
+        });
+        for (std::size_t i = 0; i < gradOutput.size(); i++) {
+            gradBias.data()[(i / (shape[2] * shape[3])) % shape[1]] += gradOutput.data()[i];
+        }
+        for (Storage storage : storages) {
+            o.layout = layoutOf(storage);
+            const NDArray<double> x = store(input, storage);
+            const NDArray<double> w = storeWeights(weights, storage);
+            const NDArray<double> dy = store(gradOutput, storage);
+            // Stale contents must be overwritten.
+            NDArray<double> dx(x.shape(), x.format(), 9.0);
+            NDArray<double> dw(w.shape(), MemoryFormat::RowMajor, 9.0);
+            NDArray<double> db(Shape{shape[1]}, MemoryFormat::RowMajor, 9.0);
+            nn::conv2dBackwardData(dy, w, dx, o);
+            nn::conv2dBackwardWeights(x, dy, dw, o);
+            nn::conv2dBackwardBias(dy, db, o.layout);
+            CHECK_NEAR(maxDifference(canonical(dx, storage), gradInput), 0.0, 1e-13);
+            CHECK_NEAR(maxDifference(canonicalWeights(dw, storage), gradWeights), 0.0, 1e-13);
+            CHECK_NEAR(maxDifference(db, gradBias), 0.0, 1e-13);
+        }
+    }
+}
+
+struct PoolCase {
+    std::size_t kernel, stride, pad;
+};
+
+const PoolCase poolCases[] = {{2, 2, 0}, {3, 2, 1}, {3, 1, 1}, {2, 3, 0}, {4, 2, 3}};
+
+// Calls fn(n, c, oh, ow, h, w) for every input element of every window,
+// skipping the padding.
+template<typename F>
+static void forEachWindowElement(const Shape& input, const Shape& output, const nn::Pool2dOptions& o, F fn) {
+    for (std::size_t n = 0; n < output[0]; n++) {
+        for (std::size_t c = 0; c < output[1]; c++) {
+            for (std::size_t oh = 0; oh < output[2]; oh++) {
+                for (std::size_t ow = 0; ow < output[3]; ow++) {
+                    for (std::size_t r = 0; r < o.kernelH; r++) {
+                        for (std::size_t s = 0; s < o.kernelW; s++) {
+                            const long h = static_cast<long>(oh * o.strideH + r) - static_cast<long>(o.padH);
+                            const long w = static_cast<long>(ow * o.strideW + s) - static_cast<long>(o.padW);
+                            if (h >= 0 && w >= 0 && h < static_cast<long>(input[2]) && w < static_cast<long>(input[3])) {
+                                fn(n, c, oh, ow, static_cast<std::size_t>(h), static_cast<std::size_t>(w));
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Pooling in every storage and in the channels-blocked format, 20 channels
+// leaving a partial block, forward and backward.
+TEST(pool2dForwardAndBackward) {
+    const NDArray<double> input = randomArray({2, 20, 9, 10}, 8);
+    for (const PoolCase& pc : poolCases) {
+        nn::Pool2dOptions o;
+        o.kernelH = pc.kernel;
+        o.kernelW = pc.kernel;
+        o.strideH = pc.stride;
+        o.strideW = pc.stride;
+        o.padH = std::min(pc.pad, pc.kernel - 1);
+        o.padW = pc.pad / 2;
+        const Shape shape = nn::pool2dOutputShape(input.shape(), o);
+        NDArray<double> maxima(shape, MemoryFormat::RowMajor, -INFINITY);
+        NDArray<double> sums(shape, MemoryFormat::RowMajor, 0.0);
+        NDArray<double> counts(shape, MemoryFormat::RowMajor, 0.0);
+        forEachWindowElement(input.shape(), shape, o, [&](auto n, auto c, auto oh, auto ow, auto h, auto w) {
+            maxima(n, c, oh, ow) = std::max(maxima(n, c, oh, ow), input(n, c, h, w));
+            sums(n, c, oh, ow) += input(n, c, h, w);
+            counts(n, c, oh, ow) += 1;
+        });
+        const NDArray<double> averages = sums / counts;
+        const NDArray<double> gradOutput = randomArray(shape, 9);
+        NDArray<double> gradMax(input.shape(), MemoryFormat::RowMajor, 0.0);
+        NDArray<double> gradAvg(input.shape(), MemoryFormat::RowMajor, 0.0);
+        NDArray<double> taken(shape, MemoryFormat::RowMajor, 0.0);
+        forEachWindowElement(input.shape(), shape, o, [&](auto n, auto c, auto oh, auto ow, auto h, auto w) {
+            if (taken(n, c, oh, ow) == 0 && input(n, c, h, w) == maxima(n, c, oh, ow)) {
+                gradMax(n, c, h, w) += gradOutput(n, c, oh, ow);
+                taken(n, c, oh, ow) = 1;
+            }
+            gradAvg(n, c, h, w) += gradOutput(n, c, oh, ow) / counts(n, c, oh, ow);
+        });
+
+        for (int variant = 0; variant < 4; variant++) {
+            const Storage storage = (variant < 3) ? storages[variant] : Storage::NCHW;
+            o.layout = layoutOf(storage);
+            const NDArray<double> x = (variant < 3) ? store(input, storage) : input.to_format(MemoryFormat::ChannelsBlocked);
+            const NDArray<double> dy = (variant < 3) ? store(gradOutput, storage) : gradOutput.to_format(MemoryFormat::ChannelsBlocked);
+            auto back = [&](const NDArray<double>& a) {
+                return (variant < 3) ? canonical(a, storage) : a.to_format(MemoryFormat::RowMajor);
+            };
+            const NDArray<double> max = nn::maxPool2d(x, o);
+            const NDArray<double> avg = nn::avgPool2d(x, o);
+            CHECK(max.format() == x.format());
+            CHECK_EQ(maxDifference(back(max), maxima), 0.0);
+            CHECK_NEAR(maxDifference(back(avg), averages), 0.0, 1e-15);
+            NDArray<double> dxMax(x.shape(), x.format(), 9.0);
+            NDArray<double> dxAvg(x.shape(), x.format(), 9.0);
+            nn::maxPool2dBackward(x, dy, dxMax, o);
+            nn::avgPool2dBackward(dy, dxAvg, o);
+            CHECK_NEAR(maxDifference(back(dxMax), gradMax), 0.0, 1e-15);
+            CHECK_NEAR(maxDifference(back(dxAvg), gradAvg), 0.0, 1e-15);
+        }
+    }
+    nn::Pool2dOptions o;
+    o.kernelH = 2;
+    o.padH = 2;
+    CHECK_THROWS(nn::maxPool2d(input, o), const std::invalid_argument&);
+}
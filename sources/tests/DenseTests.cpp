@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "gemm/Epilogue.hpp"
+#include "gemm/Gemm.hpp"
+#include "matrix/Matrix.hpp"
+#include "nn/Dense.hpp"
+#include "nn/Network.hpp"
+#include "tests/Test.hpp"
+#include "vector/Vector.hpp"
+
+template<typename T>
+static std::vector<T> randomValues(std::size_t n, std::uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    std::vector<T> values(n);
+    for (T& v : values) {
+        v = static_cast<T>(uniform(rng));
+    }
+    return values;
+}
+
+template<typename T>
+static BasicMatrix<T> randomMatrix(std::size_t rows, std::size_t cols, std::uint32_t seed) {
+    BasicMatrix<T> m(rows, cols);
+    const std::vector<T> values = randomValues<T>(rows * cols, seed);
+    std::copy(values.begin(), values.end(), m.begin());
+    return m;
+}
+
+const Activation activations[] = {Activation::Identity, Activation::Relu, Activation::Gelu, Activation::Sigmoid, Activation::Tanh};
+
+// The fused epilogue against the same GEMM followed by separate bias and
+// activation passes, for a bias per column and per row, with beta != 0 and
+// with k spanning several blocks.
+template<typename T>
+static void checkFusedEpilogue(double tolerance) {
+    const std::size_t shapes[][3] = {{1, 1, 1}, {7, 13, 5}, {33, 70, 64}, {131, 40, 513}};
+    std::uint32_t seed = 1;
+    for (const auto& shape : shapes) {
+        const std::size_t m = shape[0], n = shape[1], k = shape[2];
+        const std::vector<T> a = randomValues<T>(m * k, seed++);
+        const std::vector<T> b = randomValues<T>(k * n, seed++);
+        const std::vector<T> c0 = randomValues<T>(m * n, seed++);
+        const std::vector<T> bias = randomValues<T>(std::max(m, n), seed++);
+        for (Activation activation : activations) {
+            for (bool biasPerRow : {false, true}) {
+                std::vector<T> fused = c0;
+                std::vector<T> unfused = c0;
+                gemm(m, n, k, T(0.5), a.data(), k, 1, b.data(), n, 1, T(1), fused.data(), n, 1, GemmEpilogue<T>{bias.data(), biasPerRow, activation});
+                gemm(m, n, k, T(0.5), a.data(), k, 1, b.data(), n, 1, T(1), unfused.data(), n, 1);
+                for (std::size_t i = 0; i < m; i++) {
+                    for (std::size_t j = 0; j < n; j++) {
+                        unfused[i * n + j] += bias[biasPerRow ? i : j];
+                    }
+                }
+                activate(activation, unfused.data(), unfused.size());
+                double error = 0;
+                for (std::size_t i = 0; i < m * n; i++) {
+                    error = std::max(error, std::abs(static_cast<double>(fused[i]) - static_cast<double>(unfused[i])));
+                }
+                CHECK_NEAR(error, 0.0, tolerance);
+            }
+        }
+        // Without a bias only the activation is applied.
+        std::vector<T> fused(m * n), unfused(m * n);
+        gemm(m, n, k, T(1), a.data(), k, 1, b.data(), n, 1, T(0), fused.data(), n, 1, GemmEpilogue<T>{nullptr, false, Activation::Relu});
+        gemm(m, n, k, T(1), a.data(), k, 1, b.data(), n, 1, T(0), unfused.data(), n, 1);
+        activate(Activation::Relu, unfused.data(), unfused.size());
+        CHECK(fused == unfused);
+    }
+}
+
+TEST(fusedEpilogueDouble) {
+    checkFusedEpilogue<double>(1e-14);
+}
+
+TEST(fusedEpilogueFloat) {
+    checkFusedEpilogue<float>(1e-5);
+}
+
+TEST(denseForward) {
+    const std::size_t batch = 21, inputs = 37, outputs = 19;
+    for (Activation activation : activations) {
+        nn::Dense layer(randomMatrix<double>(inputs, outputs, 10), Vector(outputs, 0.25), activation);
+        const Matrix x = randomMatrix<double>(batch, inputs, 11);
+        const Matrix y = layer.forward(x);
+        CHECK_EQ(y.nbRows(), batch);
+        CHECK_EQ(y.nbCols(), outputs);
+        Matrix reference = x.dot(layer.weights());
+        for (std::size_t i = 0; i < batch; i++) {
+            for (std::size_t j = 0; j < outputs; j++) {
+                reference(i, j) += 0.25;
+            }
+        }
+        activate(activation, reference.data(), batch * outputs);
+        double error = 0;
+        for (std::size_t i = 0; i < batch; i++) {
+            for (std::size_t j = 0; j < outputs; j++) {
+                error = std::max(error, std::abs(y(i, j) - reference(i, j)));
+            }
+        }
+        CHECK_NEAR(error, 0.0, 1e-14);
+        // A single sample gives the row of the batch.
+        Vector sample(inputs);
+        for (std::size_t p = 0; p < inputs; p++) {
+            sample[static_cast<unsigned int>(p)] = x(3, p);
+        }
+        const Vector single = layer.forward(sample);
+        for (std::size_t j = 0; j < outputs; j++) {
+            CHECK_NEAR(single[static_cast<unsigned int>(j)], y(3, j), 1e-14);
+        }
+    }
+    nn::Dense layer(inputs, outputs);
+    CHECK_THROWS(layer.forward(Matrix(batch, outputs)), const std::invalid_argument&);
+    CHECK_THROWS(nn::Dense(Matrix(inputs, outputs), Vector(inputs)), const std::invalid_argument&);
+}
+
+// A network runs its layers one after the other, whatever batch sizes it
+// is called with in turn.
+TEST(networkForward) {
+    nn::Network network;
+    network.add(nn::Dense(randomMatrix<double>(12, 30, 20), Vector(30, 0.1), Activation::Relu));
+    network.add(24, Activation::Tanh);
+    network.add(5, Activation::Identity);
+    network.initialize(7);
+    CHECK_EQ(network.size(), std::size_t(3));
+    CHECK_EQ(network.inputs(), std::size_t(12));
+    CHECK_EQ(network.outputs(), std::size_t(5));
+    for (std::size_t batch : {std::size_t(9), std::size_t(1), std::size_t(40), std::size_t(9)}) {
+        const Matrix x = randomMatrix<double>(batch, 12, static_cast<std::uint32_t>(batch));
+        Matrix reference = x;
+        for (std::size_t l = 0; l < network.size(); l++) {
+            reference = network[l].forward(reference);
+        }
+        const Matrix y = network.forward(x);
+        CHECK_EQ(y.nbRows(), batch);
+        double error = 0;
+        for (std::size_t i = 0; i < batch; i++) {
+            for (std::size_t j = 0; j < 5; j++) {
+                error = std::max(error, std::abs(y(i, j) - reference(i, j)));
+            }
+        }
+        CHECK_EQ(error, 0.0);
+    }
+    CHECK_THROWS(network.add(nn::Dense(7, 3)), const std::invalid_argument&);
+    CHECK_THROWS(nn::Network().forward(Matrix(std::size_t(2), std::size_t(2))), const std::invalid_argument&);
+}
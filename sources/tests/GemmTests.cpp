@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "gemm/Gemm.hpp"
+#include "gemm/Gemv.hpp"
+#include "matrix/Matrix.hpp"
+#include "tests/Test.hpp"
+#include "vector/Vector.hpp"
+
+template<typename T>
+static std::vector<T> randomValues(std::size_t n, std::uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    std::vector<T> values(n);
+    for (T& v : values) {
+        v = static_cast<T>(uniform(rng));
+    }
+    return values;
+}
+
+// C = alpha * A * B + beta * C with every operand strided, one dot product
+// per element.
+template<typename T>
+static void naiveGemm(
+    std::size_t m, std::size_t n, std::size_t k, T alpha,
+    const T* a, std::size_t rsa, std::size_t csa,
+    const T* b, std::size_t rsb, std::size_t csb,
+    T beta, T* c, std::size_t rsc, std::size_t csc
+) {
+    for (std::size_t i = 0; i < m; i++) {
+        for (std::size_t j = 0; j < n; j++) {
+            double dot = 0;
+            for (std::size_t p = 0; p < k; p++) {
+                dot += static_cast<double>(a[i * rsa + p * csa]) * static_cast<double>(b[p * rsb + j * csb]);
+            }
+            c[i * rsc + j * csc] = static_cast<T>(alpha * dot + beta * c[i * rsc + j * csc]);
+        }
+    }
+}
+
+// Shapes around the register tile and beyond one KC block, so that edge
+// tiles, padding and the accumulation over k blocks are all exercised.
+template<typename T>
+static void checkGemm(double tolerance) {
+    const std::size_t shapes[][3] = {{1, 1, 1}, {7, 5, 3}, {17, 33, 9}, {64, 48, 300}, {131, 70, 513}};
+    std::uint32_t seed = 1;
+    for (const auto& shape : shapes) {
+        const std::size_t m = shape[0], n = shape[1], k = shape[2];
+        const std::vector<T> a = randomValues<T>(m * k, seed++);
+        const std::vector<T> b = randomValues<T>(k * n, seed++);
+        const std::vector<T> c0 = randomValues<T>(m * n, seed++);
+        for (bool transA : {false, true}) {
+            for (bool transB : {false, true}) {
+                const std::size_t rsa = transA ? 1 : k, csa = transA ? m : 1;
+                const std::size_t rsb = transB ? 1 : n, csb = transB ? k : 1;
+                std::vector<T> c = c0;
+                std::vector<T> expected = c0;
+                gemm(m, n, k, T(0.5), a.data(), rsa, csa, b.data(), rsb, csb, T(2), c.data(), n, 1);
+                naiveGemm(m, n, k, T(0.5), a.data(), rsa, csa, b.data(), rsb, csb, T(2), expected.data(), n, 1);
+                double error = 0;
+                for (std::size_t i = 0; i < m * n; i++) {
+                    error = std::max(error, std::abs(static_cast<double>(c[i]) - static_cast<double>(expected[i])));
+                }
+                CHECK_NEAR(error, 0.0, tolerance * static_cast<double>(k));
+            }
+        }
+    }
+}
+
+TEST(gemmDouble) {
+    checkGemm<double>(1e-15);
+}
+
+TEST(gemmFloat) {
+    checkGemm<float>(1e-6);
+}
+
+// beta = 0 must not read C, which may then hold NaNs.
+TEST(gemmBetaZeroIgnoresC) {
+    const std::size_t m = 9, n = 11, k = 6;
+    const std::vector<double> a = randomValues<double>(m * k, 7);
+    const std::vector<double> b = randomValues<double>(k * n, 8);
+    std::vector<double> c(m * n, std::nan(""));
+    std::vector<double> expected(m * n, 0.0);
+    gemm(m, n, k, 1.0, a.data(), k, 1, b.data(), n, 1, 0.0, c.data(), n, 1);
+    naiveGemm(m, n, k, 1.0, a.data(), k, 1, b.data(), n, 1, 0.0, expected.data(), n, 1);
+    for (std::size_t i = 0; i < m * n; i++) {
+        CHECK_NEAR(c[i], expected[i], 1e-13);
+    }
+}
+
+TEST(gemmInt8IsExact) {
+    const std::size_t shapes[][3] = {{1, 1, 1}, {7, 13, 5}, {33, 70, 64}, {40, 17, 301}};
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> uniform(-127, 127);
+    for (const auto& shape : shapes) {
+        const std::size_t m = shape[0], n = shape[1], k = shape[2];
+        std::vector<std::int8_t> a(m * k), b(k * n);
+        for (std::int8_t& v : a) {
+            v = static_cast<std::int8_t>(uniform(rng));
+        }
+        for (std::int8_t& v : b) {
+            v = static_cast<std::int8_t>(uniform(rng));
+        }
+        std::vector<std::int32_t> c(m * n);
+        gemm(m, n, k, a.data(), k, 1, b.data(), n, 1, c.data(), n, 1);
+        std::size_t mismatches = 0;
+        for (std::size_t i = 0; i < m; i++) {
+            for (std::size_t j = 0; j < n; j++) {
+                std::int32_t dot = 0;
+                for (std::size_t p = 0; p < k; p++) {
+                    dot += a[i * k + p] * b[p * n + j];
+                }
+                mismatches += (c[i * n + j] != dot);
+            }
+        }
+        CHECK_EQ(mismatches, std::size_t(0));
+    }
+}
+
+TEST(matrixDot) {
+    const std::size_t m = 23, n = 19, k = 31;
+    Matrix a(m, k), b(k, n);
+    const std::vector<double> va = randomValues<double>(m * k, 11);
+    const std::vector<double> vb = randomValues<double>(k * n, 12);
+    std::copy(va.begin(), va.end(), a.begin());
+    std::copy(vb.begin(), vb.end(), b.begin());
+    const Matrix c = a.dot(b);
+    CHECK_EQ(c.nbRows(), m);
+    CHECK_EQ(c.nbCols(), n);
+    for (std::size_t i = 0; i < m; i++) {
+        for (std::size_t j = 0; j < n; j++) {
+            double dot = 0;
+            for (std::size_t p = 0; p < k; p++) {
+                dot += a(i, p) * b(p, j);
+            }
+            CHECK_NEAR(c(i, j), dot, 1e-13);
+        }
+    }
+    CHECK_THROWS(a.dot(a), const char*);
+}
+
+// Both layouts of A, row counts around the four-row kernels and beta = 0
+// over a y full of NaNs.
+template<typename T>
+static void checkGemv(double tolerance) {
+    const std::size_t shapes[][2] = {{1, 1}, {3, 5}, {7, 130}, {257, 33}, {513, 300}};
+    std::uint32_t seed = 20;
+    for (const auto& shape : shapes) {
+        const std::size_t m = shape[0], n = shape[1];
+        const std::vector<T> a = randomValues<T>(m * n, seed++);
+        const std::vector<T> x = randomValues<T>(n, seed++);
+        const std::vector<T> y0 = randomValues<T>(m, seed++);
+        for (bool columns : {false, true}) {
+            const std::size_t rsa = columns ? 1 : n, csa = columns ? m : 1;
+            for (T beta : {T(0), T(-1.5)}) {
+                std::vector<T> y = (beta == T(0)) ? std::vector<T>(m, T(std::nan(""))) : y0;
+                std::vector<T> expected = (beta == T(0)) ? std::vector<T>(m, T(0)) : y0;
+                gemv(m, n, T(0.75), a.data(), rsa, csa, x.data(), beta, y.data());
+                naiveGemm(m, 1, n, T(0.75), a.data(), rsa, csa, x.data(), 1, 1, beta, expected.data(), 1, 1);
+                double error = 0;
+                for (std::size_t i = 0; i < m; i++) {
+                    error = std::max(error, std::abs(static_cast<double>(y[i]) - static_cast<double>(expected[i])));
+                }
+                CHECK_NEAR(error, 0.0, tolerance * static_cast<double>(n));
+            }
+        }
+    }
+}
+
+TEST(gemvDouble) {
+    checkGemv<double>(1e-15);
+}
+
+TEST(gemvFloat) {
+    checkGemv<float>(1e-6);
+}
+
+TEST(matrixVectorProducts) {
+    const std::size_t m = 37, n = 21;
+    Matrix a(m, n);
+    const std::vector<double> va = randomValues<double>(m * n, 30);
+    std::copy(va.begin(), va.end(), a.begin());
+    Vector x(n), z(m);
+    const std::vector<double> vx = randomValues<double>(n, 31);
+    const std::vector<double> vz = randomValues<double>(m, 32);
+    std::copy(vx.begin(), vx.end(), x.begin());
+    std::copy(vz.begin(), vz.end(), z.begin());
+    const Vector ax = a.dot(x);
+    const Vector za = z.dot(a);
+    Vector y(n, 1.0);
+    gemv(2.0, a, z, 0.5, y, true);
+    for (std::size_t i = 0; i < m; i++) {
+        double expected = 0;
+        for (std::size_t j = 0; j < n; j++) {
+            expected += a(i, j) * x[static_cast<unsigned int>(j)];
+        }
+        CHECK_NEAR(ax[static_cast<unsigned int>(i)], expected, 1e-14);
+    }
+    for (std::size_t j = 0; j < n; j++) {
+        double expected = 0;
+        for (std::size_t i = 0; i < m; i++) {
+            expected += z[static_cast<unsigned int>(i)] * a(i, j);
+        }
+        CHECK_NEAR(za[static_cast<unsigned int>(j)], expected, 1e-14);
+        CHECK_NEAR(y[static_cast<unsigned int>(j)], 2.0 * expected + 0.5, 1e-14);
+    }
+    CHECK_THROWS(a.dot(z), const char*);
+    Vector square(n);
+    Matrix b(n, n);
+    CHECK_THROWS(gemv(1.0, b, square, 0.0, square), const char*);
+}
+
+// Batches below and above one register tile of rows, which switch from
+// per-vector GEMV to one GEMM.
+TEST(batchedMatrixVectorProducts) {
+    const std::size_t m = 19, n = 45;
+    Matrix a(m, n);
+    const std::vector<double> va = randomValues<double>(m * n, 40);
+    std::copy(va.begin(), va.end(), a.begin());
+    for (std::size_t batch : {std::size_t(1), std::size_t(3), std::size_t(17)}) {
+        for (bool transA : {false, true}) {
+            const std::size_t inputs = transA ? m : n, outputs = transA ? n : m;
+            Matrix xs(batch, inputs), ys(batch, outputs);
+            const std::vector<double> vx = randomValues<double>(batch * inputs, 41);
+            std::copy(vx.begin(), vx.end(), xs.begin());
+            gemvBatch(a, xs, ys, transA);
+            for (std::size_t b = 0; b < batch; b++) {
+                for (std::size_t i = 0; i < outputs; i++) {
+                    double expected = 0;
+                    for (std::size_t j = 0; j < inputs; j++) {
+                        expected += (transA ? a(j, i) : a(i, j)) * xs(b, j);
+                    }
+                    CHECK_NEAR(ys(b, i), expected, 1e-14);
+                }
+            }
+            CHECK_THROWS(gemvBatch(a, xs, ys, !transA), const char*);
+        }
+    }
+}
@@ -0,0 +1,221 @@
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "gemm/Gemm.hpp"
+#include "half/Half.hpp"
+#include "ndarray/NDArray.hpp"
+#include "simd/Simd.hpp"
+#include "tests/Test.hpp"
+
+using Shape = std::vector<std::size_t>;
+
+// Floats covering every exponent of both formats, with random mantissas
+// and the special values.
+static std::vector<float> testFloats() {
+    std::vector<float> values = {
+        0.0f, -0.0f, 1.0f, -2.5f, 65504.0f, 65519.0f, 65520.0f, -70000.0f, 0x1p-24f, 0x1p-25f, 0x1.8p-24f,
+        std::numeric_limits<float>::max(), std::numeric_limits<float>::denorm_min(),
+        std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+    };
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<std::uint32_t> bits(0, 0xFFFFFFFFu);
+    while (values.size() < 20000) {
+        const float value = std::bit_cast<float>(bits(rng));
+        if (!std::isnan(value)) {
+            values.push_back(value);
+        }
+    }
+    return values;
+}
+
+// h rounds value to nearest even: no finite neighbour of h is closer, and
+// on a tie h is the even one. Values from halfway between the largest finite
+// value and the next power of two on round to an infinity.
+template<typename H>
+static bool roundsToNearestEven(float value, H h) {
+    const std::uint16_t infinity = H(std::numeric_limits<float>::infinity()).bits();
+    const double largest = static_cast<float>(H::fromBits(infinity - 1));
+    const double overflow = largest + (largest - static_cast<float>(H::fromBits(infinity - 2))) / 2;
+    const double x = value;
+    const double r = static_cast<float>(h);
+    if (std::abs(x) >= overflow || std::isinf(r)) {
+        return std::isinf(r) && (r > 0) == (x > 0) && std::abs(x) >= overflow;
+    }
+    for (int step : {-1, 1}) {
+        const std::uint16_t neighbourBits = static_cast<std::uint16_t>(h.bits() + step);
+        const double neighbour = static_cast<float>(H::fromBits(neighbourBits));
+        if (!std::isfinite(neighbour) || ((h.bits() ^ neighbourBits) & 0x8000u)) {
+            continue;
+        }
+        const double error = std::abs(x - r), other = std::abs(x - neighbour);
+        if (other < error || (other == error && (h.bits() & 1u))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename H>
+static void checkRounding() {
+    std::size_t failures = 0;
+    for (float value : testFloats()) {
+        failures += !roundsToNearestEven(value, H(value));
+    }
+    CHECK_EQ(failures, std::size_t(0));
+    CHECK(std::isnan(static_cast<float>(H(std::numeric_limits<float>::quiet_NaN()))));
+    CHECK(std::isnan(static_cast<float>(H(-std::numeric_limits<float>::signaling_NaN()))));
+    // Every 16-bit value widens exactly and rounds back to itself.
+    std::size_t mismatches = 0;
+    for (std::uint32_t bits = 0; bits <= 0xFFFFu; bits++) {
+        const H h = H::fromBits(static_cast<std::uint16_t>(bits));
+        const float wide = h;
+        mismatches += !std::isnan(wide) && H(wide).bits() != h.bits();
+    }
+    CHECK_EQ(mismatches, std::size_t(0));
+}
+
+TEST(bfloat16Rounding) {
+    checkRounding<BFloat16>();
+    CHECK_EQ(BFloat16(1.0f).bits(), std::uint16_t(0x3F80));
+    CHECK_EQ(static_cast<float>(BFloat16(1.0f + 0x1p-8f)), 1.0f);
+    CHECK_EQ(static_cast<float>(BFloat16(1.0f + 0x1.8p-7f)), 1.0f + 0x1p-6f);
+    CHECK(std::isinf(static_cast<float>(BFloat16(std::numeric_limits<float>::max()))));
+}
+
+TEST(float16Rounding) {
+    checkRounding<Float16>();
+    CHECK_EQ(Float16(65504.0f).bits(), std::uint16_t(0x7BFF));
+    CHECK_EQ(static_cast<float>(Float16(65519.0f)), 65504.0f);
+    CHECK(std::isinf(static_cast<float>(Float16(65520.0f))));
+    CHECK_EQ(Float16(0x1p-24f).bits(), std::uint16_t(0x0001));
+    CHECK_EQ(Float16(0x1p-25f).bits(), std::uint16_t(0x0000));
+    CHECK_EQ(Float16(0x1.8p-24f).bits(), std::uint16_t(0x0002));
+    CHECK_EQ(static_cast<float>(Float16(1.0f + 0x1p-11f)), 1.0f);
+}
+
+// The SIMD conversions agree bit for bit with the scalar ones, on lengths
+// that leave a tail after the last full register.
+TEST(halfConversionKernels) {
+    const simd::HalfKernels& k = simd::halfKernels();
+    std::vector<float> values = testFloats();
+    values.resize(values.size() - 3);
+    const std::size_t n = values.size();
+    std::vector<BFloat16> bf(n);
+    std::vector<Float16> fp(n);
+    k.toBFloat16(values.data(), bf.data(), n);
+    k.toFloat16(values.data(), fp.data(), n);
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < n; i++) {
+        mismatches += (bf[i].bits() != BFloat16(values[i]).bits()) + (fp[i].bits() != Float16(values[i]).bits());
+    }
+    CHECK_EQ(mismatches, std::size_t(0));
+
+    std::vector<BFloat16> allBf(0x10000);
+    std::vector<Float16> allFp(0x10000);
+    for (std::uint32_t bits = 0; bits <= 0xFFFFu; bits++) {
+        allBf[bits] = BFloat16::fromBits(static_cast<std::uint16_t>(bits));
+        allFp[bits] = Float16::fromBits(static_cast<std::uint16_t>(bits));
+    }
+    std::vector<float> wideBf(0x10000), wideFp(0x10000);
+    k.fromBFloat16(allBf.data(), wideBf.data(), wideBf.size());
+    k.fromFloat16(allFp.data(), wideFp.data(), wideFp.size());
+    mismatches = 0;
+    for (std::size_t i = 0; i < 0x10000; i++) {
+        mismatches += std::bit_cast<std::uint32_t>(wideBf[i]) != std::bit_cast<std::uint32_t>(static_cast<float>(allBf[i]));
+        mismatches += std::bit_cast<std::uint32_t>(wideFp[i]) != std::bit_cast<std::uint32_t>(static_cast<float>(allFp[i]));
+    }
+    CHECK_EQ(mismatches, std::size_t(0));
+}
+
+TEST(halfReductions) {
+    const simd::HalfKernels& k = simd::halfKernels();
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    for (std::size_t n : {1, 7, 64, 1000, 5003}) {
+        std::vector<BFloat16> xb(n), yb(n);
+        std::vector<Float16> xf(n), yf(n);
+        double dotB = 0, dotF = 0, sumB = 0, sumF = 0;
+        for (std::size_t i = 0; i < n; i++) {
+            xb[i] = uniform(rng);
+            yb[i] = uniform(rng);
+            xf[i] = uniform(rng);
+            yf[i] = uniform(rng);
+            dotB += static_cast<double>(xb[i]) * static_cast<double>(yb[i]);
+            dotF += static_cast<double>(xf[i]) * static_cast<double>(yf[i]);
+            sumB += static_cast<double>(xb[i]);
+            sumF += static_cast<double>(xf[i]);
+        }
+        const double tolerance = 1e-6 * static_cast<double>(n);
+        CHECK_NEAR(k.dotBFloat16(xb.data(), yb.data(), n), dotB, tolerance);
+        CHECK_NEAR(k.dotFloat16(xf.data(), yf.data(), n), dotF, tolerance);
+        CHECK_NEAR(k.sumBFloat16(xb.data(), n), sumB, tolerance);
+        CHECK_NEAR(k.sumFloat16(xf.data(), n), sumF, tolerance);
+    }
+}
+
+// Mixed-precision GEMM against a float product of the widened operands.
+TEST(mixedPrecisionGemm) {
+    const std::size_t m = 37, n = 29, k = 300;
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    std::vector<float> a(m * k);
+    std::vector<BFloat16> ab(m * k), bb(k * n);
+    std::vector<Float16> af(m * k), bf(k * n);
+    for (std::size_t i = 0; i < m * k; i++) {
+        a[i] = uniform(rng);
+        ab[i] = a[i];
+        af[i] = a[i];
+    }
+    for (std::size_t i = 0; i < k * n; i++) {
+        bb[i] = uniform(rng);
+        bf[i] = uniform(rng);
+    }
+    std::vector<float> c1(m * n), c2(m * n), c3(m * n), c4(m * n);
+    gemm(m, n, k, 1.0f, a.data(), k, 1, bb.data(), n, 1, 0.0f, c1.data(), n, 1);
+    gemm(m, n, k, 1.0f, ab.data(), k, 1, bb.data(), n, 1, 0.0f, c2.data(), n, 1);
+    gemm(m, n, k, 1.0f, a.data(), k, 1, bf.data(), n, 1, 0.0f, c3.data(), n, 1);
+    gemm(m, n, k, 1.0f, af.data(), k, 1, bf.data(), n, 1, 0.0f, c4.data(), n, 1);
+    double error = 0;
+    for (std::size_t i = 0; i < m; i++) {
+        for (std::size_t j = 0; j < n; j++) {
+            double e1 = 0, e2 = 0, e3 = 0, e4 = 0;
+            for (std::size_t p = 0; p < k; p++) {
+                e1 += static_cast<double>(a[i * k + p]) * static_cast<double>(bb[p * n + j]);
+                e2 += static_cast<double>(ab[i * k + p]) * static_cast<double>(bb[p * n + j]);
+                e3 += static_cast<double>(a[i * k + p]) * static_cast<double>(bf[p * n + j]);
+                e4 += static_cast<double>(af[i * k + p]) * static_cast<double>(bf[p * n + j]);
+            }
+            const std::size_t o = i * n + j;
+            error = std::max({error, std::abs(c1[o] - e1), std::abs(c2[o] - e2), std::abs(c3[o] - e3), std::abs(c4[o] - e4)});
+        }
+    }
+    CHECK_NEAR(error, 0.0, 1e-6 * static_cast<double>(k));
+}
+
+TEST(ndarrayHalfConversions) {
+    NDArray<float> a(Shape{3, 1000}, MemoryFormat::RowMajor);
+    for (std::size_t i = 0; i < a.size(); i++) {
+        a.data()[i] = std::sin(static_cast<float>(i)) * 100.0f;
+    }
+    const NDArray<BFloat16> bf = a.astype<BFloat16>();
+    const NDArray<Float16> fp = a.astype<Float16>();
+    const NDArray<float> fromBf = bf.astype<float>();
+    const NDArray<float> fromFp = fp.astype<float>();
+    CHECK(fromBf.shape() == a.shape());
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < a.size(); i++) {
+        mismatches += (fromBf.data()[i] != static_cast<float>(BFloat16(a.data()[i])));
+        mismatches += (fromFp.data()[i] != static_cast<float>(Float16(a.data()[i])));
+    }
+    CHECK_EQ(mismatches, std::size_t(0));
+    // 16-bit sums accumulate in float and round once at the end.
+    double total = 0;
+    for (std::size_t i = 0; i < bf.size(); i++) {
+        total += static_cast<double>(bf.data()[i]);
+    }
+    CHECK_EQ(static_cast<float>(bf.sum()), static_cast<float>(BFloat16(static_cast<float>(total))));
+}
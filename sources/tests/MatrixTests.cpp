@@ -0,0 +1,166 @@
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "matrix/Matrix.hpp"
+#include "ndarray/NDArray.hpp"
+#include "tests/Test.hpp"
+#include "vector/Vector.hpp"
+
+static Matrix randomMatrix(std::size_t rows, std::size_t cols, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    Matrix m(rows, cols);
+    for (std::size_t i = 0; i < rows; i++) {
+        for (std::size_t j = 0; j < cols; j++) {
+            m(i, j) = uniform(rng);
+        }
+    }
+    return m;
+}
+
+static Vector randomVector(std::size_t n, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    Vector v(n);
+    for (std::size_t i = 0; i < n; i++) {
+        v[static_cast<unsigned int>(i)] = uniform(rng);
+    }
+    return v;
+}
+
+TEST(matrixMove) {
+    Matrix a = randomMatrix(4, 3, 1);
+    const double* storage = a.data();
+    const double corner = a(3, 2);
+    Matrix b(std::move(a));
+    CHECK(b.data() == storage);
+    CHECK_EQ(b(3, 2), corner);
+    CHECK_EQ(a.nbRows(), std::size_t(0));
+    CHECK_EQ(a.nbCols(), std::size_t(0));
+    Matrix c;
+    c = std::move(b);
+    CHECK(c.data() == storage);
+    CHECK_EQ(b.nbRows(), std::size_t(0));
+}
+
+// Operators on a temporary left operand, or on the temporary right operand
+// of a scalar, return that temporary's buffer.
+TEST(operatorsReuseTemporaries) {
+    const Matrix m = randomMatrix(5, 7, 2);
+    const Vector bias = randomVector(7, 3);
+
+    Matrix a = m;
+    const double* storage = a.data();
+    const Matrix shifted = std::move(a) + bias;
+    CHECK(shifted.data() == storage);
+    for (std::size_t i = 0; i < 5; i++) {
+        for (std::size_t j = 0; j < 7; j++) {
+            CHECK_EQ(shifted(i, j), m(i, j) + bias[static_cast<unsigned int>(j)]);
+        }
+    }
+
+    Matrix b = m;
+    storage = b.data();
+    const Matrix scaled = 2.0 * (std::move(b) - m * m);
+    CHECK(scaled.data() == storage);
+    for (std::size_t i = 0; i < 5; i++) {
+        for (std::size_t j = 0; j < 7; j++) {
+            CHECK_EQ(scaled(i, j), 2.0 * (m(i, j) - m(i, j) * m(i, j)));
+        }
+    }
+
+    Vector v = bias;
+    const double* vectorStorage = v.data();
+    const Vector halved = std::move(v) / 2.0;
+    CHECK(halved.data() == vectorStorage);
+    for (unsigned int i = 0; i < 7; i++) {
+        CHECK_EQ(halved[i], bias[i] / 2.0);
+    }
+}
+
+TEST(elementwiseOutParameters) {
+    const Matrix a = randomMatrix(6, 9, 4);
+    const Matrix b = randomMatrix(6, 9, 5);
+    Matrix out(std::size_t(6), std::size_t(9));
+    const double* storage = out.data();
+    add(a, b, out);
+    CHECK(out.data() == storage);
+    CHECK_EQ(out(5, 8), a(5, 8) + b(5, 8));
+    sub(a, b, out);
+    CHECK_EQ(out(2, 3), a(2, 3) - b(2, 3));
+    div(a, b, out);
+    CHECK_EQ(out(4, 1), a(4, 1) / b(4, 1));
+    // out may be one of the operands.
+    Matrix c = a;
+    mul(c, b, c);
+    CHECK_EQ(c(1, 7), a(1, 7) * b(1, 7));
+    Matrix wrong(std::size_t(9), std::size_t(6));
+    CHECK_THROWS(add(a, b, wrong), const char*);
+
+    const Vector x = randomVector(11, 6);
+    const Vector y = randomVector(11, 7);
+    Vector sum(11);
+    add(x, y, sum);
+    Vector product = x;
+    mul(product, y, product);
+    for (unsigned int i = 0; i < 11; i++) {
+        CHECK_EQ(sum[i], x[i] + y[i]);
+        CHECK_EQ(product[i], x[i] * y[i]);
+    }
+    Vector shorter(10);
+    CHECK_THROWS(sub(x, y, shorter), const char*);
+
+    const NDArray<double> column(std::vector<std::size_t>{3, 1}, MemoryFormat::RowMajor, 2.0);
+    const NDArray<double> row(std::vector<std::size_t>{1, 4}, MemoryFormat::RowMajor, 5.0);
+    NDArray<double> grid(std::vector<std::size_t>{3, 4}, MemoryFormat::RowMajor);
+    const double* gridStorage = grid.data();
+    mul(column, row, grid);
+    CHECK(grid.data() == gridStorage);
+    CHECK_EQ(grid(2, 3), 10.0);
+}
+
+TEST(productOutParameters) {
+    const Matrix a = randomMatrix(13, 8, 8);
+    const Matrix b = randomMatrix(8, 10, 9);
+    const Vector x = randomVector(8, 10);
+    const Vector z = randomVector(13, 11);
+
+    Matrix c(std::size_t(13), std::size_t(10));
+    const double* storage = c.data();
+    dot(a, b, c);
+    CHECK(c.data() == storage);
+    Vector ax(13), za(8);
+    dot(a, x, ax);
+    dot(z, a, za);
+    for (std::size_t i = 0; i < 13; i++) {
+        double expected = 0;
+        for (std::size_t p = 0; p < 8; p++) {
+            expected += a(i, p) * x[static_cast<unsigned int>(p)];
+        }
+        CHECK_NEAR(ax[static_cast<unsigned int>(i)], expected, 1e-14);
+        for (std::size_t j = 0; j < 10; j++) {
+            double entry = 0;
+            for (std::size_t p = 0; p < 8; p++) {
+                entry += a(i, p) * b(p, j);
+            }
+            CHECK_NEAR(c(i, j), entry, 1e-14);
+        }
+    }
+    for (std::size_t j = 0; j < 8; j++) {
+        double expected = 0;
+        for (std::size_t i = 0; i < 13; i++) {
+            expected += z[static_cast<unsigned int>(i)] * a(i, j);
+        }
+        CHECK_NEAR(za[static_cast<unsigned int>(j)], expected, 1e-14);
+    }
+
+    Matrix t(std::size_t(8), std::size_t(13));
+    transpose(a, t);
+    CHECK_EQ(t(7, 12), a(12, 7));
+    CHECK_EQ(t(3, 5), a(5, 3));
+    CHECK_THROWS(transpose(a, c), const char*);
+    Matrix square = randomMatrix(4, 4, 12);
+    CHECK_THROWS(transpose(square, square), const char*);
+    CHECK_THROWS(dot(b, a, c), const char*);
+}
@@ -0,0 +1,125 @@
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "ndarray/MemoryFormat.hpp"
+#include "ndarray/NDArray.hpp"
+#include "tests/Test.hpp"
+
+using Shape = std::vector<std::size_t>;
+
+static NDArray<double> randomArray(const Shape& shape, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    NDArray<double> a(shape, MemoryFormat::RowMajor);
+    for (std::size_t i = 0; i < a.size(); i++) {
+        a.data()[i] = uniform(rng);
+    }
+    return a;
+}
+
+const MemoryFormat formats[] = {MemoryFormat::RowMajor, MemoryFormat::ColumnMajor, MemoryFormat::ChannelsLast, MemoryFormat::ChannelsBlocked};
+
+// Offset of element (n, c, h, w) in the buffer of an array of the format.
+static std::size_t storageOffset(const Shape& s, MemoryFormat format, std::size_t n, std::size_t c, std::size_t h, std::size_t w) {
+    switch (format) {
+        case MemoryFormat::ColumnMajor: return ((w * s[2] + h) * s[1] + c) * s[0] + n;
+        case MemoryFormat::ChannelsLast: return ((n * s[2] + h) * s[3] + w) * s[1] + c;
+        case MemoryFormat::ChannelsBlocked: {
+            const std::size_t blocks = (s[1] + channel_block - 1) / channel_block;
+            return (((n * blocks + c / channel_block) * s[2] + h) * s[3] + w) * channel_block + c % channel_block;
+        }
+        default: return ((n * s[1] + c) * s[2] + h) * s[3] + w;
+    }
+}
+
+// Number of padding elements of the buffer that are not zero.
+static std::size_t nonzeroPadding(const NDArray<double>& a) {
+    const Shape s = a.shape();
+    std::vector<bool> element(shape_size(a.storage_shape()), false);
+    for (std::size_t n = 0; n < s[0]; n++) {
+        for (std::size_t c = 0; c < s[1]; c++) {
+            for (std::size_t h = 0; h < s[2]; h++) {
+                for (std::size_t w = 0; w < s[3]; w++) {
+                    element[storageOffset(s, a.format(), n, c, h, w)] = true;
+                }
+            }
+        }
+    }
+    std::size_t nonzero = 0;
+    for (std::size_t i = 0; i < element.size(); i++) {
+        nonzero += (!element[i] && a.data()[i] != 0.0) ? 1 : 0;
+    }
+    return nonzero;
+}
+
+// Every pair of formats, with channel counts below, at and past a block:
+// elements land at the documented offsets and come back unchanged.
+TEST(reorderRoundTrips) {
+    for (std::size_t channels : {3, 16, 20, 35}) {
+        const Shape shape = {2, channels, 5, 3};
+        const NDArray<double> a = randomArray(shape, static_cast<unsigned>(channels));
+        std::size_t misplaced = 0;
+        for (MemoryFormat from : formats) {
+            const NDArray<double> src = a.to_format(from);
+            CHECK(src.format() == from);
+            CHECK_EQ(src.size(), a.size());
+            for (std::size_t n = 0; n < shape[0]; n++) {
+                for (std::size_t c = 0; c < shape[1]; c++) {
+                    for (std::size_t h = 0; h < shape[2]; h++) {
+                        for (std::size_t w = 0; w < shape[3]; w++) {
+                            misplaced += (src.data()[storageOffset(shape, from, n, c, h, w)] != a(n, c, h, w)) ? 1 : 0;
+                        }
+                    }
+                }
+            }
+            CHECK_EQ(nonzeroPadding(src), std::size_t(0));
+            for (MemoryFormat to : formats) {
+                const NDArray<double> dst = src.to_format(to);
+                CHECK_EQ(nonzeroPadding(dst), std::size_t(0));
+                const NDArray<double> back = dst.to_format(MemoryFormat::RowMajor);
+                for (std::size_t i = 0; i < a.size(); i++) {
+                    misplaced += (back.data()[i] != a.data()[i]) ? 1 : 0;
+                }
+                // Into an existing array, whose stale padding is overwritten.
+                NDArray<double> into(shape, to, 0.0);
+                for (std::size_t i = 0; i < shape_size(into.storage_shape()); i++) {
+                    into.data()[i] = 7.0;
+                }
+                reorder(src, into);
+                CHECK_EQ(nonzeroPadding(into), std::size_t(0));
+                for (std::size_t i = 0; i < a.size(); i++) {
+                    misplaced += (into.to_format(MemoryFormat::RowMajor).data()[i] != a.data()[i]) ? 1 : 0;
+                }
+            }
+        }
+        CHECK_EQ(misplaced, std::size_t(0));
+    }
+}
+
+// Scalar operations and reductions on a partial channel block leave the
+// padding at zero and do not count it.
+TEST(channelsBlockedPadding) {
+    const Shape shape = {2, 20, 3, 4};
+    NDArray<double> a(shape, MemoryFormat::ChannelsBlocked, -2.0);
+    CHECK_EQ(nonzeroPadding(a), std::size_t(0));
+    CHECK_EQ(a.max(), -2.0);
+    a += 1.0;
+    a *= 3.0;
+    a -= 0.5;
+    a /= 2.0;
+    CHECK_EQ(nonzeroPadding(a), std::size_t(0));
+    CHECK_EQ(a.max(), -1.75);
+    CHECK_NEAR(a.sum(), -1.75 * static_cast<double>(a.size()), 1e-12);
+    const NDArray<double> r = a.to_format(MemoryFormat::RowMajor);
+    CHECK_NEAR(r.sum(), a.sum(), 1e-12);
+}
+
+TEST(memoryFormatErrors) {
+    CHECK_THROWS(NDArray<double>(Shape{2, 3, 4}, MemoryFormat::ChannelsLast), const std::invalid_argument&);
+    CHECK_THROWS(NDArray<double>(Shape{2, 3, 4}, MemoryFormat::ChannelsBlocked), const std::invalid_argument&);
+    const NDArray<double> blocked(Shape{1, 20, 2, 2}, MemoryFormat::ChannelsBlocked);
+    CHECK_THROWS(blocked.view(), const std::invalid_argument&);
+    NDArray<double> other(Shape{1, 20, 2, 3}, MemoryFormat::RowMajor);
+    CHECK_THROWS(reorder(blocked, other), const std::invalid_argument&);
+}
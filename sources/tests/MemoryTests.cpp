@@ -0,0 +1,38 @@
+#include <cstdint>
+
+#include "memory/MemoryResource.hpp"
+#include "tests/Test.hpp"
+
+TEST(poolSizeClasses) {
+    for (std::size_t c = 0; c < 80; c++) {
+        const std::size_t bytes = memory::PoolResource::classBytes(c);
+        CHECK_EQ(memory::PoolResource::sizeClass(bytes), c);
+        CHECK_EQ(memory::PoolResource::sizeClass(bytes + 1), c + 1);
+    }
+}
+
+// A power-of-two buffer and its header take a block of exactly their size,
+// and the statistics count the bytes requested apart from the blocks.
+TEST(poolPowerOfTwoBuffers) {
+    memory::PoolResource pool(memory::heapResource());
+    const memory::ScopedResource scope(pool);
+    for (std::size_t shift = 6; shift <= 24; shift += 6) {
+        const std::size_t bytes = std::size_t(1) << shift;
+        pool.resetStats();
+        void* p = memory::allocate(bytes);
+        CHECK_EQ(reinterpret_cast<std::uintptr_t>(p) % memory::alignment, std::uintptr_t(0));
+        const memory::Stats stats = pool.stats();
+        CHECK_EQ(stats.bytesAllocated, bytes + memory::alignment);
+        CHECK_EQ(stats.bytesInUse, bytes + memory::alignment);
+        memory::deallocate(p);
+        CHECK_EQ(pool.stats().bytesInUse, std::size_t(0));
+    }
+    pool.resetStats();
+    memory::deallocate(memory::allocate(1000));
+    void* p = memory::allocate(1000);
+    const memory::Stats stats = pool.stats();
+    CHECK_EQ(stats.bytesAllocated, 2 * (1000 + memory::alignment));
+    CHECK_EQ(stats.hits, std::size_t(1));
+    CHECK(stats.bytesInUse >= 1000 + memory::alignment);
+    memory::deallocate(p);
+}
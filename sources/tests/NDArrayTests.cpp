@@ -0,0 +1,119 @@
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "ndarray/NDArray.hpp"
+#include "tests/Test.hpp"
+
+using Shape = std::vector<std::size_t>;
+
+// Row-major array of the given shape holding 1, 2, 3...
+static NDArray<double> sequence(const Shape& shape) {
+    NDArray<double> a(shape, MemoryFormat::RowMajor);
+    for (std::size_t i = 0; i < a.size(); i++) {
+        a.data()[i] = static_cast<double>(i + 1);
+    }
+    return a;
+}
+
+TEST(broadcastShapes) {
+    CHECK(broadcast_shapes(Shape{3, 1}, Shape{1, 4}) == (Shape{3, 4}));
+    CHECK(broadcast_shapes(Shape{5, 3, 4}, Shape{4}) == (Shape{5, 3, 4}));
+    CHECK(broadcast_shapes(Shape{2, 1, 4}, Shape{3, 1}) == (Shape{2, 3, 4}));
+    CHECK(broadcast_shapes(Shape{}, Shape{2, 2}) == (Shape{2, 2}));
+    CHECK_THROWS(broadcast_shapes(Shape{2, 3}, Shape{3, 2}), const std::invalid_argument&);
+}
+
+TEST(broadcastColumnAndRow) {
+    const NDArray<double> column = sequence({3, 1});
+    const NDArray<double> row = sequence({1, 4});
+    const NDArray<double> sum = column + row;
+    const NDArray<double> difference = column - row;
+    CHECK(sum.shape() == (Shape{3, 4}));
+    for (std::size_t i = 0; i < 3; i++) {
+        for (std::size_t j = 0; j < 4; j++) {
+            CHECK_EQ(sum(i, j), column(i, 0) + row(0, j));
+            CHECK_EQ(difference(i, j), column(i, 0) - row(0, j));
+        }
+    }
+}
+
+TEST(broadcastLeadingAxes) {
+    const NDArray<double> a = sequence({2, 3, 4});
+    const NDArray<double> b = sequence({4});
+    const NDArray<double> product = a * b;
+    const NDArray<double> quotient = b / a;
+    CHECK(product.shape() == (Shape{2, 3, 4}));
+    CHECK(quotient.shape() == (Shape{2, 3, 4}));
+    for (std::size_t i = 0; i < 2; i++) {
+        for (std::size_t j = 0; j < 3; j++) {
+            for (std::size_t k = 0; k < 4; k++) {
+                CHECK_EQ(product(i, j, k), a(i, j, k) * b(k));
+                CHECK_EQ(quotient(i, j, k), b(k) / a(i, j, k));
+            }
+        }
+    }
+}
+
+TEST(broadcastScalar) {
+    const NDArray<double> a = sequence({2, 5});
+    const NDArray<double> shifted = a - 1.0;
+    const NDArray<double> inverted = 2.0 / a;
+    for (std::size_t i = 0; i < 2; i++) {
+        for (std::size_t j = 0; j < 5; j++) {
+            CHECK_EQ(shifted(i, j), a(i, j) - 1.0);
+            CHECK_EQ(inverted(i, j), 2.0 / a(i, j));
+        }
+    }
+}
+
+TEST(broadcastInPlace) {
+    NDArray<double> a = sequence({3, 4});
+    const NDArray<double> expected = sequence({3, 4});
+    a += sequence({4});
+    a -= sequence({3, 1});
+    for (std::size_t i = 0; i < 3; i++) {
+        for (std::size_t j = 0; j < 4; j++) {
+            CHECK_EQ(a(i, j), expected(i, j) + static_cast<double>(j + 1) - static_cast<double>(i + 1));
+        }
+    }
+    // The result of an in-place operation keeps the shape of its target.
+    NDArray<double> column = sequence({3, 1});
+    CHECK_THROWS(column += sequence({3, 4}), const std::invalid_argument&);
+    CHECK_THROWS(a += sequence({3}), const std::invalid_argument&);
+}
+
+// The rvalue overloads reuse the storage of their left operand.
+TEST(broadcastIntoTemporary) {
+    NDArray<double> a = sequence({2, 3});
+    const double* storage = a.data();
+    const NDArray<double> sum = std::move(a) + sequence({1, 3});
+    CHECK(sum.data() == storage);
+    const NDArray<double> reference = sequence({2, 3});
+    for (std::size_t i = 0; i < 2; i++) {
+        for (std::size_t j = 0; j < 3; j++) {
+            CHECK_EQ(sum(i, j), reference(i, j) + static_cast<double>(j + 1));
+        }
+    }
+}
+
+// A source that is a broadcast slice of its destination is read before any
+// of it is overwritten.
+TEST(broadcastFromOwnSlice) {
+    NDArray<double> a = sequence({3, 2});
+    a += a.slice(0, 0, 1);
+    const double rows[] = {2, 4, 4, 6, 6, 8};
+    for (std::size_t i = 0; i < 6; i++) {
+        CHECK_EQ(a.data()[i], rows[i]);
+    }
+    NDArray<double> b = sequence({2, 3});
+    b.view() *= b.slice(1, 2, 3);
+    const double columns[] = {3, 6, 9, 24, 30, 36};
+    for (std::size_t i = 0; i < 6; i++) {
+        CHECK_EQ(b.data()[i], columns[i]);
+    }
+    // The same memory under the same layout is still updated in place.
+    NDArray<double> c = sequence({2, 2});
+    c += c;
+    CHECK_EQ(c(1, 1), 8.0);
+}
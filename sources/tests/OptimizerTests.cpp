@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "matrix/Matrix.hpp"
+#include "ndarray/NDArray.hpp"
+#include "nn/Optimizer.hpp"
+#include "tests/Test.hpp"
+
+template<typename T>
+static void fillRandom(T* values, std::size_t n, std::uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    for (std::size_t i = 0; i < n; i++) {
+        values[i] = static_cast<T>(uniform(rng));
+    }
+}
+
+// One scalar parameter and its moments, stepped with the textbook formulas.
+struct Reference {
+    double w;
+    double m = 0;
+    double v = 0;
+
+    void step(double g, const nn::OptimizerOptions& o, std::uint64_t t) {
+        switch (o.algorithm) {
+            case nn::OptimizerAlgorithm::Sgd: {
+                double d = g + o.weightDecay * w;
+                if (o.momentum != 0) {
+                    m = o.momentum * m + d;
+                    d = o.nesterov ? d + o.momentum * m : m;
+                }
+                w -= o.learningRate * d;
+                break;
+            }
+            case nn::OptimizerAlgorithm::Adam:
+            case nn::OptimizerAlgorithm::AdamW: {
+                const bool decoupled = o.algorithm == nn::OptimizerAlgorithm::AdamW;
+                const double d = decoupled ? g : g + o.weightDecay * w;
+                m = o.beta1 * m + (1 - o.beta1) * d;
+                v = o.beta2 * v + (1 - o.beta2) * d * d;
+                const double mHat = m / (1 - std::pow(o.beta1, static_cast<double>(t)));
+                const double vHat = v / (1 - std::pow(o.beta2, static_cast<double>(t)));
+                if (decoupled) {
+                    w -= o.learningRate * o.weightDecay * w;
+                }
+                w -= o.learningRate * mHat / (std::sqrt(vHat) + o.epsilon);
+                break;
+            }
+        }
+    }
+};
+
+static std::vector<nn::OptimizerOptions> optimizerCases() {
+    std::vector<nn::OptimizerOptions> cases;
+    nn::OptimizerOptions o;
+    o.learningRate = 0.1;
+    cases.push_back(o);
+    o.weightDecay = 0.05;
+    cases.push_back(o);
+    o.momentum = 0.9;
+    cases.push_back(o);
+    o.nesterov = true;
+    cases.push_back(o);
+    o = nn::OptimizerOptions();
+    o.algorithm = nn::OptimizerAlgorithm::Adam;
+    o.learningRate = 0.01;
+    cases.push_back(o);
+    o.weightDecay = 0.1;
+    o.epsilon = 1e-3;
+    cases.push_back(o);
+    o.algorithm = nn::OptimizerAlgorithm::AdamW;
+    cases.push_back(o);
+    o.beta1 = 0.5;
+    o.beta2 = 0.7;
+    cases.push_back(o);
+    return cases;
+}
+
+// Parameters of several kinds and sizes, one of them larger than the
+// parallel grain so that a step splits it over threads, stepped with fresh
+// gradients and a learning rate change against the reference.
+template<typename T>
+static void checkOptimizer(double tolerance) {
+    const std::size_t rows = 5;
+    const std::size_t cols = 7;
+    const std::size_t large = 70001;
+    const std::size_t small = 3;
+    for (const nn::OptimizerOptions& options : optimizerCases()) {
+        NDArray<T> a({large}, MemoryFormat::RowMajor);
+        NDArray<T> ga({large}, MemoryFormat::RowMajor);
+        BasicMatrix<T> b(rows, cols);
+        BasicMatrix<T> gb(rows, cols);
+        std::vector<T> c(small);
+        std::vector<T> gc(small);
+        fillRandom(a.data(), large, 1);
+        fillRandom(c.data(), small, 2);
+        for (std::size_t i = 0; i < rows; i++) {
+            for (std::size_t j = 0; j < cols; j++) {
+                b(i, j) = static_cast<T>(0.1 * static_cast<double>(i) - 0.05 * static_cast<double>(j));
+            }
+        }
+        // Views of every element, in the order the gradients are filled.
+        std::vector<T*> weights;
+        std::vector<T*> gradients;
+        for (std::size_t i = 0; i < large; i++) {
+            weights.push_back(&a.data()[i]);
+            gradients.push_back(&ga.data()[i]);
+        }
+        for (std::size_t i = 0; i < rows; i++) {
+            for (std::size_t j = 0; j < cols; j++) {
+                weights.push_back(&b(i, j));
+                gradients.push_back(&gb(i, j));
+            }
+        }
+        for (std::size_t i = 0; i < small; i++) {
+            weights.push_back(&c[i]);
+            gradients.push_back(&gc[i]);
+        }
+        std::vector<Reference> reference;
+        for (T* w : weights) {
+            reference.push_back({static_cast<double>(*w)});
+        }
+
+        nn::BasicOptimizer<T> optimizer(options);
+        optimizer.add(a, ga);
+        optimizer.add(b, gb);
+        optimizer.add(c.data(), gc.data(), small);
+        nn::OptimizerOptions current = options;
+        std::mt19937 rng(3);
+        std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+        for (std::uint64_t t = 1; t <= 4; t++) {
+            if (t == 3) {
+                current.learningRate /= 2;
+                optimizer.setLearningRate(current.learningRate);
+            }
+            for (std::size_t i = 0; i < gradients.size(); i++) {
+                *gradients[i] = static_cast<T>(uniform(rng));
+                reference[i].step(static_cast<double>(*gradients[i]), current, t);
+            }
+            optimizer.step();
+        }
+        CHECK_EQ(optimizer.steps(), std::uint64_t(4));
+        double error = 0;
+        for (std::size_t i = 0; i < weights.size(); i++) {
+            error = std::max(error, std::abs(static_cast<double>(*weights[i]) - reference[i].w));
+        }
+        CHECK_NEAR(error, 0.0, tolerance);
+    }
+}
+
+TEST(optimizerStepsDouble) {
+    checkOptimizer<double>(1e-12);
+}
+
+TEST(optimizerStepsFloat) {
+    checkOptimizer<float>(1e-5);
+}
+
+// Moment buffers are only allocated when the algorithm needs them.
+TEST(optimizerState) {
+    std::vector<double> w(10);
+    std::vector<double> g(10);
+    nn::OptimizerOptions o;
+    nn::Optimizer sgd(o);
+    sgd.add(w.data(), g.data(), w.size());
+    sgd.step();
+    CHECK_EQ(sgd.size(), std::size_t(10));
+    CHECK_EQ(sgd.stateBytes(), std::size_t(0));
+    o.momentum = 0.9;
+    nn::Optimizer momentum(o);
+    momentum.add(w.data(), g.data(), w.size());
+    momentum.step();
+    CHECK_EQ(momentum.stateBytes(), 10 * sizeof(double));
+    o.algorithm = nn::OptimizerAlgorithm::Adam;
+    nn::Optimizer adam(o);
+    adam.add(w.data(), g.data(), w.size());
+    adam.step();
+    CHECK_EQ(adam.stateBytes(), 20 * sizeof(double));
+}
+
+TEST(optimizerErrors) {
+    nn::OptimizerOptions o;
+    o.learningRate = -1;
+    CHECK_THROWS(nn::Optimizer{o}, const std::invalid_argument&);
+    o = nn::OptimizerOptions();
+    o.nesterov = true;
+    CHECK_THROWS(nn::Optimizer{o}, const std::invalid_argument&);
+    o = nn::OptimizerOptions();
+    o.beta2 = 1;
+    CHECK_THROWS(nn::Optimizer{o}, const std::invalid_argument&);
+    o = nn::OptimizerOptions();
+    o.epsilon = 0;
+    CHECK_THROWS(nn::Optimizer{o}, const std::invalid_argument&);
+    nn::Optimizer optimizer;
+    CHECK_THROWS(optimizer.setLearningRate(-0.5), const std::invalid_argument&);
+    CHECK_EQ(optimizer.options().learningRate, 0.01);
+    NDArray<double> value({2, 3}, MemoryFormat::RowMajor);
+    NDArray<double> gradient({3, 2}, MemoryFormat::RowMajor);
+    CHECK_THROWS(optimizer.add(value, gradient), const std::invalid_argument&);
+}
@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "matrix/Matrix.hpp"
+#include "ndarray/NDArray.hpp"
+#include "quant/Quantize.hpp"
+#include "tests/Test.hpp"
+
+using Shape = std::vector<std::size_t>;
+
+static NDArray<float> randomArray(const Shape& shape, float lo, float hi, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> uniform(lo, hi);
+    NDArray<float> a(shape, MemoryFormat::RowMajor);
+    for (std::size_t i = 0; i < a.size(); i++) {
+        a.data()[i] = uniform(rng);
+    }
+    return a;
+}
+
+// Every element of a 3-D array dequantizes to within half a step of its
+// channel.
+static void checkRoundTrip(const NDArray<float>& a, quant::Scheme scheme, std::size_t axis) {
+    const quant::QuantizedTensor q = quant::quantize(a, scheme, axis);
+    const NDArray<float> back = quant::dequantize(q);
+    CHECK(back.shape() == a.shape());
+    const Shape& shape = a.shape();
+    std::size_t outOfBounds = 0;
+    for (std::size_t i = 0; i < shape[0]; i++) {
+        for (std::size_t j = 0; j < shape[1]; j++) {
+            for (std::size_t k = 0; k < shape[2]; k++) {
+                const std::size_t index[3] = {i, j, k};
+                const std::size_t c = (axis == quant::perTensor) ? 0 : index[axis];
+                const float error = std::abs(back(i, j, k) - a(i, j, k));
+                outOfBounds += error > 0.5f * q.scale(c) * (1.f + 1e-5f);
+            }
+        }
+    }
+    CHECK_EQ(outOfBounds, std::size_t(0));
+    CHECK_EQ(q.scales().size(), (axis == quant::perTensor) ? std::size_t(1) : shape[axis]);
+    if (scheme == quant::Scheme::Symmetric) {
+        CHECK(std::all_of(q.zeroPoints().begin(), q.zeroPoints().end(), [](std::int32_t z) { return z == 0; }));
+    }
+}
+
+TEST(quantizeRoundTrip) {
+    // Channels whose ranges differ by orders of magnitude.
+    NDArray<float> a = randomArray({4, 5, 33}, -1.f, 1.f, 1);
+    for (std::size_t i = 0; i < 4; i++) {
+        for (std::size_t k = 0; k < 33; k++) {
+            for (std::size_t j = 0; j < 5; j++) {
+                a(i, j, k) *= std::pow(10.f, static_cast<float>(j) - 2.f);
+            }
+        }
+    }
+    for (quant::Scheme scheme : {quant::Scheme::Symmetric, quant::Scheme::Asymmetric}) {
+        for (std::size_t axis : {quant::perTensor, std::size_t(0), std::size_t(1), std::size_t(2)}) {
+            checkRoundTrip(a, scheme, axis);
+        }
+    }
+    // One-sided data, as after a ReLU, uses all 256 levels asymmetrically.
+    const NDArray<float> relu = randomArray({3, 8, 16}, 0.f, 6.f, 2);
+    checkRoundTrip(relu, quant::Scheme::Asymmetric, quant::perTensor);
+    const quant::QuantizedTensor q = quant::quantize(relu, quant::Scheme::Asymmetric);
+    CHECK_EQ(q.zeroPoint(), -128);
+    CHECK_EQ(*std::max_element(q.data(), q.data() + q.size()), std::int8_t(127));
+    const quant::QuantizedTensor s = quant::quantize(relu);
+    CHECK_EQ(*std::max_element(s.data(), s.data() + s.size()), std::int8_t(127));
+    // Zeros quantize to the zero point with a finite scale.
+    const quant::QuantizedTensor zeros = quant::quantize(NDArray<float>(Shape{2, 3, 4}, MemoryFormat::RowMajor, 0.f));
+    CHECK_EQ(quant::dequantize(zeros)(1, 2, 3), 0.f);
+    CHECK_THROWS(quant::quantize(a, quant::Scheme::Symmetric, 3), const std::invalid_argument&);
+}
+
+TEST(quantizeMatrix) {
+    FloatMatrix m(std::size_t(6), std::size_t(10));
+    for (std::size_t i = 0; i < 6; i++) {
+        for (std::size_t j = 0; j < 10; j++) {
+            m(i, j) = std::sin(static_cast<float>(i * 10 + j)) * static_cast<float>(i + 1);
+        }
+    }
+    const quant::QuantizedTensor q = quant::quantize(m, quant::Scheme::Symmetric, 0);
+    FloatMatrix back(std::size_t(6), std::size_t(10));
+    quant::dequantize(q, back);
+    for (std::size_t i = 0; i < 6; i++) {
+        for (std::size_t j = 0; j < 10; j++) {
+            CHECK(std::abs(back(i, j) - m(i, j)) <= 0.5f * q.scale(i) * (1.f + 1e-5f));
+        }
+    }
+    FloatMatrix wrong(std::size_t(10), std::size_t(6));
+    CHECK_THROWS(quant::dequantize(q, wrong), const std::invalid_argument&);
+}
+
+// The int8 product with zero points folded in afterwards equals the product
+// of the dequantized operands.
+TEST(quantizedDotWithZeroPoints) {
+    const std::size_t m = 23, k = 70, n = 17;
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> values(-128, 127), zeros(-20, 20);
+    std::uniform_real_distribution<float> scales(0.001f, 0.1f);
+    for (bool perChannel : {false, true}) {
+        std::vector<float> scaleA(perChannel ? m : 1), scaleB(perChannel ? n : 1);
+        std::vector<std::int32_t> zeroA(scaleA.size()), zeroB(scaleB.size());
+        for (std::size_t i = 0; i < scaleA.size(); i++) {
+            scaleA[i] = scales(rng);
+            zeroA[i] = zeros(rng);
+        }
+        for (std::size_t j = 0; j < scaleB.size(); j++) {
+            scaleB[j] = scales(rng);
+            zeroB[j] = zeros(rng);
+        }
+        quant::QuantizedTensor a({m, k}, scaleA, zeroA, perChannel ? 0 : quant::perTensor);
+        quant::QuantizedTensor b({k, n}, scaleB, zeroB, perChannel ? 1 : quant::perTensor);
+        for (std::size_t i = 0; i < a.size(); i++) {
+            a.data()[i] = static_cast<std::int8_t>(values(rng));
+        }
+        for (std::size_t i = 0; i < b.size(); i++) {
+            b.data()[i] = static_cast<std::int8_t>(values(rng));
+        }
+        const FloatMatrix c = quant::dot(a, b);
+        for (std::size_t i = 0; i < m; i++) {
+            for (std::size_t j = 0; j < n; j++) {
+                double expected = 0;
+                for (std::size_t p = 0; p < k; p++) {
+                    expected += (static_cast<double>(a.data()[i * k + p]) - a.zeroPoint(i)) * (static_cast<double>(b.data()[p * n + j]) - b.zeroPoint(j));
+                }
+                expected *= static_cast<double>(a.scale(i)) * static_cast<double>(b.scale(j));
+                CHECK_NEAR(c(i, j), expected, 1e-6 * std::max(1.0, std::abs(expected)));
+            }
+        }
+    }
+    const quant::QuantizedTensor rows({4, 5}, std::vector<float>(5, 1.f), std::vector<std::int32_t>(5, 0), 1);
+    const quant::QuantizedTensor cols({5, 3}, {1.f}, {0});
+    CHECK_THROWS(quant::dot(rows, cols), const std::invalid_argument&);
+    CHECK_THROWS(quant::dot(cols, cols), const std::invalid_argument&);
+    CHECK_THROWS(quant::QuantizedTensor({4, 5}, {1.f, 2.f}, {0, 0}, 0), const std::invalid_argument&);
+}
+
+// Dynamic quantization of the activations against float weights quantized
+// per output column: the error stays within the sum of the quantization
+// errors of the terms.
+TEST(dynamicQuantizedDot) {
+    const std::size_t m = 9, k = 64, n = 12;
+    const NDArray<float> xs = randomArray({m, k}, 0.f, 2.f, 4);
+    const NDArray<float> ws = randomArray({k, n}, -0.5f, 0.5f, 5);
+    FloatMatrix x(m, k), w(k, n);
+    std::copy(xs.data(), xs.data() + xs.size(), x.data());
+    std::copy(ws.data(), ws.data() + ws.size(), w.data());
+    const quant::QuantizedTensor qw = quant::quantize(w, quant::Scheme::Symmetric, 1);
+    const FloatMatrix c = quant::dot(x, qw);
+    for (std::size_t i = 0; i < m; i++) {
+        for (std::size_t j = 0; j < n; j++) {
+            double expected = 0;
+            for (std::size_t p = 0; p < k; p++) {
+                expected += static_cast<double>(x(i, p)) * static_cast<double>(w(p, j));
+            }
+            // |x| <= 2 and |w| <= 0.5, with half steps of 2/255/2 and 0.5/127/2.
+            const double bound = static_cast<double>(k) * (0.5 * 1.0 / 255.0 + 2.0 * 0.25 / 127.0) * 1.01;
+            CHECK_NEAR(c(i, j), expected, bound);
+        }
+    }
+}
@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "matrix/Matrix.hpp"
+#include "ndarray/NDArray.hpp"
+#include "tests/Test.hpp"
+#include "vector/Vector.hpp"
+
+using Shape = std::vector<std::size_t>;
+
+static NDArray<double> randomArray(const Shape& shape, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    NDArray<double> a(shape, MemoryFormat::RowMajor);
+    for (std::size_t i = 0; i < a.size(); i++) {
+        a.data()[i] = uniform(rng);
+    }
+    return a;
+}
+
+// Reduces axis of a 3-D array one output element at a time, in the order
+// [outer, inner] of the remaining axes.
+struct NaiveReductions {
+    std::vector<double> sum, mean, max, min, variance;
+    std::vector<std::size_t> argmax;
+
+    NaiveReductions(const NDArray<double>& a, std::size_t axis) {
+        const Shape shape = a.shape();
+        const std::size_t n = shape[axis];
+        std::size_t other[2];
+        for (std::size_t d = 0, o = 0; d < 3; d++) {
+            if (d != axis) {
+                other[o++] = shape[d];
+            }
+        }
+        for (std::size_t i = 0; i < other[0]; i++) {
+            for (std::size_t j = 0; j < other[1]; j++) {
+                std::vector<double> values(n);
+                for (std::size_t r = 0; r < n; r++) {
+                    std::size_t index[3];
+                    for (std::size_t d = 0, o = 0; d < 3; d++) {
+                        index[d] = (d == axis) ? r : ((o++ == 0) ? i : j);
+                    }
+                    values[r] = a(index[0], index[1], index[2]);
+                }
+                double total = 0;
+                for (double v : values) {
+                    total += v;
+                }
+                const double average = total / static_cast<double>(n);
+                double squares = 0;
+                for (double v : values) {
+                    squares += (v - average) * (v - average);
+                }
+                const auto largest = std::max_element(values.begin(), values.end());
+                sum.push_back(total);
+                mean.push_back(average);
+                max.push_back(*largest);
+                min.push_back(*std::min_element(values.begin(), values.end()));
+                variance.push_back(squares / static_cast<double>(n));
+                argmax.push_back(static_cast<std::size_t>(largest - values.begin()));
+            }
+        }
+    }
+};
+
+static void checkClose(const NDArray<double>& actual, const std::vector<double>& expected, double tolerance) {
+    CHECK_EQ(actual.size(), expected.size());
+    for (std::size_t i = 0; i < std::min(actual.size(), expected.size()); i++) {
+        CHECK_NEAR(actual.data()[i], expected[i], tolerance);
+    }
+}
+
+TEST(ndarrayAxisReductions) {
+    // Long enough along each axis to cross a pairwise block boundary.
+    const NDArray<double> a = randomArray({37, 70, 45}, 5);
+    for (std::size_t axis = 0; axis < 3; axis++) {
+        const NaiveReductions expected(a, axis);
+        checkClose(a.sum(axis), expected.sum, 1e-12);
+        checkClose(a.mean(axis), expected.mean, 1e-14);
+        checkClose(a.max(axis), expected.max, 0);
+        checkClose(a.min(axis), expected.min, 0);
+        checkClose(a.var(axis), expected.variance, 1e-14);
+        const NDArray<std::size_t> argmax = a.argmax(axis);
+        CHECK_EQ(argmax.size(), expected.argmax.size());
+        for (std::size_t i = 0; i < std::min(argmax.size(), expected.argmax.size()); i++) {
+            CHECK_EQ(argmax.data()[i], expected.argmax[i]);
+        }
+    }
+}
+
+TEST(ndarrayReductionShapes) {
+    const NDArray<double> a = randomArray({2, 3, 4}, 6);
+    CHECK(a.sum(1).shape() == (Shape{2, 4}));
+    CHECK(a.sum(1, true).shape() == (Shape{2, 1, 4}));
+    CHECK(a.max(2, true).shape() == (Shape{2, 3, 1}));
+    CHECK_THROWS(a.sum(3), const std::invalid_argument&);
+    const NDArray<double> empty(Shape{2, 0}, MemoryFormat::RowMajor);
+    CHECK_THROWS(empty.max(1), const std::invalid_argument&);
+}
+
+TEST(matrixAxisReductions) {
+    const std::size_t rows = 29, cols = 41;
+    const NDArray<double> values = randomArray({rows, cols}, 7);
+    Matrix m(rows, cols);
+    std::copy(values.data(), values.data() + rows * cols, m.begin());
+    for (std::size_t axis = 0; axis < 2; axis++) {
+        const std::size_t n = (axis == 0) ? rows : cols;
+        const std::size_t outputs = (axis == 0) ? cols : rows;
+        const Vector sum = m.sum(axis);
+        const Vector mean = m.mean(axis);
+        const Vector max = m.max(axis);
+        const Vector min = m.min(axis);
+        const Vector norm = m.norm(axis);
+        const Vector variance = m.variance(axis);
+        const std::vector<std::size_t> argmax = m.argmax(axis);
+        CHECK_EQ(sum.size(), outputs);
+        CHECK_EQ(argmax.size(), outputs);
+        for (std::size_t o = 0; o < std::min(outputs, sum.size()); o++) {
+            double total = 0, squares = 0, largest = -INFINITY, smallest = INFINITY;
+            std::size_t largestAt = 0;
+            for (std::size_t r = 0; r < n; r++) {
+                const double v = (axis == 0) ? m(r, o) : m(o, r);
+                total += v;
+                squares += v * v;
+                if (v > largest) {
+                    largest = v;
+                    largestAt = r;
+                }
+                smallest = std::min(smallest, v);
+            }
+            const double average = total / static_cast<double>(n);
+            double deviations = 0;
+            for (std::size_t r = 0; r < n; r++) {
+                const double v = (axis == 0) ? m(r, o) : m(o, r);
+                deviations += (v - average) * (v - average);
+            }
+            CHECK_NEAR(sum[o], total, 1e-13);
+            CHECK_NEAR(mean[o], average, 1e-14);
+            CHECK_EQ(max[o], largest);
+            CHECK_EQ(min[o], smallest);
+            CHECK_NEAR(norm[o], std::sqrt(squares), 1e-13);
+            CHECK_NEAR(variance[o], deviations / static_cast<double>(n), 1e-14);
+            CHECK_EQ(argmax[o], largestAt);
+        }
+    }
+    CHECK_THROWS(m.sum(2), const char*);
+}
+
+// A float sum of 2^22 equal terms accumulated one by one drifts by percents;
+// pairwise sums stay within a few ulps on every instruction set, which ctest
+// checks by running the suite under each NN_SIMD_ISA.
+TEST(pairwiseSumAccuracy) {
+    const std::size_t n = std::size_t(1) << 22;
+    const FloatVector v(n, 0.1f);
+    const double expected = static_cast<double>(0.1f) * static_cast<double>(n);
+    CHECK_NEAR(v.sum() / expected, 1.0, 1e-6);
+    NDArray<float> a(Shape{n}, MemoryFormat::RowMajor, 0.1f);
+    CHECK_NEAR(a.sum() / expected, 1.0, 1e-6);
+    CHECK_NEAR(a.sum(0).data()[0] / expected, 1.0, 1e-6);
+}
+
+TEST(vectorReductions) {
+    Vector v(1000);
+    for (std::size_t i = 0; i < v.size(); i++) {
+        v[static_cast<unsigned int>(i)] = std::sin(static_cast<double>(i));
+    }
+    double total = 0, largest = -INFINITY, dot = 0;
+    for (double x : v) {
+        total += x;
+        largest = std::max(largest, x);
+        dot += x * x;
+    }
+    CHECK_NEAR(v.sum(), total, 1e-12);
+    CHECK_EQ(v.max(), largest);
+    CHECK_NEAR(v.dot(v), dot, 1e-12);
+    CHECK_THROWS(Vector().max(), const char*);
+}
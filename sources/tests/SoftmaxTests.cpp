@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "matrix/Matrix.hpp"
+#include "ndarray/NDArray.hpp"
+#include "nn/Softmax.hpp"
+#include "tests/Test.hpp"
+
+using Shape = std::vector<std::size_t>;
+
+// Logits spread over [-8, 8], with every third row shifted by 1000 so that a
+// softmax without the maximum subtracted overflows.
+template<typename T>
+static NDArray<T> randomLogits(const Shape& shape, std::uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(-8.0, 8.0);
+    NDArray<T> a(shape, MemoryFormat::RowMajor);
+    const std::size_t cols = shape.back();
+    for (std::size_t i = 0; i < a.size(); i++) {
+        a.data()[i] = static_cast<T>(uniform(rng) + (((i / cols) % 3 == 0) ? 1000.0 : 0.0));
+    }
+    return a;
+}
+
+template<typename T>
+static BasicMatrix<T> toMatrix(const NDArray<T>& a, std::size_t rows, std::size_t cols) {
+    BasicMatrix<T> m(rows, cols);
+    for (std::size_t i = 0; i < rows; i++) {
+        for (std::size_t j = 0; j < cols; j++) {
+            m(i, j) = a.data()[i * cols + j];
+        }
+    }
+    return m;
+}
+
+// Reference log-softmax of every row, in long double.
+static std::vector<long double> referenceLogSoftmax(const long double* x, std::size_t rows, std::size_t cols) {
+    std::vector<long double> out(rows * cols);
+    for (std::size_t i = 0; i < rows; i++) {
+        const long double* xi = x + i * cols;
+        long double max = xi[0];
+        for (std::size_t j = 1; j < cols; j++) {
+            max = std::max(max, xi[j]);
+        }
+        long double sum = 0;
+        for (std::size_t j = 0; j < cols; j++) {
+            sum += std::exp(xi[j] - max);
+        }
+        for (std::size_t j = 0; j < cols; j++) {
+            out[i * cols + j] = (xi[j] - max) - std::log(sum);
+        }
+    }
+    return out;
+}
+
+template<typename T>
+static std::vector<long double> widen(const T* x, std::size_t n) {
+    return std::vector<long double>(x, x + n);
+}
+
+template<typename T>
+static double maxError(const T* values, const std::vector<long double>& expected) {
+    double error = 0;
+    for (std::size_t i = 0; i < expected.size(); i++) {
+        error = std::max(error, static_cast<double>(std::abs(static_cast<long double>(values[i]) - expected[i])));
+    }
+    return error;
+}
+
+template<typename T>
+static void checkForward(double tolerance) {
+    const Shape shape = {3, 4, 37};
+    const std::size_t rows = 12;
+    const std::size_t cols = 37;
+    const NDArray<T> x = randomLogits<T>(shape, 1);
+    const std::vector<long double> logY = referenceLogSoftmax(widen(x.data(), x.size()).data(), rows, cols);
+    std::vector<long double> y(logY.size());
+    for (std::size_t i = 0; i < y.size(); i++) {
+        y[i] = std::exp(logY[i]);
+    }
+
+    CHECK_NEAR(maxError(nn::softmax(x).data(), y), 0.0, tolerance);
+    CHECK_NEAR(maxError(nn::logSoftmax(x).data(), logY), 0.0, 8 * tolerance);
+    // In place.
+    NDArray<T> inPlace = x;
+    nn::logSoftmax(inPlace, inPlace);
+    CHECK_NEAR(maxError(inPlace.data(), logY), 0.0, 8 * tolerance);
+
+    const BasicMatrix<T> m = toMatrix(x, rows, cols);
+    const BasicMatrix<T> ym = nn::softmax(m);
+    const BasicMatrix<T> logYm = nn::logSoftmax(m);
+    double error = 0;
+    for (std::size_t i = 0; i < rows; i++) {
+        for (std::size_t j = 0; j < cols; j++) {
+            error = std::max(error, static_cast<double>(std::abs(ym(i, j) - y[i * cols + j])));
+            error = std::max(error, static_cast<double>(std::abs(logYm(i, j) - logY[i * cols + j])) / 8);
+        }
+    }
+    CHECK_NEAR(error, 0.0, tolerance);
+}
+
+TEST(softmaxForwardDouble) {
+    checkForward<double>(1e-15);
+}
+
+TEST(softmaxForwardFloat) {
+    checkForward<float>(1e-6);
+}
+
+// The backward passes against the Jacobian of the reference, and the
+// cross-entropy and its gradient against -log(softmax[label]).
+template<typename T>
+static void checkGradients(double tolerance) {
+    const std::size_t rows = 7;
+    const std::size_t cols = 21;
+    const NDArray<T> x = randomLogits<T>({rows, cols}, 2);
+    const NDArray<T> gradY = randomLogits<T>({rows, cols}, 3) / T(1000);
+    const std::vector<long double> logY = referenceLogSoftmax(widen(x.data(), x.size()).data(), rows, cols);
+    std::vector<long double> softmaxGrad(logY.size());
+    std::vector<long double> logSoftmaxGrad(logY.size());
+    for (std::size_t i = 0; i < rows; i++) {
+        for (std::size_t j = 0; j < cols; j++) {
+            // d y_k / d x_j = y_k (delta_kj - y_j), d log y_k / d x_j = delta_kj - y_j.
+            long double gs = 0;
+            long double gl = 0;
+            for (std::size_t k = 0; k < cols; k++) {
+                const long double yk = std::exp(logY[i * cols + k]);
+                const long double yj = std::exp(logY[i * cols + j]);
+                const long double delta = (j == k) ? 1 : 0;
+                gs += gradY.data()[i * cols + k] * yk * (delta - yj);
+                gl += gradY.data()[i * cols + k] * (delta - yj);
+            }
+            softmaxGrad[i * cols + j] = gs;
+            logSoftmaxGrad[i * cols + j] = gl;
+        }
+    }
+    NDArray<T> gradX({rows, cols}, MemoryFormat::RowMajor, T(9));
+    nn::softmaxBackward(nn::softmax(x), gradY, gradX);
+    CHECK_NEAR(maxError(gradX.data(), softmaxGrad), 0.0, tolerance);
+    // gradY - softmax(x) * sum(gradY) cancels against a row sum of order cols.
+    nn::logSoftmaxBackward(nn::logSoftmax(x), gradY, gradX);
+    CHECK_NEAR(maxError(gradX.data(), logSoftmaxGrad), 0.0, 8 * tolerance);
+
+    const std::vector<std::size_t> labels = {0, 20, 3, 3, 11, 19, 7};
+    long double loss = 0;
+    std::vector<long double> lossGrad(logY.size());
+    for (std::size_t i = 0; i < rows; i++) {
+        loss -= logY[i * cols + labels[i]] / rows;
+        for (std::size_t j = 0; j < cols; j++) {
+            lossGrad[i * cols + j] = (std::exp(logY[i * cols + j]) - ((j == labels[i]) ? 1 : 0)) / rows;
+        }
+    }
+    NDArray<T> gradLogits({rows, cols}, MemoryFormat::RowMajor, T(9));
+    CHECK_NEAR(nn::softmaxCrossEntropy(x, labels), loss, 8 * tolerance);
+    CHECK_NEAR(nn::softmaxCrossEntropy(x, labels, gradLogits), loss, 8 * tolerance);
+    CHECK_NEAR(maxError(gradLogits.data(), lossGrad), 0.0, tolerance);
+
+    const BasicMatrix<T> m = toMatrix(x, rows, cols);
+    BasicMatrix<T> gradM(rows, cols, T(9));
+    CHECK_NEAR(nn::softmaxCrossEntropy(m, labels, gradM), loss, 8 * tolerance);
+    double error = 0;
+    for (std::size_t i = 0; i < rows; i++) {
+        for (std::size_t j = 0; j < cols; j++) {
+            error = std::max(error, static_cast<double>(std::abs(gradM(i, j) - lossGrad[i * cols + j])));
+        }
+    }
+    CHECK_NEAR(error, 0.0, tolerance);
+}
+
+TEST(softmaxGradientsDouble) {
+    checkGradients<double>(1e-15);
+}
+
+TEST(softmaxGradientsFloat) {
+    checkGradients<float>(1e-6);
+}
+
+// The cross-entropy gradient agrees with central differences of the loss.
+TEST(crossEntropyFiniteDifferences) {
+    NDArray<double> x = randomLogits<double>({4, 9}, 4);
+    const std::vector<std::size_t> labels = {8, 0, 4, 4};
+    NDArray<double> gradient({4, 9}, MemoryFormat::RowMajor);
+    nn::softmaxCrossEntropy(x, labels, gradient);
+    const double h = 1e-5;
+    double error = 0;
+    for (std::size_t i = 0; i < x.size(); i++) {
+        const double saved = x.data()[i];
+        x.data()[i] = saved + h;
+        const double up = nn::softmaxCrossEntropy(x, labels);
+        x.data()[i] = saved - h;
+        const double down = nn::softmaxCrossEntropy(x, labels);
+        x.data()[i] = saved;
+        error = std::max(error, std::abs((up - down) / (2 * h) - gradient.data()[i]));
+    }
+    CHECK_NEAR(error, 0.0, 1e-9);
+}
+
+TEST(softmaxErrors) {
+    const NDArray<double> x = randomLogits<double>({2, 5}, 5);
+    NDArray<double> wrong({5, 2}, MemoryFormat::RowMajor);
+    CHECK_THROWS(nn::softmax(x, wrong), const std::invalid_argument&);
+    CHECK_THROWS(nn::softmax(x.to_format(MemoryFormat::ColumnMajor)), const std::invalid_argument&);
+    CHECK_THROWS(nn::softmaxCrossEntropy(x, {0}), const std::invalid_argument&);
+    CHECK_THROWS(nn::softmaxCrossEntropy(x, {0, 5}), const std::invalid_argument&);
+    BasicMatrix<double> m(std::size_t(2), std::size_t(5));
+    BasicMatrix<double> wrongM(std::size_t(5), std::size_t(2));
+    CHECK_THROWS(nn::logSoftmax(m, wrongM), const std::invalid_argument&);
+}
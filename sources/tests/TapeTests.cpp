@@ -0,0 +1,138 @@
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "autograd/Tape.hpp"
+#include "gemm/Epilogue.hpp"
+#include "ndarray/NDArray.hpp"
+#include "tests/Test.hpp"
+
+using Shape = std::vector<std::size_t>;
+
+static NDArray<double> randomArray(const Shape& shape, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    NDArray<double> a(shape, MemoryFormat::RowMajor);
+    for (std::size_t i = 0; i < a.size(); i++) {
+        a.data()[i] = uniform(rng);
+    }
+    return a;
+}
+
+// A small network using every operation of the tape, with broadcasting
+// along both leading and inner axes.
+struct Model {
+    NDArray<double> x = randomArray({5, 4}, 1);
+    std::vector<NDArray<double>> params = {randomArray({4, 6}, 2), randomArray({6}, 3), randomArray({3, 6}, 4), randomArray({3}, 5)};
+    std::vector<NDArray<double>> grads;
+    Activation activation;
+
+    explicit Model(Activation a) : activation(a) {
+        for (const NDArray<double>& p : params) {
+            grads.emplace_back(p.shape(), MemoryFormat::RowMajor, 0.0);
+        }
+    }
+
+    autograd::Variable record(autograd::Tape& tape) {
+        const autograd::Variable input = tape.constant(x);
+        const autograd::Variable w1 = tape.parameter(params[0], grads[0]);
+        const autograd::Variable b = tape.parameter(params[1], grads[1]);
+        const autograd::Variable w2 = tape.parameter(params[2], grads[2]);
+        const autograd::Variable s = tape.parameter(params[3], grads[3]);
+        const autograd::Variable h = tape.activate(tape.add(tape.matmul(input, w1), b), activation);
+        const autograd::Variable z = tape.matmul(h, tape.transpose(w2));
+        const autograd::Variable u = tape.div(tape.sub(z, s), tape.add(tape.mul(s, s), tape.constant(one)));
+        const autograd::Variable t = tape.transpose(tape.reshape(u, {3, 5}), {1, 0});
+        return tape.add(tape.mean(tape.reshape(u, {15})), tape.sum(tape.mul(t, t)));
+    }
+
+    double loss() {
+        autograd::Tape tape;
+        return tape.value(record(tape)).data()[0];
+    }
+
+    NDArray<double> one = NDArray<double>(Shape{1}, MemoryFormat::RowMajor, 1.0);
+};
+
+TEST(tapeGradientsMatchFiniteDifferences) {
+    for (Activation activation : {Activation::Identity, Activation::Relu, Activation::Gelu, Activation::Sigmoid, Activation::Tanh}) {
+        Model model(activation);
+        autograd::Tape tape;
+        tape.backward(model.record(tape));
+        const double h = 1e-6;
+        for (std::size_t p = 0; p < model.params.size(); p++) {
+            for (std::size_t i = 0; i < model.params[p].size(); i++) {
+                double& w = model.params[p].data()[i];
+                const double saved = w;
+                w = saved + h;
+                const double up = model.loss();
+                w = saved - h;
+                const double down = model.loss();
+                w = saved;
+                const double numeric = (up - down) / (2 * h);
+                CHECK_NEAR(model.grads[p].data()[i], numeric, 1e-6 * std::max(1.0, std::abs(numeric)));
+            }
+        }
+    }
+}
+
+// Gradients add into the caller's buffers, and a cleared tape records the
+// same graph again from its pool, even after a rejected recording.
+TEST(tapeBufferReuse) {
+    Model model(Activation::Tanh);
+    autograd::Tape tape;
+    const autograd::Variable first = model.record(tape);
+    CHECK(tape.liveBytes() > 0);
+    tape.backward(first);
+    const std::vector<NDArray<double>> once = model.grads;
+    // Only the root's value is left.
+    CHECK_EQ(tape.liveBytes(), sizeof(double));
+    const std::size_t pooled = tape.pooledBytes();
+    const std::size_t peak = tape.peakBytes();
+    CHECK(pooled > 0);
+    CHECK_THROWS(tape.backward(first), const std::invalid_argument&);
+    CHECK_THROWS(tape.add(first, first), const std::invalid_argument&);
+
+    tape.clear();
+    CHECK_EQ(tape.size(), std::size_t(0));
+    tape.backward(model.record(tape));
+    CHECK_EQ(tape.pooledBytes(), pooled);
+    CHECK_EQ(tape.peakBytes(), peak);
+    for (std::size_t p = 0; p < once.size(); p++) {
+        for (std::size_t i = 0; i < once[p].size(); i++) {
+            CHECK_NEAR(model.grads[p].data()[i], 2 * once[p].data()[i], 1e-12);
+        }
+    }
+    tape.clear();
+    tape.trim();
+    CHECK_EQ(tape.pooledBytes(), std::size_t(0));
+}
+
+// Intermediate values are released by backward() unless retained.
+TEST(tapeReleasesValues) {
+    const NDArray<double> a = randomArray({3, 3}, 6);
+    NDArray<double> grad(Shape{3, 3}, MemoryFormat::RowMajor, 0.0);
+    autograd::Tape tape;
+    const autograd::Variable p = tape.parameter(a, grad);
+    const autograd::Variable squared = tape.mul(p, p);
+    const autograd::Variable shifted = tape.add(squared, p);
+    tape.retain(shifted);
+    const autograd::Variable root = tape.sum(tape.activate(shifted, Activation::Sigmoid));
+    tape.backward(root);
+    CHECK_THROWS(tape.value(squared), const std::invalid_argument&);
+    CHECK_EQ(tape.value(shifted)(1, 2), a(1, 2) * a(1, 2) + a(1, 2));
+    CHECK_EQ(tape.value(p)(0, 1), a(0, 1));
+    for (std::size_t i = 0; i < 3; i++) {
+        for (std::size_t j = 0; j < 3; j++) {
+            const double y = 1 / (1 + std::exp(-(a(i, j) * a(i, j) + a(i, j))));
+            CHECK_NEAR(grad(i, j), y * (1 - y) * (2 * a(i, j) + 1), 1e-14);
+        }
+    }
+
+    autograd::Tape other;
+    const autograd::Variable c = other.constant(a);
+    CHECK_THROWS(other.backward(other.sum(c)), const std::invalid_argument&);
+    CHECK_THROWS(other.matmul(c, other.constant(randomArray({2, 3}, 7))), const std::invalid_argument&);
+    CHECK_THROWS(other.reshape(c, {4, 2}), const std::invalid_argument&);
+}
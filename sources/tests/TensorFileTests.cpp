@@ -0,0 +1,157 @@
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "io/TensorFile.hpp"
+#include "tests/Test.hpp"
+
+using Shape = std::vector<std::size_t>;
+
+// A file in the temporary directory, removed with its writer's temporary
+// when the test ends.
+class TemporaryPath {
+
+    std::string m_path;
+
+public:
+
+    explicit TemporaryPath(const std::string& name) :
+        m_path((std::filesystem::temp_directory_path() / ("nn-tests-" + name + ".nnt")).string())
+    {}
+
+    ~TemporaryPath() {
+        std::remove(m_path.c_str());
+        std::remove((m_path + ".tmp").c_str());
+    }
+
+    const std::string& str() const { return m_path; }
+
+};
+
+template<typename T>
+static NDArray<T> sequence(const Shape& shape, T step) {
+    NDArray<T> a(shape, MemoryFormat::RowMajor);
+    for (std::size_t i = 0; i < a.size(); i++) {
+        a.data()[i] = static_cast<T>(static_cast<T>(i % 101) * step);
+    }
+    return a;
+}
+
+template<typename T>
+static bool sameElements(const NDArray<T>& a, const NDArray<T>& b) {
+    if (a.shape() != b.shape()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.size(); i++) {
+        if (a.data()[i] != b.data()[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST(tensorFileRoundTrip) {
+    const TemporaryPath path("round-trip");
+    const NDArray<double> weights = sequence<double>({3, 4, 5}, 0.25);
+    const NDArray<float> bias = sequence<float>({7}, -1.5f);
+    const NDArray<std::int8_t> quantized = sequence<std::int8_t>({2, 9}, 1);
+    Matrix m(std::size_t(5), std::size_t(3));
+    for (std::size_t i = 0; i < 5; i++) {
+        for (std::size_t j = 0; j < 3; j++) {
+            m(i, j) = static_cast<double>(i) - 0.5 * static_cast<double>(j);
+        }
+    }
+    FloatVector v(std::size_t(6), 2.0f);
+    v[3] = -4.0f;
+
+    io::TensorWriter writer;
+    writer.add("weights", weights);
+    writer.add("bias", bias);
+    writer.add("quantized", quantized);
+    writer.add("matrix", m);
+    writer.add("vector", v);
+    CHECK_EQ(writer.size(), std::size_t(5));
+    CHECK_THROWS(writer.add("bias", bias), const std::invalid_argument&);
+    writer.write(path.str());
+    CHECK(!std::filesystem::exists(path.str() + ".tmp"));
+
+    const io::TensorFile file(path.str());
+    file.verifyAll();
+    CHECK_EQ(file.size(), std::size_t(5));
+    CHECK(file.contains("matrix"));
+    CHECK(!file.contains("missing"));
+    CHECK(file.info("weights").shape == (Shape{3, 4, 5}));
+    CHECK(sameElements(file.load<double>("weights"), weights));
+    CHECK(sameElements(file.load<float>("bias"), bias));
+    CHECK(sameElements(file.load<std::int8_t>("quantized"), quantized));
+    const Matrix loaded = file.loadMatrix<double>("matrix");
+    CHECK_EQ(loaded.nbRows(), std::size_t(5));
+    CHECK_EQ(loaded.nbCols(), std::size_t(3));
+    for (std::size_t i = 0; i < 5; i++) {
+        for (std::size_t j = 0; j < 3; j++) {
+            CHECK_EQ(loaded(i, j), m(i, j));
+        }
+    }
+    const FloatVector loadedVector = file.loadVector<float>("vector");
+    CHECK_EQ(loadedVector.size(), v.size());
+    for (unsigned int i = 0; i < 6; i++) {
+        CHECK_EQ(loadedVector[i], v[i]);
+    }
+    CHECK_THROWS(file.load<float>("weights"), const std::invalid_argument&);
+    CHECK_THROWS(file.info("missing"), const std::invalid_argument&);
+}
+
+// Rewriting a file must leave the pages of an earlier mapping readable.
+TEST(tensorFileRewriteWhileMapped) {
+    const TemporaryPath path("rewrite");
+    const NDArray<double> first = sequence<double>({256, 300}, 1.0);
+    io::TensorWriter writer;
+    writer.add("a", first);
+    writer.write(path.str());
+    const io::TensorFile old(path.str());
+
+    const NDArray<double> second = sequence<double>({2, 2}, 3.0);
+    writer.clear();
+    writer.add("b", second);
+    writer.write(path.str());
+
+    CHECK(sameElements(old.load<double>("a"), first));
+    CHECK(old.verify("a"));
+    const io::TensorFile now(path.str());
+    CHECK(!now.contains("a"));
+    CHECK(sameElements(now.load<double>("b"), second));
+}
+
+TEST(tensorFileDetectsCorruption) {
+    const TemporaryPath path("corrupt");
+    io::TensorWriter writer;
+    writer.add("a", sequence<float>({64}, 0.5f));
+    writer.write(path.str());
+    std::uint64_t offset = 0;
+    {
+        const io::TensorFile file(path.str());
+        CHECK(file.verify("a"));
+        offset = file.info("a").offset;
+    }
+    {
+        std::fstream stream(path.str(), std::ios::in | std::ios::out | std::ios::binary);
+        stream.seekp(static_cast<std::streamoff>(offset + 3));
+        stream.put('\x7f');
+    }
+    {
+        const io::TensorFile file(path.str());
+        CHECK(!file.verify("a"));
+        CHECK_THROWS(file.verifyAll(), const std::runtime_error&);
+    }
+    {
+        std::fstream stream(path.str(), std::ios::in | std::ios::out | std::ios::binary);
+        stream.seekp(10);
+        stream.put('\x7f');
+    }
+    CHECK_THROWS(io::TensorFile(path.str()), const std::runtime_error&);
+    CHECK_THROWS(io::TensorFile(path.str() + ".missing"), const std::runtime_error&);
+}
@@ -0,0 +1,119 @@
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tests/Test.hpp"
+
+struct Options {
+    std::string filter = ".*";
+    bool list = false;
+    bool help = false;
+};
+
+struct Test {
+    std::string name;
+    test::Function function;
+};
+
+static std::vector<Test>& registry() {
+    static std::vector<Test> tests;
+    return tests;
+}
+
+// Failures of the running test.
+static std::size_t failures = 0;
+
+static void printUsage(std::ostream& out, const char* program) {
+    out << "Usage: " << program << " [options]\n"
+        << "  --filter=REGEX   only the tests whose name matches (.*)\n"
+        << "  --list           print the test names and exit\n"
+        << "  --help           print this message and exit\n";
+}
+
+static Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const std::string option(argv[i]);
+        const std::size_t equal = option.find('=');
+        const std::string key = option.substr(0, equal);
+        const std::string value = (equal == std::string::npos) ? "" : option.substr(equal + 1);
+        if (key == "--filter") {
+            options.filter = value;
+        } else if (key == "--list") {
+            options.list = true;
+        } else if (key == "--help" || key == "-h") {
+            options.help = true;
+        } else {
+            throw std::invalid_argument("Unknown option " + option + ", see --help.");
+        }
+    }
+    return options;
+}
+
+namespace test {
+
+bool registerTest(std::string name, Function function) {
+    registry().push_back(Test{std::move(name), std::move(function)});
+    return true;
+}
+
+void fail(const char* file, int line, const std::string& message) {
+    failures++;
+    std::cout << "  " << file << ":" << line << ": " << message << "\n";
+}
+
+int run(int argc, char** argv) {
+    Options options;
+    try {
+        options = parseOptions(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    if (options.help) {
+        printUsage(std::cout, argv[0]);
+        return 0;
+    }
+
+    const std::regex filter(options.filter);
+    std::size_t ran = 0;
+    std::vector<std::string> failed;
+    for (const Test& t : registry()) {
+        if (!std::regex_search(t.name, filter)) {
+            continue;
+        }
+        if (options.list) {
+            std::cout << t.name << "\n";
+            continue;
+        }
+        std::cout << t.name << std::endl;
+        failures = 0;
+        try {
+            t.function();
+        } catch (const std::exception& e) {
+            fail(__FILE__, __LINE__, std::string("uncaught exception: ") + e.what());
+        } catch (...) {
+            fail(__FILE__, __LINE__, "uncaught exception");
+        }
+        ran++;
+        if (failures != 0) {
+            failed.push_back(t.name);
+        }
+    }
+    if (options.list) {
+        return 0;
+    }
+
+    std::cout << "\n" << ran - failed.size() << " of " << ran << " tests passed\n";
+    for (const std::string& name : failed) {
+        std::cout << "FAILED " << name << "\n";
+    }
+    return failed.empty() ? 0 : 1;
+}
+
+}
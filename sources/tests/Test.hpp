@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cmath>
+#include <functional>
+#include <sstream>
+#include <string>
+
+// Unit test harness in the style of Google Test, without the dependency.
+//
+//     TEST(vectorSum) {
+//         Vector v(1000, 0.5);
+//         CHECK_NEAR(v.sum(), 500.0, 1e-12);
+//         CHECK_THROWS(Vector().max(), const char*);
+//     }
+//
+// A failed check records its file, line and expression and the test goes on;
+// an exception escaping a test fails it. run() returns non-zero when any test
+// failed, so that ctest reports it.
+namespace test {
+
+using Function = std::function<void()>;
+
+bool registerTest(std::string name, Function function);
+
+// Records a failure of the running test.
+void fail(const char* file, int line, const std::string& message);
+
+// Runs the registered tests. Options:
+//   --filter=REGEX   only the tests whose name matches
+//   --list           print the test names and exit
+//   --help           print the options and exit
+int run(int argc, char** argv);
+
+template<typename A, typename B>
+std::string describe(const char* expression, const A& actual, const B& expected) {
+    std::ostringstream text;
+    text.precision(17);
+    text << expression << " (" << actual << " vs " << expected << ")";
+    return text.str();
+}
+
+}
+
+#define TEST_CONCAT_IMPL(a, b) a##b
+#define TEST_CONCAT(a, b) TEST_CONCAT_IMPL(a, b)
+#define TEST(name) \
+    static void name(); \
+    [[maybe_unused]] static bool TEST_CONCAT(test_, __LINE__) = test::registerTest(#name, name); \
+    static void name()
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            test::fail(__FILE__, __LINE__, #condition); \
+        } \
+    } while (false)
+
+#define CHECK_EQ(actual, expected) \
+    do { \
+        const auto& checkActual = (actual); \
+        const auto& checkExpected = (expected); \
+        if (!(checkActual == checkExpected)) { \
+            test::fail(__FILE__, __LINE__, test::describe(#actual " == " #expected, checkActual, checkExpected)); \
+        } \
+    } while (false)
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+    do { \
+        const double checkActual = static_cast<double>(actual); \
+        const double checkExpected = static_cast<double>(expected); \
+        if (!(std::abs(checkActual - checkExpected) <= (tolerance))) { \
+            test::fail(__FILE__, __LINE__, test::describe(#actual " ~ " #expected, checkActual, checkExpected)); \
+        } \
+    } while (false)
+
+#define CHECK_THROWS(expression, Exception) \
+    do { \
+        bool checkThrown = false; \
+        try { \
+            (void)(expression); \
+        } catch (Exception) { \
+            checkThrown = true; \
+        } \
+        if (!checkThrown) { \
+            test::fail(__FILE__, __LINE__, #expression " does not throw " #Exception); \
+        } \
+    } while (false)
@@ -0,0 +1,135 @@
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "matrix/Matrix.hpp"
+#include "ndarray/NDArray.hpp"
+#include "tests/Test.hpp"
+#include "transpose/Transpose.hpp"
+
+using Shape = std::vector<std::size_t>;
+
+template<typename T>
+static std::vector<T> randomValues(std::size_t n, std::uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> uniform(-1000, 1000);
+    std::vector<T> values(n);
+    for (T& v : values) {
+        v = static_cast<T>(uniform(rng));
+    }
+    return values;
+}
+
+// Shapes around the 32 x 32 tiles and the SIMD tile widths, with leading
+// dimensions larger than the rows so that padding must be left alone.
+template<typename T>
+static void checkTranspose() {
+    const std::size_t shapes[][2] = {{1, 1}, {1, 17}, {9, 1}, {31, 33}, {64, 64}, {100, 257}, {1000, 3}};
+    std::uint32_t seed = 1;
+    for (const auto& shape : shapes) {
+        const std::size_t rows = shape[0], cols = shape[1];
+        const std::size_t lda = cols + 3, ldb = rows + 5;
+        const std::vector<T> a = randomValues<T>(rows * lda, seed++);
+        std::vector<T> b(cols * ldb, T(-7));
+        transpose(rows, cols, a.data(), lda, b.data(), ldb);
+        std::size_t mismatches = 0;
+        for (std::size_t j = 0; j < cols; j++) {
+            for (std::size_t i = 0; i < ldb; i++) {
+                const T expected = (i < rows) ? a[i * lda + j] : T(-7);
+                mismatches += (b[j * ldb + i] != expected);
+            }
+        }
+        CHECK_EQ(mismatches, std::size_t(0));
+    }
+}
+
+template<typename T>
+static void checkTransposeInPlace() {
+    std::uint32_t seed = 10;
+    for (std::size_t n : {1, 5, 8, 32, 33, 100, 130}) {
+        const std::size_t lda = n + 2;
+        const std::vector<T> original = randomValues<T>(n * lda, seed++);
+        std::vector<T> a = original;
+        transposeInPlace(n, a.data(), lda);
+        std::size_t mismatches = 0;
+        for (std::size_t i = 0; i < n; i++) {
+            for (std::size_t j = 0; j < lda; j++) {
+                const T expected = (j < n) ? original[j * lda + i] : original[i * lda + j];
+                mismatches += (a[i * lda + j] != expected);
+            }
+        }
+        CHECK_EQ(mismatches, std::size_t(0));
+    }
+}
+
+TEST(transposeBlocked) {
+    checkTranspose<double>();
+    checkTranspose<float>();
+    checkTranspose<std::int32_t>();
+}
+
+TEST(transposeSquareInPlace) {
+    checkTransposeInPlace<double>();
+    checkTransposeInPlace<float>();
+    checkTransposeInPlace<std::int32_t>();
+}
+
+TEST(matrixTranspose) {
+    for (std::size_t rows : {7, 40}) {
+        for (std::size_t cols : {7, 65}) {
+            Matrix m(rows, cols);
+            const std::vector<double> values = randomValues<double>(rows * cols, 20);
+            std::copy(values.begin(), values.end(), m.begin());
+            const Matrix t = m.transpose();
+            Matrix inPlace = m;
+            inPlace.transposeInPlace();
+            CHECK_EQ(t.nbRows(), cols);
+            CHECK_EQ(inPlace.nbRows(), cols);
+            CHECK_EQ(inPlace.nbCols(), rows);
+            std::size_t mismatches = 0;
+            for (std::size_t i = 0; i < rows; i++) {
+                for (std::size_t j = 0; j < cols; j++) {
+                    mismatches += (t(j, i) != m(i, j)) + (inPlace(j, i) != m(i, j));
+                }
+            }
+            CHECK_EQ(mismatches, std::size_t(0));
+        }
+    }
+}
+
+// Copies of permuted views, which go through 2-D transposes when the
+// source's stride-1 axis is not the destination's innermost one.
+TEST(permutedCopies) {
+    NDArray<double> a(Shape{6, 35, 40}, MemoryFormat::RowMajor);
+    for (std::size_t i = 0; i < a.size(); i++) {
+        a.data()[i] = static_cast<double>(i);
+    }
+    const std::vector<std::vector<std::size_t>> permutations = {{0, 2, 1}, {2, 0, 1}, {1, 2, 0}, {2, 1, 0}};
+    for (const std::vector<std::size_t>& axes : permutations) {
+        const NDArrayView<const double> permuted = a.transpose(axes);
+        const NDArray<double> copy = permuted.copy();
+        NDArray<double> assigned(permuted.shape(), MemoryFormat::RowMajor);
+        assigned.view().assign(permuted);
+        std::size_t mismatches = 0;
+        for (std::size_t i = 0; i < copy.shape()[0]; i++) {
+            for (std::size_t j = 0; j < copy.shape()[1]; j++) {
+                for (std::size_t k = 0; k < copy.shape()[2]; k++) {
+                    const std::size_t index[3] = {i, j, k};
+                    std::size_t source[3];
+                    for (std::size_t d = 0; d < 3; d++) {
+                        source[axes[d]] = index[d];
+                    }
+                    const double expected = a(source[0], source[1], source[2]);
+                    mismatches += (copy(i, j, k) != expected) + (assigned(i, j, k) != expected);
+                }
+            }
+        }
+        CHECK_EQ(mismatches, std::size_t(0));
+    }
+    // A strided slice of a transposed view copies like any other view.
+    const NDArray<double> sliced = a.transpose().slice(0, 3, 40, 4).copy();
+    CHECK(sliced.shape() == (Shape{10, 35, 6}));
+    CHECK_EQ(sliced(9, 34, 5), a(5, 34, 39));
+    CHECK_THROWS(a.transpose({0, 0, 1}), const std::invalid_argument&);
+}
@@ -0,0 +1,5 @@
+#include "tests/Test.hpp"
+
+int main(int argc, char** argv) {
+    return test::run(argc, argv);
+}
@@ -0,0 +1,23 @@
+#include "profile/Profiler.hpp"
+#include "simd/Simd.hpp"
+#include "transpose/Transpose.hpp"
+
+void transpose(std::size_t rows, std::size_t cols, const double* a, std::size_t lda, double* b, std::size_t ldb) {
+    NN_PROFILE_SCOPE(Transpose, "transpose", 2.0 * static_cast<double>(rows * cols * sizeof(double)), 0);
+    transposeParallel(rows, cols, a, lda, b, ldb, simd::kernels<double>().transpose);
+}
+
+void transpose(std::size_t rows, std::size_t cols, const float* a, std::size_t lda, float* b, std::size_t ldb) {
+    NN_PROFILE_SCOPE(Transpose, "transpose", 2.0 * static_cast<double>(rows * cols * sizeof(float)), 0);
+    transposeParallel(rows, cols, a, lda, b, ldb, simd::kernels<float>().transpose);
+}
+
+void transposeInPlace(std::size_t n, double* a, std::size_t lda) {
+    NN_PROFILE_SCOPE(Transpose, "transposeInPlace", 2.0 * static_cast<double>(n * n * sizeof(double)), 0);
+    transposeInPlaceParallel(n, a, lda, simd::kernels<double>().transpose);
+}
+
+void transposeInPlace(std::size_t n, float* a, std::size_t lda) {
+    NN_PROFILE_SCOPE(Transpose, "transposeInPlace", 2.0 * static_cast<double>(n * n * sizeof(float)), 0);
+    transposeInPlaceParallel(n, a, lda, simd::kernels<float>().transpose);
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+#include "parallel/ThreadPool.hpp"
+
+// Transposes of row-major blocks: b[j * ldb + i] = a[i * lda + j].
+//
+// A plain double loop reads a along rows but writes b along columns, so on
+// large matrices every write touches a new cache line (and a new page every
+// few hundred writes). Here the problem is halved along its longest side until
+// the pieces are transposeBlock x transposeBlock tiles, whose source and
+// destination lines stay in L1 while the tile is transposed, whatever the
+// cache sizes. Leaves are transposed by a leaf(a, lda, b, ldb, rows, cols)
+// callable: the SIMD tile transposes for double and float, an element loop
+// for other types.
+
+// Side of the leaf tiles: a source and a destination tile of doubles take
+// 16 KiB together.
+constexpr std::size_t transposeBlock = 32;
+
+template<typename T, typename Leaf>
+void transposeRecursive(
+    std::size_t rows, std::size_t cols,
+    const T* a, std::size_t lda, T* b, std::size_t ldb,
+    const Leaf& leaf
+) {
+    if (rows <= transposeBlock && cols <= transposeBlock) {
+        leaf(a, lda, b, ldb, rows, cols);
+        return;
+    }
+    // Split points are kept on multiples of the tile side so that leaves are
+    // full tiles except on the last row and column of tiles.
+    if (rows >= cols) {
+        const std::size_t half = (rows / 2 + transposeBlock - 1) / transposeBlock * transposeBlock;
+        transposeRecursive(half, cols, a, lda, b, ldb, leaf);
+        transposeRecursive(rows - half, cols, a + half * lda, lda, b + half, ldb, leaf);
+    } else {
+        const std::size_t half = (cols / 2 + transposeBlock - 1) / transposeBlock * transposeBlock;
+        transposeRecursive(rows, half, a, lda, b, ldb, leaf);
+        transposeRecursive(rows, cols - half, a + half, lda, b + half * ldb, ldb, leaf);
+    }
+}
+
+// Out-of-place transpose of the rows x cols matrix a into b, with panels of
+// the longest side split over the thread pool. a and b must not overlap.
+template<typename T, typename Leaf>
+void transposeParallel(
+    std::size_t rows, std::size_t cols,
+    const T* a, std::size_t lda, T* b, std::size_t ldb,
+    const Leaf& leaf
+) {
+    if (rows == 0 || cols == 0) {
+        return;
+    }
+    const std::size_t panel = std::min(rows, cols);
+    const std::size_t grain = std::max<std::size_t>(1, parallelGrain / panel / transposeBlock) * transposeBlock;
+    if (rows >= cols) {
+        parallelFor(0, rows, grain, [&](std::size_t first, std::size_t last) {
+            transposeRecursive(last - first, cols, a + first * lda, lda, b + first, ldb, leaf);
+        });
+    } else {
+        parallelFor(0, cols, grain, [&](std::size_t first, std::size_t last) {
+            transposeRecursive(rows, last - first, a + first, lda, b + first * ldb, ldb, leaf);
+        });
+    }
+}
+
+// In-place transpose of the n x n matrix a. Each pair of tiles mirrored
+// across the diagonal is swapped through a tile-sized buffer on the stack,
+// and block rows of tiles are split over the thread pool.
+template<typename T, typename Leaf>
+void transposeInPlaceParallel(std::size_t n, T* a, std::size_t lda, const Leaf& leaf) {
+    const std::size_t blocks = (n + transposeBlock - 1) / transposeBlock;
+    const std::size_t grain = std::max<std::size_t>(1, parallelGrain / std::max<std::size_t>(1, n * transposeBlock));
+    parallelFor(0, blocks, grain, [&](std::size_t first, std::size_t last) {
+        alignas(64) T tile[transposeBlock * transposeBlock];
+        for (std::size_t bi = first; bi < last; bi++) {
+            const std::size_t i0 = bi * transposeBlock;
+            const std::size_t h = std::min(transposeBlock, n - i0);
+            T* diagonal = a + i0 * lda + i0;
+            leaf(diagonal, lda, tile, transposeBlock, h, h);
+            for (std::size_t r = 0; r < h; r++) {
+                std::copy(tile + r * transposeBlock, tile + r * transposeBlock + h, diagonal + r * lda);
+            }
+            for (std::size_t j0 = i0 + transposeBlock; j0 < n; j0 += transposeBlock) {
+                const std::size_t w = std::min(transposeBlock, n - j0);
+                T* upper = a + i0 * lda + j0;   // h x w
+                T* lower = a + j0 * lda + i0;   // w x h
+                leaf(upper, lda, tile, transposeBlock, h, w);
+                leaf(lower, lda, upper, lda, w, h);
+                for (std::size_t r = 0; r < w; r++) {
+                    std::copy(tile + r * transposeBlock, tile + r * transposeBlock + h, lower + r * lda);
+                }
+            }
+        }
+    });
+}
+
+template<typename T>
+void transposeLeaf(const T* a, std::size_t lda, T* b, std::size_t ldb, std::size_t rows, std::size_t cols) {
+    for (std::size_t i = 0; i < rows; i++) {
+        for (std::size_t j = 0; j < cols; j++) {
+            b[j * ldb + i] = a[i * lda + j];
+        }
+    }
+}
+
+// b (cols x rows) = transpose of a (rows x cols). a and b must not overlap.
+template<typename T>
+void transpose(std::size_t rows, std::size_t cols, const T* a, std::size_t lda, T* b, std::size_t ldb) {
+    transposeParallel(rows, cols, a, lda, b, ldb, &transposeLeaf<T>);
+}
+
+// a = transpose of a, for the n x n matrix a.
+template<typename T>
+void transposeInPlace(std::size_t n, T* a, std::size_t lda) {
+    transposeInPlaceParallel(n, a, lda, &transposeLeaf<T>);
+}
+
+// The same for double and float, with the SIMD tile transposes.
+void transpose(std::size_t rows, std::size_t cols, const double* a, std::size_t lda, double* b, std::size_t ldb);
+void transpose(std::size_t rows, std::size_t cols, const float* a, std::size_t lda, float* b, std::size_t ldb);
+void transposeInPlace(std::size_t n, double* a, std::size_t lda);
+void transposeInPlace(std::size_t n, float* a, std::size_t lda);
@@ -1,126 +1,165 @@
-#include <algorithm>
-#include <functional>
-#include <numeric>
-
+#include "profile/Profiler.hpp"
+#include "reduce/Reduce.hpp"
+#include "simd/Simd.hpp"
 #include "vector/Vector.hpp"
 
 // Constructors
 
-Vector::Vector() : 
+template<typename T>
+BasicVector<T>::BasicVector() : 
     m_vec() 
 {}
 
-Vector::Vector(std::size_t n, double value) :
+template<typename T>
+BasicVector<T>::BasicVector(std::size_t n, T value) :
     m_vec(n, value)
 {}
 
 // Operators
 
-Vector& Vector::operator+=(const Vector& other) {
+template<typename T>
+BasicVector<T>& BasicVector<T>::operator+=(const BasicVector& other) {
     checkVectDimOp(*this, other);
-    std::transform(
-        begin(), end(), 
-        other.cbegin(),
-        begin(), std::plus<double>()
-    );
+    NN_PROFILE_SCOPE(Elementwise, "Vector += Vector", 3.0 * static_cast<double>(size() * sizeof(T)), static_cast<double>(size()));
+    simd::kernels<T>().add(m_vec.data(), other.m_vec.data(), m_vec.data(), size());
     return *this;
 }
 
-Vector& Vector::operator+=(double value) {
-    std::for_each(begin(), end(), [value](double& d){d += value;});
+template<typename T>
+BasicVector<T>& BasicVector<T>::operator+=(T value) {
+    NN_PROFILE_SCOPE(Elementwise, "Vector += scalar", 2.0 * static_cast<double>(size() * sizeof(T)), static_cast<double>(size()));
+    simd::kernels<T>().addScalar(m_vec.data(), value, m_vec.data(), size());
     return *this;
 }
 
-Vector& Vector::operator-=(const Vector& other) {
+template<typename T>
+BasicVector<T>& BasicVector<T>::operator-=(const BasicVector& other) {
     checkVectDimOp(*this, other);
-    std::transform(
-        begin(), end(),
-        other.cbegin(),
-        begin(), std::minus<double>()
-    );
+    NN_PROFILE_SCOPE(Elementwise, "Vector -= Vector", 3.0 * static_cast<double>(size() * sizeof(T)), static_cast<double>(size()));
+    simd::kernels<T>().sub(m_vec.data(), other.m_vec.data(), m_vec.data(), size());
     return *this;
 }
 
-Vector& Vector::operator-=(double value) {
-    std::for_each(begin(), end(), [value](double& d){d -= value;});
+template<typename T>
+BasicVector<T>& BasicVector<T>::operator-=(T value) {
+    NN_PROFILE_SCOPE(Elementwise, "Vector -= scalar", 2.0 * static_cast<double>(size() * sizeof(T)), static_cast<double>(size()));
+    simd::kernels<T>().subScalar(m_vec.data(), value, m_vec.data(), size());
     return *this;
 }
 
-Vector& Vector::operator*=(const Vector& other) {
+template<typename T>
+BasicVector<T>& BasicVector<T>::operator*=(const BasicVector& other) {
     checkVectDimOp(*this, other);
-    std::transform(
-        begin(), end(),
-        other.cbegin(),
-        begin(), std::multiplies<double>()
-    );
+    NN_PROFILE_SCOPE(Elementwise, "Vector *= Vector", 3.0 * static_cast<double>(size() * sizeof(T)), static_cast<double>(size()));
+    simd::kernels<T>().mul(m_vec.data(), other.m_vec.data(), m_vec.data(), size());
     return *this;
 }
 
-Vector& Vector::operator*=(double value) {
-    std::for_each(begin(), end(), [value](double& d){d *= value;});
+template<typename T>
+BasicVector<T>& BasicVector<T>::operator*=(T value) {
+    NN_PROFILE_SCOPE(Elementwise, "Vector *= scalar", 2.0 * static_cast<double>(size() * sizeof(T)), static_cast<double>(size()));
+    simd::kernels<T>().mulScalar(m_vec.data(), value, m_vec.data(), size());
     return *this;
 }
 
-Vector& Vector::operator/=(const Vector& other) {
+template<typename T>
+BasicVector<T>& BasicVector<T>::operator/=(const BasicVector& other) {
     checkVectDimOp(*this, other);
-    std::transform(
-        begin(), end(),
-        other.cbegin(),
-        begin(), std::divides<double>()
-    );
+    NN_PROFILE_SCOPE(Elementwise, "Vector /= Vector", 3.0 * static_cast<double>(size() * sizeof(T)), static_cast<double>(size()));
+    simd::kernels<T>().div(m_vec.data(), other.m_vec.data(), m_vec.data(), size());
     return *this;
 }
 
-Vector& Vector::operator/=(double value) {
-    std::for_each(begin(), end(), [value](double& d){d /= value;});
+template<typename T>
+BasicVector<T>& BasicVector<T>::operator/=(T value) {
+    NN_PROFILE_SCOPE(Elementwise, "Vector /= scalar", 2.0 * static_cast<double>(size() * sizeof(T)), static_cast<double>(size()));
+    simd::kernels<T>().divScalar(m_vec.data(), value, m_vec.data(), size());
     return *this;
 }
 
-double& Vector::operator[](unsigned int i) {
+template<typename T>
+T& BasicVector<T>::operator[](unsigned int i) {
     return m_vec[i];
 }
 
-const double& Vector::operator[](unsigned int i) const {
+template<typename T>
+const T& BasicVector<T>::operator[](unsigned int i) const {
     return m_vec[i];
 }
 
 // Other members 
 
-std::size_t Vector::size() const {
+template<typename T>
+std::size_t BasicVector<T>::size() const {
     return m_vec.size();
 }
 
-double Vector::dot(const Vector& other) const {
+template<typename T>
+T* BasicVector<T>::data() {
+    return m_vec.data();
+}
+
+template<typename T>
+const T* BasicVector<T>::data() const {
+    return m_vec.data();
+}
+
+template<typename T>
+T BasicVector<T>::sum() const {
+    NN_PROFILE_SCOPE(Reduction, "Vector sum", static_cast<double>(size() * sizeof(T)), static_cast<double>(size()));
+    return reduceSum(m_vec.data(), size());
+}
+
+template<typename T>
+T BasicVector<T>::max() const {
+    if (m_vec.empty()) {
+        throw("Cannot take the maximum of an empty Vector.");
+    }
+    NN_PROFILE_SCOPE(Reduction, "Vector max", static_cast<double>(size() * sizeof(T)), static_cast<double>(size()));
+    return reduce(Reduction::Max, m_vec.data(), size());
+}
+
+template<typename T>
+T BasicVector<T>::dot(const BasicVector& other) const {
     checkVectDimOp(*this, other);
-    return std::inner_product(cbegin(), cend(), other.cbegin(), 0.);
+    NN_PROFILE_SCOPE(Dot, "Vector dot", 2.0 * static_cast<double>(size() * sizeof(T)), 2.0 * static_cast<double>(size()));
+    return reduceDot(m_vec.data(), other.m_vec.data(), size());
 }
 
-Vector Vector::dot(const Matrix& other) const {
-    checkVectMatDimDot(*this, other);
-    return std::inner_product(cbegin(), cend(), other.cbegin(), Vector(size()));
+template<typename T>
+BasicVector<T> BasicVector<T>::dot(const BasicMatrix<T>& other) const {
+    BasicVector result(other.nbCols());
+    ::dot(*this, other, result);
+    return result;
 }
 
-std::vector<double>::iterator Vector::begin() {
+template<typename T>
+typename BasicVector<T>::iterator BasicVector<T>::begin() {
     return m_vec.begin();
 }
 
-std::vector<double>::const_iterator Vector::begin() const {
+template<typename T>
+typename BasicVector<T>::const_iterator BasicVector<T>::begin() const {
     return m_vec.cbegin();
 }
 
-std::vector<double>::iterator Vector::end() {
+template<typename T>
+typename BasicVector<T>::iterator BasicVector<T>::end() {
     return m_vec.end();
 }
 
-std::vector<double>::const_iterator Vector::end() const {
+template<typename T>
+typename BasicVector<T>::const_iterator BasicVector<T>::end() const {
     return m_vec.cend();
 }
 
-std::vector<double>::const_iterator Vector::cbegin() const {
+template<typename T>
+typename BasicVector<T>::const_iterator BasicVector<T>::cbegin() const {
     return m_vec.cbegin();
 }
 
-std::vector<double>::const_iterator Vector::cend() const {
+template<typename T>
+typename BasicVector<T>::const_iterator BasicVector<T>::cend() const {
     return m_vec.cend();
 }
 
@@ -130,108 +169,90 @@ std::vector<double>::const_iterator Vector::cend() const {
 
 // Functions
 
-void checkVectDimOp(const Vector& v1, const Vector& v2) {
+template<typename T>
+void checkVectDimOp(const BasicVector<T>& v1, const BasicVector<T>& v2) {
     if (v1.size() != v2.size()) {
         throw("Vectors do not have the same dimension.");
     }
     return;
 }
 
-void checkVectMatDimDot(const Vector& v, const Matrix& m) {
+template<typename T>
+void checkVectMatDimDot(const BasicVector<T>& v, const BasicMatrix<T>& m) {
     if (v.size() != m.nbRows()) {
         throw("Vector and Matrix do not have the same dimension.");
     }
     return;
 }
 
-Vector operator+(const Vector& v1, const Vector& v2) {
-    checkVectDimOp(v1, v2);
-    Vector result(v1);
-    result += v2;
-    return result;
-}
-
-Vector operator+(const Vector& v, double value) {
-    Vector result(v);
-    result += value;
-    return result;
-}
-
-Vector operator+(double value, const Vector& v) {
-    Vector result(v);
-    result += value;
-    return result;
-}
-
-Vector operator+(const Vector& v) {
-    return v;
+template<typename T>
+std::size_t size(const BasicVector<T>& v) {
+    return v.size();
 }
 
-Vector operator-(const Vector& v1, const Vector& v2) {
-    checkVectDimOp(v1, v2);
-    Vector result(v1);
-    result -= v2;
-    return result;
+template<typename T>
+T dot(const BasicVector<T>& v1, const BasicVector<T>& v2) {
+    return v1.dot(v2);
 }
 
-Vector operator-(const Vector& v, double value) {
-    Vector result(v);
-    result -= value;
-    return result;
+template<typename T>
+T sum(const BasicVector<T>& v) {
+    return v.sum();
 }
 
-Vector operator-(double value, const Vector& v) {
-    Vector result(v);
-    result -= value;
-    return result;
+template<typename T>
+T max(const BasicVector<T>& v) {
+    return v.max();
 }
 
-Vector operator-(const Vector& v) {
-    Vector result(v);
-    std::for_each(result.begin(), result.end(), [](double& d){d = -d;});
-    return result;
-}
-
-Vector operator*(const Vector& v1, const Vector& v2) {
-    Vector result(v1);
-    result *= v2;
-    return result;
+template<typename T>
+void add(const BasicVector<T>& a, const BasicVector<T>& b, BasicVector<T>& out) {
+    checkVectDimOp(a, b);
+    checkVectDimOp(a, out);
+    NN_PROFILE_SCOPE(Elementwise, "Vector add", 3.0 * static_cast<double>(out.size() * sizeof(T)), static_cast<double>(out.size()));
+    simd::kernels<T>().add(a.data(), b.data(), out.data(), out.size());
 }
 
-Vector operator*(const Vector& v, double value) {
-    Vector result(v);
-    result *= value;
-    return result;
+template<typename T>
+void sub(const BasicVector<T>& a, const BasicVector<T>& b, BasicVector<T>& out) {
+    checkVectDimOp(a, b);
+    checkVectDimOp(a, out);
+    NN_PROFILE_SCOPE(Elementwise, "Vector sub", 3.0 * static_cast<double>(out.size() * sizeof(T)), static_cast<double>(out.size()));
+    simd::kernels<T>().sub(a.data(), b.data(), out.data(), out.size());
 }
 
-Vector operator*(double value, const Vector& v) {
-    Vector result(v);
-    result *= value;
-    return result;
+template<typename T>
+void mul(const BasicVector<T>& a, const BasicVector<T>& b, BasicVector<T>& out) {
+    checkVectDimOp(a, b);
+    checkVectDimOp(a, out);
+    NN_PROFILE_SCOPE(Elementwise, "Vector mul", 3.0 * static_cast<double>(out.size() * sizeof(T)), static_cast<double>(out.size()));
+    simd::kernels<T>().mul(a.data(), b.data(), out.data(), out.size());
 }
 
-Vector operator/(const Vector& v1, const Vector& v2) {
-    Vector result(v1);
-    result /= v2;
-    return result;
+template<typename T>
+void div(const BasicVector<T>& a, const BasicVector<T>& b, BasicVector<T>& out) {
+    checkVectDimOp(a, b);
+    checkVectDimOp(a, out);
+    NN_PROFILE_SCOPE(Elementwise, "Vector div", 3.0 * static_cast<double>(out.size() * sizeof(T)), static_cast<double>(out.size()));
+    simd::kernels<T>().div(a.data(), b.data(), out.data(), out.size());
 }
 
-Vector operator/(const Vector& v, double value) {
-    Vector result(v);
-    result /= value;
-    return result;
-}
+// Instantiations
 
-Vector operator/(double value, const Vector& v) {
-    Vector result(v);
-    result /= value;
-    return result;
-}
+#define INSTANTIATE_VECTOR(T) \
+    template class BasicVector<T>; \
+    template void checkVectDimOp(const BasicVector<T>&, const BasicVector<T>&); \
+    template void checkVectMatDimDot(const BasicVector<T>&, const BasicMatrix<T>&); \
+    template std::size_t size(const BasicVector<T>&); \
+    template T dot(const BasicVector<T>&, const BasicVector<T>&); \
+    template T sum(const BasicVector<T>&); \
+    template T max(const BasicVector<T>&); \
+    template void add(const BasicVector<T>&, const BasicVector<T>&, BasicVector<T>&); \
+    template void sub(const BasicVector<T>&, const BasicVector<T>&, BasicVector<T>&); \
+    template void mul(const BasicVector<T>&, const BasicVector<T>&, BasicVector<T>&); \
+    template void div(const BasicVector<T>&, const BasicVector<T>&, BasicVector<T>&);
 
-std::size_t size(const Vector& v) {
-    return v.size();
-}
+INSTANTIATE_VECTOR(double)
+INSTANTIATE_VECTOR(float)
 
-double dot(const Vector& v1, const Vector& v2) {
-    return std::inner_product(v1.cbegin(), v1.cend(), v2.cbegin(), 0.);
-}
\ No newline at end of file
+#undef INSTANTIATE_VECTOR
@@ -1,71 +1,174 @@
 #pragma once 
 
+#include <type_traits>
 #include <vector>
 
+#include "expression/Expression.hpp"
 #include "matrix/Matrix.hpp"
+#include "memory/AlignedAllocator.hpp"
+#include "parallel/ThreadPool.hpp"
+#include "profile/Profiler.hpp"
 
-class Matrix;
+// Dense vector of double (Vector) or float (FloatVector). Member functions
+// are defined in Vector.cpp and instantiated there for both types.
+template<typename T>
+class BasicVector {
 
-class Vector {
+public:
+
+    using value_type = T;
+    using Storage = std::vector<T, AlignedAllocator<T>>;
+    using iterator = typename Storage::iterator;
+    using const_iterator = typename Storage::const_iterator;
 
 private:
 
-    std::vector<double> m_vec;
+    Storage m_vec;
+
+    // Private methods
+    template<typename Op, typename E>
+    void evaluate(const E& e);
 
 public:
 
     // Constructors
-    Vector();
-    Vector(std::size_t n, double value = 0.);
-    Vector(const Vector& other) = default;
+    BasicVector();
+    BasicVector(std::size_t n, T value = T());
+    BasicVector(const BasicVector& other) = default;
+    BasicVector(BasicVector&& other) noexcept = default;
+    template<typename E>
+    BasicVector(const VectorExpression<E>& e);
 
     // Destructors
-    ~Vector() = default;
+    ~BasicVector() = default;
 
     // Operators
-    Vector& operator=(const Vector& other) = default;
-    Vector& operator+=(const Vector& other);
-    Vector& operator+=(double value);
-    Vector& operator-=(const Vector& other);
-    Vector& operator-=(double value);
-    Vector& operator*=(const Vector& other); // not the dot product
-    Vector& operator*=(double value);
-    Vector& operator/=(const Vector& other);
-    Vector& operator/=(double value);
-    double& operator[](unsigned int i);
-    const double& operator[](unsigned int i) const;
+    BasicVector& operator=(const BasicVector& other) = default;
+    BasicVector& operator=(BasicVector&& other) noexcept = default;
+    BasicVector& operator+=(const BasicVector& other);
+    BasicVector& operator+=(T value);
+    BasicVector& operator-=(const BasicVector& other);
+    BasicVector& operator-=(T value);
+    BasicVector& operator*=(const BasicVector& other); // not the dot product
+    BasicVector& operator*=(T value);
+    BasicVector& operator/=(const BasicVector& other);
+    BasicVector& operator/=(T value);
+    template<typename E>
+    BasicVector& operator=(const VectorExpression<E>& e);
+    template<typename E>
+    BasicVector& operator+=(const VectorExpression<E>& e);
+    template<typename E>
+    BasicVector& operator-=(const VectorExpression<E>& e);
+    template<typename E>
+    BasicVector& operator*=(const VectorExpression<E>& e);
+    template<typename E>
+    BasicVector& operator/=(const VectorExpression<E>& e);
+    T& operator[](unsigned int i);
+    const T& operator[](unsigned int i) const;
 
     // Other members
     std::size_t size() const;
-    double dot(const Vector& other) const;
-    Vector dot(const Matrix& other) const;
-    std::vector<double>::iterator begin();
-    std::vector<double>::const_iterator begin() const;
-    std::vector<double>::iterator end();
-    std::vector<double>::const_iterator end() const;
-    std::vector<double>::const_iterator cbegin() const;
-    std::vector<double>::const_iterator cend() const;
+    T* data();
+    const T* data() const;
+    T sum() const;
+    T max() const;
+    T dot(const BasicVector& other) const;
+    BasicVector dot(const BasicMatrix<T>& other) const;
+    iterator begin();
+    const_iterator begin() const;
+    iterator end();
+    const_iterator end() const;
+    const_iterator cbegin() const;
+    const_iterator cend() const;
 
     // Friend functions
 
 };
 
 // Functions
-void checkVectDimOp(const Vector& v1, const Vector& v2);
-void checkVectMatDimDot(const Vector& v, const Matrix& m);
-Vector operator+(const Vector& v1, const Vector& v2);
-Vector operator+(const Vector& v, double value);
-Vector operator+(double value, const Vector& v);
-Vector operator+(const Vector& v);
-Vector operator-(const Vector& v1, const Vector& v2);
-Vector operator-(const Vector& v, double value);
-Vector operator-(double value, const Vector& v);
-Vector operator-(const Vector& v);
-Vector operator*(const Vector& v1, const Vector& v2);
-Vector operator*(const Vector& v, double value);
-Vector operator*(double value, const Vector& v);
-Vector operator/(const Vector& v1, const Vector& v2);
-Vector operator/(const Vector& v, double value);
-Vector operator/(double value, const Vector& v);
-std::size_t size(const Vector& v);
-double dot(const Vector& v1, const Vector& v2);
\ No newline at end of file
+template<typename T>
+void checkVectDimOp(const BasicVector<T>& v1, const BasicVector<T>& v2);
+template<typename T>
+void checkVectMatDimDot(const BasicVector<T>& v, const BasicMatrix<T>& m);
+template<typename T>
+std::size_t size(const BasicVector<T>& v);
+template<typename T>
+T dot(const BasicVector<T>& v1, const BasicVector<T>& v2);
+template<typename T>
+T sum(const BasicVector<T>& v);
+template<typename T>
+T max(const BasicVector<T>& v);
+// Destination-passing variants: out must already have the size of a and b,
+// and may be one of them.
+template<typename T>
+void add(const BasicVector<T>& a, const BasicVector<T>& b, BasicVector<T>& out);
+template<typename T>
+void sub(const BasicVector<T>& a, const BasicVector<T>& b, BasicVector<T>& out);
+template<typename T>
+void mul(const BasicVector<T>& a, const BasicVector<T>& b, BasicVector<T>& out);
+template<typename T>
+void div(const BasicVector<T>& a, const BasicVector<T>& b, BasicVector<T>& out);
+
+// Expression evaluation
+
+template<typename T>
+template<typename Op, typename E>
+void BasicVector<T>::evaluate(const E& e) {
+    if (e.size() != size()) {
+        throw("Vectors do not have the same dimension.");
+    }
+    NN_PROFILE_SCOPE(Elementwise, "Vector expression", static_cast<double>(size() * sizeof(T)), 0);
+    T* d = m_vec.data();
+    parallelFor(0, size(), parallelGrain, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) {
+            d[i] = static_cast<T>(Op::apply(d[i], e[i]));
+        }
+    });
+}
+
+template<typename T>
+template<typename E>
+BasicVector<T>::BasicVector(const VectorExpression<E>& e) :
+    m_vec(static_cast<const E&>(e).size())
+{
+    evaluate<ExprAssign>(static_cast<const E&>(e));
+}
+
+template<typename T>
+template<typename E>
+BasicVector<T>& BasicVector<T>::operator=(const VectorExpression<E>& e) {
+    const E& expr = static_cast<const E&>(e);
+    if (expr.size() != size()) {
+        m_vec.resize(expr.size());
+    }
+    evaluate<ExprAssign>(expr);
+    return *this;
+}
+
+template<typename T>
+template<typename E>
+BasicVector<T>& BasicVector<T>::operator+=(const VectorExpression<E>& e) {
+    evaluate<ExprAdd>(static_cast<const E&>(e));
+    return *this;
+}
+
+template<typename T>
+template<typename E>
+BasicVector<T>& BasicVector<T>::operator-=(const VectorExpression<E>& e) {
+    evaluate<ExprSub>(static_cast<const E&>(e));
+    return *this;
+}
+
+template<typename T>
+template<typename E>
+BasicVector<T>& BasicVector<T>::operator*=(const VectorExpression<E>& e) {
+    evaluate<ExprMul>(static_cast<const E&>(e));
+    return *this;
+}
+
+template<typename T>
+template<typename E>
+BasicVector<T>& BasicVector<T>::operator/=(const VectorExpression<E>& e) {
+    evaluate<ExprDiv>(static_cast<const E&>(e));
+    return *this;
+}